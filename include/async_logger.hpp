@@ -0,0 +1,165 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include "../include/singleton.hpp"
+#include "../include/ring_queue.hpp"
+#include "../include/wait_strategy.hpp"
+#include "../include/tsc_clock.hpp"
+
+namespace hft {
+
+enum class LogLevel : uint8_t {
+    DEBUG = 1,
+    INFO = 2,
+    WARN = 3,
+    ERROR = 4
+};
+
+const char* logLevelName(LogLevel level);
+bool parseLogLevel(const std::string& name, LogLevel& out);
+
+// One log statement, defined once with static storage next to its call
+// site; its address is the record's format id. Each "{}" in the format
+// takes the next argument.
+struct LogSite {
+    LogLevel level;
+    const char* component;
+    const char* format;
+};
+
+enum class LogArgType : uint8_t {
+    INT = 1,
+    UINT,
+    DOUBLE,
+    STRING          // Pointer to static storage, e.g. a literal or a name table
+};
+
+union LogArg {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char* s;
+};
+
+// What the hot path writes: a timestamp, the site and the raw arguments
+struct LogRecord {
+    static constexpr size_t MAX_ARGS = 6;
+    
+    uint64_t ticks;
+    const LogSite* site;
+    uint8_t arg_count;
+    LogArgType types[MAX_ARGS];
+    LogArg args[MAX_ARGS];
+};
+
+// Deferred-format logger. log() stamps the TSC and copies its arguments
+// into the calling thread's SPSC ring, a few tens of nanoseconds; the
+// logger thread formats and writes the lines. Lines are in order per
+// producing thread. A full ring drops the record and counts it rather
+// than stall the caller.
+class AsyncLogger : public Singleton<AsyncLogger> {
+public:
+    friend class Singleton<AsyncLogger>;
+    
+    ~AsyncLogger() override;
+    
+    // Empty path writes to stdout
+    bool start(const std::string& path = "");
+    void stop();
+    
+    void setMinLevel(LogLevel level) { min_level_.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+    void setWaitStrategy(WaitStrategyType type) { wait_strategy_ = type; }
+    
+    bool enabled(LogLevel level) const {
+        return running_.load(std::memory_order_relaxed) &&
+               static_cast<uint8_t>(level) >= min_level_.load(std::memory_order_relaxed);
+    }
+    
+    template<typename... Args>
+    void log(const LogSite& site, Args... args) {
+        static_assert(sizeof...(Args) <= LogRecord::MAX_ARGS, "too many log arguments");
+        if (!enabled(site.level)) return;
+        
+        LogRecord record;
+        record.ticks = TscClock::now();
+        record.site = &site;
+        record.arg_count = 0;
+        pack(record, args...);
+        push(record);
+    }
+    
+    size_t getRecordCount() const { return record_count_.load(std::memory_order_relaxed); }
+    size_t getDropCount() const { return drop_count_.load(std::memory_order_relaxed); }
+    
+protected:
+    AsyncLogger();
+    
+private:
+    static void pack(LogRecord&) {}
+    
+    template<typename T, typename... Rest>
+    static void pack(LogRecord& record, T value, Rest... rest) {
+        store(record, value);
+        pack(record, rest...);
+    }
+    
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+    store(LogRecord& record, T value) {
+        record.types[record.arg_count] = LogArgType::INT;
+        record.args[record.arg_count++].i = value;
+    }
+    
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+    store(LogRecord& record, T value) {
+        record.types[record.arg_count] = LogArgType::UINT;
+        record.args[record.arg_count++].u = value;
+    }
+    
+    template<typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type
+    store(LogRecord& record, T value) {
+        record.types[record.arg_count] = LogArgType::DOUBLE;
+        record.args[record.arg_count++].d = value;
+    }
+    
+    template<typename T>
+    static typename std::enable_if<std::is_enum<T>::value>::type
+    store(LogRecord& record, T value) {
+        store(record, static_cast<typename std::underlying_type<T>::type>(value));
+    }
+    
+    static void store(LogRecord& record, const char* value) {
+        record.types[record.arg_count] = LogArgType::STRING;
+        record.args[record.arg_count++].s = value;
+    }
+    
+    void push(const LogRecord& record);
+    void writerLoop();
+    void format(const LogRecord& record);
+    
+    PerThreadSpscFanIn<LogRecord> inbound_;
+    WaitNotifier notifier_;
+    WaitStrategyType wait_strategy_{WaitStrategyType::SPIN_PARK};
+    
+    std::atomic<bool> running_{false};
+    std::atomic<uint8_t> min_level_{static_cast<uint8_t>(LogLevel::INFO)};
+    std::thread writer_thread_;
+    FILE* out_{nullptr};
+    
+    std::atomic<size_t> record_count_{0};
+    std::atomic<size_t> drop_count_{0};
+    
+    static constexpr size_t PRODUCER_QUEUE_CAPACITY = 4096;
+    static constexpr size_t MAX_BATCH = 256;
+};
+
+} // namespace hft
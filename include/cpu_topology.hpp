@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "../include/singleton.hpp"
+
+namespace hft {
+
+// Long-lived threads that get a core of their own
+enum class ThreadRole : uint8_t {
+    REACTOR = 0,
+    ACCEPT,
+    PROCESSOR,              // ServiceManager message processor
+    MATCHING,
+    RISK,
+    MARKET_DATA,
+    FEED,                   // Multicast feed handler
+    JOURNAL,                // Inbound journal writer
+    LOGGER,                 // AsyncLogger formatter
+    ROLE_COUNT
+};
+
+const char* threadRoleName(ThreadRole role);
+
+// Online CPUs this process may run on, grouped by NUMA node, from sysfs
+class CpuTopology {
+public:
+    bool load();
+    
+    const std::vector<int>& cpus() const { return cpus_; }
+    size_t nodeCount() const { return node_cpus_.size(); }
+    int nodeOf(int cpu) const;
+    const std::vector<int>& cpusOnNode(int node) const;
+    
+    // NUMA node of a network interface's device; -1 if unknown or virtual
+    static int interfaceNode(const std::string& interface);
+    
+    // Kernel cpulist syntax ("0-3,8"); '+' is accepted in place of ','
+    static bool parseCpuList(const std::string& text, std::vector<int>& out);
+    static std::string formatCpuList(const std::vector<int>& cpus);
+    
+private:
+    std::vector<int> cpus_;
+    std::vector<std::vector<int>> node_cpus_;   // Indexed by node id
+    std::vector<int> cpu_node_;                 // Indexed by cpu id
+};
+
+// Role -> CPU map for every long-lived thread. Built once at startup from
+// an explicit spec, with anything left unassigned placed automatically:
+// reactors on the NIC's node, then a dedicated core each for the matching
+// shards, risk, the feed handler, the processor, market data, the accept
+// thread, the journal and the logger, sharing only when the machine runs
+// out of cores. Threads pin themselves as they start, so everything they
+// allocate afterwards (connection buffers, message pools, rings) is first
+// touched on their own node.
+class ThreadPlacement : public Singleton<ThreadPlacement> {
+public:
+    friend class Singleton<ThreadPlacement>;
+    
+    // "off", "auto", or comma separated role=cpulist and nic=<interface>
+    // items, e.g. "nic=eth0,reactor=2-5,matching=6,risk=7". Roles are
+    // reactor, accept, processor, matching, risk, marketdata, feed, journal,
+    // logger. Reactors and matching shards run several threads each and get
+    // that many CPUs.
+    bool configure(const std::string& spec, size_t reactor_count, size_t matching_count = 1);
+    bool enabled() const { return enabled_; }
+    
+    // Pin the calling thread to its slot (index selects among the role's
+    // CPUs, e.g. the reactor or shard id) and prefer its node for allocations
+    bool pinCurrentThread(ThreadRole role, size_t index = 0) const;
+    
+    // -1 when placement is off
+    int cpuFor(ThreadRole role, size_t index = 0) const;
+    
+    void printReport() const;
+    
+protected:
+    ThreadPlacement() = default;
+    
+private:
+    struct RolePlacement {
+        std::vector<int> cpus;
+        size_t threads{1};
+        bool explicit_map{false};
+        bool shared{false};         // At least one CPU also hosts another role
+    };
+    
+    void assignRemaining();
+    void markShared();
+    
+    CpuTopology topology_;
+    RolePlacement roles_[static_cast<size_t>(ThreadRole::ROLE_COUNT)];
+    std::string nic_;
+    int home_node_{0};
+    bool enabled_{false};
+};
+
+} // namespace hft
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include "../include/message.hpp"
+#include "../include/wait_strategy.hpp"
+#include "../include/xdp_socket.hpp"
+#include "../include/wire_format.hpp"
+
+struct mmsghdr;
+struct iovec;
+
+namespace hft {
+
+// How datagrams leave the kernel
+enum class FeedMode : uint8_t {
+    RECVMMSG,       // Ordinary UDP sockets, drained a batch per syscall
+    XDP             // AF_XDP socket: XDP redirect into a UMEM ring, bypassing the stack
+};
+
+bool parseFeedMode(const std::string& name, FeedMode& mode);
+const char* feedModeName(FeedMode mode);
+
+// One multicast line of the feed, "239.1.1.1:5000"
+struct FeedLine {
+    std::string group;
+    uint16_t port{0};
+    
+    static bool parse(const std::string& text, FeedLine& out);
+};
+
+struct FeedConfig {
+    std::vector<FeedLine> lines;    // A, then optionally B, carrying the same stream
+    std::string interface;          // Join on this interface; empty lets the kernel choose
+    FeedMode mode{FeedMode::RECVMMSG};
+    uint32_t xdp_queue{0};          // NIC queue the AF_XDP socket binds to
+    uint32_t gap_timeout_us{500};   // How long a gap may wait to be filled by the other line
+};
+
+// UDP multicast market data feed handler. One thread reads every line and
+// arbitrates them by feed sequence: the first copy of a message to arrive
+// from either line is delivered and the other is dropped, so a packet lost
+// on one line costs nothing as long as the other delivers it. A packet that
+// jumps ahead is copied aside until the other line fills the hole or the gap
+// timeout passes; sequences missing from both lines are then counted as a
+// gap and skipped. Quotes are last-value, so the next one for the symbol
+// supersedes what was lost.
+// Quotes are handed to the callback as views into the receive buffer, on
+// the feed thread, without going through the TCP pipeline.
+class FeedHandler {
+public:
+    typedef std::function<void(const MarketDataView&)> QuoteCallback;
+    
+    static constexpr size_t MAX_LINES = 2;
+    
+    FeedHandler();
+    ~FeedHandler();
+    
+    FeedHandler(const FeedHandler&) = delete;
+    FeedHandler& operator=(const FeedHandler&) = delete;
+    
+    void setQuoteCallback(QuoteCallback callback) { quote_callback_ = std::move(callback); }
+    void setWaitStrategy(WaitStrategyType type) { wait_strategy_ = type; }
+    
+    // Joins the lines and starts the feed thread. AF_XDP falls back to
+    // recvmmsg if the socket cannot be set up.
+    bool start(const FeedConfig& config);
+    void stop();
+    
+    bool usingXdp() const { return xdp_ != nullptr; }
+    
+    size_t getPacketCount() const { return packets_.load(std::memory_order_relaxed); }
+    size_t getMessageCount() const { return messages_.load(std::memory_order_relaxed); }
+    // Packets that carried nothing newer than what was already delivered
+    size_t getDuplicateCount() const { return duplicates_.load(std::memory_order_relaxed); }
+    size_t getGapCount() const { return gaps_.load(std::memory_order_relaxed); }
+    // Messages lost on every line
+    size_t getMissedCount() const { return missed_.load(std::memory_order_relaxed); }
+    size_t getMalformedCount() const { return malformed_.load(std::memory_order_relaxed); }
+    // Packets this line delivered first
+    size_t getLineWins(size_t line) const { return line < MAX_LINES ? wins_[line].load(std::memory_order_relaxed) : 0; }
+    
+    void printStats() const;
+    
+private:
+    struct Line {
+        FeedLine config;
+        uint32_t group_addr{0};     // Network order
+        int fd{-1};
+    };
+    
+    bool openLine(Line& line);
+    void receiveLoop();
+    size_t drainSocket(size_t line);
+    size_t drainXdp();
+    void onPacket(size_t line, const char* data, size_t length);
+    void deliver(size_t line, const wire::FeedPacketHeader& header, const char* data, size_t length);
+    void hold(size_t line, const char* data, size_t length, uint64_t sequence);
+    void releaseHeld(bool expired);
+    // Line whose group and port an AF_XDP frame was addressed to, or MAX_LINES
+    size_t lineForFrame(const char* frame, size_t length, const char*& payload, size_t& payload_length) const;
+    
+    Line lines_[MAX_LINES];
+    size_t line_count_{0};
+    std::string interface_;
+    std::unique_ptr<XdpSocket> xdp_;
+    
+    // recvmmsg batch, reused for every line
+    std::unique_ptr<mmsghdr[]> headers_;
+    std::unique_ptr<iovec[]> iovecs_;
+    std::vector<char> buffers_;
+    
+    // Packets waiting out a gap, unordered
+    struct HeldPacket {
+        uint64_t sequence{0};
+        size_t line{0};
+        size_t length{0};
+        std::unique_ptr<char[]> data;
+    };
+    
+    // Feed thread state
+    uint64_t next_sequence_{0};     // 0 until the first packet
+    std::unique_ptr<HeldPacket[]> held_;
+    size_t held_count_{0};
+    uint64_t hold_deadline_{0};     // TscClock ticks
+    uint64_t gap_timeout_ticks_{0};
+    
+    QuoteCallback quote_callback_;
+    WaitStrategyType wait_strategy_{WaitStrategyType::SPIN_PARK};
+    std::thread feed_thread_;
+    std::atomic<bool> running_{false};
+    
+    std::atomic<size_t> packets_{0};
+    std::atomic<size_t> messages_{0};
+    std::atomic<size_t> duplicates_{0};
+    std::atomic<size_t> gaps_{0};
+    std::atomic<size_t> missed_{0};
+    std::atomic<size_t> malformed_{0};
+    std::atomic<size_t> wins_[MAX_LINES];
+    
+    static constexpr size_t BATCH = 32;
+    static constexpr size_t HOLD_CAPACITY = 64;
+    static constexpr size_t MAX_DATAGRAM = 9216;
+    static constexpr int RECEIVE_BUFFER = 8 * 1024 * 1024;
+};
+
+} // namespace hft
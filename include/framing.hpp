@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace hft {
+
+// Forward declarations
+class Message;
+
+// Wire framing: each Message::serialize payload is preceded by a
+// 4-byte little-endian payload length
+constexpr size_t FRAME_HEADER_SIZE = 4;
+constexpr size_t MAX_FRAME_SIZE = 4096;
+
+void encodeFrameHeader(uint32_t payload_length, uint8_t* out);
+uint32_t decodeFrameHeader(const uint8_t* in);
+
+// Header + payload, ready for a single send()
+std::vector<uint8_t> frameMessage(const Message& message);
+
+// Per-connection receive buffer that reassembles partial frames.
+// Sockets read straight into the free tail; complete frames are parsed in
+// place and the leftover partial frame is moved to the front only when
+// the tail can no longer hold a maximum-size frame.
+class FrameBuffer {
+public:
+    explicit FrameBuffer(size_t capacity);
+    
+    // Producer side (socket reads)
+    char* writePtr() { return buffer_.data() + write_pos_; }
+    size_t writable() const { return buffer_.size() - write_pos_; }
+    void commit(size_t count) { write_pos_ += count; }
+    
+    // Consumer side (frame parsing)
+    const char* readPtr() const { return buffer_.data() + read_pos_; }
+    size_t readable() const { return write_pos_ - read_pos_; }
+    void consume(size_t count) { read_pos_ += count; }
+    
+    void compact();
+    void clear() { read_pos_ = write_pos_ = 0; }
+
+private:
+    std::vector<char> buffer_;
+    size_t read_pos_{0};
+    size_t write_pos_{0};
+};
+
+} // namespace hft
@@ -3,15 +3,58 @@
 #include <vector>
 #include <functional>
 #include <memory>
-#include <chrono>
-#include <map>
 #include <mutex>
+#include <unordered_map>
+#include <tuple>
+#include <type_traits>
+#include <cstdint>
+#include <atomic>
+#include "../include/thread_slot.hpp"
+#include "../include/tsc_clock.hpp"
 
 namespace hft {
 
 // Forward declarations
 class Message;
 class InterceptorContext;
+class RiskEngine;
+
+// Why a stage rejected a message; OK while the chain is still passing
+enum class InterceptStatus : uint8_t {
+    OK = 0,
+    NULL_MESSAGE,
+    INVALID_SEQUENCE,
+    INVALID_TIMESTAMP,
+    INVALID_ORDER_ID,
+    UNKNOWN_SYMBOL,
+    INVALID_PRICE,
+    INVALID_QUANTITY,
+    INVALID_QUOTE,
+    CROSSED_QUOTE,
+    THROTTLED,
+    RISK_REJECTED,
+    ENGINE_UNAVAILABLE      // Passed the chain but matching could not take it
+};
+
+const char* interceptStatusName(InterceptStatus status);
+
+// Stages a message has passed, as bits in InterceptorContext::flags()
+enum ContextFlag : uint32_t {
+    FLAG_VALIDATED = 1u << 0,
+    FLAG_LOGGED = 1u << 1,
+    FLAG_MEASURED = 1u << 2,
+    FLAG_THROTTLE_ACCEPTED = 1u << 3,
+    FLAG_LATENCY_WARNING = 1u << 4,
+    FLAG_RISK_ACCEPTED = 1u << 5
+};
+
+// Fixed numeric slots stages can fill in
+enum class ContextField : uint8_t {
+    LATENCY_NS = 0,
+    RISK_RESULT,            // RiskResult of a RISK_REJECTED order
+    RISK_START_TICKS,       // TscClock reading as the risk check began; 0 if it did not run
+    FIELD_COUNT
+};
 
 // Base interceptor interface
 class IInterceptor {
@@ -20,31 +63,43 @@ public:
     virtual bool intercept(InterceptorContext& context) = 0;
 };
 
-// Interceptor context for passing data through the chain
+// Per-message state passed through the chain. Fixed layout, no heap:
+// the message is borrowed, not owned, and must outlive the context.
 class InterceptorContext {
 public:
-    explicit InterceptorContext(std::shared_ptr<Message> msg);
+    explicit InterceptorContext(const Message& msg);
+    
+    const Message* getMessage() const { return message_; }
+    void setMessage(const Message& msg) { message_ = &msg; }
     
-    std::shared_ptr<Message> getMessage() const { return message_; }
-    void setMessage(std::shared_ptr<Message> msg) { message_ = msg; }
+    // Performance tracking, in TscClock ticks
+    void startTimer() { start_ticks_ = TscClock::now(); }
+    void endTimer() { end_ticks_ = TscClock::nowOrdered(); }
+    uint64_t getLatencyNs() const { return TscClock::toNanos(end_ticks_ - start_ticks_); }
+    double getLatencyUs() const { return getLatencyNs() / 1000.0; }
     
-    // Performance tracking
-    void startTimer();
-    void endTimer();
-    double getLatencyUs() const;
+    // Rejection reason; the first failing stage sets it and returns false
+    InterceptStatus getStatus() const { return status_; }
+    bool reject(InterceptStatus status) { status_ = status; return false; }
     
-    // Metadata
-    void setMetadata(const std::string& key, const std::string& value);
-    std::string getMetadata(const std::string& key) const;
+    void setFlag(ContextFlag flag) { flags_ |= flag; }
+    bool hasFlag(ContextFlag flag) const { return (flags_ & flag) != 0; }
+    uint32_t flags() const { return flags_; }
+    
+    void setField(ContextField field, uint64_t value) { fields_[static_cast<size_t>(field)] = value; }
+    uint64_t getField(ContextField field) const { return fields_[static_cast<size_t>(field)]; }
 
 private:
-    std::shared_ptr<Message> message_;
-    std::chrono::high_resolution_clock::time_point start_time_;
-    std::chrono::high_resolution_clock::time_point end_time_;
-    std::map<std::string, std::string> metadata_;
+    const Message* message_;
+    uint64_t start_ticks_;
+    uint64_t end_ticks_;
+    InterceptStatus status_;
+    uint32_t flags_;
+    uint64_t fields_[static_cast<size_t>(ContextField::FIELD_COUNT)];
 };
 
-// Interceptor chain for processing messages
+// Runtime-configured chain; one virtual call per stage. Prefer
+// StaticInterceptorChain on the hot path.
 class InterceptorChain {
 public:
     void addInterceptor(std::shared_ptr<IInterceptor> interceptor);
@@ -55,32 +110,140 @@ private:
     std::vector<std::shared_ptr<IInterceptor>> interceptors_;
 };
 
-// Concrete interceptors
+// Concrete interceptors. check() is the non-virtual stage body used by
+// StaticInterceptorChain; intercept() forwards to it for InterceptorChain.
 class ValidationInterceptor : public IInterceptor {
 public:
-    bool intercept(InterceptorContext& context) override;
+    bool intercept(InterceptorContext& context) override { return check(context); }
+    bool check(InterceptorContext& context);
 };
 
 class LoggingInterceptor : public IInterceptor {
 public:
-    bool intercept(InterceptorContext& context) override;
+    bool intercept(InterceptorContext& context) override { return check(context); }
+    bool check(InterceptorContext& context);
 };
 
 class PerformanceInterceptor : public IInterceptor {
 public:
-    bool intercept(InterceptorContext& context) override;
+    bool intercept(InterceptorContext& context) override { return check(context); }
+    bool check(InterceptorContext& context);
+};
+
+// Per-client token buckets. Each thread keeps its own bucket table, so a
+// client pinned to one reactor is metered without locks or shared writes;
+// a client spread over several reactors gets one bucket per reactor.
+// Limits default to the constructor values and can be overridden per
+// client (e.g. at login); buckets pick up changes on their next message.
+struct ThrottleConfig {
+    double messages_per_second;
+    double burst;                   // 0 means 10ms worth of the sustained rate
+    size_t max_clients_per_thread;
+    
+    ThrottleConfig(double rate, double burst_size = 0.0, size_t max_clients = 4096)
+        : messages_per_second(rate), burst(burst_size), max_clients_per_thread(max_clients) {}
 };
 
 class ThrottlingInterceptor : public IInterceptor {
 public:
-    explicit ThrottlingInterceptor(size_t max_messages_per_second);
-    bool intercept(InterceptorContext& context) override;
+    explicit ThrottlingInterceptor(const ThrottleConfig& config);
+    explicit ThrottlingInterceptor(double messages_per_second, double burst = 0.0,
+                                   size_t max_clients_per_thread = 4096)
+        : ThrottlingInterceptor(ThrottleConfig(messages_per_second, burst, max_clients_per_thread)) {}
+    ~ThrottlingInterceptor() override;
+    
+    bool intercept(InterceptorContext& context) override { return check(context); }
+    bool check(InterceptorContext& context);
+    
+    void setClientLimits(uint64_t client_id, double messages_per_second, double burst);
+    void clearClientLimits(uint64_t client_id);
 
 private:
-    size_t max_messages_per_second_;
-    std::chrono::steady_clock::time_point last_check_;
-    size_t message_count_;
-    mutable std::mutex throttle_mutex_;
+    struct Limits {
+        double tokens_per_tick;
+        double burst;
+    };
+    
+    struct Bucket {
+        uint64_t client_id;
+        uint64_t last_ticks;
+        double tokens;
+        Limits limits;
+        uint32_t generation;
+        bool used;
+    };
+    
+    // One per thread slot, written only by that thread
+    struct Shard {
+        std::vector<Bucket> buckets;    // Open addressing, power-of-two size
+        Bucket overflow;                // Shared by clients once the table is full
+        size_t used_count;
+    };
+    
+    Limits makeLimits(double messages_per_second, double burst) const;
+    Limits limitsFor(uint64_t client_id) const;
+    Shard& localShard();
+    Bucket& bucketFor(Shard& shard, uint64_t client_id);
+    void resetBucket(Bucket& bucket, uint64_t client_id, uint64_t now);
+    
+    Limits default_limits_;
+    size_t shard_capacity_;
+    std::atomic<Shard*> shards_[MAX_THREAD_SLOTS];
+    
+    // Consulted only when a bucket is created or its generation is stale
+    std::unordered_map<uint64_t, Limits> overrides_;
+    mutable std::mutex overrides_mutex_;
+    std::atomic<uint32_t> generation_{0};
+};
+
+// Pre-trade risk check in front of matching. Reservations made here are
+// released by the matching side, so this must be the last stage that can
+// reject: a later reject would leak the reservation.
+class RiskInterceptor : public IInterceptor {
+public:
+    explicit RiskInterceptor(RiskEngine* engine = nullptr) : engine_(engine) {}
+    
+    void setEngine(RiskEngine* engine) { engine_ = engine; }
+    
+    bool intercept(InterceptorContext& context) override { return check(context); }
+    bool check(InterceptorContext& context);
+
+private:
+    RiskEngine* engine_;
+};
+
+// Chain composed at compile time: stages are held by value and called
+// directly in order, so the whole chain inlines into the caller.
+//   StaticInterceptorChain<ValidationInterceptor, ThrottlingInterceptor>
+//       chain(ValidationInterceptor(), 1000000);
+template<typename... Stages>
+class StaticInterceptorChain {
+public:
+    StaticInterceptorChain() = default;
+    
+    // One constructor argument per stage
+    template<typename... Args>
+    explicit StaticInterceptorChain(Args&&... args) : stages_(std::forward<Args>(args)...) {}
+    
+    bool process(InterceptorContext& context) { return run<0>(context); }
+    
+    template<size_t I>
+    typename std::tuple_element<I, std::tuple<Stages...>>::type& stage() { return std::get<I>(stages_); }
+    
+    static constexpr size_t size() { return sizeof...(Stages); }
+
+private:
+    template<size_t I>
+    typename std::enable_if<(I < sizeof...(Stages)), bool>::type run(InterceptorContext& context) {
+        return std::get<I>(stages_).check(context) && run<I + 1>(context);
+    }
+    
+    template<size_t I>
+    typename std::enable_if<(I == sizeof...(Stages)), bool>::type run(InterceptorContext&) {
+        return true;
+    }
+    
+    std::tuple<Stages...> stages_;
 };
 
-} // namespace hft 
\ No newline at end of file
+} // namespace hft
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct msghdr;
+
+namespace hft {
+
+// Minimal io_uring wrapper over the raw syscalls; no liburing dependency.
+// One ring per reactor thread, used only by that thread. Receives draw from
+// a provided-buffer ring registered with the kernel, so multishot recv needs
+// no per-read buffer setup.
+class IoUring {
+public:
+    struct Completion {
+        uint64_t user_data;
+        int32_t res;
+        uint32_t flags;
+    };
+    
+    IoUring();
+    ~IoUring();
+    
+    // False if the kernel (or seccomp) refuses io_uring; callers fall back to epoll
+    bool init(unsigned entries, bool sqpoll);
+    
+    // Provided buffers for recv with buffer select; count is rounded to a power of two.
+    // Uses a registered buffer ring where the kernel delivers from it, otherwise
+    // re-provides each buffer with IORING_OP_PROVIDE_BUFFERS as it is recycled.
+    bool setupBuffers(uint16_t group, uint32_t count, uint32_t size);
+    const char* buffer(uint16_t id) const { return buffers_.data() + static_cast<size_t>(id) * buffer_size_; }
+    // Without a buffer ring, kernels lacking CQE skip post a completion with
+    // user_data 0 for each recycle; a negative result means the buffer is lost
+    void recycleBuffer(uint16_t id);
+    uint16_t bufferGroup() const { return buffer_group_; }
+    
+    // Queue operations; false if the submission queue stays full after a submit
+    bool prepAccept(int listen_fd, bool multishot, uint64_t user_data);
+    bool prepRecv(int fd, bool multishot, uint64_t user_data);
+    bool prepSendmsg(int fd, const struct msghdr* msg, int flags, uint64_t user_data);
+    bool prepRead(int fd, void* buf, uint32_t length, uint64_t user_data);
+    
+    // Hand queued operations to the kernel; with SQPOLL this is usually free
+    int submit();
+    // Submit, then block until a completion arrives or the timeout passes
+    int submitAndWait(int timeout_ms);
+    
+    // Copies up to max ready completions and retires them from the ring
+    size_t reap(Completion* out, size_t max);
+    
+    static bool hasMore(uint32_t flags);
+    static bool hasBuffer(uint32_t flags);
+    static uint16_t bufferId(uint32_t flags);
+    
+    bool sqpoll() const { return sqpoll_; }
+    bool bufferRing() const { return buf_ring_ != nullptr; }
+
+private:
+    void* getSqe();
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags, int timeout_ms);
+    void cleanup();
+    bool registerBufferRing(uint32_t entries);
+    void unregisterBufferRing();
+    bool probeBuffers();
+    bool provideBuffers(uint16_t first_id, uint32_t count, bool wait);
+    bool waitOne(Completion& completion);
+    
+    int ring_fd_{-1};
+    bool sqpoll_{false};
+    bool cqe_skip_{false};          // IOSQE_CQE_SKIP_SUCCESS honoured (5.17)
+    
+    // Mapped ring regions
+    void* sq_ring_{nullptr};
+    void* cq_ring_{nullptr};
+    void* sqes_{nullptr};
+    size_t sq_ring_size_{0};
+    size_t cq_ring_size_{0};
+    size_t sqes_size_{0};
+    
+    unsigned* sq_head_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned* sq_flags_{nullptr};
+    unsigned* sq_array_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned sq_entries_{0};
+    unsigned sqe_tail_{0};          // Next SQE to hand out
+    unsigned submitted_tail_{0};    // Last tail published to the kernel
+    
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    void* cqes_{nullptr};
+    
+    // Provided buffers
+    void* buf_ring_{nullptr};
+    size_t buf_ring_size_{0};
+    uint32_t buf_count_{0};
+    uint16_t buf_tail_{0};
+    uint16_t buffer_group_{0};
+    uint32_t buffer_size_{0};
+    std::vector<char> buffers_;
+};
+
+} // namespace hft
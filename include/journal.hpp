@@ -0,0 +1,147 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "../include/ring_queue.hpp"
+#include "../include/wait_strategy.hpp"
+
+namespace hft {
+
+class Message;
+
+// On-disk layout. A journal is a series of segment files named
+// <base>.000000, <base>.000001, ...; each starts with a segment header and
+// holds records back to back, 8-byte aligned. A zero length ends the
+// segment: the writer stores a record's length last, so a record torn by a
+// crash is never visible to a reader.
+struct JournalSegmentHeader {
+    char magic[8];                  // "HFTJRNL1"
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t segment_index;
+    uint64_t created_ns;            // System clock
+    uint8_t reserved[32];
+};
+
+struct JournalRecordHeader {
+    uint32_t length;                // Payload bytes; 0 ends the segment
+    uint32_t reserved;
+    uint64_t receive_ns;            // Message receive time, Unix epoch
+    uint64_t connection_id;
+};
+
+// One inbound message as journaled: the wire payload without its frame header
+struct JournalRecord {
+    uint64_t receive_ns{0};
+    uint64_t connection_id{0};
+    const char* payload{nullptr};   // Points into the mapped segment
+    uint32_t length{0};
+};
+
+// Append-only journal of accepted inbound messages. Producers (reactors)
+// copy each payload as received into their own SPSC ring; a dedicated
+// thread copies records into memory-mapped segments that are sized and
+// pre-faulted up front, so the hot path never touches the file system and
+// the writer never page faults.
+// Mapped pages survive a process crash; segments are msync'd on rollover
+// and on stop.
+class Journal {
+public:
+    Journal();
+    ~Journal();
+    
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+    
+    // Creates the first segment; existing segments of the same base are replaced
+    bool open(const std::string& base_path, size_t segment_size = DEFAULT_SEGMENT_SIZE);
+    void start();
+    void stop();
+    
+    void setWaitStrategy(WaitStrategyType type) { wait_strategy_ = type; }
+    
+    // Copy the payload the message was decoded from into the calling thread's
+    // ring, stamped with the message's receive time and connection; false (and
+    // counted) if the ring is full or the payload does not fit a record
+    bool append(const Message& message, const char* data, size_t length);
+    
+    size_t getRecordCount() const { return record_count_.load(std::memory_order_relaxed); }
+    size_t getDropCount() const { return drop_count_.load(std::memory_order_relaxed); }
+    size_t getSegmentCount() const { return segment_index_; }
+    
+    static std::string segmentPath(const std::string& base_path, uint64_t index);
+    
+    static constexpr size_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+    
+private:
+    // Fixed-size handoff entry; inbound messages are all fixed layout, so
+    // only frames padded well past theirs are dropped
+    struct Entry {
+        static constexpr size_t MAX_PAYLOAD = 128;
+        
+        uint64_t receive_ns;
+        uint64_t connection_id;
+        uint32_t length;
+        char payload[MAX_PAYLOAD];
+    };
+    
+    void writerLoop();
+    void write(const Entry& entry);
+    bool openSegment();
+    void closeSegment();
+    
+    std::string base_path_;
+    size_t segment_size_{DEFAULT_SEGMENT_SIZE};
+    
+    // Writer state
+    int fd_{-1};
+    char* base_{nullptr};
+    size_t offset_{0};
+    uint64_t segment_index_{0};
+    
+    PerThreadSpscFanIn<Entry> inbound_;
+    WaitNotifier notifier_;
+    WaitStrategyType wait_strategy_{WaitStrategyType::SPIN_PARK};
+    
+    std::thread writer_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> record_count_{0};
+    std::atomic<size_t> drop_count_{0};
+    
+    static constexpr size_t PRODUCER_QUEUE_CAPACITY = 8192;
+    static constexpr size_t MAX_BATCH = 256;
+};
+
+// Sequential reader over a journal's segments, for replay
+class JournalReader {
+public:
+    JournalReader() = default;
+    ~JournalReader();
+    
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+    
+    // Accepts the base path or the path of its first segment
+    bool open(const std::string& path);
+    
+    // False at the end of the journal; the record is valid until the next call
+    bool next(JournalRecord& record);
+    
+    size_t getSegmentCount() const { return segment_index_; }
+    
+private:
+    bool mapSegment(uint64_t index);
+    void unmapSegment();
+    
+    std::string base_path_;
+    const char* base_{nullptr};
+    size_t size_{0};
+    size_t offset_{0};
+    uint64_t segment_index_{0};
+};
+
+} // namespace hft
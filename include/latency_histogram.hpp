@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "../include/thread_slot.hpp"
+
+namespace hft {
+
+// Log-linear (HDR-style) histogram of nanosecond values. Values below 128
+// are exact; above that each power of two is split into 64 buckets, so
+// any recorded value is reported within 1.6%. Fixed 18KB footprint.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 7;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;
+    static constexpr uint64_t HALF_COUNT = SUB_BUCKET_COUNT / 2;
+    static constexpr unsigned MAX_SHIFT = 34;                  // Values clamp at ~2^40 ns (18 minutes)
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT + MAX_SHIFT * HALF_COUNT;
+    
+    LatencyHistogram() { reset(); }
+    
+    void record(uint64_t value_ns) { recordCount(value_ns, 1); }
+    void recordCount(uint64_t value_ns, uint64_t count);
+    void merge(const LatencyHistogram& other);
+    void subtract(const LatencyHistogram& baseline);
+    void reset();
+    
+    // Upper edge of the bucket holding the given quantile, q in [0, 1]
+    uint64_t percentile(double q) const;
+    uint64_t min() const;
+    uint64_t max() const;
+    double mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+    uint64_t count() const { return count_; }
+    uint64_t sum() const { return sum_; }
+    
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketLower(size_t index);
+    static uint64_t bucketUpper(size_t index);
+    
+    uint64_t bucketCount(size_t index) const { return counts_[index]; }
+
+private:
+    friend class ConcurrentHistogram;
+    
+    uint64_t counts_[BUCKET_COUNT];
+    uint64_t count_;
+    uint64_t sum_;
+};
+
+// LatencyHistogram sharded by thread slot. record() touches only the
+// calling thread's shard (relaxed single-writer stores, no RMW, no shared
+// cache lines), and snapshot() merges every shard without stopping writers.
+class ConcurrentHistogram {
+public:
+    ConcurrentHistogram();
+    ~ConcurrentHistogram();
+    
+    ConcurrentHistogram(const ConcurrentHistogram&) = delete;
+    ConcurrentHistogram& operator=(const ConcurrentHistogram&) = delete;
+    
+    void record(uint64_t value_ns);
+    
+    // Merged view of everything recorded since construction or reset()
+    void snapshot(LatencyHistogram& out) const;
+    
+    // Readers mark a baseline; writers keep counting undisturbed
+    void reset();
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> counts[LatencyHistogram::BUCKET_COUNT];
+        std::atomic<uint64_t> sum;
+        Shard();
+    };
+    
+    Shard& localShard();
+    void collect(LatencyHistogram& out) const;
+    
+    std::atomic<Shard*> shards_[MAX_THREAD_SLOTS];
+    LatencyHistogram baseline_;
+    mutable std::mutex baseline_mutex_;     // Readers only
+};
+
+} // namespace hft
@@ -4,33 +4,15 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <chrono>
 #include <atomic> // Added for atomic sequence counter
+#include "../include/wire_format.hpp"
+#include "../include/symbol_registry.hpp"
+#include "../include/pipeline_trace.hpp"
 
 namespace hft {
 
-// Message types for HFT system
-enum class MessageType : uint8_t {
-    ORDER_NEW = 1,
-    ORDER_CANCEL = 2,
-    ORDER_REPLACE = 3,
-    ORDER_FILL = 4,
-    MARKET_DATA = 5,
-    HEARTBEAT = 6,
-    LOGIN = 7,
-    LOGOUT = 8,
-    ERROR = 9
-};
-
-// Message priority levels
-enum class MessagePriority : uint8_t {
-    LOW = 1,
-    NORMAL = 2,
-    HIGH = 3,
-    CRITICAL = 4
-};
-
-// Base message class
+// Base message class. Default-constructed messages (the decode path) are
+// left unstamped; value constructors stamp a timestamp and sequence number.
 class Message {
 public:
     Message(MessageType type, MessagePriority priority = MessagePriority::NORMAL);
@@ -43,18 +25,31 @@ public:
     uint64_t getTimestamp() const { return timestamp_; }
     uint64_t getClientId() const { return client_id_; }
     
+    // Server connection the message arrived on; local routing state, never on the wire
+    uint64_t getConnectionId() const { return connection_id_; }
+    void setConnectionId(uint64_t connection_id) { connection_id_ = connection_id; }
+    
     // Setters
     void setSequenceNumber(uint64_t seq) { sequence_number_ = seq; }
     void setClientId(uint64_t client_id) { client_id_ = client_id; }
     void setTimestamp(uint64_t ts) { timestamp_ = ts; }
     
     // Serialization
-    virtual std::vector<uint8_t> serialize() const = 0;
-    virtual bool deserialize(const std::vector<uint8_t>& data) = 0;
+    std::vector<uint8_t> serialize() const;
+    bool deserialize(const std::vector<uint8_t>& data);
     
-    // Performance tracking
-    void setReceiveTime(std::chrono::high_resolution_clock::time_point time) { receive_time_ = time; }
-    std::chrono::high_resolution_clock::time_point getReceiveTime() const { return receive_time_; }
+    // Encode into a caller-provided buffer of at least serializedSize() bytes
+    virtual size_t serializedSize() const = 0;
+    virtual size_t serializeInto(char* buf) const = 0;
+    virtual bool deserialize(const char* data, size_t length) = 0;
+    
+    // TscClock reading taken when the message was decoded
+    void setReceiveTicks(uint64_t ticks) { receive_ticks_ = ticks; }
+    uint64_t getReceiveTicks() const { return receive_ticks_; }
+    
+    // Stage stamps on the way through the server; local state, never on the wire
+    PipelineTrace& trace() { return trace_; }
+    const PipelineTrace& trace() const { return trace_; }
 
 protected:
     MessageType type_;
@@ -62,7 +57,15 @@ protected:
     uint64_t sequence_number_;
     uint64_t timestamp_;
     uint64_t client_id_;
-    std::chrono::high_resolution_clock::time_point receive_time_;
+    uint64_t connection_id_;
+    uint64_t receive_ticks_;
+    PipelineTrace trace_;
+    
+    // Originating side only: reads the clock and the shared sequence counter
+    void stamp();
+    
+    void encodeHeader(wire::Header& header) const;
+    void decodeHeader(const wire::Header& header);
     
     static std::atomic<uint64_t> global_sequence_counter_;
 };
@@ -76,17 +79,31 @@ public:
     // Getters
     uint64_t getOrderId() const { return order_id_; }
     std::string getSymbol() const { return symbol_; }
+    SymbolId getSymbolId() const { return symbol_id_; }
     double getPrice() const { return price_; }
     uint32_t getQuantity() const { return quantity_; }
     bool isBuy() const { return is_buy_; }
     
+    // Setters; the type may be any of the ORDER_* family
+    void setType(MessageType type) { type_ = type; }
+    void setOrderId(uint64_t order_id) { order_id_ = order_id; }
+    // Setting the text resolves the id; setSymbolId takes the name from the registry
+    void setSymbol(const std::string& symbol);
+    void setSymbolId(SymbolId symbol_id);
+    void setPrice(double price) { price_ = price; }
+    void setQuantity(uint32_t quantity) { quantity_ = quantity; }
+    void setBuy(bool is_buy) { is_buy_ = is_buy; }
+    
     // Serialization
-    std::vector<uint8_t> serialize() const override;
-    bool deserialize(const std::vector<uint8_t>& data) override;
+    using Message::deserialize;
+    size_t serializedSize() const override;
+    size_t serializeInto(char* buf) const override;
+    bool deserialize(const char* data, size_t length) override;
 
 private:
     uint64_t order_id_;
     std::string symbol_;
+    SymbolId symbol_id_;
     double price_;
     uint32_t quantity_;
     bool is_buy_;
@@ -100,17 +117,21 @@ public:
     
     // Getters
     std::string getSymbol() const { return symbol_; }
+    SymbolId getSymbolId() const { return symbol_id_; }
     double getBid() const { return bid_; }
     double getAsk() const { return ask_; }
     uint32_t getBidSize() const { return bid_size_; }
     uint32_t getAskSize() const { return ask_size_; }
     
     // Serialization
-    std::vector<uint8_t> serialize() const override;
-    bool deserialize(const std::vector<uint8_t>& data) override;
+    using Message::deserialize;
+    size_t serializedSize() const override;
+    size_t serializeInto(char* buf) const override;
+    bool deserialize(const char* data, size_t length) override;
 
 private:
     std::string symbol_;
+    SymbolId symbol_id_;
     double bid_;
     double ask_;
     uint32_t bid_size_;
@@ -124,8 +145,10 @@ public:
     HeartbeatMessage(uint64_t client_id);
     
     // Serialization
-    std::vector<uint8_t> serialize() const override;
-    bool deserialize(const std::vector<uint8_t>& data) override;
+    using Message::deserialize;
+    size_t serializedSize() const override;
+    size_t serializeInto(char* buf) const override;
+    bool deserialize(const char* data, size_t length) override;
 };
 
 // Error message
@@ -139,25 +162,185 @@ public:
     std::string getErrorMessage() const { return error_message_; }
     
     // Serialization
-    std::vector<uint8_t> serialize() const override;
-    bool deserialize(const std::vector<uint8_t>& data) override;
+    using Message::deserialize;
+    size_t serializedSize() const override;
+    size_t serializeInto(char* buf) const override;
+    bool deserialize(const char* data, size_t length) override;
 
 private:
     uint32_t error_code_;
     std::string error_message_;
 };
 
-// Message factory for creating messages from serialized data
+// Acknowledgement of an order request
+class OrderAckMessage : public Message {
+public:
+    OrderAckMessage();
+    // Acknowledges order, echoing its sequence number and timestamp
+    OrderAckMessage(const OrderMessage& order, AckStatus status, uint8_t reason = 0);
+    
+    // Getters
+    uint64_t getOrderId() const { return order_id_; }
+    uint64_t getClientSequence() const { return client_sequence_; }
+    uint64_t getClientTimestamp() const { return client_timestamp_; }
+    SymbolId getSymbolId() const { return symbol_id_; }
+    AckStatus getStatus() const { return status_; }
+    uint8_t getReason() const { return reason_; }
+    MessageType getOrderType() const { return order_type_; }
+    
+    // Serialization
+    using Message::deserialize;
+    size_t serializedSize() const override;
+    size_t serializeInto(char* buf) const override;
+    bool deserialize(const char* data, size_t length) override;
+
+private:
+    uint64_t order_id_;
+    uint64_t client_sequence_;
+    uint64_t client_timestamp_;
+    SymbolId symbol_id_;
+    AckStatus status_;
+    uint8_t reason_;
+    MessageType order_type_;
+};
+
+// Session login; the server replies with one carrying the granted interval
+class LoginMessage : public Message {
+public:
+    LoginMessage();
+    LoginMessage(uint64_t client_id, uint32_t heartbeat_interval_ms, const std::string& credentials = "");
+    
+    // Getters
+    uint32_t getHeartbeatIntervalMs() const { return heartbeat_interval_ms_; }
+    std::string getCredentials() const { return credentials_; }
+    uint32_t getFlags() const { return flags_; }
+    
+    // Setters
+    void setHeartbeatIntervalMs(uint32_t interval_ms) { heartbeat_interval_ms_ = interval_ms; }
+    void setFlags(uint32_t flags) { flags_ = flags; }
+    
+    // Serialization
+    using Message::deserialize;
+    size_t serializedSize() const override;
+    size_t serializeInto(char* buf) const override;
+    bool deserialize(const char* data, size_t length) override;
+    
+private:
+    uint32_t heartbeat_interval_ms_;
+    uint32_t flags_;
+    std::string credentials_;
+};
+
+// Session logout, sent by either side
+class LogoutMessage : public Message {
+public:
+    LogoutMessage();
+    LogoutMessage(uint64_t client_id, LogoutReason reason);
+    
+    // Getters
+    LogoutReason getReason() const { return reason_; }
+    
+    // Serialization
+    using Message::deserialize;
+    size_t serializedSize() const override;
+    size_t serializeInto(char* buf) const override;
+    bool deserialize(const char* data, size_t length) override;
+    
+private:
+    LogoutReason reason_;
+};
+
+// Flyweight views reading fields straight out of a receive buffer.
+// Views never copy or allocate; the buffer must outlive the view.
+class MessageView {
+public:
+    MessageView(const char* data, size_t length) : data_(data), length_(length) {}
+    
+    bool valid() const {
+        return data_ && length_ >= wire::HEADER_SIZE &&
+               wire::isSupportedVersion(static_cast<uint8_t>(data_[wire::VERSION_OFFSET]));
+    }
+    
+    uint8_t getVersion() const { return static_cast<uint8_t>(data_[wire::VERSION_OFFSET]); }    
+    MessageType getType() const { return static_cast<MessageType>(data_[wire::TYPE_OFFSET]); }
+    MessagePriority getPriority() const { return static_cast<MessagePriority>(data_[wire::PRIORITY_OFFSET]); }
+    uint64_t getSequenceNumber() const { return wire::load<uint64_t>(data_, wire::SEQUENCE_OFFSET); }
+    uint64_t getTimestamp() const { return wire::load<uint64_t>(data_, wire::TIMESTAMP_OFFSET); }
+    uint64_t getClientId() const { return wire::load<uint64_t>(data_, wire::CLIENT_ID_OFFSET); }
+    
+    const char* data() const { return data_; }
+    size_t length() const { return length_; }
+
+protected:
+    const char* data_;
+    size_t length_;
+};
+
+class OrderView : public MessageView {
+public:
+    static constexpr size_t ORDER_ID_OFFSET = offsetof(wire::Order, order_id);
+    static constexpr size_t SYMBOL_OFFSET = offsetof(wire::Order, symbol);
+    static constexpr size_t PRICE_OFFSET = offsetof(wire::Order, price);
+    static constexpr size_t QUANTITY_OFFSET = offsetof(wire::Order, quantity);
+    static constexpr size_t SIDE_OFFSET = offsetof(wire::Order, is_buy);
+    static constexpr size_t SYMBOL_ID_OFFSET = offsetof(wire::Order, symbol_id);
+    static constexpr size_t SIZE = sizeof(wire::Order);
+    static constexpr size_t MIN_SIZE = wire::MinSize<wire::Order>::value;
+    
+    OrderView(const char* data, size_t length) : MessageView(data, length) {}
+    
+    bool valid() const;
+    
+    uint64_t getOrderId() const { return wire::load<uint64_t>(data_, ORDER_ID_OFFSET); }
+    const char* getSymbolData() const { return data_ + SYMBOL_OFFSET; }
+    size_t getSymbolLength() const;
+    double getPrice() const { return wire::load<double>(data_, PRICE_OFFSET); }
+    uint32_t getQuantity() const { return wire::load<uint32_t>(data_, QUANTITY_OFFSET); }
+    bool isBuy() const { return data_[SIDE_OFFSET] != 0; }
+    
+    // Id carried on the wire, 0 for v1 frames or senders without reference data
+    SymbolId getSymbolId() const {
+        return length_ >= SIZE ? wire::load<uint32_t>(data_, SYMBOL_ID_OFFSET) : INVALID_SYMBOL_ID;
+    }
+    // Wire id, falling back to a registry lookup of the symbol text
+    SymbolId resolveSymbolId() const;
+};
+
+class MarketDataView : public MessageView {
+public:
+    static constexpr size_t SYMBOL_OFFSET = offsetof(wire::MarketData, symbol);
+    static constexpr size_t BID_OFFSET = offsetof(wire::MarketData, bid);
+    static constexpr size_t ASK_OFFSET = offsetof(wire::MarketData, ask);
+    static constexpr size_t BID_SIZE_OFFSET = offsetof(wire::MarketData, bid_size);
+    static constexpr size_t ASK_SIZE_OFFSET = offsetof(wire::MarketData, ask_size);
+    static constexpr size_t SYMBOL_ID_OFFSET = offsetof(wire::MarketData, symbol_id);
+    static constexpr size_t SIZE = sizeof(wire::MarketData);
+    static constexpr size_t MIN_SIZE = wire::MinSize<wire::MarketData>::value;
+    
+    MarketDataView(const char* data, size_t length) : MessageView(data, length) {}
+    
+    bool valid() const;
+    
+    const char* getSymbolData() const { return data_ + SYMBOL_OFFSET; }
+    size_t getSymbolLength() const;
+    double getBid() const { return wire::load<double>(data_, BID_OFFSET); }
+    double getAsk() const { return wire::load<double>(data_, ASK_OFFSET); }
+    uint32_t getBidSize() const { return wire::load<uint32_t>(data_, BID_SIZE_OFFSET); }
+    uint32_t getAskSize() const { return wire::load<uint32_t>(data_, ASK_SIZE_OFFSET); }
+    
+    SymbolId getSymbolId() const {
+        return length_ >= SIZE ? wire::load<uint32_t>(data_, SYMBOL_ID_OFFSET) : INVALID_SYMBOL_ID;
+    }
+    SymbolId resolveSymbolId() const;
+};
+
+// Message factory for creating messages from serialized data. These are
+// heap-allocated; the receive path decodes into MessagePool instead.
 class MessageFactory {
 public:
     static std::shared_ptr<Message> createMessage(const std::vector<uint8_t>& data);
+    static std::shared_ptr<Message> createMessage(const char* data, size_t length);
     static std::shared_ptr<Message> createMessage(MessageType type);
-    
-private:
-    static std::shared_ptr<Message> createOrderMessage(const std::vector<uint8_t>& data);
-    static std::shared_ptr<Message> createMarketDataMessage(const std::vector<uint8_t>& data);
-    static std::shared_ptr<Message> createHeartbeatMessage(const std::vector<uint8_t>& data);
-    static std::shared_ptr<Message> createErrorMessage(const std::vector<uint8_t>& data);
 };
 
 } // namespace hft 
\ No newline at end of file
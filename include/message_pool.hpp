@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "../include/message.hpp"
+#include "../include/ring_queue.hpp"
+
+namespace hft {
+
+class MessagePool;
+
+// Move-only owner of a pooled message. Destruction hands the message back
+// to the pool that allocated it; no reference count is kept. A handle
+// without a pool owns a plain heap message and deletes it.
+class MessageHandle {
+public:
+    MessageHandle() : message_(nullptr), pool_(nullptr) {}
+    MessageHandle(Message* message, MessagePool* pool) : message_(message), pool_(pool) {}
+    ~MessageHandle() { reset(); }
+    
+    MessageHandle(MessageHandle&& other) noexcept : message_(other.message_), pool_(other.pool_) {
+        other.message_ = nullptr;
+    }
+    
+    MessageHandle& operator=(MessageHandle&& other) noexcept {
+        if (this != &other) {
+            reset();
+            message_ = other.message_;
+            pool_ = other.pool_;
+            other.message_ = nullptr;
+        }
+        return *this;
+    }
+    
+    MessageHandle(const MessageHandle&) = delete;
+    MessageHandle& operator=(const MessageHandle&) = delete;
+    
+    Message* get() const { return message_; }
+    Message& operator*() const { return *message_; }
+    Message* operator->() const { return message_; }
+    explicit operator bool() const { return message_ != nullptr; }
+    
+    void reset();
+
+private:
+    Message* message_;
+    MessagePool* pool_;
+};
+
+// Per-thread free lists of message objects. A message released on its
+// owning thread goes straight back on the free list; one released on any
+// other thread travels back through the owner's MPSC return queue and is
+// reclaimed on the owner's next acquire. Pools are never freed: when a
+// thread exits its pool is parked and adopted by the next thread that
+// asks, so late cross-thread returns always land in live memory.
+class MessagePool {
+public:
+    static constexpr size_t PREALLOCATED_PER_TYPE = 256;
+    static constexpr size_t RETURN_QUEUE_CAPACITY = 16384;
+    
+    // Pool owned by the calling thread
+    static MessagePool& local();
+    
+    // Message reset to its default state; empty handle for unpooled types
+    MessageHandle acquire(MessageType type);
+    
+    // Decode a wire payload into a pooled message; empty handle on failure
+    MessageHandle decode(const char* data, size_t length);
+    
+    void release(Message* message);
+    
+    // Objects created by this pool over its lifetime; flat once warmed up
+    size_t allocatedCount() const { return allocated_; }
+
+private:
+    enum Kind { ORDER, MARKET_DATA, HEARTBEAT, ERROR_MSG, KIND_COUNT };
+    
+    MessagePool();
+    ~MessagePool() = delete;
+    MessagePool(const MessagePool&) = delete;
+    MessagePool& operator=(const MessagePool&) = delete;
+    
+    static int kindOf(MessageType type);
+    static Message* create(int kind);
+    
+    Message* take(int kind);
+    void recycle(Message* message);
+    void reclaimReturns();
+    
+    static MessagePool* adopt();
+    static void park(MessagePool* pool);
+    
+    struct LocalSlot {
+        MessagePool* pool{nullptr};
+        ~LocalSlot();
+    };
+    static thread_local LocalSlot local_;
+    
+    std::vector<Message*> free_[KIND_COUNT];
+    MpscQueue<Message*> returns_;
+    size_t allocated_{0};
+};
+
+} // namespace hft
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+namespace hft {
+
+// Trade between an incoming (taker) order and a resting (maker) order
+struct Execution {
+    uint64_t taker_order_id;
+    uint64_t maker_order_id;
+    uint64_t taker_client_id;
+    uint64_t maker_client_id;
+    double price;
+    uint32_t quantity;
+    uint32_t taker_remaining;
+    uint32_t maker_remaining;
+    bool taker_is_buy;
+};
+
+enum class BookResult : uint8_t {
+    OK = 0,
+    DUPLICATE_ORDER_ID = 1,
+    UNKNOWN_ORDER_ID = 2,
+    PRICE_OUT_OF_RANGE = 3,
+    BOOK_FULL = 4,
+    INVALID_QUANTITY = 5
+};
+
+const char* bookResultName(BookResult result);
+
+// Snapshot of a resting order's remaining state
+struct RestingOrder {
+    uint64_t client_id;
+    double price;
+    uint32_t quantity;
+    bool is_buy;
+};
+
+// Open-addressing order id -> node index map with backward-shift deletion.
+// Sized once; never allocates afterwards.
+class FlatOrderIndex {
+public:
+    explicit FlatOrderIndex(size_t max_orders);
+    
+    bool insert(uint64_t order_id, uint32_t node);
+    bool find(uint64_t order_id, uint32_t& node) const;
+    bool erase(uint64_t order_id);
+    size_t size() const { return size_; }
+
+private:
+    struct Entry {
+        uint64_t order_id;   // 0 marks an empty slot
+        uint32_t node;
+    };
+    
+    size_t slotFor(uint64_t order_id) const;
+    
+    std::vector<Entry> entries_;
+    size_t mask_;
+    size_t size_{0};
+};
+
+// Price-time priority limit order book for one symbol.
+// Prices are integer ticks inside a fixed window around a reference
+// price; each tick has a FIFO level built from intrusive links into a
+// preallocated node pool, so steady-state operation never allocates.
+class OrderBook {
+public:
+    typedef std::function<void(const Execution&)> ExecutionCallback;
+    
+    OrderBook(double reference_price, double tick_size = 0.01,
+              size_t price_levels = 4096, size_t max_orders = 65536);
+    
+    void setExecutionCallback(ExecutionCallback callback) { execution_callback_ = callback; }
+    
+    // Match against the opposite side, rest any remainder
+    BookResult addOrder(uint64_t order_id, uint64_t client_id, bool is_buy, double price, uint32_t quantity);
+    BookResult cancelOrder(uint64_t order_id);
+    
+    // Quantity reductions at the same price keep queue priority; anything
+    // else is cancel/replace and may trade
+    BookResult replaceOrder(uint64_t order_id, double new_price, uint32_t new_quantity);
+    
+    // Top of book; false if that side is empty
+    bool bestBid(double& price, uint64_t& quantity) const;
+    bool bestAsk(double& price, uint64_t& quantity) const;
+    
+    // False if the order is not resting (unknown, filled or cancelled)
+    bool findOrder(uint64_t order_id, RestingOrder& order) const;
+    
+    size_t orderCount() const { return index_.size(); }
+
+private:
+    static constexpr uint32_t NIL = 0xFFFFFFFFu;
+    
+    struct OrderNode {
+        uint64_t order_id;
+        uint64_t client_id;
+        uint32_t level;
+        uint32_t quantity;
+        uint32_t prev;
+        uint32_t next;
+        bool is_buy;
+    };
+    
+    struct PriceLevel {
+        uint32_t head{NIL};
+        uint32_t tail{NIL};
+        uint64_t total_quantity{0};
+    };
+    
+    bool toLevel(double price, uint32_t& level) const;
+    double toPrice(uint32_t level) const;
+    
+    uint32_t match(uint64_t order_id, uint64_t client_id, bool is_buy, uint32_t level, uint32_t quantity);
+    BookResult rest(uint64_t order_id, uint64_t client_id, bool is_buy, uint32_t level, uint32_t quantity);
+    void unlink(uint32_t node_index);
+    void updateBestAfterRemoval(bool is_buy, uint32_t level);
+    
+    double tick_size_;
+    int64_t base_tick_;
+    
+    std::vector<PriceLevel> bids_;
+    std::vector<PriceLevel> asks_;
+    int64_t best_bid_{-1};      // Level index, -1 when empty
+    int64_t best_ask_;          // Level index, price_levels when empty
+    
+    std::vector<OrderNode> nodes_;
+    uint32_t free_head_;
+    FlatOrderIndex index_;
+    
+    ExecutionCallback execution_callback_;
+};
+
+} // namespace hft
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct iovec;
+
+namespace hft {
+
+// Per-connection send ring owned by one reactor. Frames are appended as
+// they are produced and flushed with a single sendmsg() per reactor cycle,
+// so syscalls scale with batches rather than messages. A flush that hits
+// EAGAIN leaves the rest queued for EPOLLOUT instead of blocking.
+//
+// With zero-copy enabled, large flushes use MSG_ZEROCOPY. The kernel then
+// reads straight from the ring, so those bytes stay reserved until the
+// completion arrives on the socket error queue.
+class OutboundBuffer {
+public:
+    static constexpr size_t CAPACITY = 65536;              // Power of two
+    static constexpr size_t ZEROCOPY_THRESHOLD = 16384;    // Below this copying is cheaper
+    static constexpr size_t MAX_ZEROCOPY_INFLIGHT = 64;
+    
+    enum FlushResult {
+        FLUSH_DONE,       // Everything handed to the kernel
+        FLUSH_BLOCKED,    // Socket full; wait for EPOLLOUT
+        FLUSH_ERROR       // Connection is broken
+    };
+    
+    OutboundBuffer();
+    
+    // False if the ring cannot hold the whole frame; nothing is written then
+    bool append(const char* data, size_t length);
+    
+    FlushResult flush(int fd, bool zerocopy);
+    
+    // For asynchronous senders: describe the pending bytes (at most two runs
+    // of the ring) and retire them once the kernel reports them sent. Bytes
+    // stay in place between the two calls; only appends touch the ring.
+    size_t peek(struct iovec* iov) const;
+    void consume(size_t length);
+    
+    // Drain zero-copy completions from the socket error queue; returns the
+    // number of notifications read
+    size_t reapCompletions(int fd);
+    
+    size_t pending() const { return static_cast<size_t>(tail_ - head_); }
+    // Ring space in use, including sent bytes still pinned by zero-copy
+    size_t queued() const { return static_cast<size_t>(tail_ - released_); }
+    bool empty() const { return tail_ == head_; }
+    
+    size_t sendCalls() const { return send_calls_; }
+    size_t zerocopySends() const { return zerocopy_sends_; }
+
+private:
+    struct ZeroCopySend {
+        uint32_t id;          // Kernel's per-socket zero-copy counter
+        uint64_t start;
+        uint64_t end;
+    };
+    
+    void complete(uint32_t last_id);
+    void updateReleased();
+    
+    std::vector<char> data_;  // Allocated on first append
+    uint64_t head_{0};        // Next byte to send
+    uint64_t tail_{0};        // Next byte to write
+    uint64_t released_{0};    // Everything before this may be overwritten
+    
+    ZeroCopySend inflight_[MAX_ZEROCOPY_INFLIGHT];
+    size_t inflight_head_{0};
+    size_t inflight_count_{0};
+    uint32_t next_zerocopy_id_{0};
+    
+    size_t send_calls_{0};
+    size_t zerocopy_sends_{0};
+};
+
+} // namespace hft
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include "../include/singleton.hpp"
+#include "../include/ring_queue.hpp"
+#include "../include/latency_histogram.hpp"
+#include "../include/tsc_clock.hpp"
+
+namespace hft {
+
+// Points along the inbound path where a message is stamped, in pipeline
+// order. Each stage is timed from the last stage stamped before it.
+enum class TraceStage : uint8_t {
+    WIRE = 0,       // Kernel or NIC receive timestamp, when enabled
+    READ,           // Socket read returned
+    DECODE,         // Message decoded from the frame
+    INTERCEPT,      // Validation and throttling passed
+    RISK,           // Pre-trade risk check done
+    ACK,            // Ack queued on the connection
+    DEQUEUE,        // Popped by the matching shard
+    MATCH,          // Matching done
+    STAGE_COUNT
+};
+
+constexpr size_t TRACE_STAGE_COUNT = static_cast<size_t>(TraceStage::STAGE_COUNT);
+
+const char* traceStageName(TraceStage stage);
+
+// Fixed array of TscClock stamps carried by a message through the
+// pipeline; a zero stamp means the message never reached that stage.
+struct PipelineTrace {
+    uint64_t ticks[TRACE_STAGE_COUNT];
+    
+    PipelineTrace() { reset(); }
+    
+    void reset() {
+        for (auto& stamp : ticks) {
+            stamp = 0;
+        }
+    }
+    
+    void mark(TraceStage stage) { ticks[static_cast<size_t>(stage)] = TscClock::now(); }
+    void mark(TraceStage stage, uint64_t stamp) { ticks[static_cast<size_t>(stage)] = stamp; }
+    uint64_t at(TraceStage stage) const { return ticks[static_cast<size_t>(stage)]; }
+};
+
+// Aggregates completed traces into one histogram per stage plus an
+// end-to-end one. record() is called by whichever thread finishes the
+// message (the reactor, or the matching shard for accepted orders) and only
+// touches that thread's histogram shards. With a trace file open, every
+// Nth trace per thread is also copied into that thread's SPSC ring and
+// written out by flushSamples(), which the owner calls periodically.
+class PipelineTracer : public Singleton<PipelineTracer> {
+public:
+    friend class Singleton<PipelineTracer>;
+    
+    ~PipelineTracer() override;
+    
+    // One line per sampled message; sample_every 1 traces everything
+    bool openTraceFile(const std::string& path, size_t sample_every = DEFAULT_SAMPLE_EVERY);
+    void closeTraceFile();
+    
+    void record(const PipelineTrace& trace, uint64_t sequence, uint64_t client_id, uint8_t type);
+    
+    // Writes out the sampled traces queued so far; single caller
+    size_t flushSamples();
+    
+    // Time spent reaching the stage from the previous stamped one
+    void getStageSnapshot(TraceStage stage, LatencyHistogram& out) const;
+    // First to last stamp of each trace
+    void getTotalSnapshot(LatencyHistogram& out) const { total_.snapshot(out); }
+    
+    size_t getSampleDropCount() const { return sample_drops_.load(std::memory_order_relaxed); }
+    
+    void printStats() const;
+    
+    static constexpr size_t DEFAULT_SAMPLE_EVERY = 1024;
+    
+protected:
+    PipelineTracer();
+    
+private:
+    struct Sample {
+        uint64_t sequence;
+        uint64_t client_id;
+        uint8_t type;
+        PipelineTrace trace;
+    };
+    
+    void write(const Sample& sample);
+    
+    ConcurrentHistogram stages_[TRACE_STAGE_COUNT];
+    ConcurrentHistogram total_;
+    
+    PerThreadSpscFanIn<Sample> samples_;
+    std::atomic<size_t> sample_every_{0};                           // 0 while no file is open
+    std::atomic<size_t> sample_drops_{0};
+    FILE* out_{nullptr};
+    
+    static constexpr size_t SAMPLE_QUEUE_CAPACITY = 4096;
+};
+
+} // namespace hft
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "../include/symbol_registry.hpp"
+#include "../include/ring_queue.hpp"
+
+namespace hft {
+
+// Latest quote for one symbol
+struct TopOfBook {
+    double bid;
+    double ask;
+    uint32_t bid_size;
+    uint32_t ask_size;
+    uint64_t timestamp;
+    uint64_t sequence;      // Updates applied to this symbol so far
+};
+
+// Latest-value top-of-book per symbol, indexed by SymbolId. Each entry is
+// a seqlock on its own cache line: readers copy and retry if a write
+// overlapped, so they never block writers or each other. Writers to the
+// same symbol serialise on the sequence word; different symbols never
+// contend.
+class QuoteCache {
+public:
+    QuoteCache();
+    
+    void update(SymbolId symbol_id, double bid, double ask,
+                uint32_t bid_size, uint32_t ask_size, uint64_t timestamp);
+    
+    // False if the symbol is out of range or has never been quoted
+    bool read(SymbolId symbol_id, TopOfBook& quote) const;
+
+private:
+    // Fields are stored as atomic words so overlapping reads are not data races
+    struct Entry {
+        std::atomic<uint64_t> sequence{0};      // Odd while a write is in progress
+        std::atomic<uint64_t> bid{0};
+        std::atomic<uint64_t> ask{0};
+        std::atomic<uint64_t> sizes{0};
+        std::atomic<uint64_t> timestamp{0};
+        char padding[CACHE_LINE_SIZE - 5 * sizeof(uint64_t)];
+    };
+    
+    std::vector<Entry> entries_;
+};
+
+} // namespace hft
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <utility>
+#include "../include/thread_slot.hpp"
+
+namespace hft {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Bounded single-producer/single-consumer ring. Head and tail live on
+// separate cache lines and each side caches the other's index so the
+// common case touches no shared line. Capacity is rounded up to a power of 2.
+template<typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : mask_(roundUp(capacity) - 1), slots_(mask_ + 1) {}
+    
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    
+    bool tryPush(T&& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool tryPush(const T& value) {
+        T copy(value);
+        return tryPush(std::move(copy));
+    }
+    
+    bool tryPop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return false;
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Hand up to max_count items to fn, publishing the new head once
+    template<typename Fn>
+    size_t popBatch(Fn&& fn, size_t max_count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        
+        size_t available = cached_tail_ - head;
+        size_t count = available < max_count ? available : max_count;
+        for (size_t i = 0; i < count; ++i) {
+            fn(std::move(slots_[(head + i) & mask_]));
+        }
+        if (count) {
+            head_.store(head + count, std::memory_order_release);
+        }
+        return count;
+    }
+    
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    static size_t roundUp(size_t value) {
+        size_t result = 2;
+        while (result < value) result <<= 1;
+        return result;
+    }
+    
+    const size_t mask_;
+    std::vector<T> slots_;
+    char pad0_[CACHE_LINE_SIZE];
+    
+    // Consumer side
+    std::atomic<size_t> head_{0};
+    size_t cached_tail_{0};
+    char pad1_[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    
+    // Producer side
+    std::atomic<size_t> tail_{0};
+    size_t cached_head_{0};
+    char pad2_[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
+
+// Many producers into one consumer without a shared tail: each producer
+// thread slot gets its own SpscQueue, created by that producer on first use.
+// The consumer scans only the slots in use, up to a batch from each per
+// pass so one busy producer cannot starve the others.
+template<typename T>
+class PerThreadSpscFanIn {
+public:
+    explicit PerThreadSpscFanIn(size_t capacity_per_producer)
+        : capacity_(capacity_per_producer), queues_(new std::atomic<SpscQueue<T>*>[MAX_THREAD_SLOTS]) {
+        for (size_t i = 0; i < MAX_THREAD_SLOTS; ++i) {
+            queues_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    
+    ~PerThreadSpscFanIn() {
+        for (size_t i = 0; i < MAX_THREAD_SLOTS; ++i) {
+            delete queues_[i].load(std::memory_order_relaxed);
+        }
+    }
+    
+    PerThreadSpscFanIn(const PerThreadSpscFanIn&) = delete;
+    PerThreadSpscFanIn& operator=(const PerThreadSpscFanIn&) = delete;
+    
+    // The calling thread's ring
+    SpscQueue<T>* producer() {
+        size_t slot = currentThreadSlot();
+        SpscQueue<T>* queue = queues_[slot].load(std::memory_order_acquire);
+        if (queue) return queue;
+        
+        // First push from this thread: publish its ring, then widen the
+        // range the consumer scans
+        queue = new SpscQueue<T>(capacity_);
+        queues_[slot].store(queue, std::memory_order_release);
+        size_t limit = producer_limit_.load(std::memory_order_relaxed);
+        while (limit < slot + 1 &&
+               !producer_limit_.compare_exchange_weak(limit, slot + 1, std::memory_order_release)) {
+        }
+        return queue;
+    }
+    
+    // Consumer only: up to max_batch items from each producer to fn
+    template<typename Fn>
+    size_t drain(Fn&& fn, size_t max_batch) {
+        size_t processed = 0;
+        size_t limit = producer_limit_.load(std::memory_order_acquire);
+        for (size_t slot = 0; slot < limit; ++slot) {
+            SpscQueue<T>* queue = queues_[slot].load(std::memory_order_acquire);
+            if (queue) {
+                processed += queue->popBatch(fn, max_batch);
+            }
+        }
+        return processed;
+    }
+    
+    // Consumer only: some producer has items waiting
+    bool pending() const {
+        size_t limit = producer_limit_.load(std::memory_order_acquire);
+        for (size_t slot = 0; slot < limit; ++slot) {
+            const SpscQueue<T>* queue = queues_[slot].load(std::memory_order_acquire);
+            if (queue && !queue->empty()) return true;
+        }
+        return false;
+    }
+
+private:
+    const size_t capacity_;
+    std::unique_ptr<std::atomic<SpscQueue<T>*>[]> queues_;   // Indexed by thread slot
+    std::atomic<size_t> producer_limit_{0};                   // Highest slot used + 1
+};
+
+// Bounded multi-producer/single-consumer ring (per-slot sequence numbers,
+// after Vyukov). Producers claim a slot with one CAS on the tail; the
+// consumer never writes a shared index other than its own head.
+template<typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity)
+        : mask_(roundUp(capacity) - 1), slots_(new Slot[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    ~MpscQueue() { delete[] slots_; }
+    
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+    
+    bool tryPush(T&& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[tail & mask_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(tail);
+            
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                tail = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    bool tryPush(const T& value) {
+        T copy(value);
+        return tryPush(std::move(copy));
+    }
+    
+    bool tryPop(T& value) {
+        Slot& slot = slots_[head_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) return false;
+        
+        value = std::move(slot.value);
+        slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+    
+    template<typename Fn>
+    size_t popBatch(Fn&& fn, size_t max_count) {
+        size_t count = 0;
+        while (count < max_count) {
+            Slot& slot = slots_[head_ & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) break;
+            
+            fn(std::move(slot.value));
+            slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+            ++head_;
+            ++count;
+        }
+        return count;
+    }
+    
+    // Consumer only: nothing published at the head
+    bool empty() const {
+        return slots_[head_ & mask_].sequence.load(std::memory_order_acquire) != head_ + 1;
+    }
+    
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    
+    static size_t roundUp(size_t value) {
+        size_t result = 2;
+        while (result < value) result <<= 1;
+        return result;
+    }
+    
+    const size_t mask_;
+    Slot* slots_;
+    char pad0_[CACHE_LINE_SIZE];
+    
+    // Producers
+    std::atomic<size_t> tail_{0};
+    char pad1_[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    
+    // Consumer only
+    size_t head_{0};
+    char pad2_[CACHE_LINE_SIZE - sizeof(size_t)];
+};
+
+} // namespace hft
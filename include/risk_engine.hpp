@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../include/symbol_registry.hpp"
+
+namespace hft {
+
+class OrderMessage;
+
+enum class RiskResult : uint8_t {
+    OK = 0,
+    UNKNOWN_SYMBOL,
+    ORDER_SIZE,          // Quantity above the symbol's max order size
+    FAT_FINGER,          // Single-order notional above the symbol limit
+    PRICE_COLLAR,        // Too far from the last market data mid
+    POSITION_LIMIT,      // Worst-case position would exceed the account limit
+    NOTIONAL_LIMIT,      // Open order notional would exceed the account limit
+    ACCOUNT_TABLE_FULL
+};
+
+const char* riskResultName(RiskResult result);
+
+struct SymbolRiskLimits {
+    uint32_t max_order_quantity{100000};
+    double max_order_notional{5000000.0};
+    double price_collar{0.10};           // Fraction of the reference price; 0 disables
+};
+
+struct AccountRiskLimits {
+    int64_t max_position{1000000};       // Absolute net shares per symbol
+    double max_open_notional{50000000.0};
+};
+
+// Pre-trade risk tables indexed by dense symbol id and dense account index.
+// checkOrder() runs on the reactor before an order is routed and reserves
+// its worst-case exposure; the matching thread converts reservations into
+// positions on fills and releases them on cancels and rejects. All hot-path
+// state is atomic, and each reservation is an add-then-verify so
+// concurrent checks on one account can never overshoot a limit.
+class RiskEngine {
+public:
+    static constexpr size_t MAX_ACCOUNTS = 1024;
+    
+    RiskEngine();
+    
+    // Configuration; apply before traffic starts
+    void setDefaultSymbolLimits(const SymbolRiskLimits& limits);
+    void setSymbolLimits(SymbolId symbol_id, const SymbolRiskLimits& limits);
+    void setDefaultAccountLimits(const AccountRiskLimits& limits) { default_account_limits_ = limits; }
+    bool setAccountLimits(uint64_t client_id, const AccountRiskLimits& limits);
+    // Registers the account ahead of its first order, e.g. at login; false when the table is full
+    bool registerAccount(uint64_t client_id) { return getAccount(client_id) != nullptr; }
+    
+    // Reserves exposure for ORDER_NEW / ORDER_REPLACE; other types pass
+    RiskResult checkOrder(const OrderMessage& order);
+    
+    // Undo a reservation for quantity that will never trade
+    void release(uint64_t client_id, SymbolId symbol_id, bool is_buy, double limit_price, uint32_t quantity);
+    
+    // Reserved quantity at limit_price became a position
+    void onFill(uint64_t client_id, SymbolId symbol_id, bool is_buy, double limit_price, uint32_t quantity);
+    
+    // Collar reference is the mid of the last quote
+    void onMarketData(SymbolId symbol_id, double bid, double ask);
+    
+    // Filled net position; 0 for unknown accounts
+    int64_t getPosition(uint64_t client_id, SymbolId symbol_id) const;
+    double getOpenNotional(uint64_t client_id) const;
+
+private:
+    struct SymbolState {
+        std::atomic<double> reference_price{0.0};
+        SymbolRiskLimits limits;
+    };
+    
+    struct PositionState {
+        std::atomic<int64_t> position{0};
+        std::atomic<int64_t> open_buy{0};
+        std::atomic<int64_t> open_sell{0};
+    };
+    
+    struct Account {
+        uint64_t client_id{0};
+        AccountRiskLimits limits;
+        std::atomic<int64_t> open_notional_cents{0};
+        std::unique_ptr<PositionState[]> positions;     // Indexed by SymbolId
+    };
+    
+    struct IndexSlot {
+        std::atomic<uint64_t> client_id{0};
+        std::atomic<uint32_t> account{0};               // 1-based, 0 when empty
+    };
+    
+    static int64_t toCents(double price) { return static_cast<int64_t>(price * 100.0 + (price >= 0 ? 0.5 : -0.5)); }
+    
+    Account* findAccount(uint64_t client_id) const;
+    Account* getAccount(uint64_t client_id);
+    size_t slotFor(uint64_t client_id) const;
+    
+    std::vector<SymbolState> symbols_;
+    std::vector<Account> accounts_;
+    std::vector<IndexSlot> index_;                      // Open addressing, 2x MAX_ACCOUNTS
+    std::atomic<size_t> account_count_{0};
+    std::mutex accounts_mutex_;                         // Registration only
+    AccountRiskLimits default_account_limits_;
+};
+
+} // namespace hft
@@ -6,15 +6,20 @@
 #include <functional>
 #include <thread>
 #include <atomic>
-#include <queue>
 #include <mutex>
-#include <condition_variable>
+#include <vector>
 #include "../include/singleton.hpp"
+#include "../include/ring_queue.hpp"
+#include "../include/wait_strategy.hpp"
+#include "../include/order_book.hpp"
+#include "../include/symbol_registry.hpp"
+#include "../include/message_pool.hpp"
+#include "../include/risk_engine.hpp"
+#include "../include/quote_cache.hpp"
+#include "../include/latency_histogram.hpp"
 
 namespace hft {
 
-// Forward declarations
-class Message;
 class IService;
 
 // Service interface
@@ -24,8 +29,27 @@ public:
     virtual void start() = 0;
     virtual void stop() = 0;
     virtual bool isRunning() const = 0;
-    virtual void processMessage(std::shared_ptr<Message> message) = 0;
+    // The message is only valid for the duration of the call; services copy
+    // whatever they keep so pooled messages can be recycled immediately.
+    // False if the service dropped a message it would have handled.
+    virtual bool processMessage(const Message& message) = 0;
     virtual std::string getName() const = 0;
+    
+    // Message types ServiceManager::publish delivers here; read once at
+    // registration. Direct sendMessage routes are not filtered.
+    virtual std::vector<MessageType> getSubscriptions() const { return {}; }
+    
+    // Idle policy for the service's own thread; applied on the next start()
+    virtual void setWaitStrategy(WaitStrategyType type) { (void)type; }
+};
+
+// Pre-resolved service route; resolve once at setup, send lock-free afterwards
+struct ServiceHandle {
+    size_t index{INVALID_INDEX};
+    
+    bool valid() const { return index != INVALID_INDEX; }
+    
+    static constexpr size_t INVALID_INDEX = static_cast<size_t>(-1);
 };
 
 // Service manager for coordinating different services
@@ -39,67 +63,243 @@ public:
     void startAllServices();
     void stopAllServices();
     
-    void sendMessage(const std::string& service_name, std::shared_ptr<Message> message);
-    void broadcastMessage(std::shared_ptr<Message> message);
+    // Idle policies for the message processor and the service threads
+    void setWaitStrategy(WaitStrategyType processor, WaitStrategyType services);
+    
+    ServiceHandle resolveService(const std::string& service_name) const;
+    
+    // Returns false if the service is unknown or its queue is full
+    bool sendMessage(ServiceHandle handle, MessageHandle message);
+    bool sendMessage(const std::string& service_name, MessageHandle message);
+    
+    // Delivers to the running services subscribed to the message's type,
+    // inline on the calling thread and without taking a lock. False if no
+    // running service took the message or one of them dropped it.
+    bool publish(const Message& message);
     
     std::shared_ptr<IService> getService(const std::string& service_name);
     
-    // Performance monitoring
+    // Performance monitoring. Latency is the time spent inside a service's
+    // processMessage per delivery, from publish() and the queued path alike;
+    // services that hand off to their own threads report the handoff.
     size_t getActiveServiceCount() const;
-    double getAverageLatency() const;
+    double getAverageLatency() const;      // Microseconds, over every active service
+    bool getServiceLatencySnapshot(const std::string& service_name, LatencyHistogram& out) const;
+    std::vector<std::string> getServiceNames() const;
 
 public:
     ~ServiceManager();
 protected:
-    ServiceManager() = default;
+    ServiceManager();
     
-    std::unordered_map<std::string, std::shared_ptr<IService>> services_;
+    // Registered service with its inbound queue; slots are never reused so
+    // handles stay valid and producers never race with registration
+    struct ServiceSlot {
+        std::shared_ptr<IService> service;
+        std::unique_ptr<MpscQueue<MessageHandle>> queue;
+        std::atomic<bool> active{false};
+        ConcurrentHistogram latency;
+    };
+    
+    std::unordered_map<std::string, ServiceHandle> service_index_;
     std::atomic<bool> running_{false};
     mutable std::mutex services_mutex_;
     
-    // Message queue for async processing
-    std::queue<std::pair<std::string, std::shared_ptr<Message>>> message_queue_;
-    std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
+    // Fixed slot table so lock-free senders never see a reallocation
+    std::vector<ServiceSlot> slots_;
+    std::atomic<size_t> slot_count_{0};
     std::thread message_processor_thread_;
     
+    WaitStrategyType processor_wait_{WaitStrategyType::SPIN_PARK};
+    WaitNotifier queue_notifier_;
+    
     void messageProcessorLoop();
-    void processMessageQueue();
+    size_t processMessageQueue();
+    
+    static constexpr size_t MAX_SERVICES = 32;
+    static constexpr size_t SERVICE_QUEUE_CAPACITY = 65536;
+    static constexpr size_t MAX_BATCH = 100;
+    static constexpr size_t MESSAGE_TYPE_SLOTS = 16;
+    
+    // Subscribers per message type. Entries are appended under the mutex
+    // and published by count, so publish() reads them lock-free.
+    struct Route {
+        ServiceSlot* subscribers[MAX_SERVICES];
+        std::atomic<size_t> count{0};
+    };
+    Route routes_[MESSAGE_TYPE_SLOTS];   // Indexed by MessageType
 };
 
 // Concrete services
+
+// Matching partitioned by symbol: shard i owns the books of every symbol
+// with id % shard_count == i and matches them on its own thread. Each
+// producer thread (in practice a reactor) gets its own SPSC ring into each
+// shard, so routing never contends, and orders for a symbol arriving on
+// one producer are matched in the order they arrived. Throughput scales
+// with the shard count as long as flow is spread over symbols.
 class OrderMatchingService : public IService {
 public:
-    OrderMatchingService();
+    typedef std::function<void(const OrderMessage&)> FillCallback;
+    
+    explicit OrderMatchingService(size_t shard_count = 1);
     ~OrderMatchingService() override;
     
     void start() override;
     void stop() override;
     bool isRunning() const override;
-    void processMessage(std::shared_ptr<Message> message) override;
+    
+    // Routes orders to the owning shard's ring for the calling thread
+    bool processMessage(const Message& message) override;
     std::string getName() const override { return "OrderMatching"; }
+    std::vector<MessageType> getSubscriptions() const override {
+        return {MessageType::ORDER_NEW, MessageType::ORDER_CANCEL, MessageType::ORDER_REPLACE};
+    }
+    void setWaitStrategy(WaitStrategyType type) override { wait_strategy_ = type; }
+    
+    // Invoked on the matching shard's thread with an ORDER_FILL for each
+    // side of every trade; shards call it concurrently, and the message is
+    // reused and only valid during the call
+    void setFillCallback(FillCallback callback) { fill_callback_ = callback; }
+    
+    // Engine whose reservations this service settles: fills become
+    // positions, and quantity that will never trade is released. Set
+    // before start(), together with a RiskInterceptor on the same engine.
+    void setRiskEngine(RiskEngine* engine) { risk_engine_ = engine; }
+    
+    size_t getShardCount() const { return shards_.size(); }
+    size_t shardFor(SymbolId symbol_id) const { return symbol_id % shards_.size(); }
+    
+    size_t getFillCount() const { return fill_count_.load(std::memory_order_relaxed); }
+    size_t getRejectCount() const { return reject_count_.load(std::memory_order_relaxed); }
 
 private:
+    // Everything a shard touches while matching; only its thread writes it
+    struct Shard {
+        Shard();
+        ~Shard();
+        
+        size_t index{0};
+        std::thread thread;
+        
+        PerThreadSpscFanIn<OrderMessage> inbound;       // One ring per producer thread
+        WaitNotifier notifier;
+        
+        std::vector<std::unique_ptr<OrderBook>> books;  // Indexed by SymbolId
+        double taker_price{0.0};                        // Limit of the order being matched
+        uint32_t taker_filled{0};
+        std::unique_ptr<OrderMessage> fill_message;
+        uint64_t fill_sequence{0};
+    };
+    
     std::atomic<bool> running_{false};
-    std::thread worker_thread_;
-    void workerLoop();
+    WaitStrategyType wait_strategy_{WaitStrategyType::SPIN_PARK};
+    void workerLoop(Shard* shard);
+    
+    void handleOrder(Shard& shard, const OrderMessage& order);
+    void releaseOrder(const OrderMessage& order, uint32_t quantity);
+    void releaseResting(const RestingOrder& order, SymbolId symbol_id);
+    OrderBook* findBook(Shard& shard, SymbolId symbol_id) const;
+    OrderBook* getBook(Shard& shard, SymbolId symbol_id, double reference_price);
+    void onExecution(Shard& shard, SymbolId symbol_id, const Execution& execution);
+    void emitFill(Shard& shard, SymbolId symbol_id, uint64_t order_id, uint64_t client_id,
+                  bool is_buy, double price, uint32_t quantity);
+    
+    std::vector<std::unique_ptr<Shard>> shards_;
+    RiskEngine* risk_engine_{nullptr};
+    
+    FillCallback fill_callback_;
+    std::atomic<size_t> fill_count_{0};
+    std::atomic<size_t> reject_count_{0};
+    
+    static constexpr size_t PRODUCER_QUEUE_CAPACITY = 16384;   // Per producer, per shard
+    static constexpr size_t MAX_BATCH = 64;
 };
 
+// Keeps the latest quote per symbol and fans it out to subscribers.
+// Delivery is conflated per subscriber: each keeps one pending flag per
+// symbol, so a subscriber that falls behind gets the newest quote for
+// each symbol it missed rather than every intermediate update, and its
+// backlog is bounded by the number of symbols.
 class MarketDataService : public IService {
 public:
+    // Called on the service thread. Return false when the subscriber cannot
+    // take the quote right now (e.g. its socket is backed up); the symbol
+    // stays pending and is redelivered, with whatever is newest, later.
+    typedef std::function<bool(SymbolId, const TopOfBook&)> QuoteSink;
+    typedef size_t SubscriberId;
+    
+    static constexpr size_t MAX_SUBSCRIBERS = 64;
+    static constexpr SubscriberId INVALID_SUBSCRIBER = static_cast<SubscriberId>(-1);
+    
     MarketDataService();
     ~MarketDataService() override;
     
     void start() override;
     void stop() override;
     bool isRunning() const override;
-    void processMessage(std::shared_ptr<Message> message) override;
+    bool processMessage(const Message& message) override;
     std::string getName() const override { return "MarketData"; }
+    std::vector<MessageType> getSubscriptions() const override { return {MessageType::MARKET_DATA}; }
+    void setWaitStrategy(WaitStrategyType type) override { wait_strategy_ = type; }
+    
+    // Quotes straight off the multicast feed, without decoding into a
+    // message; same effect as processMessage
+    void processQuote(const MarketDataView& quote);
+    
+    // Empty symbol list subscribes to everything. INVALID_SUBSCRIBER if the
+    // table is full.
+    SubscriberId subscribe(QuoteSink sink, const std::vector<SymbolId>& symbols = std::vector<SymbolId>());
+    // The sink may still be called until the service thread retires the slot,
+    // so it must not capture anything that dies with the subscriber
+    void unsubscribe(SubscriberId id);
+    
+    // Lock-free snapshot of the cache
+    bool getQuote(SymbolId symbol_id, TopOfBook& quote) const { return cache_.read(symbol_id, quote); }
+    
+    size_t getDeliveredCount() const { return delivered_count_.load(std::memory_order_relaxed); }
+    size_t getConflatedCount() const { return conflated_count_.load(std::memory_order_relaxed); }
 
 private:
+    enum SubscriberState : uint8_t {
+        SUBSCRIBER_FREE = 0,
+        SUBSCRIBER_ACTIVE,
+        SUBSCRIBER_CLOSING
+    };
+    
+    // Per-symbol subscriber flags
+    enum : uint8_t {
+        SYMBOL_SUBSCRIBED = 1u << 0,
+        SYMBOL_PENDING = 1u << 1        // Queued in pending, not yet delivered
+    };
+    
+    // Arrays are allocated on first use of the slot and kept for reuse
+    struct Subscriber {
+        std::atomic<uint8_t> state{SUBSCRIBER_FREE};
+        QuoteSink sink;
+        std::unique_ptr<std::atomic<uint8_t>[]> symbols;   // Indexed by SymbolId
+        std::unique_ptr<MpscQueue<SymbolId>> pending;      // Each symbol at most once
+    };
+    
     std::atomic<bool> running_{false};
     std::thread worker_thread_;
+    WaitStrategyType wait_strategy_{WaitStrategyType::SPIN_PARK};
     void workerLoop();
+    
+    size_t deliver(Subscriber& subscriber);
+    void retire(Subscriber& subscriber);
+    void updateQuote(SymbolId symbol_id, double bid, double ask, uint32_t bid_size, uint32_t ask_size, uint64_t timestamp);
+    
+    QuoteCache cache_;
+    std::unique_ptr<Subscriber[]> subscribers_;
+    std::atomic<size_t> subscriber_count_{0};       // High-water mark of used slots
+    std::mutex subscribers_mutex_;                  // subscribe/unsubscribe only
+    WaitNotifier notifier_;
+    
+    std::atomic<size_t> delivered_count_{0};
+    std::atomic<size_t> conflated_count_{0};
+    
+    static constexpr size_t MAX_BATCH = 64;
 };
 
 class RiskManagementService : public IService {
@@ -110,12 +310,20 @@ public:
     void start() override;
     void stop() override;
     bool isRunning() const override;
-    void processMessage(std::shared_ptr<Message> message) override;
+    bool processMessage(const Message& message) override;
     std::string getName() const override { return "RiskManagement"; }
+    std::vector<MessageType> getSubscriptions() const override { return {MessageType::MARKET_DATA}; }
+    void setWaitStrategy(WaitStrategyType type) override { wait_strategy_ = type; }
+    
+    // Checks run inline on the reactors through RiskInterceptor; this
+    // service keeps the engine's collar references current from quotes
+    RiskEngine& engine() { return engine_; }
 
 private:
+    RiskEngine engine_;
     std::atomic<bool> running_{false};
     std::thread worker_thread_;
+    WaitStrategyType wait_strategy_{WaitStrategyType::SPIN_PARK};
     void workerLoop();
 };
 
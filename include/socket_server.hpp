@@ -6,21 +6,216 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 #include <vector>
 #include <thread>
 #include <atomic>
 #include <memory>
 #include <functional>
+#include <string>
 #include <chrono>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include "../include/singleton.hpp"
+#include "../include/framing.hpp"
+#include "../include/wait_strategy.hpp"
+#include "../include/latency_histogram.hpp"
+#include "../include/outbound_buffer.hpp"
+#include "../include/ring_queue.hpp"
+#include "../include/io_uring.hpp"
+#include "../include/timer_wheel.hpp"
+#include "../include/wire_format.hpp"
 
 namespace hft {
 
 // Forward declarations
 class Message;
+class MessageView;
+class MessageHandle;
 class MessageHandler;
 class PerformanceMonitor;
+class LoginMessage;
+
+// Policy for handing accepted connections to reactors
+enum class DispatchPolicy : uint8_t {
+    ROUND_ROBIN = 1,
+    LEAST_LOADED = 2
+};
+
+// Listening socket layout
+enum class ListenMode : uint8_t {
+    SINGLE = 1,          // One listener drained by the accept thread
+    REUSEPORT = 2,       // One SO_REUSEPORT listener per reactor, kernel hash balancing
+    REUSEPORT_CPU = 3    // As REUSEPORT, steered to the reactor on the receiving CPU
+};
+
+// Readiness/IO mechanism of the reactors
+enum class IoBackend : uint8_t {
+    EPOLL = 1,           // Edge-triggered epoll with read()/sendmsg()
+    IO_URING = 2         // Multishot accept/recv and async sendmsg on a per-reactor ring
+};
+
+// Kernel receive timestamps on client sockets (SO_TIMESTAMPING)
+enum class RxTimestamping : uint8_t {
+    OFF = 0,
+    SOFTWARE = 1,        // Stamped when the stack takes the packet off the device
+    HARDWARE = 2         // NIC clock at the wire; software stamps where the NIC gives none
+};
+
+// Busy polling of the device queue from the reactor threads. Zero fields
+// keep the kernel defaults; usecs 0 also defers to the wait strategy.
+struct BusyPollConfig {
+    uint32_t usecs{0};     // SO_BUSY_POLL and the epoll busy-poll window
+    uint16_t budget{0};    // Packets per poll, SO_BUSY_POLL_BUDGET
+    bool prefer{false};    // SO_PREFER_BUSY_POLL: keep softirq processing off the queue
+};
+
+// Session layer settings. Heartbeat intervals are negotiated at LOGIN;
+// timeouts of 0 disable that check.
+struct SessionConfig {
+    bool require_login{false};                 // Application messages before LOGIN end the connection
+    uint32_t heartbeat_interval_ms{1000};       // Granted when the client asks for 0
+    uint32_t min_heartbeat_interval_ms{100};
+    uint32_t max_heartbeat_interval_ms{60000};
+    uint32_t missed_heartbeats{3};             // Silent intervals before a session is reaped
+    uint32_t login_timeout_ms{5000};           // With require_login: time allowed to send LOGIN
+    uint32_t idle_timeout_ms{0};               // Silence allowed on connections without a session
+};
+
+enum class SessionState : uint8_t {
+    CONNECTED = 1,       // Accepted, not logged in
+    ACTIVE = 2,          // Logged in; the client id is bound to the connection
+    CLOSING = 3          // LOGOUT queued; closed once the current read is handled
+};
+
+// Per-connection session, driven by the reactor's timer wheel. Times are
+// in wheel ticks (milliseconds since the reactor started).
+struct Session {
+    SessionState state{SessionState::CONNECTED};
+    uint64_t client_id{0};               // Authenticated at LOGIN
+    uint64_t last_sequence{0};           // Highest inbound sequence accepted
+    uint32_t heartbeat_interval_ms{0};   // Granted at LOGIN
+    uint64_t connected_ms{0};
+    uint64_t last_rx_ms{0};              // Last read from the client
+    uint64_t last_tx_ms{0};              // Last frame queued to the client
+    TimerWheel::Timer timer;             // Next heartbeat or timeout check; one per connection
+};
+
+// Cumulative session layer counters
+struct SessionStats {
+    size_t logins{0};
+    size_t logins_rejected{0};
+    size_t logouts{0};               // Sessions ended by a client LOGOUT
+    size_t reaped{0};                // Closed by a login, heartbeat or idle timeout
+    size_t heartbeats_sent{0};
+    size_t sequence_gaps{0};
+    size_t duplicates_dropped{0};    // Frames at or below the session's last sequence
+};
+
+// Server-assigned connection id: generation in the high 32 bits, slot in
+// the low 32, so ids of closed connections never match a live one
+typedef uint64_t ConnectionId;
+constexpr ConnectionId INVALID_CONNECTION_ID = 0;
+
+// Per-connection state owned by a reactor
+struct Connection {
+    explicit Connection(int client_fd, size_t buffer_size, ConnectionId connection_id = INVALID_CONNECTION_ID)
+        : fd(client_fd), id(connection_id), rx(buffer_size) {}
+    
+    int fd;
+    ConnectionId id;
+    FrameBuffer rx;
+    OutboundBuffer tx;
+    bool zerocopy{false};          // SO_ZEROCOPY accepted for this socket
+    bool write_blocked{false};     // Waiting on EPOLLOUT
+    bool flush_queued{false};      // Listed in Reactor::dirty this cycle
+    
+    // io_uring backend: at most one sendmsg in flight, described by these
+    bool send_inflight{false};
+    bool multishot_recv{true};     // Cleared if the kernel rejects multishot recv
+    struct msghdr send_msg;
+    struct iovec send_iov[2];
+    
+    // TscClock reading when the bytes being parsed were read
+    uint64_t read_ticks{0};
+    // Kernel receive timestamp of that read on the TscClock scale, 0 if none
+    uint64_t wire_ticks{0};
+    
+    // Last client id seen, so the route table is only touched on change
+    uint64_t routed_client_id{0};
+    bool routed{false};
+    
+    Session session;
+};
+
+// Encoded frame handed to a reactor by another thread
+struct OutboundFrame {
+    static constexpr size_t MAX_SIZE = 128;     // Largest fixed-layout message plus header
+    
+    ConnectionId connection_id;
+    uint32_t length;
+    char data[MAX_SIZE];
+};
+
+// Per-worker event loop owning its own epoll set and connections
+struct Reactor {
+    int id{0};
+    int epoll_fd{-1};
+    int wakeup_fd{-1};
+    int listen_fd{-1};   // Own listener in SO_REUSEPORT mode
+    std::atomic<size_t> connection_count{0};
+    std::atomic<uint64_t> frames_read{0};    // Written by the reactor thread only
+    
+    // Accepted fds waiting to be registered by the reactor thread
+    std::vector<int> pending_fds;
+    std::mutex pending_mutex;
+    
+    // Frames from other threads; the flag limits wakeups to one per drain
+    std::unique_ptr<MpscQueue<OutboundFrame>> outbound;
+    std::atomic<bool> outbound_signalled{false};
+    
+    // Owned by the reactor thread only
+    std::unordered_map<int, Connection> connections;
+    std::vector<std::pair<int, ConnectionId>> dirty;     // Connections to flush this cycle
+    size_t messages_queued{0};
+    
+    // Session timers in milliseconds since start_ticks; advanced once a tick has passed
+    TimerWheel timers;
+    uint64_t start_ticks{0};
+    uint64_t next_tick_ticks{0};
+    
+    // io_uring backend; null when the reactor runs on epoll
+    std::unique_ptr<IoUring> uring;
+    uint64_t wakeup_value{0};                            // eventfd read target
+    bool multishot_accept{true};                         // Cleared if the kernel rejects multishot accept
+    // Send rings of closed connections, kept until their sendmsg completes
+    std::unordered_map<ConnectionId, OutboundBuffer> retired_tx;
+};
+
+// Lock-free client id -> connection map, learned from inbound traffic
+// (and later set at login), used to route fills and other unsolicited
+// messages. Stale entries are harmless: sends to a closed id fail.
+class ClientRouteTable {
+public:
+    explicit ClientRouteTable(size_t max_clients = 16384);
+    
+    void bind(uint64_t client_id, ConnectionId connection_id);
+    ConnectionId find(uint64_t client_id) const;
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> client_id{0};
+        std::atomic<uint64_t> connection_id{INVALID_CONNECTION_ID};   // Empty until set
+    };
+    
+    size_t slotFor(uint64_t client_id) const;
+    
+    std::vector<Entry> entries_;
+    size_t mask_;
+    size_t size_{0};
+    std::mutex insert_mutex_;
+};
 
 // High-performance socket server for HFT
 class SocketServer : public Singleton<SocketServer> {
@@ -29,7 +224,8 @@ public:
     
     ~SocketServer();
     
-    bool initialize(int port, int max_connections = 10000);
+    // Thread count must be configured first when using a SO_REUSEPORT mode
+    bool initialize(int port, int max_connections = 10000, ListenMode listen_mode = ListenMode::SINGLE);
     void start();
     void stop();
     bool isRunning() const { return running_.load(); }
@@ -38,24 +234,140 @@ public:
     void setBufferSize(size_t buffer_size);
     void setThreadCount(size_t thread_count);
     void setAffinity(bool enable);
+    void setDispatchPolicy(DispatchPolicy policy);
+    void setWaitStrategy(WaitStrategyType type);
+    
+    // Set before start(). Reactors whose ring cannot be set up stay on epoll;
+    // SQPOLL trades a kernel polling thread per reactor for syscall-free submits.
+    void setIoBackend(IoBackend backend, bool sqpoll = false);
+    
+    // Message dispatch; the view is the frame as received, valid for the call
+    void setMessageCallback(std::function<void(MessageHandle, const MessageView&)> callback);
+    void setViewCallback(std::function<void(int, const MessageView&)> callback);
     
     // Statistics
     size_t getConnectionCount() const;
     double getAverageLatency() const;
     size_t getMessagesProcessed() const;
+    
+    // Merged per-reactor histogram of in-server handling time
+    void getLatencySnapshot(LatencyHistogram& out) const;
+    
+    // Per-reactor load, readable from any thread between start() and stop()
+    size_t getReactorCount() const { return reactors_.size(); }
+    size_t getReactorConnections(size_t index) const;
+    uint64_t getReactorFramesRead(size_t index) const;
+    
+    // Outbound. Safe from any thread: the owning reactor sends directly,
+    // others hand the encoded frame over. Queued output is flushed once per
+    // reactor cycle. Returns false if the connection is gone or too backed
+    // up to take the message; nothing ever blocks.
+    bool send(ConnectionId connection_id, const Message& message);
+    bool sendToClient(uint64_t client_id, const Message& message);
+    void bindClient(uint64_t client_id, ConnectionId connection_id) { routes_.bind(client_id, connection_id); }
+    
+    // Past the high watermark; callers with droppable data (quotes) should back off
+    bool isCongested(ConnectionId connection_id) const;
+    
+    // Session layer; set before start(). LOGIN, LOGOUT and HEARTBEAT frames
+    // are handled here and never reach the message callbacks. The login
+    // handler runs on the connection's reactor and decides whether a
+    // client id may log in; without one every non-zero id is accepted.
+    typedef std::function<bool(const LoginMessage&, ConnectionId)> LoginHandler;
+    // Runs on the reactor as a logged-in session's connection closes, so
+    // whatever the login handler set up for it can be torn down
+    typedef std::function<void(uint64_t client_id, ConnectionId)> SessionEndHandler;
+    void setSessionConfig(const SessionConfig& config);
+    void setLoginHandler(LoginHandler handler) { login_handler_ = std::move(handler); }
+    void setSessionEndHandler(SessionEndHandler handler) { session_end_handler_ = std::move(handler); }
+    const SessionConfig& getSessionConfig() const { return session_config_; }
+    SessionStats getSessionStats() const;
+    
+    // MSG_ZEROCOPY for flushes of at least OutboundBuffer::ZEROCOPY_THRESHOLD bytes;
+    // set before start(). Epoll reactors only.
+    void setZeroCopy(bool enable);
+    
+    // Set before start(). Hardware stamps need the interface the clients
+    // arrive on; when the NIC refuses, software stamps are used instead.
+    // Epoll reactors only: multishot recv carries no control messages.
+    bool setRxTimestamping(RxTimestamping mode, const std::string& interface = "");
+    void setBusyPoll(const BusyPollConfig& config);
+    
+    // Reads that carried a hardware or only a software stamp
+    size_t getHardwareStampCount() const { return hardware_stamps_.load(std::memory_order_relaxed); }
+    size_t getSoftwareStampCount() const { return software_stamps_.load(std::memory_order_relaxed); }
+    
+    size_t getMessagesSent() const { return messages_sent_.load(std::memory_order_relaxed); }
+    size_t getSendCalls() const { return send_calls_.load(std::memory_order_relaxed); }
+    size_t getSendDrops() const { return send_drops_.load(std::memory_order_relaxed); }
 
 protected:
     SocketServer() = default;
     
     void acceptLoop();
     void workerLoop(int worker_id);
-    void handleConnection(int client_fd);
+    void acceptConnections(int listen_fd, Reactor* owner);
+    void handleConnection(int client_fd, Reactor* owner = nullptr);
     void setSocketOptions(int sock_fd);
+    void setBusyPollOptions(int sock_fd);
+    void setEpollBusyPoll(int epoll_fd);
+    // read() plus the SO_TIMESTAMPING control message, into connection.wire_ticks
+    ssize_t readStamped(Connection& connection, char* buffer, size_t length);
+    
+    // Listener management
+    int createListener(bool reuse_port);
+    bool attachReuseportCpuFilter();
+    void closeListeners();
+    
+    // Reactor management
+    bool createReactors();
+    void destroyReactors();
+    Reactor& selectReactor();
+    void registerPendingConnections(Reactor& reactor);
+    void readConnection(Reactor& reactor, int client_fd);
+    void closeConnection(Reactor& reactor, int client_fd);
+    
+    // Session layer (socket_server_session.cpp), reactor thread only
+    void startSession(Reactor& reactor, Connection& connection);
+    bool onSessionFrame(Connection& connection, const MessageView& view);
+    bool handleLogin(Reactor& reactor, Connection& connection, const MessageView& view);
+    void onSessionTimer(Reactor& reactor, int client_fd);
+    void advanceTimers(Reactor& reactor, uint64_t now_ticks);
+    bool queueMessage(Reactor& reactor, Connection& connection, const Message& message);
+    void queueLogout(Reactor& reactor, Connection& connection, LogoutReason reason);
+    void endSession(Reactor& reactor, Connection& connection, LogoutReason reason);
+    void closeSession(Reactor& reactor, Connection& connection);
+    bool claimClient(uint64_t client_id);
+    void releaseClient(uint64_t client_id);
+    
+    // Outbound path, reactor thread only
+    bool appendFrame(Reactor& reactor, Connection& connection, const char* frame, size_t length);
+    size_t drainOutbound(Reactor& reactor);
+    size_t flushDirty(Reactor& reactor);
+    void flushConnection(Reactor& reactor, Connection& connection);
+    bool handleSocketError(Connection& connection);
+    void setWriteInterest(Reactor& reactor, Connection& connection, bool enable);
+    
+    // io_uring backend (socket_server_uring.cpp)
+    bool setupUring(Reactor& reactor);
+    void uringWorkerLoop(Reactor& reactor);
+    void armUringConnection(Reactor& reactor, Connection& connection);
+    void submitUringSend(Reactor& reactor, Connection& connection);
+    Connection* findUringConnection(Reactor& reactor, uint64_t user_data);
+    void onUringAccept(Reactor& reactor, const IoUring::Completion& completion);
+    void onUringWakeup(Reactor& reactor, const IoUring::Completion& completion);
+    void onUringRecv(Reactor& reactor, const IoUring::Completion& completion);
+    void onUringSend(Reactor& reactor, const IoUring::Completion& completion);
+    
+    // Connection slots, shared with senders on other threads
+    ConnectionId allocateSlot(int client_fd, int reactor_id);
+    void releaseSlot(ConnectionId connection_id);
     void setThreadAffinity(int worker_id);
     
     // Socket management
     int server_fd_{-1};
     int epoll_fd_{-1};
+    std::vector<int> listener_fds_;
     std::atomic<bool> running_{false};
     
     // Configuration
@@ -64,11 +376,20 @@ protected:
     size_t buffer_size_{8192};
     size_t thread_count_{4};
     bool affinity_enabled_{true};
+    DispatchPolicy dispatch_policy_{DispatchPolicy::ROUND_ROBIN};
+    ListenMode listen_mode_{ListenMode::SINGLE};
+    WaitStrategyType wait_strategy_{WaitStrategyType::SPIN_PARK};
+    IoBackend io_backend_{IoBackend::EPOLL};
+    bool uring_sqpoll_{false};
     
     // Threads
     std::thread accept_thread_;
     std::vector<std::thread> worker_threads_;
     
+    // One reactor per worker thread
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    size_t next_reactor_{0};
+    
     // Performance monitoring
     std::shared_ptr<PerformanceMonitor> performance_monitor_;
     std::shared_ptr<MessageHandler> message_handler_;
@@ -77,9 +398,51 @@ protected:
     std::atomic<size_t> connection_count_{0};
     std::atomic<size_t> messages_processed_{0};
     
+    struct ConnectionSlot {
+        std::atomic<uint64_t> id{INVALID_CONNECTION_ID};  // Live connection, 0 when free
+        std::atomic<int> fd{-1};
+        std::atomic<int> reactor{0};
+        std::atomic<uint32_t> queued_bytes{0};            // Reactor's view of tx.queued()
+    };
+    std::unique_ptr<ConnectionSlot[]> slots_;
+    size_t slot_capacity_{0};
+    std::vector<uint32_t> free_slots_;
+    std::mutex slots_mutex_;
+    uint32_t next_generation_{1};
+    
+    ClientRouteTable routes_;
+    bool zerocopy_enabled_{false};
+    RxTimestamping rx_timestamping_{RxTimestamping::OFF};
+    BusyPollConfig busy_poll_;
+    
+    std::atomic<size_t> messages_sent_{0};
+    std::atomic<size_t> send_calls_{0};
+    std::atomic<size_t> send_drops_{0};
+    std::atomic<size_t> hardware_stamps_{0};
+    std::atomic<size_t> software_stamps_{0};
+    
+    // Session layer
+    SessionConfig session_config_;
+    LoginHandler login_handler_;
+    SessionEndHandler session_end_handler_;
+    std::unordered_set<uint64_t> logged_in_clients_;     // One session per client id
+    std::mutex logged_in_mutex_;
+    std::atomic<size_t> logins_{0};
+    std::atomic<size_t> logins_rejected_{0};
+    std::atomic<size_t> logouts_{0};
+    std::atomic<size_t> sessions_reaped_{0};
+    std::atomic<size_t> heartbeats_sent_{0};
+    std::atomic<size_t> sequence_gaps_{0};
+    std::atomic<size_t> duplicates_dropped_{0};
+    
     // Constants for optimization
     static constexpr size_t MAX_EVENTS = 1000;
     static constexpr size_t MAX_BUFFER_SIZE = 65536;
+    static constexpr int BUSY_POLL_USEC = 50;
+    static constexpr size_t OUTBOUND_QUEUE_CAPACITY = 8192;
+    static constexpr size_t CONGESTION_WATERMARK = OutboundBuffer::CAPACITY / 2;
+    static constexpr unsigned URING_ENTRIES = 2048;
+    static constexpr uint32_t URING_RECV_BUFFERS = 256;  // Per reactor, each buffer_size_ bytes
 };
 
 // Message handler for processing incoming messages
@@ -88,15 +451,40 @@ public:
     MessageHandler();
     ~MessageHandler();
     
-    void handleMessage(int client_fd, const char* data, size_t length);
-    void setMessageCallback(std::function<void(std::shared_ptr<Message>)> callback);
+    // Decode a single unframed payload; messages are tagged with the
+    // connection id, and its client id is learned for routing
+    void handleMessage(Connection& connection, const char* data, size_t length);
+    
+    // Dispatch every complete frame in the connection's receive buffer;
+    // returns the number of frames handled, or -1 on a malformed frame
+    int handleFrames(Connection& connection);
+    
+    // Receives each decoded message with a view over the payload it was
+    // decoded from; the view is only valid for the duration of the call
+    void setMessageCallback(std::function<void(MessageHandle, const MessageView&)> callback);
+    
+    // Decode-to-callback-return time of each message is recorded here
+    void setPerformanceMonitor(PerformanceMonitor* monitor) { performance_monitor_ = monitor; }
+    void setRouteTable(ClientRouteTable* routes) { routes_ = routes; }
+    
+    // When set, frames are delivered as in-place views instead of decoded
+    // messages; the view is only valid for the duration of the call
+    void setViewCallback(std::function<void(int, const MessageView&)> callback);
+    
+    // Sees every valid frame before it is decoded; frames it returns false
+    // for go no further. Frame handling stops once the session is closing.
+    void setSessionCallback(std::function<bool(Connection&, const MessageView&)> callback);
     
     // Performance optimization
     void preallocateBuffers(size_t count);
     void setBatchSize(size_t batch_size);
 
 private:
-    std::function<void(std::shared_ptr<Message>)> message_callback_;
+    std::function<void(MessageHandle, const MessageView&)> message_callback_;
+    std::function<void(int, const MessageView&)> view_callback_;
+    std::function<bool(Connection&, const MessageView&)> session_callback_;
+    PerformanceMonitor* performance_monitor_{nullptr};
+    ClientRouteTable* routes_{nullptr};
     size_t batch_size_{100};
     
     // Buffer pool for zero-copy operations
@@ -108,31 +496,37 @@ private:
     void returnBuffer(std::vector<char> buffer);
 };
 
-// Performance monitoring for latency tracking
+// Performance monitoring for latency tracking. Latencies go into a
+// per-thread histogram, so recording never locks and reads merge shards.
 class PerformanceMonitor {
 public:
     PerformanceMonitor();
     ~PerformanceMonitor();
     
     void recordLatency(double latency_us);
+    void recordLatencyNs(uint64_t latency_ns) { latencies_.record(latency_ns); }
     void recordThroughput(size_t messages_per_second);
     
+    // Microseconds
     double getAverageLatency() const;
     double getP95Latency() const;
     double getP99Latency() const;
     size_t getThroughput() const;
     
+    void getLatencySnapshot(LatencyHistogram& out) const { latencies_.snapshot(out); }
+    
     void reset();
     void printStats() const;
 
 private:
-    std::vector<double> latency_samples_;
-    mutable std::mutex stats_mutex_;
+    double percentileUs(double q) const;
+    
+    ConcurrentHistogram latencies_;
     
-    size_t throughput_{0};
+    std::atomic<size_t> throughput_{0};
     std::chrono::steady_clock::time_point last_throughput_update_;
+    std::mutex throughput_mutex_;
     
-    static constexpr size_t MAX_SAMPLES = 100000;
     static constexpr size_t THROUGHPUT_UPDATE_INTERVAL_MS = 1000;
 };
 
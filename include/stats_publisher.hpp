@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include "../include/stats_segment.hpp"
+
+namespace hft {
+
+// Publishes counters and latency histograms to a shared-memory segment
+// (see stats_segment.hpp) for external monitoring. Sources are read on the
+// publisher's own thread from the counters and sharded histograms the
+// components already keep, so the trading threads do no extra work and a
+// reader never talks to the server at all.
+class StatsPublisher {
+public:
+    typedef std::function<uint64_t()> CounterSource;
+    typedef std::function<void(LatencyHistogram&)> HistogramSource;
+    
+    StatsPublisher();
+    ~StatsPublisher();
+    
+    StatsPublisher(const StatsPublisher&) = delete;
+    StatsPublisher& operator=(const StatsPublisher&) = delete;
+    
+    // Register before start(); false once the segment's table is full
+    bool addCounter(const std::string& name, CounterSource source);
+    bool addHistogram(const std::string& name, HistogramSource source);
+    
+    // Creates /dev/shm/<name>, replacing a stale one, and publishes every interval
+    bool start(const std::string& name = stats::DEFAULT_NAME, uint32_t interval_ms = DEFAULT_INTERVAL_MS);
+    // Publishes a final snapshot and removes the segment
+    void stop();
+    
+    size_t getPublishCount() const { return publish_count_.load(std::memory_order_relaxed); }
+    
+    static constexpr uint32_t DEFAULT_INTERVAL_MS = 100;
+    
+private:
+    void publishLoop();
+    void collect();
+    void publish();
+    
+    std::vector<std::pair<std::string, CounterSource>> counters_;
+    std::vector<std::pair<std::string, HistogramSource>> histograms_;
+    
+    std::string name_;
+    uint32_t interval_ms_{DEFAULT_INTERVAL_MS};
+    stats::Segment* segment_{nullptr};          // Shared mapping
+    std::unique_ptr<stats::Segment> staging_;   // Filled outside the sequence lock
+    LatencyHistogram scratch_;
+    
+    std::thread publisher_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> publish_count_{0};
+};
+
+} // namespace hft
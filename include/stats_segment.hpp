@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "../include/latency_histogram.hpp"
+
+namespace hft {
+
+// Shared-memory layout of the stats segment, /dev/shm/<name>. One writer
+// (the server's StatsPublisher) and any number of read-only mappers. The
+// whole body is guarded by a sequence lock: the publisher makes sequence
+// odd, rewrites the entries and makes it even again, so a reader that
+// copies the segment and sees the same even sequence before and after
+// has a consistent snapshot. Counters and histograms are cumulative since
+// the server started; readers difference successive snapshots for rates.
+namespace stats {
+
+constexpr char MAGIC[8] = {'H', 'F', 'T', 'S', 'T', 'A', 'T', '1'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t NAME_LENGTH = 48;
+constexpr size_t MAX_COUNTERS = 256;
+constexpr size_t MAX_HISTOGRAMS = 32;
+constexpr const char* DEFAULT_NAME = "hft_stats";
+
+struct SegmentHeader {
+    char magic[8];                  // Written last, once the layout is in place
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t bucket_count;          // LatencyHistogram::BUCKET_COUNT of the writer
+    uint32_t pid;
+    std::atomic<uint64_t> sequence; // Odd while the publisher is writing
+    uint64_t publish_ns;            // System clock of the last publish
+    uint64_t publish_count;
+    uint32_t interval_ms;
+    uint32_t counter_count;
+    uint32_t histogram_count;
+    uint32_t reserved;
+};
+
+struct CounterEntry {
+    char name[NAME_LENGTH];         // NUL-padded
+    uint64_t value;
+};
+
+// LatencyHistogram buckets of nanosecond values
+struct HistogramEntry {
+    char name[NAME_LENGTH];         // NUL-padded
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t reserved;
+    uint64_t buckets[LatencyHistogram::BUCKET_COUNT];
+};
+
+struct Segment {
+    SegmentHeader header;
+    CounterEntry counters[MAX_COUNTERS];
+    HistogramEntry histograms[MAX_HISTOGRAMS];
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "stats sequence must be lock-free to be shared across processes");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "stats sequence layout changed");
+static_assert(sizeof(SegmentHeader) == 64, "stats::SegmentHeader layout changed");
+static_assert(sizeof(CounterEntry) == 56, "stats::CounterEntry layout changed");
+
+} // namespace stats
+
+} // namespace hft
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../include/singleton.hpp"
+
+namespace hft {
+
+// Dense symbol id; 0 means unknown/unresolved so zeroed wire fields are safe
+typedef uint32_t SymbolId;
+constexpr SymbolId INVALID_SYMBOL_ID = 0;
+
+// Process-wide symbol table populated from reference data (and at login).
+// Lookups are lock-free so reactors can resolve symbols while new ones
+// are interned; ids are dense so books, risk tables and caches can be
+// plain arrays indexed by SymbolId.
+class SymbolRegistry : public Singleton<SymbolRegistry> {
+public:
+    friend class Singleton<SymbolRegistry>;
+    
+    static constexpr size_t MAX_SYMBOLS = 4096;
+    
+    // Returns the existing id or assigns the next one; INVALID_SYMBOL_ID if
+    // the symbol is empty, longer than the wire width or the table is full
+    SymbolId intern(const std::string& symbol);
+    
+    SymbolId find(const char* symbol, size_t length) const;
+    SymbolId find(const std::string& symbol) const { return find(symbol.data(), symbol.length()); }
+    
+    // Empty string for unknown ids
+    const std::string& name(SymbolId id) const;
+    
+    // Checks a client-supplied id: returns it if assigned and, when symbol
+    // text accompanies it, naming that symbol; INVALID_SYMBOL_ID otherwise
+    SymbolId verify(SymbolId id, const char* symbol, size_t length) const;
+    SymbolId verify(SymbolId id, const std::string& symbol) const { return verify(id, symbol.data(), symbol.length()); }
+    
+    // One symbol per line; blank lines and '#' comments are skipped
+    size_t loadFromFile(const std::string& path);
+    size_t load(const std::vector<std::string>& symbols);
+    
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+
+protected:
+    SymbolRegistry();
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> key{0};     // Packed NUL-padded symbol, 0 when empty
+        std::atomic<SymbolId> id{INVALID_SYMBOL_ID};
+    };
+    
+    static bool packKey(const char* symbol, size_t length, uint64_t& key);
+    size_t slotFor(uint64_t key) const;
+    
+    std::vector<Slot> slots_;            // Open addressing, 2x MAX_SYMBOLS
+    std::vector<std::string> names_;     // Indexed by id, preallocated
+    std::atomic<size_t> count_{0};
+    std::mutex intern_mutex_;
+};
+
+} // namespace hft
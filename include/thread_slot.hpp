@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace hft {
+
+// Upper bound on concurrently live threads using per-thread tables
+constexpr size_t MAX_THREAD_SLOTS = 128;
+
+// Dense index of the calling thread in [0, MAX_THREAD_SLOTS), assigned on
+// first use and released when the thread exits. Lets per-thread state live
+// in plain arrays owned by one writer each. If more threads than slots are
+// alive at once the index wraps and a warning is logged.
+size_t currentThreadSlot();
+
+} // namespace hft
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hft {
+
+// Hierarchical timing wheel for a reactor's per-connection timers. Four
+// levels of 64 slots cover 2^24 ticks; a timer sits in the level whose
+// slot span fits its remaining delay and moves down one level each time
+// the level below wraps. Timers are intrusive nodes owned by the caller,
+// so schedule and cancel are O(1) list splices and a tick only visits the
+// one slot that is due: no scan over idle connections, however many there
+// are. Single-threaded; the owning reactor schedules and advances.
+class TimerWheel {
+public:
+    // Embedded in the owner; must stay at a fixed address while armed
+    struct Timer {
+        Timer* next{nullptr};
+        Timer* prev{nullptr};
+        uint64_t expiry{0};      // Tick the timer fires at
+        uint64_t key{0};         // Owner's handle, for the expiry callback
+        
+        bool armed() const { return prev != nullptr; }
+    };
+    
+    static constexpr unsigned LEVEL_BITS = 6;
+    static constexpr size_t SLOTS = 1u << LEVEL_BITS;
+    static constexpr unsigned LEVELS = 4;
+    // Longer delays are clamped and fire early; callers re-check their deadline
+    static constexpr uint64_t MAX_DELAY = (1ull << (LEVEL_BITS * LEVELS)) - 1;
+    
+    explicit TimerWheel(uint64_t start_tick = 0);
+    
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    
+    // Last tick advanced to
+    uint64_t now() const { return now_; }
+    size_t size() const { return count_; }
+    
+    // Fires delay ticks from now (at least 1); rescheduling an armed timer moves it
+    void schedule(Timer& timer, uint64_t delay);
+    void cancel(Timer& timer);
+    
+    // Moves time forward to tick, calling on_expire(Timer&) for every timer
+    // that falls due, in tick order. A timer is disarmed before its callback,
+    // which may reschedule it or cancel any other timer.
+    template<typename Callback>
+    size_t advance(uint64_t tick, Callback&& on_expire) {
+        size_t fired = 0;
+        while (now_ < tick) {
+            if (count_ == 0) {
+                now_ = tick;
+                break;
+            }
+            
+            uint64_t next = now_ + 1;
+            if ((next & (SLOTS - 1)) == 0) cascade(next);
+            now_ = next;
+            
+            // Everything in a level-0 slot is due; detach it so callbacks that
+            // reschedule into this slot are not fired again this tick
+            Timer due;
+            takeSlot(slots_[0][next & (SLOTS - 1)], due);
+            while (due.next != &due) {
+                Timer& timer = *due.next;
+                unlink(timer);
+                --count_;
+                on_expire(timer);
+                ++fired;
+            }
+        }
+        return fired;
+    }
+    
+private:
+    void insert(Timer& timer);
+    void cascade(uint64_t tick);
+    static void unlink(Timer& timer);
+    static void takeSlot(Timer& slot, Timer& out);
+    
+    Timer slots_[LEVELS][SLOTS];     // List heads; circular, empty when pointing at themselves
+    uint64_t now_;
+    size_t count_{0};
+};
+
+} // namespace hft
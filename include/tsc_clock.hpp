@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace hft {
+
+// Cycle-counter clock calibrated once against steady_clock. now() is an
+// rdtsc behind one predictable branch (a few ns); nowOrdered() waits for
+// earlier instructions to retire and is the one to use for closing a timed
+// interval. Ticks are only comparable within a host; convert with toNanos()
+// for reporting. Falls back to steady_clock nanoseconds, decided once at
+// calibration, where CPUID reports no invariant TSC.
+class TscClock {
+public:
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        if (calibration().invariant_tsc) return __rdtsc();
+#endif
+        return fallbackNanos();
+    }
+    
+    static uint64_t nowOrdered() {
+#if defined(__x86_64__) || defined(__i386__)
+        if (calibration().invariant_tsc) {
+            unsigned int aux;
+            return __rdtscp(&aux);
+        }
+#endif
+        return fallbackNanos();
+    }
+    
+    static double ticksPerNano() { return calibration().ticks_per_ns; }
+    
+    static uint64_t toNanos(uint64_t ticks) {
+        return static_cast<uint64_t>(ticks * calibration().ns_per_tick);
+    }
+    
+    static uint64_t fromNanos(uint64_t nanos) {
+        return static_cast<uint64_t>(nanos * calibration().ticks_per_ns);
+    }
+    
+    // Nanoseconds since the steady_clock epoch, derived from the TSC
+    static uint64_t nowNanos() {
+        const Calibration& cal = calibration();
+        return cal.base_ns + static_cast<uint64_t>((now() - cal.base_ticks) * cal.ns_per_tick);
+    }
+    
+    // Nanoseconds since the Unix epoch for a reading, anchored to
+    // system_clock once at calibration: for wire and log timestamps, not
+    // for intervals, and it does not follow later clock adjustments
+    static uint64_t toWallNanos(uint64_t ticks) {
+        const Calibration& cal = calibration();
+        // Another core's counter may read slightly behind the calibrating one
+        if (ticks >= cal.base_ticks) {
+            return cal.base_wall_ns + static_cast<uint64_t>((ticks - cal.base_ticks) * cal.ns_per_tick);
+        }
+        return cal.base_wall_ns - static_cast<uint64_t>((cal.base_ticks - ticks) * cal.ns_per_tick);
+    }
+    
+    static uint64_t wallNanos() { return toWallNanos(now()); }
+    
+    // Forces calibration up front so the first hot-path read doesn't pay it
+    static void calibrate() { calibration(); }
+
+private:
+    struct Calibration {
+        double ticks_per_ns;
+        double ns_per_tick;
+        uint64_t base_ticks;
+        uint64_t base_ns;
+        uint64_t base_wall_ns;
+        bool invariant_tsc;
+    };
+    
+    static uint64_t fallbackNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    static const Calibration& calibration() {
+        static const Calibration cal = measure();
+        return cal;
+    }
+    
+    static bool hasInvariantTsc();
+    static Calibration measure();
+};
+
+} // namespace hft
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace hft {
+
+// How a polling thread behaves when it finds no work
+enum class WaitStrategyType : uint8_t {
+    BUSY_SPIN = 1,    // Spin with pause forever; lowest latency, burns the core
+    SPIN_YIELD = 2,   // Spin, then sched_yield between polls
+    SPIN_PARK = 3,    // Spin, yield, then park on a futex (or block in epoll)
+    BUSY_POLL = 4     // Busy-spin in user space and let the kernel busy-poll the NIC (SO_BUSY_POLL)
+};
+
+bool parseWaitStrategy(const std::string& name, WaitStrategyType& type);
+const char* waitStrategyName(WaitStrategyType type);
+
+// Pause hint for spin loops
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Futex-backed wakeup for parked consumers. notify() costs a fence and a
+// relaxed load when nobody is parked. Producers publish, then notify().
+// A consumer parks in two steps so a notify() that lands between its last
+// empty poll and the park is never lost: prepareWait() registers it, it
+// re-checks its queues, then either cancelWait()s because work arrived or
+// commitWait()s, which returns at once if the epoch moved since.
+class WaitNotifier {
+public:
+    void notify();
+    
+    uint32_t prepareWait();
+    void cancelWait();
+    // Block until notify() or the timeout; spurious returns are allowed
+    void commitWait(uint32_t epoch, uint32_t timeout_us);
+
+private:
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> waiters_{0};
+};
+
+// Per-thread idle policy. Call idle() after a poll that found nothing
+// and reset() after one that did.
+class WaitStrategy {
+public:
+    explicit WaitStrategy(WaitStrategyType type = WaitStrategyType::SPIN_PARK,
+                          WaitNotifier* notifier = nullptr);
+    
+    // For loops that park in epoll_wait, io_uring_enter or poll, where the fd
+    // is the wakeup: idle() stops at the yield phase and never sleeps, and
+    // pollTimeoutMs() supplies the blocking timeout from then on
+    static WaitStrategy forEventLoop(WaitStrategyType type);
+    
+    void idle();
+    void reset() { idle_count_ = 0; }
+    
+    // As idle(), for loops with a notifier: before parking, has_work() is
+    // asked again once registered as a waiter, so work published since the
+    // last poll either shows up there or wakes the park
+    template<typename Recheck>
+    void idle(Recheck&& has_work) {
+        if (type_ != WaitStrategyType::SPIN_PARK || !notifier_ || idle_count_ + 1 < YIELD_LIMIT) {
+            idle();
+            return;
+        }
+        
+        idle_count_ = YIELD_LIMIT;
+        uint32_t epoch = notifier_->prepareWait();
+        if (has_work()) {
+            notifier_->cancelWait();
+        } else {
+            notifier_->commitWait(epoch, PARK_TIMEOUT_US);
+        }
+    }
+    
+    // For event loops that can block in the kernel instead of on a futex:
+    // epoll_wait timeout to use for the next poll
+    int pollTimeoutMs() const;
+    
+    WaitStrategyType type() const { return type_; }
+
+private:
+    WaitStrategyType type_;
+    WaitNotifier* notifier_;
+    bool event_loop_{false};
+    uint32_t idle_count_{0};
+    
+    static constexpr uint32_t SPIN_LIMIT = 2000;
+    static constexpr uint32_t YIELD_LIMIT = SPIN_LIMIT + 100;
+    static constexpr uint32_t PARK_TIMEOUT_US = 1000;
+};
+
+} // namespace hft
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Wire format is little-endian; in-place message views require a little-endian host"
+#endif
+
+namespace hft {
+
+// Message types for HFT system
+enum class MessageType : uint8_t {
+    ORDER_NEW = 1,
+    ORDER_CANCEL = 2,
+    ORDER_REPLACE = 3,
+    ORDER_FILL = 4,
+    MARKET_DATA = 5,
+    HEARTBEAT = 6,
+    LOGIN = 7,
+    LOGOUT = 8,
+    ERROR = 9,
+    ORDER_ACK = 10
+};
+
+// Message priority levels
+enum class MessagePriority : uint8_t {
+    LOW = 1,
+    NORMAL = 2,
+    HIGH = 3,
+    CRITICAL = 4
+};
+
+// Outcome carried by ORDER_ACK
+enum class AckStatus : uint8_t {
+    ACCEPTED = 1,    // Passed the inbound checks and was routed to matching
+    REJECTED = 2     // Reason holds the InterceptStatus of the failing stage
+};
+
+// Why a session ended, carried by LOGOUT
+enum class LogoutReason : uint8_t {
+    NORMAL = 1,             // Requested by the client, or the server's reply to that
+    LOGIN_REJECTED = 2,     // Refused by the login handler
+    NOT_LOGGED_IN = 3,      // Application message before a successful LOGIN
+    DUPLICATE_LOGIN = 4,    // Second LOGIN on a session, or client id already logged in elsewhere
+    CLIENT_MISMATCH = 5,    // Message claims a client id other than the session's
+    LOGIN_TIMEOUT = 6,      // No LOGIN within the login timeout
+    HEARTBEAT_TIMEOUT = 7,  // Nothing received for too many heartbeat intervals
+    IDLE_TIMEOUT = 8        // Connection without a session stayed silent
+};
+
+// Fixed-layout wire schema. Every message is a naturally aligned struct
+// copied to and from the wire with a single memcpy; field offsets are
+// compile-time constants. Layouts only ever grow at the end, so a reader
+// accepts any version in [MIN_SCHEMA_VERSION, SCHEMA_VERSION] as long as
+// the frame is at least as long as the fields it reads.
+namespace wire {
+
+// v2: dense symbol_id appended to Order and MarketData. New message
+// types (ORDER_ACK, LOGIN, LOGOUT) do not change existing layouts and need no bump.
+constexpr uint8_t SCHEMA_VERSION = 2;
+constexpr uint8_t MIN_SCHEMA_VERSION = 1;
+
+constexpr size_t SYMBOL_LENGTH = 8;
+constexpr size_t ERROR_TEXT_LENGTH = 56;
+constexpr size_t CREDENTIALS_LENGTH = 16;
+
+// Login::flags
+constexpr uint32_t LOGIN_MARKET_DATA = 1u << 0;   // Stream quotes for every symbol to this session
+
+struct Header {
+    uint8_t version;
+    uint8_t type;
+    uint8_t priority;
+    uint8_t reserved[5];
+    uint64_t sequence_number;
+    uint64_t timestamp;
+    uint64_t client_id;
+};
+
+struct Order {
+    Header header;
+    uint64_t order_id;
+    char symbol[SYMBOL_LENGTH];   // NUL-padded
+    double price;
+    uint32_t quantity;
+    uint8_t is_buy;
+    uint8_t reserved[3];
+    uint32_t symbol_id;           // v2; 0 = resolve from symbol text
+    uint32_t reserved_v2;
+};
+
+struct MarketData {
+    Header header;
+    char symbol[SYMBOL_LENGTH];   // NUL-padded
+    double bid;
+    double ask;
+    uint32_t bid_size;
+    uint32_t ask_size;
+    uint32_t symbol_id;           // v2; 0 = resolve from symbol text
+    uint32_t reserved_v2;
+};
+
+struct Heartbeat {
+    Header header;
+};
+
+struct Error {
+    Header header;
+    uint32_t error_code;
+    uint8_t text_length;
+    uint8_t reserved[3];
+    char text[ERROR_TEXT_LENGTH];
+};
+
+// Server reply to every ORDER_NEW / ORDER_CANCEL / ORDER_REPLACE. Echoes
+// the order's own header sequence and timestamp so clients can match
+// acks to requests and measure round trips without keeping state.
+struct OrderAck {
+    Header header;
+    uint64_t order_id;
+    uint64_t client_sequence;
+    uint64_t client_timestamp;
+    uint32_t symbol_id;
+    uint8_t status;               // AckStatus
+    uint8_t reason;               // Reject reason, 0 when accepted
+    uint8_t order_type;           // MessageType being acknowledged
+    uint8_t reserved;
+};
+
+// Opens a session for header.client_id. The server answers with a LOGIN
+// carrying the granted heartbeat interval, or a LOGOUT with the reason
+// it refused. The header sequence is the client's first sequence number.
+struct Login {
+    Header header;
+    uint32_t heartbeat_interval_ms;           // Requested; 0 takes the server default
+    uint32_t flags;                           // LOGIN_* bits; the reply echoes those granted
+    char credentials[CREDENTIALS_LENGTH];     // NUL-padded, checked by the server's login handler
+};
+
+// Ends a session. Either side may send it; the server closes the
+// connection after sending one.
+struct Logout {
+    Header header;
+    uint8_t reason;                           // LogoutReason
+    uint8_t reserved[7];
+};
+
+// Multicast feed datagram: this header, then message_count frames (4-byte
+// length + MarketData payload, as on the TCP stream) back to back. The
+// i-th message carries feed sequence sequence + i; a count of 0 is a
+// heartbeat announcing the next sequence. A and B lines carry identical
+// datagrams.
+constexpr uint8_t FEED_VERSION = 1;
+
+struct FeedPacketHeader {
+    uint64_t sequence;
+    uint16_t message_count;
+    uint8_t version;              // FEED_VERSION
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(Header) == 32, "wire::Header layout changed");
+static_assert(sizeof(Order) == 72, "wire::Order layout changed");
+static_assert(sizeof(MarketData) == 72, "wire::MarketData layout changed");
+static_assert(offsetof(Order, symbol_id) == 64 && offsetof(MarketData, symbol_id) == 64,
+              "v2 fields must follow the v1 layout");
+static_assert(sizeof(Heartbeat) == 32, "wire::Heartbeat layout changed");
+static_assert(sizeof(Error) == 96, "wire::Error layout changed");
+static_assert(sizeof(OrderAck) == 64, "wire::OrderAck layout changed");
+static_assert(sizeof(Login) == 56, "wire::Login layout changed");
+static_assert(sizeof(Logout) == 40, "wire::Logout layout changed");
+static_assert(sizeof(FeedPacketHeader) == 16, "wire::FeedPacketHeader layout changed");
+static_assert(offsetof(Order, price) % 8 == 0 && offsetof(MarketData, bid) % 8 == 0,
+              "wire fields must be naturally aligned");
+
+constexpr size_t TYPE_OFFSET = offsetof(Header, type);
+constexpr size_t VERSION_OFFSET = offsetof(Header, version);
+constexpr size_t PRIORITY_OFFSET = offsetof(Header, priority);
+constexpr size_t SEQUENCE_OFFSET = offsetof(Header, sequence_number);
+constexpr size_t TIMESTAMP_OFFSET = offsetof(Header, timestamp);
+constexpr size_t CLIENT_ID_OFFSET = offsetof(Header, client_id);
+constexpr size_t HEADER_SIZE = sizeof(Header);
+
+// Compile-time mapping from message type to its layout
+template<MessageType Type> struct Layout;
+template<> struct Layout<MessageType::ORDER_NEW> { typedef Order type; };
+template<> struct Layout<MessageType::ORDER_CANCEL> { typedef Order type; };
+template<> struct Layout<MessageType::ORDER_REPLACE> { typedef Order type; };
+template<> struct Layout<MessageType::ORDER_FILL> { typedef Order type; };
+template<> struct Layout<MessageType::MARKET_DATA> { typedef MarketData type; };
+template<> struct Layout<MessageType::HEARTBEAT> { typedef Heartbeat type; };
+template<> struct Layout<MessageType::ERROR> { typedef Error type; };
+template<> struct Layout<MessageType::ORDER_ACK> { typedef OrderAck type; };
+template<> struct Layout<MessageType::LOGIN> { typedef Login type; };
+template<> struct Layout<MessageType::LOGOUT> { typedef Logout type; };
+
+// Shortest encoding a reader accepts. Fields appended after
+// MIN_SCHEMA_VERSION decode as zero when an older, shorter frame arrives.
+template<typename T> struct MinSize { static constexpr size_t value = sizeof(T); };
+template<> struct MinSize<Order> { static constexpr size_t value = offsetof(Order, symbol_id); };
+template<> struct MinSize<MarketData> { static constexpr size_t value = offsetof(MarketData, symbol_id); };
+
+// Encoded size per type, 0 for types without a layout
+constexpr size_t sizeOf(MessageType type) {
+    return (type == MessageType::ORDER_NEW || type == MessageType::ORDER_CANCEL ||
+            type == MessageType::ORDER_REPLACE || type == MessageType::ORDER_FILL) ? sizeof(Order) :
+           type == MessageType::MARKET_DATA ? sizeof(MarketData) :
+           type == MessageType::HEARTBEAT ? sizeof(Heartbeat) :
+           type == MessageType::ERROR ? sizeof(Error) :
+           type == MessageType::ORDER_ACK ? sizeof(OrderAck) :
+           type == MessageType::LOGIN ? sizeof(Login) :
+           type == MessageType::LOGOUT ? sizeof(Logout) : 0;
+}
+
+constexpr bool isSupportedVersion(uint8_t version) {
+    return version >= MIN_SCHEMA_VERSION && version <= SCHEMA_VERSION;
+}
+
+// Single-copy codec for a layout
+template<typename T>
+struct Codec {
+    static void encode(const T& in, char* out) {
+        memcpy(out, &in, sizeof(T));
+    }
+    
+    static bool decode(const char* data, size_t length, T& out) {
+        if (!data || length < MinSize<T>::value) return false;
+        if (length < sizeof(T)) {
+            memset(&out, 0, sizeof(T));
+            memcpy(&out, data, length);
+        } else {
+            memcpy(&out, data, sizeof(T));
+        }
+        return isSupportedVersion(out.header.version);
+    }
+};
+
+// Unaligned field access for views into receive buffers
+template<typename T>
+inline T load(const char* data, size_t offset) {
+    T value;
+    memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+template<typename T>
+inline void store(char* data, size_t offset, T value) {
+    memcpy(data + offset, &value, sizeof(T));
+}
+
+} // namespace wire
+
+} // namespace hft
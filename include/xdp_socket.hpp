@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace hft {
+
+// Minimal AF_XDP receive socket over the raw syscalls; no libbpf or libxdp
+// dependency. Owns a UMEM of fixed-size frames, its fill ring and one RX
+// ring bound to a single NIC queue, plus a small XDP program that redirects
+// UDP datagrams for the given destination ports into that ring and passes
+// everything else to the kernel stack. Used by one thread only.
+class XdpSocket {
+public:
+    // A received Ethernet frame, in UMEM; valid until release()
+    struct Packet {
+        const char* data;
+        uint32_t length;
+    };
+    
+    XdpSocket();
+    ~XdpSocket();
+    
+    XdpSocket(const XdpSocket&) = delete;
+    XdpSocket& operator=(const XdpSocket&) = delete;
+    
+    // Tries native (driver) XDP with zero-copy, then the generic hook with
+    // copy mode. False if the kernel, driver or privileges refuse AF_XDP;
+    // callers fall back to ordinary sockets.
+    bool open(const std::string& interface, uint32_t queue, const std::vector<uint16_t>& ports);
+    void close();
+    
+    // Up to max frames from the RX ring; release() hands them back
+    size_t receive(Packet* out, size_t max);
+    // Return every frame from the last receive() to the fill ring
+    void release();
+    
+    int fd() const { return fd_; }
+    bool zeroCopy() const { return zero_copy_; }
+    bool driverMode() const { return driver_mode_; }
+    
+    static constexpr uint32_t FRAME_SIZE = 2048;
+    static constexpr uint32_t FRAME_COUNT = 4096;
+    static constexpr uint32_t RX_RING_SIZE = 2048;
+    static constexpr size_t MAX_BATCH = 64;
+    
+private:
+    // Producer/consumer indices and descriptors shared with the kernel
+    struct Ring {
+        uint32_t* producer{nullptr};
+        uint32_t* consumer{nullptr};
+        uint32_t* flags{nullptr};
+        void* descs{nullptr};
+        uint32_t size{0};
+        void* map{nullptr};
+        size_t map_size{0};
+    };
+    
+    bool setupUmem();
+    bool mapRing(Ring& ring, uint64_t page_offset, uint32_t size, size_t desc_size,
+                 uint64_t producer, uint64_t consumer, uint64_t flags, uint64_t descs);
+    bool bindSocket(int ifindex, uint32_t queue, bool zero_copy);
+    bool attachProgram(int ifindex, uint32_t queue, const std::vector<uint16_t>& ports);
+    void fillFrames(const uint64_t* addrs, size_t count);
+    
+    int fd_{-1};
+    int map_fd_{-1};
+    int prog_fd_{-1};
+    int link_fd_{-1};              // Closing the link detaches the program
+    bool zero_copy_{false};
+    bool driver_mode_{false};
+    
+    char* umem_{nullptr};
+    size_t umem_size_{0};
+    Ring fill_;
+    Ring completion_;              // Required by bind; unused for receive only
+    Ring rx_;
+    
+    uint64_t held_[MAX_BATCH];     // Frames out with the caller
+    size_t held_count_{0};
+};
+
+} // namespace hft
@@ -0,0 +1,150 @@
+#include "../include/async_logger.hpp"
+#include "../include/cpu_topology.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <algorithm>
+
+namespace hft {
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARN: return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+bool parseLogLevel(const std::string& name, LogLevel& out) {
+    if (name == "debug") out = LogLevel::DEBUG;
+    else if (name == "info") out = LogLevel::INFO;
+    else if (name == "warn") out = LogLevel::WARN;
+    else if (name == "error") out = LogLevel::ERROR;
+    else return false;
+    return true;
+}
+
+// AsyncLogger implementation
+constexpr size_t LogRecord::MAX_ARGS;
+constexpr size_t AsyncLogger::PRODUCER_QUEUE_CAPACITY;
+constexpr size_t AsyncLogger::MAX_BATCH;
+
+AsyncLogger::AsyncLogger() : inbound_(PRODUCER_QUEUE_CAPACITY) {}
+
+AsyncLogger::~AsyncLogger() {
+    stop();
+}
+
+bool AsyncLogger::start(const std::string& path) {
+    if (running_.load()) return true;
+    
+    if (path.empty()) {
+        out_ = stdout;
+    } else {
+        out_ = fopen(path.c_str(), "a");
+        if (!out_) {
+            std::cerr << "[Logger] Failed to open " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    
+    TscClock::calibrate();
+    
+    running_ = true;
+    writer_thread_ = std::thread(&AsyncLogger::writerLoop, this);
+    return true;
+}
+
+void AsyncLogger::stop() {
+    if (!running_.load()) return;
+    
+    running_ = false;
+    notifier_.notify();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+    if (out_ && out_ != stdout) {
+        fclose(out_);
+    } else if (out_) {
+        fflush(out_);
+    }
+    out_ = nullptr;
+    
+    if (getDropCount() > 0) {
+        std::cerr << "[Logger] Dropped " << getDropCount() << " records on full rings" << std::endl;
+    }
+}
+
+void AsyncLogger::push(const LogRecord& record) {
+    if (!inbound_.producer()->tryPush(record)) {
+        drop_count_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    notifier_.notify();
+}
+
+void AsyncLogger::writerLoop() {
+    ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::LOGGER);
+    WaitStrategy wait(wait_strategy_, &notifier_);
+    
+    auto drain = [this]() { return inbound_.drain([this](LogRecord&& record) { format(record); }, MAX_BATCH); };
+    auto pending = [this]() { return inbound_.pending(); };
+    
+    while (running_.load()) {
+        if (drain() == 0) {
+            // Lines reach the file once the rings run dry, not per record
+            fflush(out_);
+            wait.idle(pending);
+        } else {
+            wait.reset();
+        }
+    }
+    
+    while (drain() > 0) {
+    }
+    fflush(out_);
+}
+
+void AsyncLogger::format(const LogRecord& record) {
+    uint64_t wall_ns = TscClock::toWallNanos(record.ticks);
+    time_t seconds = static_cast<time_t>(wall_ns / 1000000000);
+    struct tm parts;
+    localtime_r(&seconds, &parts);
+    
+    char line[1024];
+    size_t length = strftime(line, sizeof(line), "%Y-%m-%d %H:%M:%S", &parts);
+    int written = snprintf(line + length, sizeof(line) - length, ".%09lld %s [%s] ",
+                           static_cast<long long>(wall_ns % 1000000000ULL), logLevelName(record.site->level),
+                           record.site->component);
+    if (written > 0) length += static_cast<size_t>(written);
+    
+    // Substitute each "{}" with the next argument; extras are ignored
+    uint8_t next_arg = 0;
+    for (const char* p = record.site->format; *p && length < sizeof(line) - 1; ++p) {
+        if (p[0] != '{' || p[1] != '}' || next_arg >= record.arg_count) {
+            line[length++] = *p;
+            continue;
+        }
+        
+        const LogArg& arg = record.args[next_arg];
+        size_t room = sizeof(line) - length;
+        switch (record.types[next_arg]) {
+            case LogArgType::INT: written = snprintf(line + length, room, "%lld", static_cast<long long>(arg.i)); break;
+            case LogArgType::UINT: written = snprintf(line + length, room, "%llu", static_cast<unsigned long long>(arg.u)); break;
+            case LogArgType::DOUBLE: written = snprintf(line + length, room, "%g", arg.d); break;
+            case LogArgType::STRING: written = snprintf(line + length, room, "%s", arg.s ? arg.s : "(null)"); break;
+        }
+        if (written > 0) length = std::min(length + static_cast<size_t>(written), sizeof(line) - 1);
+        ++next_arg;
+        ++p;
+    }
+    line[length++] = '\n';
+    
+    fwrite(line, 1, length, out_);
+    record_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace hft
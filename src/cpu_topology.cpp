@@ -0,0 +1,390 @@
+#include "../include/cpu_topology.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+namespace hft {
+
+namespace {
+
+bool readLine(const std::string& path, std::string& out) {
+    std::ifstream file(path);
+    return file && std::getline(file, out);
+}
+
+} // namespace
+
+const char* threadRoleName(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::REACTOR: return "reactor";
+        case ThreadRole::ACCEPT: return "accept";
+        case ThreadRole::PROCESSOR: return "processor";
+        case ThreadRole::MATCHING: return "matching";
+        case ThreadRole::RISK: return "risk";
+        case ThreadRole::MARKET_DATA: return "marketdata";
+        case ThreadRole::FEED: return "feed";
+        case ThreadRole::JOURNAL: return "journal";
+        case ThreadRole::LOGGER: return "logger";
+        case ThreadRole::ROLE_COUNT: break;
+    }
+    return "unknown";
+}
+
+// CpuTopology implementation
+bool CpuTopology::parseCpuList(const std::string& text, std::vector<int>& out) {
+    out.clear();
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find_first_of(",+", start);
+        if (end == std::string::npos) end = text.size();
+        
+        std::string item = text.substr(start, end - start);
+        size_t dash = item.find('-');
+        try {
+            int first = std::stoi(item.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(item.substr(dash + 1));
+            if (first < 0 || last < first) return false;
+            for (int cpu = first; cpu <= last; ++cpu) {
+                out.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        start = end + 1;
+    }
+    return !out.empty();
+}
+
+std::string CpuTopology::formatCpuList(const std::vector<int>& cpus) {
+    std::vector<int> sorted(cpus);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    
+    std::ostringstream out;
+    for (size_t i = 0; i < sorted.size(); ) {
+        size_t j = i;
+        while (j + 1 < sorted.size() && sorted[j + 1] == sorted[j] + 1) ++j;
+        if (i > 0) out << ",";
+        out << sorted[i];
+        if (j > i) out << "-" << sorted[j];
+        i = j + 1;
+    }
+    return out.str();
+}
+
+bool CpuTopology::load() {
+    cpus_.clear();
+    node_cpus_.clear();
+    cpu_node_.clear();
+    
+    std::string line;
+    std::vector<int> online;
+    if (!readLine("/sys/devices/system/cpu/online", line) || !parseCpuList(line, online)) {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = 0; cpu < std::max(count, 1L); ++cpu) {
+            online.push_back(static_cast<int>(cpu));
+        }
+    }
+    
+    // Respect cpusets and taskset: only CPUs this process may use
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    for (int cpu : online) {
+        if (!have_mask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+            cpus_.push_back(cpu);
+        }
+    }
+    if (cpus_.empty()) {
+        std::cerr << "[CpuTopology] No usable CPUs found" << std::endl;
+        return false;
+    }
+    
+    int max_cpu = *std::max_element(cpus_.begin(), cpus_.end());
+    cpu_node_.assign(static_cast<size_t>(max_cpu) + 1, 0);
+    
+    std::vector<int> nodes;
+    if (readLine("/sys/devices/system/node/online", line) && parseCpuList(line, nodes)) {
+        node_cpus_.resize(static_cast<size_t>(*std::max_element(nodes.begin(), nodes.end())) + 1);
+        for (int node : nodes) {
+            std::vector<int> node_list;
+            if (!readLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", line) ||
+                !parseCpuList(line, node_list)) {
+                continue;   // Memory-only node
+            }
+            for (int cpu : node_list) {
+                if (cpu <= max_cpu && std::find(cpus_.begin(), cpus_.end(), cpu) != cpus_.end()) {
+                    cpu_node_[cpu] = node;
+                    node_cpus_[node].push_back(cpu);
+                }
+            }
+        }
+    }
+    
+    // No NUMA information: one node holding everything
+    if (node_cpus_.empty()) {
+        node_cpus_.push_back(cpus_);
+    }
+    return true;
+}
+
+int CpuTopology::nodeOf(int cpu) const {
+    return (cpu >= 0 && static_cast<size_t>(cpu) < cpu_node_.size()) ? cpu_node_[cpu] : 0;
+}
+
+const std::vector<int>& CpuTopology::cpusOnNode(int node) const {
+    static const std::vector<int> none;
+    return (node >= 0 && static_cast<size_t>(node) < node_cpus_.size()) ? node_cpus_[node] : none;
+}
+
+int CpuTopology::interfaceNode(const std::string& interface) {
+    std::string line;
+    if (interface.empty() || !readLine("/sys/class/net/" + interface + "/device/numa_node", line)) {
+        return -1;
+    }
+    try {
+        return std::stoi(line);
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+// ThreadPlacement implementation
+bool ThreadPlacement::configure(const std::string& spec, size_t reactor_count, size_t matching_count) {
+    enabled_ = false;
+    nic_.clear();
+    for (auto& role : roles_) {
+        role = RolePlacement();
+    }
+    roles_[static_cast<size_t>(ThreadRole::REACTOR)].threads = std::max<size_t>(reactor_count, 1);
+    roles_[static_cast<size_t>(ThreadRole::MATCHING)].threads = std::max<size_t>(matching_count, 1);
+    if (spec == "off") {
+        return true;
+    }
+    if (!topology_.load()) {
+        return false;
+    }
+    
+    // Items are comma separated, and so are cpulist entries: a piece without
+    // '=' continues the previous item's list ("reactor=2,3,matching=4")
+    std::vector<std::pair<std::string, std::string>> items;
+    size_t start = 0;
+    while (spec != "auto" && start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string piece = spec.substr(start, end - start);
+        start = end + 1;
+        
+        size_t eq = piece.find('=');
+        if (eq != std::string::npos) {
+            items.emplace_back(piece.substr(0, eq), piece.substr(eq + 1));
+        } else if (!items.empty()) {
+            items.back().second += "," + piece;
+        } else {
+            std::cerr << "[Placement] Expected role=cpulist, got '" << piece << "'" << std::endl;
+            return false;
+        }
+    }
+    
+    for (const auto& item : items) {
+        const std::string& name = item.first;
+        const std::string& value = item.second;
+        if (name == "nic") {
+            nic_ = value;
+            continue;
+        }
+        
+        size_t role = 0;
+        while (role < static_cast<size_t>(ThreadRole::ROLE_COUNT) &&
+               name != threadRoleName(static_cast<ThreadRole>(role))) {
+            ++role;
+        }
+        if (role == static_cast<size_t>(ThreadRole::ROLE_COUNT)) {
+            std::cerr << "[Placement] Unknown thread role '" << name << "'" << std::endl;
+            return false;
+        }
+        
+        std::vector<int> cpus;
+        if (!CpuTopology::parseCpuList(value, cpus)) {
+            std::cerr << "[Placement] Invalid CPU list '" << value << "' for " << name << std::endl;
+            return false;
+        }
+        for (int cpu : cpus) {
+            if (std::find(topology_.cpus().begin(), topology_.cpus().end(), cpu) == topology_.cpus().end()) {
+                std::cerr << "[Placement] CPU " << cpu << " for " << name << " is offline or not allowed" << std::endl;
+                return false;
+            }
+        }
+        roles_[role].cpus = cpus;
+        roles_[role].explicit_map = true;
+    }
+    
+    // Reactors follow the NIC; without one, the node of any explicit reactor CPU
+    int nic_node = CpuTopology::interfaceNode(nic_);
+    const RolePlacement& reactors = roles_[static_cast<size_t>(ThreadRole::REACTOR)];
+    if (nic_node >= 0 && !topology_.cpusOnNode(nic_node).empty()) {
+        home_node_ = nic_node;
+    } else if (!reactors.cpus.empty()) {
+        home_node_ = topology_.nodeOf(reactors.cpus.front());
+    } else {
+        home_node_ = topology_.nodeOf(topology_.cpus().front());
+    }
+    if (!nic_.empty() && nic_node < 0) {
+        std::cerr << "[Placement] NUMA node of " << nic_ << " unknown, using node " << home_node_ << std::endl;
+    }
+    
+    assignRemaining();
+    markShared();
+    enabled_ = true;
+    return true;
+}
+
+void ThreadPlacement::assignRemaining() {
+    // Free CPUs, home node first; CPU 0 goes last since it usually carries
+    // housekeeping and unsteered interrupts
+    std::vector<int> pool;
+    std::vector<int> order(topology_.cpusOnNode(home_node_));
+    for (int cpu : topology_.cpus()) {
+        if (topology_.nodeOf(cpu) != home_node_) order.push_back(cpu);
+    }
+    std::stable_partition(order.begin(), order.end(), [](int cpu) { return cpu != 0; });
+    for (int cpu : order) {
+        bool taken = false;
+        for (const auto& role : roles_) {
+            taken = taken || std::find(role.cpus.begin(), role.cpus.end(), cpu) != role.cpus.end();
+        }
+        if (!taken) pool.push_back(cpu);
+    }
+    
+    // Out of free CPUs: share, cycling over the home node
+    size_t next_free = 0;
+    size_t next_shared = 0;
+    const std::vector<int>& fallback = order;
+    auto take = [&]() {
+        if (next_free < pool.size()) return pool[next_free++];
+        return fallback[next_shared++ % fallback.size()];
+    };
+    
+    // Most latency-sensitive first, so they are the last to share
+    static const ThreadRole priority[] = {
+        ThreadRole::REACTOR, ThreadRole::MATCHING, ThreadRole::RISK, ThreadRole::FEED,
+        ThreadRole::PROCESSOR, ThreadRole::MARKET_DATA, ThreadRole::ACCEPT,
+        ThreadRole::JOURNAL, ThreadRole::LOGGER
+    };
+    for (ThreadRole id : priority) {
+        RolePlacement& role = roles_[static_cast<size_t>(id)];
+        if (role.explicit_map) continue;
+        for (size_t i = 0; i < role.threads; ++i) {
+            role.cpus.push_back(take());
+        }
+    }
+}
+
+void ThreadPlacement::markShared() {
+    for (size_t i = 0; i < static_cast<size_t>(ThreadRole::ROLE_COUNT); ++i) {
+        std::vector<int> mine(roles_[i].cpus);
+        std::sort(mine.begin(), mine.end());
+        // Within a role (more reactors than CPUs) or with another role
+        roles_[i].shared = std::adjacent_find(mine.begin(), mine.end()) != mine.end() ||
+                           roles_[i].threads > mine.size();
+        for (size_t j = 0; j < static_cast<size_t>(ThreadRole::ROLE_COUNT) && !roles_[i].shared; ++j) {
+            if (j == i) continue;
+            for (int cpu : roles_[j].cpus) {
+                if (std::binary_search(mine.begin(), mine.end(), cpu)) {
+                    roles_[i].shared = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int ThreadPlacement::cpuFor(ThreadRole role, size_t index) const {
+    const RolePlacement& placement = roles_[static_cast<size_t>(role)];
+    if (!enabled_ || placement.cpus.empty()) return -1;
+    return placement.cpus[index % placement.cpus.size()];
+}
+
+bool ThreadPlacement::pinCurrentThread(ThreadRole role, size_t index) const {
+    int cpu = cpuFor(role, index);
+    if (cpu < 0) return false;
+    
+    std::string name = std::string("hft-") + threadRoleName(role);
+    if (role == ThreadRole::REACTOR || roles_[static_cast<size_t>(role)].threads > 1) {
+        name += "-" + std::to_string(index);
+    }
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0) {
+        std::cerr << "[Placement] Failed to pin " << name << " to CPU " << cpu << std::endl;
+        return false;
+    }
+    
+    // Default policy already allocates on the running node; this overrides an
+    // inherited interleave policy (e.g. numactl) for the thread's own memory
+    if (topology_.nodeCount() > 1) {
+        int node = topology_.nodeOf(cpu);
+        unsigned long mask[16] = {0};
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, sizeof(mask) * 8) != 0) {
+            std::cerr << "[Placement] Failed to prefer node " << node << " for " << name
+                      << ": " << strerror(errno) << std::endl;
+        }
+    }
+    return true;
+}
+
+void ThreadPlacement::printReport() const {
+    std::cout << "=== Thread Placement ===" << std::endl;
+    if (!enabled_) {
+        std::cout << "Affinity: disabled" << std::endl;
+        std::cout << "========================" << std::endl;
+        return;
+    }
+    
+    std::cout << "CPUs: " << CpuTopology::formatCpuList(topology_.cpus())
+              << " on " << topology_.nodeCount() << " node(s)" << std::endl;
+    if (!nic_.empty()) {
+        int nic_node = CpuTopology::interfaceNode(nic_);
+        std::cout << "NIC " << nic_ << ": node " << (nic_node >= 0 ? std::to_string(nic_node) : "unknown") << std::endl;
+    }
+    
+    for (size_t i = 0; i < static_cast<size_t>(ThreadRole::ROLE_COUNT); ++i) {
+        const RolePlacement& role = roles_[i];
+        std::vector<int> nodes;
+        for (int cpu : role.cpus) {
+            nodes.push_back(topology_.nodeOf(cpu));
+        }
+        std::cout << "  " << threadRoleName(static_cast<ThreadRole>(i)) << ": cpu "
+                  << CpuTopology::formatCpuList(role.cpus) << " node " << CpuTopology::formatCpuList(nodes)
+                  << (role.explicit_map ? " (configured)" : " (auto)")
+                  << (role.shared ? " shared" : " dedicated") << std::endl;
+    }
+    
+    // Cross-node hops on the hot path are what this is meant to avoid
+    const RolePlacement& reactors = roles_[static_cast<size_t>(ThreadRole::REACTOR)];
+    for (int cpu : reactors.cpus) {
+        if (topology_.nodeOf(cpu) != home_node_) {
+            std::cout << "  warning: reactor CPU " << cpu << " is off node " << home_node_ << std::endl;
+        }
+    }
+    for (ThreadRole id : {ThreadRole::MATCHING, ThreadRole::RISK}) {
+        if (roles_[static_cast<size_t>(id)].shared) {
+            std::cout << "  warning: " << threadRoleName(id) << " shares a core" << std::endl;
+        }
+    }
+    std::cout << "========================" << std::endl;
+}
+
+} // namespace hft
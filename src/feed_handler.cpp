@@ -0,0 +1,428 @@
+#include "../include/feed_handler.hpp"
+#include "../include/framing.hpp"
+#include "../include/cpu_topology.hpp"
+#include "../include/tsc_clock.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace hft {
+
+bool parseFeedMode(const std::string& name, FeedMode& mode) {
+    if (name == "recvmmsg") {
+        mode = FeedMode::RECVMMSG;
+    } else if (name == "xdp" || name == "af_xdp") {
+        mode = FeedMode::XDP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* feedModeName(FeedMode mode) {
+    switch (mode) {
+        case FeedMode::RECVMMSG: return "recvmmsg";
+        case FeedMode::XDP: return "af_xdp";
+    }
+    return "unknown";
+}
+
+bool FeedLine::parse(const std::string& text, FeedLine& out) {
+    size_t colon = text.rfind(':');
+    if (colon == std::string::npos || colon == 0) return false;
+    
+    in_addr addr;
+    std::string group = text.substr(0, colon);
+    if (inet_pton(AF_INET, group.c_str(), &addr) != 1 || !IN_MULTICAST(ntohl(addr.s_addr))) return false;
+    
+    char* end = nullptr;
+    unsigned long port = strtoul(text.c_str() + colon + 1, &end, 10);
+    if (*end != '\0' || port == 0 || port > 65535) return false;
+    
+    out.group = group;
+    out.port = static_cast<uint16_t>(port);
+    return true;
+}
+
+// FeedHandler implementation
+constexpr size_t FeedHandler::MAX_LINES;
+constexpr size_t FeedHandler::BATCH;
+constexpr size_t FeedHandler::HOLD_CAPACITY;
+constexpr size_t FeedHandler::MAX_DATAGRAM;
+constexpr int FeedHandler::RECEIVE_BUFFER;
+
+FeedHandler::FeedHandler()
+    : headers_(new mmsghdr[BATCH]), iovecs_(new iovec[BATCH]), buffers_(BATCH * MAX_DATAGRAM),
+      held_(new HeldPacket[HOLD_CAPACITY]) {
+    for (auto& wins : wins_) {
+        wins.store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < BATCH; ++i) {
+        iovecs_[i].iov_base = buffers_.data() + i * MAX_DATAGRAM;
+        iovecs_[i].iov_len = MAX_DATAGRAM;
+        memset(&headers_[i], 0, sizeof(mmsghdr));
+        headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+        headers_[i].msg_hdr.msg_iovlen = 1;
+    }
+    for (size_t i = 0; i < HOLD_CAPACITY; ++i) {
+        held_[i].data.reset(new char[MAX_DATAGRAM]);
+    }
+}
+
+FeedHandler::~FeedHandler() {
+    stop();
+}
+
+bool FeedHandler::start(const FeedConfig& config) {
+    if (running_.load()) return false;
+    if (config.lines.empty() || config.lines.size() > MAX_LINES) {
+        std::cerr << "[Feed] Expected one or two lines, got " << config.lines.size() << std::endl;
+        return false;
+    }
+    
+    interface_ = config.interface;
+    line_count_ = config.lines.size();
+    for (size_t i = 0; i < line_count_; ++i) {
+        lines_[i] = Line();
+        lines_[i].config = config.lines[i];
+        if (!openLine(lines_[i])) {
+            stop();
+            return false;
+        }
+    }
+    
+    // The kernel sockets stay joined in AF_XDP mode: they keep the IGMP
+    // membership up and catch datagrams steered to other NIC queues
+    if (config.mode == FeedMode::XDP) {
+        std::vector<uint16_t> ports;
+        for (size_t i = 0; i < line_count_; ++i) {
+            ports.push_back(lines_[i].config.port);
+        }
+        xdp_.reset(new XdpSocket());
+        if (interface_.empty() || !xdp_->open(interface_, config.xdp_queue, ports)) {
+            std::cerr << "[Feed] AF_XDP unavailable" << (interface_.empty() ? " without an interface" : "")
+                      << ", falling back to recvmmsg" << std::endl;
+            xdp_.reset();
+        }
+    }
+    
+    next_sequence_ = 0;
+    held_count_ = 0;
+    gap_timeout_ticks_ = TscClock::fromNanos(static_cast<uint64_t>(config.gap_timeout_us) * 1000);
+    running_ = true;
+    feed_thread_ = std::thread(&FeedHandler::receiveLoop, this);
+    
+    std::cout << "[Feed] Receiving";
+    for (size_t i = 0; i < line_count_; ++i) {
+        std::cout << " " << static_cast<char>('A' + i) << "=" << lines_[i].config.group << ":" << lines_[i].config.port;
+    }
+    std::cout << " via " << (xdp_ ? "af_xdp" : "recvmmsg")
+              << (interface_.empty() ? "" : " on " + interface_) << std::endl;
+    return true;
+}
+
+bool FeedHandler::openLine(Line& line) {
+    in_addr group;
+    inet_pton(AF_INET, line.config.group.c_str(), &group);
+    line.group_addr = group.s_addr;
+    
+    line.fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (line.fd < 0) {
+        std::cerr << "[Feed] Failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    // Both lines may share a port, and other processes may listen to the feed too
+    int opt = 1;
+    setsockopt(line.fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(line.fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+    
+    // Bursts at the open arrive faster than any consumer; absorb them in the kernel
+    int rcvbuf = RECEIVE_BUFFER;
+    if (setsockopt(line.fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) != 0) {
+        setsockopt(line.fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    
+    // Bound to the group address, the socket only sees its own line
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr = group;
+    addr.sin_port = htons(line.config.port);
+    if (bind(line.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "[Feed] Failed to bind " << line.config.group << ":" << line.config.port
+                  << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    ip_mreqn membership;
+    memset(&membership, 0, sizeof(membership));
+    membership.imr_multiaddr = group;
+    membership.imr_ifindex = interface_.empty() ? 0 : static_cast<int>(if_nametoindex(interface_.c_str()));
+    if (setsockopt(line.fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+        std::cerr << "[Feed] Failed to join " << line.config.group
+                  << (interface_.empty() ? "" : " on " + interface_) << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void FeedHandler::stop() {
+    if (running_.load()) {
+        running_ = false;
+        if (feed_thread_.joinable()) {
+            feed_thread_.join();
+        }
+        printStats();
+    }
+    
+    xdp_.reset();
+    for (size_t i = 0; i < line_count_; ++i) {
+        if (lines_[i].fd >= 0) {
+            close(lines_[i].fd);
+            lines_[i].fd = -1;
+        }
+    }
+    line_count_ = 0;
+}
+
+void FeedHandler::receiveLoop() {
+    ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::FEED);
+    WaitStrategy wait = WaitStrategy::forEventLoop(wait_strategy_);
+    
+    pollfd fds[MAX_LINES + 1];
+    size_t fd_count = 0;
+    for (size_t i = 0; i < line_count_; ++i) {
+        fds[fd_count].fd = lines_[i].fd;
+        fds[fd_count++].events = POLLIN;
+    }
+    if (xdp_) {
+        fds[fd_count].fd = xdp_->fd();
+        fds[fd_count++].events = POLLIN;
+    }
+    
+    while (running_.load(std::memory_order_relaxed)) {
+        // Spinning strategies poll the rings and sockets; parking ones block in poll
+        int timeout_ms = wait.pollTimeoutMs();
+        if (timeout_ms > 0) {
+            poll(fds, fd_count, timeout_ms);
+        }
+        
+        size_t received = xdp_ ? drainXdp() : 0;
+        for (size_t i = 0; i < line_count_; ++i) {
+            received += drainSocket(i);
+        }
+        if (held_count_ > 0 && TscClock::now() >= hold_deadline_) {
+            releaseHeld(true);
+        }
+        
+        if (received == 0) {
+            if (timeout_ms == 0) {
+                wait.idle();
+            }
+            continue;
+        }
+        wait.reset();
+    }
+    if (xdp_) {
+        xdp_->release();
+    }
+    releaseHeld(true);
+}
+
+size_t FeedHandler::drainSocket(size_t line) {
+    // recvmmsg only writes back the lengths and flags, so the batch is set up once
+    int count = recvmmsg(lines_[line].fd, headers_.get(), BATCH, MSG_DONTWAIT, nullptr);
+    if (count <= 0) return 0;
+    
+    for (int i = 0; i < count; ++i) {
+        if (headers_[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            malformed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        onPacket(line, buffers_.data() + i * MAX_DATAGRAM, headers_[i].msg_len);
+    }
+    return static_cast<size_t>(count);
+}
+
+size_t FeedHandler::drainXdp() {
+    XdpSocket::Packet frames[XdpSocket::MAX_BATCH];
+    size_t count = xdp_->receive(frames, XdpSocket::MAX_BATCH);
+    for (size_t i = 0; i < count; ++i) {
+        const char* payload = nullptr;
+        size_t payload_length = 0;
+        size_t line = lineForFrame(frames[i].data, frames[i].length, payload, payload_length);
+        if (line < line_count_) {
+            onPacket(line, payload, payload_length);
+        }
+    }
+    xdp_->release();
+    return count;
+}
+
+size_t FeedHandler::lineForFrame(const char* frame, size_t length, const char*& payload, size_t& payload_length) const {
+    // Ethernet II carrying unfragmented IPv4/UDP; the program already filtered on the port
+    const size_t eth_size = 14;
+    if (length < eth_size + sizeof(iphdr) + sizeof(udphdr)) return MAX_LINES;
+    if (wire::load<uint16_t>(frame, 12) != htons(0x0800)) return MAX_LINES;
+    
+    iphdr ip;
+    memcpy(&ip, frame + eth_size, sizeof(ip));
+    size_t ip_size = ip.ihl * 4u;
+    if (ip.protocol != IPPROTO_UDP || ip_size < sizeof(iphdr) ||
+        (ntohs(ip.frag_off) & (IP_MF | IP_OFFMASK)) != 0 || length < eth_size + ip_size + sizeof(udphdr)) {
+        return MAX_LINES;
+    }
+    
+    udphdr udp;
+    memcpy(&udp, frame + eth_size + ip_size, sizeof(udp));
+    size_t udp_length = ntohs(udp.len);
+    if (udp_length < sizeof(udphdr) || eth_size + ip_size + udp_length > length) return MAX_LINES;
+    
+    uint16_t port = ntohs(udp.dest);
+    for (size_t i = 0; i < line_count_; ++i) {
+        if (lines_[i].group_addr == ip.daddr && lines_[i].config.port == port) {
+            payload = frame + eth_size + ip_size + sizeof(udphdr);
+            payload_length = udp_length - sizeof(udphdr);
+            return i;
+        }
+    }
+    return MAX_LINES;
+}
+
+void FeedHandler::onPacket(size_t line, const char* data, size_t length) {
+    packets_.fetch_add(1, std::memory_order_relaxed);
+    
+    wire::FeedPacketHeader header;
+    if (length < sizeof(header)) {
+        malformed_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.version != wire::FEED_VERSION || header.sequence == 0) {
+        malformed_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    // Join wherever the feed is; nothing before the first packet counts as lost
+    if (next_sequence_ == 0) {
+        next_sequence_ = header.sequence;
+    }
+    
+    // Ahead of the stream: the other line may still bring what is missing,
+    // so hold on to this one for up to the gap timeout
+    if (header.sequence > next_sequence_ && line_count_ > 1) {
+        hold(line, data, length, header.sequence);
+        return;
+    }
+    
+    deliver(line, header, data, length);
+    if (held_count_ > 0) {
+        releaseHeld(false);
+    }
+}
+
+void FeedHandler::hold(size_t line, const char* data, size_t length, uint64_t sequence) {
+    if (held_count_ == HOLD_CAPACITY) {
+        releaseHeld(true);
+    }
+    if (held_count_ == 0) {
+        hold_deadline_ = TscClock::now() + gap_timeout_ticks_;
+    }
+    
+    HeldPacket& held = held_[held_count_++];
+    held.sequence = sequence;
+    held.line = line;
+    held.length = length;
+    memcpy(held.data.get(), data, length);
+}
+
+void FeedHandler::releaseHeld(bool expired) {
+    // Oldest first: whatever is now contiguous, or everything once the wait is over
+    while (held_count_ > 0) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < held_count_; ++i) {
+            if (held_[i].sequence < held_[oldest].sequence) oldest = i;
+        }
+        HeldPacket& held = held_[oldest];
+        if (!expired && held.sequence > next_sequence_) break;
+        
+        wire::FeedPacketHeader header;
+        memcpy(&header, held.data.get(), sizeof(header));
+        deliver(held.line, header, held.data.get(), held.length);
+        std::swap(held, held_[--held_count_]);
+    }
+}
+
+void FeedHandler::deliver(size_t line, const wire::FeedPacketHeader& header, const char* data, size_t length) {
+    // Anything between what we have and where the packet starts was lost on every line
+    if (header.sequence > next_sequence_) {
+        gaps_.fetch_add(1, std::memory_order_relaxed);
+        missed_.fetch_add(header.sequence - next_sequence_, std::memory_order_relaxed);
+        next_sequence_ = header.sequence;
+    }
+    if (header.message_count == 0) return;
+    
+    uint64_t end = header.sequence + header.message_count;
+    if (end <= next_sequence_) {
+        // The other line already delivered all of it
+        duplicates_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    wins_[line].fetch_add(1, std::memory_order_relaxed);
+    
+    // Walk the frames, skipping the ones the other line got here first with
+    const char* frame = data + sizeof(header);
+    const char* limit = data + length;
+    size_t delivered = 0;
+    for (uint64_t sequence = header.sequence; sequence < end; ++sequence) {
+        if (static_cast<size_t>(limit - frame) < FRAME_HEADER_SIZE) {
+            malformed_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        uint32_t frame_length = decodeFrameHeader(reinterpret_cast<const uint8_t*>(frame));
+        const char* payload = frame + FRAME_HEADER_SIZE;
+        if (frame_length > static_cast<size_t>(limit - payload)) {
+            malformed_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        frame = payload + frame_length;
+        if (sequence < next_sequence_) continue;
+        
+        next_sequence_ = sequence + 1;
+        MarketDataView view(payload, frame_length);
+        if (!view.valid()) {
+            malformed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (quote_callback_) {
+            quote_callback_(view);
+        }
+        ++delivered;
+    }
+    
+    messages_.fetch_add(delivered, std::memory_order_relaxed);
+}
+
+void FeedHandler::printStats() const {
+    std::cout << "[Feed] Packets: " << getPacketCount() << ", quotes: " << getMessageCount()
+              << ", duplicates: " << getDuplicateCount() << ", gaps: " << getGapCount()
+              << " (" << getMissedCount() << " missed), malformed: " << getMalformedCount();
+    for (size_t i = 0; i < line_count_; ++i) {
+        std::cout << ", line " << static_cast<char>('A' + i) << " first " << getLineWins(i);
+    }
+    std::cout << std::endl;
+}
+
+} // namespace hft
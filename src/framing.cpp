@@ -0,0 +1,51 @@
+#include "../include/framing.hpp"
+#include "../include/message.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace hft {
+
+void encodeFrameHeader(uint32_t payload_length, uint8_t* out) {
+    for (size_t i = 0; i < FRAME_HEADER_SIZE; ++i) {
+        out[i] = (payload_length >> (i * 8)) & 0xFF;
+    }
+}
+
+uint32_t decodeFrameHeader(const uint8_t* in) {
+    uint32_t payload_length = 0;
+    for (size_t i = 0; i < FRAME_HEADER_SIZE; ++i) {
+        payload_length |= static_cast<uint32_t>(in[i]) << (i * 8);
+    }
+    return payload_length;
+}
+
+std::vector<uint8_t> frameMessage(const Message& message) {
+    size_t payload_length = message.serializedSize();
+    
+    std::vector<uint8_t> frame(FRAME_HEADER_SIZE + payload_length);
+    encodeFrameHeader(static_cast<uint32_t>(payload_length), frame.data());
+    message.serializeInto(reinterpret_cast<char*>(frame.data()) + FRAME_HEADER_SIZE);
+    return frame;
+}
+
+// FrameBuffer implementation
+FrameBuffer::FrameBuffer(size_t capacity)
+    : buffer_(std::max(capacity, 2 * (FRAME_HEADER_SIZE + MAX_FRAME_SIZE))) {
+}
+
+void FrameBuffer::compact() {
+    if (read_pos_ == write_pos_) {
+        // Fully drained: rewind for free
+        clear();
+        return;
+    }
+    
+    if (writable() >= FRAME_HEADER_SIZE + MAX_FRAME_SIZE) return;
+    
+    size_t remaining = readable();
+    memmove(buffer_.data(), buffer_.data() + read_pos_, remaining);
+    read_pos_ = 0;
+    write_pos_ = remaining;
+}
+
+} // namespace hft
@@ -0,0 +1,289 @@
+#include "../include/message.hpp"
+#include "../include/message_pool.hpp"
+#include "../include/interceptor.hpp"
+#include "../include/order_book.hpp"
+#include "../include/ring_queue.hpp"
+#include "../include/service_manager.hpp"
+#include "../include/symbol_registry.hpp"
+#include "../include/latency_histogram.hpp"
+#include "../include/pipeline_trace.hpp"
+#include "../include/tsc_clock.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sched.h>
+#include <unistd.h>
+
+using namespace hft;
+
+namespace {
+
+struct BenchOptions {
+    std::string filter;
+    size_t iterations{1000000};
+    size_t warmup{100000};
+    size_t batch{16};
+    int cpu{-1};                // -1: last CPU the process may run on
+};
+
+// Keeps the compiler from discarding a result it can prove unused
+template<typename T>
+inline void consume(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Ops are timed in batches so the clock reads do not dominate; the
+// percentiles are over per-op averages of each batch
+template<typename Op>
+void runBench(const BenchOptions& options, const char* name, Op op) {
+    if (!options.filter.empty() && std::string(name).find(options.filter) == std::string::npos) return;
+    
+    for (size_t i = 0; i < options.warmup; ++i) {
+        op(i);
+    }
+    
+    LatencyHistogram per_op;
+    size_t batches = std::max<size_t>(options.iterations / options.batch, 1);
+    size_t index = options.warmup;
+    uint64_t total_ticks = 0;
+    for (size_t b = 0; b < batches; ++b) {
+        uint64_t start = TscClock::now();
+        for (size_t j = 0; j < options.batch; ++j) {
+            op(index++);
+        }
+        uint64_t ticks = TscClock::nowOrdered() - start;
+        total_ticks += ticks;
+        per_op.record(TscClock::toNanos(ticks) / options.batch);
+    }
+    
+    size_t ops = batches * options.batch;
+    printf("%-32s %10zu %9.1f %8llu %8llu %8llu %9llu\n", name, ops,
+           static_cast<double>(TscClock::toNanos(total_ticks)) / ops,
+           static_cast<unsigned long long>(per_op.percentile(0.50)),
+           static_cast<unsigned long long>(per_op.percentile(0.99)),
+           static_cast<unsigned long long>(per_op.percentile(0.999)),
+           static_cast<unsigned long long>(per_op.max()));
+    fflush(stdout);
+}
+
+// CPUs the process could use before the main thread pinned itself
+cpu_set_t g_allowed_cpus;
+
+bool pinToCpu(int cpu) {
+    cpu_set_t& allowed = g_allowed_cpus;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return false;
+    if (cpu < 0) {
+        for (int i = CPU_SETSIZE - 1; i >= 0; --i) {
+            if (CPU_ISSET(i, &allowed)) {
+                cpu = i;
+                break;
+            }
+        }
+    }
+    
+    cpu_set_t target;
+    CPU_ZERO(&target);
+    CPU_SET(cpu, &target);
+    if (sched_setaffinity(0, sizeof(target), &target) != 0) {
+        std::cerr << "[Bench] Failed to pin to CPU " << cpu << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::cout << "[Bench] Pinned to CPU " << cpu << std::endl;
+    return true;
+}
+
+OrderMessage makeOrder(uint64_t sequence) {
+    OrderMessage order(sequence, "AAPL", 150.50, 100, true);
+    order.setSequenceNumber(sequence);
+    order.setClientId(7);
+    return order;
+}
+
+void benchCodec(const BenchOptions& options) {
+    OrderMessage order = makeOrder(1);
+    char buffer[256];
+    size_t length = order.serializeInto(buffer);
+    
+    runBench(options, "codec.order_serialize", [&](size_t i) {
+        order.setSequenceNumber(i + 1);
+        consume(order.serializeInto(buffer));
+    });
+    runBench(options, "codec.order_serialize_vector", [&](size_t i) {
+        order.setSequenceNumber(i + 1);
+        std::vector<uint8_t> bytes = order.serialize();
+        consume(bytes.data());
+    });
+    
+    OrderMessage decoded;
+    runBench(options, "codec.order_deserialize", [&](size_t) {
+        consume(decoded.deserialize(buffer, length));
+    });
+    runBench(options, "codec.order_view", [&](size_t) {
+        OrderView view(buffer, length);
+        consume(view.valid() ? view.getOrderId() + view.getQuantity() : 0);
+    });
+    
+    runBench(options, "factory.create_message", [&](size_t) {
+        std::shared_ptr<Message> message = MessageFactory::createMessage(buffer, length);
+        consume(message.get());
+    });
+    runBench(options, "pool.decode", [&](size_t) {
+        MessageHandle message = MessagePool::local().decode(buffer, length);
+        consume(message.get());
+    });
+}
+
+void benchInterceptors(const BenchOptions& options) {
+    OrderMessage order = makeOrder(1);
+    
+    // Rate limits far above what one thread can send, so nothing throttles
+    InterceptorChain dynamic_chain;
+    dynamic_chain.addInterceptor(std::make_shared<ValidationInterceptor>());
+    dynamic_chain.addInterceptor(std::make_shared<ThrottlingInterceptor>(1e12));
+    runBench(options, "interceptor.dynamic_chain", [&](size_t) {
+        InterceptorContext context(order);
+        consume(dynamic_chain.process(context));
+    });
+    
+    StaticInterceptorChain<ValidationInterceptor, ThrottlingInterceptor> static_chain(ValidationInterceptor(), 1e12);
+    runBench(options, "interceptor.static_chain", [&](size_t) {
+        InterceptorContext context(order);
+        consume(static_chain.process(context));
+    });
+}
+
+void benchQueue(const BenchOptions& options) {
+    SpscQueue<OrderMessage> queue(1024);
+    OrderMessage order = makeOrder(1);
+    OrderMessage out;
+    runBench(options, "queue.spsc_push_pop", [&](size_t) {
+        queue.tryPush(order);
+        consume(queue.tryPop(out));
+    });
+}
+
+void benchBook(const BenchOptions& options) {
+    OrderBook book(150.00);
+    size_t executions = 0;
+    book.setExecutionCallback([&executions](const Execution&) { ++executions; });
+    
+    // Seed both sides so incoming orders alternate between resting and trading
+    uint64_t next_order_id = 1;
+    for (int level = 1; level <= 50; ++level) {
+        book.addOrder(next_order_id++, 1, true, 150.00 - level * 0.01, 100);
+        book.addOrder(next_order_id++, 1, false, 150.00 + level * 0.01, 100);
+    }
+    
+    runBench(options, "book.add_cancel", [&](size_t i) {
+        bool is_buy = (i % 2) == 0;
+        uint64_t order_id = next_order_id++;
+        book.addOrder(order_id, 2, is_buy, 150.00, 50);
+        book.cancelOrder(order_id);
+    });
+    
+    // A resting order and the one that fills it completely
+    runBench(options, "book.add_cross", [&](size_t) {
+        book.addOrder(next_order_id++, 1, true, 150.00, 100);
+        book.addOrder(next_order_id++, 2, false, 150.00, 100);
+    });
+    consume(executions);
+}
+
+void benchServices(const BenchOptions& options) {
+    if (!options.filter.empty() && std::string("service.publish").find(options.filter) == std::string::npos) return;
+    
+    // One matching shard behind the subscription bus, as the reactors see it
+    auto& service_manager = ServiceManager::getInstance();
+    auto matching_service = std::make_shared<OrderMatchingService>(1);
+    service_manager.registerService(matching_service);
+    
+    // Threads inherit the creator's mask; keep the shard off the benchmark's CPU
+    cpu_set_t pinned;
+    sched_getaffinity(0, sizeof(pinned), &pinned);
+    cpu_set_t others = g_allowed_cpus;
+    for (int i = 0; i < CPU_SETSIZE; ++i) {
+        if (CPU_ISSET(i, &pinned) && CPU_COUNT(&others) > 1) CPU_CLR(i, &others);
+    }
+    sched_setaffinity(0, sizeof(others), &others);
+    service_manager.startAllServices();
+    sched_setaffinity(0, sizeof(pinned), &pinned);
+    
+    OrderMessage order = makeOrder(1);
+    runBench(options, "service.publish", [&](size_t i) {
+        order.setSequenceNumber(i + 1);
+        order.setOrderId(i + 1);
+        order.setBuy(i % 2 == 0);
+        service_manager.publish(order);
+    });
+    service_manager.stopAllServices();
+    
+    // The shard stamps dequeue and match on every order it handles
+    LatencyHistogram match;
+    PipelineTracer::getInstance().getStageSnapshot(TraceStage::MATCH, match);
+    printf("%-32s %10llu %9.1f %8llu %8llu %8llu %9llu\n", "service.match (shard thread)",
+           static_cast<unsigned long long>(match.count()), match.mean(),
+           static_cast<unsigned long long>(match.percentile(0.50)),
+           static_cast<unsigned long long>(match.percentile(0.99)),
+           static_cast<unsigned long long>(match.percentile(0.999)),
+           static_cast<unsigned long long>(match.max()));
+    std::cout << "[Bench] Matching: " << matching_service->getFillCount() << " fills, "
+              << matching_service->getRejectCount() << " rejects (full rings count as rejects)" << std::endl;
+}
+
+void printUsage() {
+    std::cout << "Usage: ./hft_bench [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -f <filter>         Run only benchmarks whose name contains <filter>" << std::endl;
+    std::cout << "  -n <iterations>     Timed operations per benchmark (default: 1000000)" << std::endl;
+    std::cout << "  -w <iterations>     Untimed warmup operations (default: 100000)" << std::endl;
+    std::cout << "  -b <batch>          Operations per clock read (default: 16)" << std::endl;
+    std::cout << "  -c <cpu>            CPU to pin to (default: last allowed CPU)" << std::endl;
+    std::cout << "  -h                  Show this help message" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "-f" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "-n" && i + 1 < argc) {
+            options.iterations = std::stoul(argv[++i]);
+        } else if (arg == "-w" && i + 1 < argc) {
+            options.warmup = std::stoul(argv[++i]);
+        } else if (arg == "-b" && i + 1 < argc) {
+            options.batch = std::max<size_t>(std::stoul(argv[++i]), 1);
+        } else if (arg == "-c" && i + 1 < argc) {
+            options.cpu = std::stoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    
+#ifndef __OPTIMIZE__
+    std::cout << "[Bench] Warning: built without optimization; configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+    SymbolRegistry::getInstance().load({"AAPL", "MSFT", "GOOGL", "AMZN", "NVDA", "META", "TSLA", "SPY", "QQQ", "IWM"});
+    TscClock::calibrate();
+    pinToCpu(options.cpu);
+    
+    printf("%-32s %10s %9s %8s %8s %8s %9s\n", "benchmark (ns/op)", "ops", "mean", "p50", "p99", "p99.9", "max");
+    benchCodec(options);
+    benchInterceptors(options);
+    benchQueue(options);
+    benchBook(options);
+    benchServices(options);
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "../include/stats_segment.hpp"
+#include "../include/latency_histogram.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace hft;
+
+namespace {
+
+struct StatsOptions {
+    std::string name{stats::DEFAULT_NAME};
+    std::string filter;
+    uint32_t interval_ms{0};    // 0: print one snapshot and exit
+    size_t count{0};            // Snapshots to print with -i; 0 runs until interrupted
+};
+
+// Consistent copy of the shared segment. Everything past the header is
+// copied only as far as the published counts reach.
+struct Snapshot {
+    uint32_t pid{0};
+    uint64_t publish_ns{0};
+    uint64_t publish_count{0};
+    uint32_t interval_ms{0};
+    std::vector<stats::CounterEntry> counters;
+    std::vector<stats::HistogramEntry> histograms;
+};
+
+const stats::Segment* mapSegment(const std::string& name, ino_t& inode) {
+    std::string shm_name = "/" + name;
+    int fd = shm_open(shm_name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "[Stats] Failed to open /dev/shm" << shm_name << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(stats::Segment)) {
+        std::cerr << "[Stats] /dev/shm" << shm_name << " is not a stats segment" << std::endl;
+        close(fd);
+        return nullptr;
+    }
+    inode = info.st_ino;
+    void* base = mmap(nullptr, sizeof(stats::Segment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "[Stats] Failed to map /dev/shm" << shm_name << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    
+    const stats::Segment* segment = static_cast<const stats::Segment*>(base);
+    const stats::SegmentHeader& header = segment->header;
+    if (memcmp(header.magic, stats::MAGIC, sizeof(header.magic)) != 0 || header.version != stats::VERSION ||
+        header.header_size != sizeof(stats::SegmentHeader) || header.bucket_count != LatencyHistogram::BUCKET_COUNT) {
+        std::cerr << "[Stats] /dev/shm" << shm_name << " is not a version " << stats::VERSION
+                  << " stats segment (or the server is still starting)" << std::endl;
+        munmap(base, sizeof(stats::Segment));
+        return nullptr;
+    }
+    return segment;
+}
+
+bool readSnapshot(const stats::Segment& segment, Snapshot& out) {
+    const stats::SegmentHeader& header = segment.header;
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        uint64_t before = header.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+        
+        // Counts are range-checked so a torn read cannot run off the segment
+        size_t counters = std::min<size_t>(header.counter_count, stats::MAX_COUNTERS);
+        size_t histograms = std::min<size_t>(header.histogram_count, stats::MAX_HISTOGRAMS);
+        out.pid = header.pid;
+        out.publish_ns = header.publish_ns;
+        out.publish_count = header.publish_count;
+        out.interval_ms = header.interval_ms;
+        out.counters.assign(segment.counters, segment.counters + counters);
+        out.histograms.assign(segment.histograms, segment.histograms + histograms);
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header.sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+void toHistogram(const stats::HistogramEntry& entry, LatencyHistogram& out) {
+    out.reset();
+    for (size_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+        if (entry.buckets[i]) out.recordCount(LatencyHistogram::bucketLower(i), entry.buckets[i]);
+    }
+}
+
+bool matches(const StatsOptions& options, const char* name) {
+    return options.filter.empty() || strstr(name, options.filter.c_str()) != nullptr;
+}
+
+// With a baseline, counters also show their rate and histograms cover only
+// what was recorded since the baseline was taken
+void printSnapshot(const StatsOptions& options, const Snapshot& current, const Snapshot* baseline) {
+    time_t seconds = static_cast<time_t>(current.publish_ns / 1000000000ULL);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    char when[32];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+    printf("=== /dev/shm/%s: pid %u, snapshot %llu at %s.%03llu, published every %u ms ===\n",
+           options.name.c_str(), current.pid, static_cast<unsigned long long>(current.publish_count), when,
+           static_cast<unsigned long long>(current.publish_ns / 1000000ULL % 1000ULL), current.interval_ms);
+    
+    double elapsed_s = baseline && current.publish_ns > baseline->publish_ns
+                       ? (current.publish_ns - baseline->publish_ns) / 1e9 : 0.0;
+    printf("%-40s %16s %14s\n", "counter", "value", elapsed_s > 0 ? "rate/s" : "");
+    for (size_t i = 0; i < current.counters.size(); ++i) {
+        const stats::CounterEntry& counter = current.counters[i];
+        if (!matches(options, counter.name)) continue;
+        printf("%-40.*s %16llu", static_cast<int>(stats::NAME_LENGTH), counter.name,
+               static_cast<unsigned long long>(counter.value));
+        if (elapsed_s > 0 && i < baseline->counters.size() && counter.value >= baseline->counters[i].value) {
+            printf(" %14.1f", (counter.value - baseline->counters[i].value) / elapsed_s);
+        }
+        printf("\n");
+    }
+    
+    printf("%-40s %12s %9s %9s %9s %9s %9s\n", elapsed_s > 0 ? "histogram (μs, this interval)" : "histogram (μs)",
+           "count", "mean", "p50", "p99", "p99.9", "max");
+    LatencyHistogram histogram;
+    LatencyHistogram previous;
+    for (size_t i = 0; i < current.histograms.size(); ++i) {
+        const stats::HistogramEntry& entry = current.histograms[i];
+        if (!matches(options, entry.name)) continue;
+        
+        toHistogram(entry, histogram);
+        uint64_t sum = entry.sum;
+        uint64_t max = entry.max;
+        if (elapsed_s > 0 && i < baseline->histograms.size() && entry.count >= baseline->histograms[i].count) {
+            toHistogram(baseline->histograms[i], previous);
+            histogram.subtract(previous);
+            sum -= baseline->histograms[i].sum;
+            max = histogram.max();
+        }
+        if (histogram.count() == 0) {
+            printf("%-40.*s %12d\n", static_cast<int>(stats::NAME_LENGTH), entry.name, 0);
+            continue;
+        }
+        printf("%-40.*s %12llu %9.3f %9.3f %9.3f %9.3f %9.3f\n", static_cast<int>(stats::NAME_LENGTH), entry.name,
+               static_cast<unsigned long long>(histogram.count()),
+               static_cast<double>(sum) / histogram.count() / 1000.0,
+               histogram.percentile(0.50) / 1000.0, histogram.percentile(0.99) / 1000.0,
+               histogram.percentile(0.999) / 1000.0, max / 1000.0);
+    }
+    fflush(stdout);
+}
+
+void printUsage() {
+    std::cout << "Usage: ./hft_stats [options] [segment]" << std::endl;
+    std::cout << "Reads the stats segment a running hft_server publishes with --stats (default: "
+              << stats::DEFAULT_NAME << ")" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -i <ms>             Print every <ms>, with rates and per-interval histograms (default: once)" << std::endl;
+    std::cout << "  -n <count>          Stop after <count> snapshots with -i (default: until interrupted)" << std::endl;
+    std::cout << "  -f <filter>         Only counters and histograms whose name contains <filter>" << std::endl;
+    std::cout << "  -h                  Show this help message" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    StatsOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "-i" && i + 1 < argc) {
+            options.interval_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "-n" && i + 1 < argc) {
+            options.count = std::stoul(argv[++i]);
+        } else if (arg == "-f" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.name = arg;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    
+    ino_t inode = 0;
+    const stats::Segment* segment = mapSegment(options.name, inode);
+    if (!segment) return 1;
+    
+    std::unique_ptr<Snapshot> current(new Snapshot());
+    std::unique_ptr<Snapshot> baseline;
+    for (size_t printed = 0; ; ) {
+        if (readSnapshot(*segment, *current)) {
+            printSnapshot(options, *current, baseline.get());
+            if (options.interval_ms == 0 || (options.count > 0 && ++printed >= options.count)) break;
+            
+            if (!baseline) baseline.reset(new Snapshot());
+            std::swap(baseline, current);
+        } else if (options.interval_ms == 0) {
+            std::cerr << "[Stats] Segment kept changing under the reader" << std::endl;
+            break;
+        }
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.interval_ms));
+        
+        // The server removes the segment on shutdown and a restarted one makes
+        // a new file; either way this mapping would only repeat its last snapshot
+        struct stat info;
+        std::string path = "/dev/shm/" + options.name;
+        if (stat(path.c_str(), &info) != 0 || info.st_ino != inode) {
+            std::cerr << "[Stats] " << path << " removed or replaced, server stopped" << std::endl;
+            break;
+        }
+    }
+    
+    munmap(const_cast<stats::Segment*>(segment), sizeof(stats::Segment));
+    return 0;
+}
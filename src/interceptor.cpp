@@ -1,38 +1,47 @@
 #include "../include/interceptor.hpp"
 #include "../include/message.hpp"
+#include "../include/symbol_registry.hpp"
+#include "../include/tsc_clock.hpp"
+#include "../include/risk_engine.hpp"
+#include "../include/async_logger.hpp"
 #include <iostream>
 #include <algorithm>
 #include <numeric>
-#include <sstream>
 
 namespace hft {
 
-// InterceptorContext implementation
-InterceptorContext::InterceptorContext(std::shared_ptr<Message> msg)
-    : message_(msg) {
-    startTimer();
-}
-
-void InterceptorContext::startTimer() {
-    start_time_ = std::chrono::high_resolution_clock::now();
-}
+namespace {
 
-void InterceptorContext::endTimer() {
-    end_time_ = std::chrono::high_resolution_clock::now();
-}
+const LogSite LOG_INBOUND = {LogLevel::INFO, "Inbound", "type={} seq={} client={} priority={}"};
 
-double InterceptorContext::getLatencyUs() const {
-    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time_ - start_time_);
-    return duration.count() / 1000.0; // Convert to microseconds
-}
+} // namespace
 
-void InterceptorContext::setMetadata(const std::string& key, const std::string& value) {
-    metadata_[key] = value;
+const char* interceptStatusName(InterceptStatus status) {
+    switch (status) {
+        case InterceptStatus::OK: return "ok";
+        case InterceptStatus::NULL_MESSAGE: return "null message";
+        case InterceptStatus::INVALID_SEQUENCE: return "invalid sequence number";
+        case InterceptStatus::INVALID_TIMESTAMP: return "invalid timestamp";
+        case InterceptStatus::INVALID_ORDER_ID: return "invalid order id";
+        case InterceptStatus::UNKNOWN_SYMBOL: return "unknown symbol";
+        case InterceptStatus::INVALID_PRICE: return "invalid price";
+        case InterceptStatus::INVALID_QUANTITY: return "invalid quantity";
+        case InterceptStatus::INVALID_QUOTE: return "invalid bid/ask";
+        case InterceptStatus::CROSSED_QUOTE: return "bid >= ask";
+        case InterceptStatus::THROTTLED: return "rate limit exceeded";
+        case InterceptStatus::RISK_REJECTED: return "pre-trade risk reject";
+        case InterceptStatus::ENGINE_UNAVAILABLE: return "matching engine unavailable";
+    }
+    return "unknown";
 }
 
-std::string InterceptorContext::getMetadata(const std::string& key) const {
-    auto it = metadata_.find(key);
-    return (it != metadata_.end()) ? it->second : "";
+// InterceptorContext implementation
+InterceptorContext::InterceptorContext(const Message& msg)
+    : message_(&msg), status_(InterceptStatus::OK), flags_(0) {
+    for (auto& field : fields_) {
+        field = 0;
+    }
+    startTimer();
 }
 
 // InterceptorChain implementation
@@ -54,65 +63,52 @@ void InterceptorChain::clear() {
 }
 
 // ValidationInterceptor implementation
-bool ValidationInterceptor::intercept(InterceptorContext& context) {
-    auto message = context.getMessage();
+bool ValidationInterceptor::check(InterceptorContext& context) {
+    const Message* message = context.getMessage();
     if (!message) {
-        context.setMetadata("error", "Null message");
-        return false;
+        return context.reject(InterceptStatus::NULL_MESSAGE);
     }
     
     // Basic validation
     if (message->getSequenceNumber() == 0) {
-        context.setMetadata("error", "Invalid sequence number");
-        return false;
+        return context.reject(InterceptStatus::INVALID_SEQUENCE);
     }
     
     if (message->getTimestamp() == 0) {
-        context.setMetadata("error", "Invalid timestamp");
-        return false;
+        return context.reject(InterceptStatus::INVALID_TIMESTAMP);
     }
     
-    // Message-specific validation
+    // Message-specific validation; the factory and pool only ever build
+    // ORDER_* types as OrderMessage and MARKET_DATA as MarketDataMessage
     switch (message->getType()) {
         case MessageType::ORDER_NEW:
         case MessageType::ORDER_CANCEL:
         case MessageType::ORDER_REPLACE: {
-            auto order_msg = std::dynamic_pointer_cast<OrderMessage>(message);
-            if (order_msg) {
-                if (order_msg->getOrderId() == 0) {
-                    context.setMetadata("error", "Invalid order ID");
-                    return false;
-                }
-                if (order_msg->getSymbol().empty()) {
-                    context.setMetadata("error", "Empty symbol");
-                    return false;
-                }
-                if (order_msg->getPrice() <= 0.0) {
-                    context.setMetadata("error", "Invalid price");
-                    return false;
-                }
-                if (order_msg->getQuantity() == 0) {
-                    context.setMetadata("error", "Invalid quantity");
-                    return false;
-                }
+            const OrderMessage& order_msg = static_cast<const OrderMessage&>(*message);
+            if (order_msg.getOrderId() == 0) {
+                return context.reject(InterceptStatus::INVALID_ORDER_ID);
+            }
+            if (SymbolRegistry::getInstance().verify(order_msg.getSymbolId(), order_msg.getSymbol()) == INVALID_SYMBOL_ID) {
+                return context.reject(InterceptStatus::UNKNOWN_SYMBOL);
+            }
+            if (order_msg.getPrice() <= 0.0) {
+                return context.reject(InterceptStatus::INVALID_PRICE);
+            }
+            if (order_msg.getQuantity() == 0) {
+                return context.reject(InterceptStatus::INVALID_QUANTITY);
             }
             break;
         }
         case MessageType::MARKET_DATA: {
-            auto md_msg = std::dynamic_pointer_cast<MarketDataMessage>(message);
-            if (md_msg) {
-                if (md_msg->getSymbol().empty()) {
-                    context.setMetadata("error", "Empty symbol");
-                    return false;
-                }
-                if (md_msg->getBid() < 0.0 || md_msg->getAsk() < 0.0) {
-                    context.setMetadata("error", "Invalid bid/ask");
-                    return false;
-                }
-                if (md_msg->getBid() >= md_msg->getAsk()) {
-                    context.setMetadata("error", "Bid >= Ask");
-                    return false;
-                }
+            const MarketDataMessage& md_msg = static_cast<const MarketDataMessage&>(*message);
+            if (SymbolRegistry::getInstance().verify(md_msg.getSymbolId(), md_msg.getSymbol()) == INVALID_SYMBOL_ID) {
+                return context.reject(InterceptStatus::UNKNOWN_SYMBOL);
+            }
+            if (md_msg.getBid() < 0.0 || md_msg.getAsk() < 0.0) {
+                return context.reject(InterceptStatus::INVALID_QUOTE);
+            }
+            if (md_msg.getBid() >= md_msg.getAsk()) {
+                return context.reject(InterceptStatus::CROSSED_QUOTE);
             }
             break;
         }
@@ -120,72 +116,188 @@ bool ValidationInterceptor::intercept(InterceptorContext& context) {
             break;
     }
     
-    context.setMetadata("validation", "passed");
+    context.setFlag(FLAG_VALIDATED);
     return true;
 }
 
 // LoggingInterceptor implementation
-bool LoggingInterceptor::intercept(InterceptorContext& context) {
-    auto message = context.getMessage();
-    if (!message) return false;
-    
-    // Log message details (in production, use proper logging framework)
-    std::stringstream ss;
-    ss << "Processing message: Type=" << static_cast<int>(message->getType())
-       << ", Seq=" << message->getSequenceNumber()
-       << ", Client=" << message->getClientId()
-       << ", Priority=" << static_cast<int>(message->getPriority());
-    
-    context.setMetadata("log", ss.str());
-    
-    // In production, this would write to a log file or syslog
-    // std::cout << "[LOG] " << ss.str() << std::endl;
+bool LoggingInterceptor::check(InterceptorContext& context) {
+    if (!context.getMessage()) {
+        return context.reject(InterceptStatus::NULL_MESSAGE);
+    }
     
+    // Raw fields only; the logger thread does the formatting
+    const Message& message = *context.getMessage();
+    AsyncLogger::getInstance().log(LOG_INBOUND, message.getType(), message.getSequenceNumber(),
+                                   message.getClientId(), message.getPriority());
+    context.setFlag(FLAG_LOGGED);
     return true;
 }
 
 // PerformanceInterceptor implementation
-bool PerformanceInterceptor::intercept(InterceptorContext& context) {
+bool PerformanceInterceptor::check(InterceptorContext& context) {
     context.endTimer();
-    double latency = context.getLatencyUs();
+    uint64_t latency_ns = context.getLatencyNs();
     
     // Record performance metrics
-    context.setMetadata("latency_us", std::to_string(latency));
+    context.setField(ContextField::LATENCY_NS, latency_ns);
+    context.setFlag(FLAG_MEASURED);
     
     // Check if latency exceeds threshold (10 microseconds target)
-    if (latency > 10.0) {
-        context.setMetadata("performance_warning", "Latency exceeds 10us threshold");
-        // In production, this could trigger alerts or performance degradation handling
+    if (latency_ns > 10000) {
+        context.setFlag(FLAG_LATENCY_WARNING);
     }
     
     return true;
 }
 
 // ThrottlingInterceptor implementation
-ThrottlingInterceptor::ThrottlingInterceptor(size_t max_messages_per_second)
-    : max_messages_per_second_(max_messages_per_second), message_count_(0) {
-    last_check_ = std::chrono::steady_clock::now();
+ThrottlingInterceptor::ThrottlingInterceptor(const ThrottleConfig& config)
+    : default_limits_(makeLimits(config.messages_per_second, config.burst)), shard_capacity_(2) {
+    // Keep the table at most half full
+    while (shard_capacity_ < config.max_clients_per_thread * 2) {
+        shard_capacity_ <<= 1;
+    }
+    for (auto& shard : shards_) {
+        shard.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ThrottlingInterceptor::~ThrottlingInterceptor() {
+    for (auto& shard : shards_) {
+        delete shard.load(std::memory_order_relaxed);
+    }
+}
+
+ThrottlingInterceptor::Limits ThrottlingInterceptor::makeLimits(double messages_per_second, double burst) const {
+    Limits limits;
+    limits.tokens_per_tick = messages_per_second / (TscClock::ticksPerNano() * 1e9);
+    limits.burst = (burst > 0.0) ? burst : std::max(1.0, messages_per_second / 100.0);
+    return limits;
+}
+
+void ThrottlingInterceptor::setClientLimits(uint64_t client_id, double messages_per_second, double burst) {
+    {
+        std::lock_guard<std::mutex> lock(overrides_mutex_);
+        overrides_[client_id] = makeLimits(messages_per_second, burst);
+    }
+    generation_.fetch_add(1, std::memory_order_release);
 }
 
-bool ThrottlingInterceptor::intercept(InterceptorContext& context) {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_check_).count();
+void ThrottlingInterceptor::clearClientLimits(uint64_t client_id) {
+    {
+        std::lock_guard<std::mutex> lock(overrides_mutex_);
+        overrides_.erase(client_id);
+    }
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+ThrottlingInterceptor::Limits ThrottlingInterceptor::limitsFor(uint64_t client_id) const {
+    std::lock_guard<std::mutex> lock(overrides_mutex_);
+    auto it = overrides_.find(client_id);
+    return (it != overrides_.end()) ? it->second : default_limits_;
+}
+
+ThrottlingInterceptor::Shard& ThrottlingInterceptor::localShard() {
+    std::atomic<Shard*>& slot = shards_[currentThreadSlot()];
+    Shard* shard = slot.load(std::memory_order_relaxed);
+    if (!shard) {
+        // First message seen on this thread; only the owner ever writes the slot
+        shard = new Shard();
+        shard->buckets.resize(shard_capacity_);
+        for (auto& bucket : shard->buckets) {
+            bucket.used = false;
+        }
+        shard->used_count = 0;
+        resetBucket(shard->overflow, 0, TscClock::now());
+        slot.store(shard, std::memory_order_relaxed);
+    }
+    return *shard;
+}
+
+void ThrottlingInterceptor::resetBucket(Bucket& bucket, uint64_t client_id, uint64_t now) {
+    bucket.client_id = client_id;
+    bucket.generation = generation_.load(std::memory_order_acquire);
+    bucket.limits = limitsFor(client_id);
+    bucket.tokens = bucket.limits.burst;
+    bucket.last_ticks = now;
+    bucket.used = true;
+}
+
+ThrottlingInterceptor::Bucket& ThrottlingInterceptor::bucketFor(Shard& shard, uint64_t client_id) {
+    size_t mask = shard.buckets.size() - 1;
+    uint64_t hash = client_id * 0x9E3779B97F4A7C15ull;
+    size_t index = static_cast<size_t>(hash ^ (hash >> 32)) & mask;
+    
+    while (shard.buckets[index].used) {
+        if (shard.buckets[index].client_id == client_id) {
+            return shard.buckets[index];
+        }
+        index = (index + 1) & mask;
+    }
     
-    std::lock_guard<std::mutex> lock(throttle_mutex_);
+    if (shard.used_count * 2 >= shard.buckets.size()) {
+        return shard.overflow;
+    }
+    
+    ++shard.used_count;
+    resetBucket(shard.buckets[index], client_id, TscClock::now());
+    return shard.buckets[index];
+}
+
+bool ThrottlingInterceptor::check(InterceptorContext& context) {
+    const Message* message = context.getMessage();
+    if (!message) {
+        return context.reject(InterceptStatus::NULL_MESSAGE);
+    }
+    
+    Bucket& bucket = bucketFor(localShard(), message->getClientId());
+    uint64_t now = TscClock::now();
+    
+    // Limits changed since this bucket last looked; rare, so the lock is fine
+    if (bucket.generation != generation_.load(std::memory_order_relaxed)) {
+        bucket.generation = generation_.load(std::memory_order_acquire);
+        bucket.limits = limitsFor(bucket.client_id);
+    }
+    
+    // Refill for the elapsed ticks, capped at the burst size
+    if (now > bucket.last_ticks) {
+        bucket.tokens = std::min(bucket.limits.burst,
+                                 bucket.tokens + (now - bucket.last_ticks) * bucket.limits.tokens_per_tick);
+        bucket.last_ticks = now;
+    }
+    
+    if (bucket.tokens < 1.0) {
+        return context.reject(InterceptStatus::THROTTLED);
+    }
+    
+    bucket.tokens -= 1.0;
+    context.setFlag(FLAG_THROTTLE_ACCEPTED);
+    return true;
+}
+
+// RiskInterceptor implementation
+bool RiskInterceptor::check(InterceptorContext& context) {
+    const Message* message = context.getMessage();
+    if (!message) {
+        return context.reject(InterceptStatus::NULL_MESSAGE);
+    }
     
-    if (elapsed >= 1000) { // Reset counter every second
-        message_count_ = 0;
-        last_check_ = now;
+    MessageType type = message->getType();
+    if (!engine_ || (type != MessageType::ORDER_NEW && type != MessageType::ORDER_REPLACE)) {
+        return true;
     }
     
-    if (message_count_ >= max_messages_per_second_) {
-        context.setMetadata("throttled", "Rate limit exceeded");
-        return false; // Reject message
+    // Splits the chain's time into the stages before risk and risk itself
+    context.setField(ContextField::RISK_START_TICKS, TscClock::now());
+    RiskResult result = engine_->checkOrder(static_cast<const OrderMessage&>(*message));
+    if (result != RiskResult::OK) {
+        context.setField(ContextField::RISK_RESULT, static_cast<uint64_t>(result));
+        return context.reject(InterceptStatus::RISK_REJECTED);
     }
     
-    message_count_++;
-    context.setMetadata("throttle_status", "accepted");
+    context.setFlag(FLAG_RISK_ACCEPTED);
     return true;
 }
 
-} // namespace hft 
\ No newline at end of file
+} // namespace hft
@@ -0,0 +1,487 @@
+#include "../include/io_uring.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HFT_HAVE_IO_URING 1
+#endif
+#endif
+
+#ifdef HFT_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace hft {
+
+#ifdef HFT_HAVE_IO_URING
+
+namespace {
+
+// The ring indices are shared with the kernel; these pair with its
+// smp_load_acquire/smp_store_release on the other side
+inline unsigned loadAcquire(const unsigned* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+inline void storeRelease(unsigned* p, unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+struct KernelTimespec {
+    int64_t tv_sec;
+    long long tv_nsec;
+};
+
+int sysSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sysRegister(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+} // namespace
+
+IoUring::IoUring() {}
+
+IoUring::~IoUring() {
+    cleanup();
+}
+
+bool IoUring::init(unsigned entries, bool sqpoll) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    
+    // Multishot recv can post several completions per submission, so give the
+    // completion queue headroom; the optional flags are dropped on old kernels.
+    // No COOP_TASKRUN: a reactor spinning in user space must still see
+    // completions without entering the kernel
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    params.cq_entries = entries * 4;
+    if (sqpoll) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = 1000;   // ms before the poller sleeps
+    }
+    
+    ring_fd_ = sysSetup(entries, &params);
+    if (ring_fd_ < 0 && errno == EINVAL) {
+        params.flags &= ~static_cast<unsigned>(IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP);
+        ring_fd_ = sysSetup(entries, &params);
+    }
+    if (ring_fd_ < 0) {
+        std::cerr << "[IoUring] io_uring_setup failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    sqpoll_ = (params.flags & IORING_SETUP_SQPOLL) != 0;
+    
+    // The reactor waits with a timeout through IORING_ENTER_EXT_ARG (5.11);
+    // without it there is no bounded wait, so stay on epoll
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        std::cerr << "[IoUring] Kernel lacks IORING_FEAT_EXT_ARG" << std::endl;
+        cleanup();
+        return false;
+    }
+    cqe_skip_ = (params.features & IORING_FEAT_CQE_SKIP) != 0;
+    
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        std::cerr << "[IoUring] Failed to map submission ring: " << std::strerror(errno) << std::endl;
+        cleanup();
+        return false;
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            std::cerr << "[IoUring] Failed to map completion ring: " << std::strerror(errno) << std::endl;
+            cleanup();
+            return false;
+        }
+    }
+    
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        sqes_ = nullptr;
+        std::cerr << "[IoUring] Failed to map submission entries: " << std::strerror(errno) << std::endl;
+        cleanup();
+        return false;
+    }
+    
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_flags_ = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    sqe_tail_ = submitted_tail_ = *sq_tail_;
+    
+    // Identity mapping: SQE i always sits in array slot i
+    for (unsigned i = 0; i < sq_entries_; ++i) {
+        sq_array_[i] = i;
+    }
+    
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+    return true;
+}
+
+bool IoUring::setupBuffers(uint16_t group, uint32_t count, uint32_t size) {
+    uint32_t entries = 1;
+    while (entries < count && entries < 32768) {
+        entries <<= 1;
+    }
+    
+    buf_count_ = entries;
+    buffer_group_ = group;
+    buffer_size_ = size;
+    buffers_.assign(static_cast<size_t>(entries) * size, 0);
+    
+    // Some kernels accept the ring registration yet never select from it; a
+    // one-byte recv over a socketpair tells the two apart
+    if (registerBufferRing(entries) && probeBuffers()) {
+        return true;
+    }
+    unregisterBufferRing();
+    
+    if (!provideBuffers(0, entries, true)) {
+        std::cerr << "[IoUring] Provided buffers not supported" << std::endl;
+        return false;
+    }
+    return probeBuffers();
+}
+
+bool IoUring::registerBufferRing(uint32_t entries) {
+    buf_ring_size_ = entries * sizeof(io_uring_buf);
+    buf_ring_ = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf_ring_ == MAP_FAILED) {
+        buf_ring_ = nullptr;
+        return false;
+    }
+    
+    io_uring_buf_ring* ring = static_cast<io_uring_buf_ring*>(buf_ring_);
+    for (uint32_t i = 0; i < entries; ++i) {
+        io_uring_buf& buf = ring->bufs[i];
+        buf.addr = reinterpret_cast<uint64_t>(buffers_.data() + static_cast<size_t>(i) * buffer_size_);
+        buf.len = buffer_size_;
+        buf.bid = static_cast<uint16_t>(i);
+    }
+    buf_tail_ = static_cast<uint16_t>(entries);
+    __atomic_store_n(&ring->tail, buf_tail_, __ATOMIC_RELEASE);
+    
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = entries;
+    reg.bgid = buffer_group_;
+    if (sysRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void IoUring::unregisterBufferRing() {
+    if (!buf_ring_) return;
+    
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.bgid = buffer_group_;
+    sysRegister(ring_fd_, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    munmap(buf_ring_, buf_ring_size_);
+    buf_ring_ = nullptr;
+}
+
+bool IoUring::provideBuffers(uint16_t first_id, uint32_t count, bool wait) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(getSqe());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int32_t>(count);
+    sqe->addr = reinterpret_cast<uint64_t>(buffers_.data() + static_cast<size_t>(first_id) * buffer_size_);
+    sqe->len = buffer_size_;
+    sqe->off = first_id;
+    sqe->buf_group = buffer_group_;
+    if (!wait) {
+        // Recycling happens per receive; only failures need a completion.
+        // Kernels before 5.17 post every one, tagged with user_data 0
+        if (cqe_skip_) {
+            sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+        }
+        return true;
+    }
+    
+    Completion completion;
+    return waitOne(completion) && completion.res >= 0;
+}
+
+bool IoUring::probeBuffers() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        return false;
+    }
+    
+    char byte = 0;
+    Completion completion{};
+    bool reaped = write(fds[1], &byte, 1) == 1 && prepRecv(fds[0], false, 0) && waitOne(completion);
+    bool ok = reaped && completion.res == 1 && hasBuffer(completion.flags);
+    // Only a completion that was actually reaped can hold a buffer
+    if (reaped && hasBuffer(completion.flags)) {
+        recycleBuffer(bufferId(completion.flags));
+    }
+    close(fds[0]);
+    close(fds[1]);
+    return ok;
+}
+
+bool IoUring::waitOne(Completion& completion) {
+    // Only used during setup, before any other operation is queued
+    completion.flags = 0;
+    completion.res = -EAGAIN;
+    if (submitAndWait(1000) < 0) {
+        return false;
+    }
+    return reap(&completion, 1) == 1;
+}
+
+void IoUring::recycleBuffer(uint16_t id) {
+    if (!buf_ring_) {
+        provideBuffers(id, 1, false);
+        return;
+    }
+    
+    io_uring_buf_ring* ring = static_cast<io_uring_buf_ring*>(buf_ring_);
+    io_uring_buf& buf = ring->bufs[buf_tail_ & (buf_count_ - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffers_.data() + static_cast<size_t>(id) * buffer_size_);
+    buf.len = buffer_size_;
+    buf.bid = id;
+    ++buf_tail_;
+    __atomic_store_n(&ring->tail, buf_tail_, __ATOMIC_RELEASE);
+}
+
+void* IoUring::getSqe() {
+    if (sqe_tail_ - loadAcquire(sq_head_) >= sq_entries_) {
+        // Full: hand what is queued to the kernel and try once more
+        submit();
+        if (sqe_tail_ - loadAcquire(sq_head_) >= sq_entries_) {
+            return nullptr;
+        }
+    }
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + (sqe_tail_ & sq_mask_);
+    ++sqe_tail_;
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+bool IoUring::prepAccept(int listen_fd, bool multishot, uint64_t user_data) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(getSqe());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_fd;
+    sqe->ioprio = multishot ? IORING_ACCEPT_MULTISHOT : 0;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = user_data;
+    return true;
+}
+
+bool IoUring::prepRecv(int fd, bool multishot, uint64_t user_data) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(getSqe());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = buffer_group_;
+    sqe->ioprio = multishot ? IORING_RECV_MULTISHOT : 0;
+    sqe->user_data = user_data;
+    return true;
+}
+
+bool IoUring::prepSendmsg(int fd, const struct msghdr* msg, int flags, uint64_t user_data) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(getSqe());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(msg);
+    sqe->len = 1;
+    sqe->msg_flags = static_cast<uint32_t>(flags);
+    sqe->user_data = user_data;
+    return true;
+}
+
+bool IoUring::prepRead(int fd, void* buf, uint32_t length, uint64_t user_data) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(getSqe());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = length;
+    sqe->off = static_cast<uint64_t>(-1);   // Current position; required for eventfd
+    sqe->user_data = user_data;
+    return true;
+}
+
+int IoUring::enter(unsigned to_submit, unsigned min_complete, unsigned flags, int timeout_ms) {
+    if (timeout_ms < 0 || min_complete == 0) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+                                        flags, nullptr, 0));
+    }
+    KernelTimespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000LL;
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+                                    flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)));
+}
+
+int IoUring::submit() {
+    unsigned pending = sqe_tail_ - submitted_tail_;
+    if (pending > 0) {
+        storeRelease(sq_tail_, sqe_tail_);
+        submitted_tail_ = sqe_tail_;
+    }
+    if (sqpoll_) {
+        // The poller thread picks entries up by itself unless it went to sleep
+        if (__atomic_load_n(sq_flags_, __ATOMIC_ACQUIRE) & IORING_SQ_NEED_WAKEUP) {
+            enter(0, 0, IORING_ENTER_SQ_WAKEUP, -1);
+        }
+        return static_cast<int>(pending);
+    }
+    if (pending == 0) {
+        return 0;
+    }
+    return enter(pending, 0, 0, -1);
+}
+
+int IoUring::submitAndWait(int timeout_ms) {
+    unsigned pending = sqe_tail_ - submitted_tail_;
+    if (pending > 0) {
+        storeRelease(sq_tail_, sqe_tail_);
+        submitted_tail_ = sqe_tail_;
+    }
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    if (sqpoll_) {
+        if (__atomic_load_n(sq_flags_, __ATOMIC_ACQUIRE) & IORING_SQ_NEED_WAKEUP) {
+            flags |= IORING_ENTER_SQ_WAKEUP;
+        }
+        pending = 0;
+    }
+    int ret = enter(pending, 1, flags, timeout_ms);
+    if (ret < 0 && errno != ETIME && errno != EINTR && errno != EBUSY) {
+        return -1;
+    }
+    return ret < 0 ? 0 : ret;
+}
+
+size_t IoUring::reap(Completion* out, size_t max) {
+    unsigned head = *cq_head_;
+    unsigned tail = loadAcquire(cq_tail_);
+    size_t count = 0;
+    const io_uring_cqe* cqes = static_cast<const io_uring_cqe*>(cqes_);
+    while (head != tail && count < max) {
+        const io_uring_cqe& cqe = cqes[head & cq_mask_];
+        out[count].user_data = cqe.user_data;
+        out[count].res = cqe.res;
+        out[count].flags = cqe.flags;
+        ++count;
+        ++head;
+    }
+    if (count > 0) {
+        storeRelease(cq_head_, head);
+    }
+    return count;
+}
+
+bool IoUring::hasMore(uint32_t flags) { return (flags & IORING_CQE_F_MORE) != 0; }
+bool IoUring::hasBuffer(uint32_t flags) { return (flags & IORING_CQE_F_BUFFER) != 0; }
+uint16_t IoUring::bufferId(uint32_t flags) { return static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT); }
+
+void IoUring::cleanup() {
+    if (buf_ring_) {
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = nullptr;
+    }
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_ring_ && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+    if (sq_ring_) {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+}
+
+#else
+
+// No io_uring headers at build time: every setup call fails and the
+// socket server stays on epoll
+IoUring::IoUring() {}
+IoUring::~IoUring() {}
+
+bool IoUring::init(unsigned, bool) {
+    std::cerr << "[IoUring] Built without io_uring support" << std::endl;
+    return false;
+}
+
+bool IoUring::setupBuffers(uint16_t, uint32_t, uint32_t) { return false; }
+bool IoUring::registerBufferRing(uint32_t) { return false; }
+void IoUring::unregisterBufferRing() {}
+bool IoUring::probeBuffers() { return false; }
+bool IoUring::provideBuffers(uint16_t, uint32_t, bool) { return false; }
+bool IoUring::waitOne(Completion&) { return false; }
+void IoUring::recycleBuffer(uint16_t) {}
+void* IoUring::getSqe() { return nullptr; }
+bool IoUring::prepAccept(int, bool, uint64_t) { return false; }
+bool IoUring::prepRecv(int, bool, uint64_t) { return false; }
+bool IoUring::prepSendmsg(int, const struct msghdr*, int, uint64_t) { return false; }
+bool IoUring::prepRead(int, void*, uint32_t, uint64_t) { return false; }
+int IoUring::enter(unsigned, unsigned, unsigned, int) { return -1; }
+int IoUring::submit() { return -1; }
+int IoUring::submitAndWait(int) { return -1; }
+size_t IoUring::reap(Completion*, size_t) { return 0; }
+bool IoUring::hasMore(uint32_t) { return false; }
+bool IoUring::hasBuffer(uint32_t) { return false; }
+uint16_t IoUring::bufferId(uint32_t) { return 0; }
+void IoUring::cleanup() {}
+
+#endif
+
+} // namespace hft
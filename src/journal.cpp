@@ -0,0 +1,302 @@
+#include "../include/journal.hpp"
+#include "../include/message.hpp"
+#include "../include/cpu_topology.hpp"
+#include "../include/tsc_clock.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace hft {
+
+namespace {
+
+const char JOURNAL_MAGIC[8] = {'H', 'F', 'T', 'J', 'R', 'N', 'L', '1'};
+constexpr uint32_t JOURNAL_VERSION = 1;
+
+inline size_t alignRecord(size_t length) {
+    return (length + 7) & ~static_cast<size_t>(7);
+}
+
+} // namespace
+
+// Journal implementation
+constexpr size_t Journal::DEFAULT_SEGMENT_SIZE;
+constexpr size_t Journal::Entry::MAX_PAYLOAD;
+constexpr size_t Journal::PRODUCER_QUEUE_CAPACITY;
+constexpr size_t Journal::MAX_BATCH;
+
+Journal::Journal() : inbound_(PRODUCER_QUEUE_CAPACITY) {}
+
+Journal::~Journal() {
+    stop();
+    closeSegment();
+}
+
+std::string Journal::segmentPath(const std::string& base_path, uint64_t index) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%06llu", static_cast<unsigned long long>(index));
+    return base_path + suffix;
+}
+
+bool Journal::open(const std::string& base_path, size_t segment_size) {
+    if (running_.load()) return false;
+    
+    closeSegment();
+    base_path_ = base_path;
+    segment_size_ = std::max(alignRecord(segment_size), sizeof(JournalSegmentHeader) + 2 * sizeof(Entry));
+    segment_index_ = 0;
+    
+    // Leftover higher-numbered segments would be replayed after ours
+    for (uint64_t index = 1; unlink(segmentPath(base_path_, index).c_str()) == 0; ++index) {
+    }
+    return openSegment();
+}
+
+bool Journal::openSegment() {
+    std::string path = segmentPath(base_path_, segment_index_);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "[Journal] Failed to create " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    // Reserve the blocks now so appends never hit ENOSPC through a mapping;
+    // MAP_POPULATE then faults every page in before the first record
+    int err = posix_fallocate(fd, 0, static_cast<off_t>(segment_size_));
+    if (err != 0 && ftruncate(fd, static_cast<off_t>(segment_size_)) != 0) {
+        std::cerr << "[Journal] Failed to size " << path << ": " << strerror(err) << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "[Journal] Failed to map " << path << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+    
+    fd_ = fd;
+    base_ = static_cast<char*>(base);
+    
+    JournalSegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.header_size = sizeof(JournalSegmentHeader);
+    header.segment_index = segment_index_;
+    header.created_ns = TscClock::wallNanos();
+    memcpy(base_, &header, sizeof(header));
+    offset_ = sizeof(JournalSegmentHeader);
+    
+    ++segment_index_;
+    return true;
+}
+
+void Journal::closeSegment() {
+    if (!base_) return;
+    
+    // Trim the unused tail; readers stop at the end of the file as well as at a zero length
+    msync(base_, offset_, MS_SYNC);
+    munmap(base_, segment_size_);
+    if (ftruncate(fd_, static_cast<off_t>(offset_)) != 0) {
+        std::cerr << "[Journal] Failed to trim segment: " << strerror(errno) << std::endl;
+    }
+    ::close(fd_);
+    base_ = nullptr;
+    fd_ = -1;
+    offset_ = 0;
+}
+
+void Journal::start() {
+    if (running_.load() || !base_) return;
+    
+    running_ = true;
+    writer_thread_ = std::thread(&Journal::writerLoop, this);
+    std::cout << "[Journal] Writing to " << segmentPath(base_path_, 0) << " in "
+              << (segment_size_ >> 20) << " MB segments" << std::endl;
+}
+
+void Journal::stop() {
+    if (!running_.load()) return;
+    
+    running_ = false;
+    notifier_.notify();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+    std::cout << "[Journal] Stopped after " << getRecordCount() << " records in "
+              << getSegmentCount() << " segment(s), " << getDropCount() << " dropped" << std::endl;
+}
+
+bool Journal::append(const Message& message, const char* data, size_t length) {
+    if (!running_.load(std::memory_order_relaxed)) return false;
+    
+    if (length > Entry::MAX_PAYLOAD) {
+        drop_count_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    // The bytes as they arrived, version, padding and all, so a replay decodes
+    // exactly what the server did
+    Entry entry;
+    entry.receive_ns = TscClock::toWallNanos(message.getReceiveTicks());
+    entry.connection_id = message.getConnectionId();
+    entry.length = static_cast<uint32_t>(length);
+    memcpy(entry.payload, data, length);
+    
+    if (!inbound_.producer()->tryPush(std::move(entry))) {
+        drop_count_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    notifier_.notify();
+    return true;
+}
+
+void Journal::writerLoop() {
+    ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::JOURNAL);
+    WaitStrategy wait(wait_strategy_, &notifier_);
+    
+    auto drain = [this]() { return inbound_.drain([this](Entry&& entry) { write(entry); }, MAX_BATCH); };
+    auto pending = [this]() { return inbound_.pending(); };
+    
+    while (running_.load()) {
+        if (drain() == 0) {
+            wait.idle(pending);
+        } else {
+            wait.reset();
+        }
+    }
+    
+    // Producers stop before the journal does; keep whatever they left behind
+    while (drain() > 0) {
+    }
+    if (base_) {
+        msync(base_, offset_, MS_SYNC);
+    }
+}
+
+void Journal::write(const Entry& entry) {
+    if (!base_) {
+        drop_count_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    size_t record_size = alignRecord(sizeof(JournalRecordHeader) + entry.length);
+    // Keep room for the terminating zero length
+    if (offset_ + record_size + sizeof(uint32_t) > segment_size_) {
+        closeSegment();
+        if (!openSegment()) {
+            drop_count_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    
+    char* record = base_ + offset_;
+    JournalRecordHeader* header = reinterpret_cast<JournalRecordHeader*>(record);
+    header->reserved = 0;
+    header->receive_ns = entry.receive_ns;
+    header->connection_id = entry.connection_id;
+    memcpy(record + sizeof(JournalRecordHeader), entry.payload, entry.length);
+    
+    // Length last: a reader of a crashed journal sees the record whole or not at all
+    __atomic_store_n(&header->length, entry.length, __ATOMIC_RELEASE);
+    offset_ += record_size;
+    record_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// JournalReader implementation
+JournalReader::~JournalReader() {
+    unmapSegment();
+}
+
+bool JournalReader::open(const std::string& path) {
+    unmapSegment();
+    
+    // A first segment path names the journal it belongs to
+    base_path_ = path;
+    const std::string first_suffix = Journal::segmentPath("", 0);
+    if (base_path_.size() > first_suffix.size() &&
+        base_path_.compare(base_path_.size() - first_suffix.size(), first_suffix.size(), first_suffix) == 0) {
+        base_path_.erase(base_path_.size() - first_suffix.size());
+    }
+    
+    segment_index_ = 0;
+    if (!mapSegment(0)) {
+        std::cerr << "[Journal] No journal at " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool JournalReader::mapSegment(uint64_t index) {
+    std::string path = Journal::segmentPath(base_path_, index);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(JournalSegmentHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "[Journal] Failed to map " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    const JournalSegmentHeader* header = static_cast<const JournalSegmentHeader*>(base);
+    if (memcmp(header->magic, JOURNAL_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != JOURNAL_VERSION || header->header_size < sizeof(JournalSegmentHeader)) {
+        std::cerr << "[Journal] " << path << " is not a version " << JOURNAL_VERSION << " journal segment" << std::endl;
+        munmap(base, size);
+        return false;
+    }
+    
+    base_ = static_cast<const char*>(base);
+    size_ = size;
+    offset_ = header->header_size;
+    segment_index_ = index + 1;
+    return true;
+}
+
+void JournalReader::unmapSegment() {
+    if (!base_) return;
+    munmap(const_cast<char*>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+    offset_ = 0;
+}
+
+bool JournalReader::next(JournalRecord& record) {
+    while (base_) {
+        if (offset_ + sizeof(JournalRecordHeader) <= size_) {
+            const JournalRecordHeader* header = reinterpret_cast<const JournalRecordHeader*>(base_ + offset_);
+            uint32_t length = __atomic_load_n(&header->length, __ATOMIC_ACQUIRE);
+            size_t record_size = alignRecord(sizeof(JournalRecordHeader) + length);
+            if (length != 0 && offset_ + record_size <= size_) {
+                record.receive_ns = header->receive_ns;
+                record.connection_id = header->connection_id;
+                record.payload = base_ + offset_ + sizeof(JournalRecordHeader);
+                record.length = length;
+                offset_ += record_size;
+                return true;
+            }
+        }
+        
+        // End of this segment; carry on with the next one if there is one
+        uint64_t next_index = segment_index_;
+        unmapSegment();
+        mapSegment(next_index);
+    }
+    return false;
+}
+
+} // namespace hft
@@ -0,0 +1,169 @@
+#include "../include/latency_histogram.hpp"
+#include <cstring>
+
+namespace hft {
+
+constexpr unsigned LatencyHistogram::SUB_BUCKET_BITS;
+constexpr uint64_t LatencyHistogram::SUB_BUCKET_COUNT;
+constexpr uint64_t LatencyHistogram::HALF_COUNT;
+constexpr unsigned LatencyHistogram::MAX_SHIFT;
+constexpr size_t LatencyHistogram::BUCKET_COUNT;
+
+// LatencyHistogram implementation
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return static_cast<size_t>(value);
+    }
+    
+    // Keep the top SUB_BUCKET_BITS bits: value >> shift lands in [64, 128)
+    unsigned msb = 63 - __builtin_clzll(value);
+    unsigned shift = msb - (SUB_BUCKET_BITS - 1);
+    if (shift > MAX_SHIFT) {
+        return BUCKET_COUNT - 1;
+    }
+    return static_cast<size_t>(SUB_BUCKET_COUNT + (shift - 1) * HALF_COUNT + ((value >> shift) - HALF_COUNT));
+}
+
+uint64_t LatencyHistogram::bucketLower(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    size_t offset = index - SUB_BUCKET_COUNT;
+    unsigned shift = static_cast<unsigned>(offset / HALF_COUNT) + 1;
+    return (offset % HALF_COUNT + HALF_COUNT) << shift;
+}
+
+uint64_t LatencyHistogram::bucketUpper(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    size_t offset = index - SUB_BUCKET_COUNT;
+    unsigned shift = static_cast<unsigned>(offset / HALF_COUNT) + 1;
+    return ((offset % HALF_COUNT + HALF_COUNT + 1) << shift) - 1;
+}
+
+void LatencyHistogram::recordCount(uint64_t value_ns, uint64_t count) {
+    counts_[bucketIndex(value_ns)] += count;
+    count_ += count;
+    sum_ += value_ns * count;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+}
+
+void LatencyHistogram::subtract(const LatencyHistogram& baseline) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts_[i] -= baseline.counts_[i];
+    }
+    count_ -= baseline.count_;
+    sum_ -= baseline.sum_;
+}
+
+void LatencyHistogram::reset() {
+    memset(counts_, 0, sizeof(counts_));
+    count_ = 0;
+    sum_ = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (count_ == 0) return 0;
+    
+    uint64_t rank = static_cast<uint64_t>(q * count_ + 0.5);
+    if (rank == 0) rank = 1;
+    if (rank > count_) rank = count_;
+    
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return bucketUpper(i);
+        }
+    }
+    return bucketUpper(BUCKET_COUNT - 1);
+}
+
+uint64_t LatencyHistogram::min() const {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        if (counts_[i]) return bucketLower(i);
+    }
+    return 0;
+}
+
+uint64_t LatencyHistogram::max() const {
+    for (size_t i = BUCKET_COUNT; i > 0; --i) {
+        if (counts_[i - 1]) return bucketUpper(i - 1);
+    }
+    return 0;
+}
+
+// ConcurrentHistogram implementation
+ConcurrentHistogram::Shard::Shard() : sum(0) {
+    for (auto& count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+ConcurrentHistogram::ConcurrentHistogram() {
+    for (auto& shard : shards_) {
+        shard.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ConcurrentHistogram::~ConcurrentHistogram() {
+    for (auto& shard : shards_) {
+        delete shard.load(std::memory_order_relaxed);
+    }
+}
+
+ConcurrentHistogram::Shard& ConcurrentHistogram::localShard() {
+    std::atomic<Shard*>& slot = shards_[currentThreadSlot()];
+    Shard* shard = slot.load(std::memory_order_relaxed);
+    if (!shard) {
+        // Published with release so readers see zeroed counters
+        shard = new Shard();
+        slot.store(shard, std::memory_order_release);
+    }
+    return *shard;
+}
+
+void ConcurrentHistogram::record(uint64_t value_ns) {
+    Shard& shard = localShard();
+    
+    // Single writer per shard: plain load+store instead of a locked RMW
+    std::atomic<uint64_t>& count = shard.counts[LatencyHistogram::bucketIndex(value_ns)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    shard.sum.store(shard.sum.load(std::memory_order_relaxed) + value_ns, std::memory_order_relaxed);
+}
+
+void ConcurrentHistogram::collect(LatencyHistogram& out) const {
+    out.reset();
+    for (const auto& slot : shards_) {
+        const Shard* shard = slot.load(std::memory_order_acquire);
+        if (!shard) continue;
+        
+        for (size_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+            uint64_t count = shard->counts[i].load(std::memory_order_relaxed);
+            out.counts_[i] += count;
+            out.count_ += count;
+        }
+        out.sum_ += shard->sum.load(std::memory_order_relaxed);
+    }
+}
+
+void ConcurrentHistogram::snapshot(LatencyHistogram& out) const {
+    std::lock_guard<std::mutex> lock(baseline_mutex_);
+    collect(out);
+    out.subtract(baseline_);
+}
+
+void ConcurrentHistogram::reset() {
+    std::lock_guard<std::mutex> lock(baseline_mutex_);
+    collect(baseline_);
+}
+
+} // namespace hft
@@ -2,12 +2,22 @@
 #include "../include/service_manager.hpp"
 #include "../include/interceptor.hpp"
 #include "../include/message.hpp"
+#include "../include/order_book.hpp"
+#include "../include/cpu_topology.hpp"
+#include "../include/journal.hpp"
+#include "../include/async_logger.hpp"
+#include "../include/tsc_clock.hpp"
+#include "../include/pipeline_trace.hpp"
+#include "../include/feed_handler.hpp"
+#include "../include/stats_publisher.hpp"
 #include <iostream>
 #include <signal.h>
 #include <chrono>
 #include <thread>
 #include <atomic>
 #include <algorithm>
+#include <unordered_map>
+#include <mutex>
 
 namespace hft {
 
@@ -31,13 +41,77 @@ void printUsage() {
     std::cout << "Options:" << std::endl;
     std::cout << "  -p <port>           Server port (default: 8080)" << std::endl;
     std::cout << "  -t <threads>        Worker thread count (default: 4)" << std::endl;
+    std::cout << "  -m <shards>         Matching shards, each owning the books of symbol id % shards (default: 1)" << std::endl;
     std::cout << "  -b <buffer_size>    Buffer size in bytes (default: 8192)" << std::endl;
-    std::cout << "  -a                  Enable thread affinity (default: true)" << std::endl;
+    std::cout << "  -a <map>            Thread placement: off, auto, or role=cpulist,... (default: auto)" << std::endl;
+    std::cout << "                      roles: reactor, accept, processor, matching, risk, marketdata, feed, journal, logger" << std::endl;
+    std::cout << "                      nic=<interface> puts reactors on that NIC's NUMA node" << std::endl;
+    std::cout << "  -d <rr|ll>          Connection dispatch: round-robin or least-loaded (default: rr)" << std::endl;
+    std::cout << "  -l <mode>           Listener mode: single, reuseport, reuseport-cpu (default: single)" << std::endl;
+    std::cout << "  -w <role=strategy>  Idle strategy per thread role, comma separated" << std::endl;
+    std::cout << "                      roles: reactor, processor, service" << std::endl;
+    std::cout << "                      strategies: spin, yield, park, busy-poll (default: park)" << std::endl;
+    std::cout << "  -r <rate[,burst]>   Per-client message rate limit in msg/s (default: 1000000)" << std::endl;
+    std::cout << "  --client-rate <id>=<rate[,burst]>  Override -r for one client id; repeatable" << std::endl;
+    std::cout << "  -s <file>           Symbol reference data, one per line (default: built-in list)" << std::endl;
+    std::cout << "  -z                  MSG_ZEROCOPY for large outbound flushes (default: off)" << std::endl;
+    std::cout << "  -i <backend>        Reactor I/O: epoll, uring, uring-sqpoll (default: epoll)" << std::endl;
+    std::cout << "  -j <path>           Journal accepted inbound messages to <path>.000000, ... (default: off)" << std::endl;
+    std::cout << "  --replay <journal>  Feed a journal through the pipeline offline instead of listening" << std::endl;
+    std::cout << "  --replay-speed <s>  Replay pacing: max or recorded (default: max)" << std::endl;
+    std::cout << "  --log <file>        Asynchronous log output (default: stdout)" << std::endl;
+    std::cout << "  --log-level <l>     debug, info, warn, error (default: info)" << std::endl;
+    std::cout << "  --trace <file[,n]>  Write every nth message's stage timings to <file> as CSV (default n: 1024)" << std::endl;
+    std::cout << "  --feed <a>[,<b>]    Multicast market data lines, group:port, arbitrated by sequence (default: off)" << std::endl;
+    std::cout << "  --feed-if <iface>   Interface to join the feed on; required for xdp (default: kernel's choice)" << std::endl;
+    std::cout << "  --feed-mode <m>     Feed receive path: recvmmsg or xdp (default: recvmmsg)" << std::endl;
+    std::cout << "  --feed-queue <n>    NIC queue the AF_XDP socket binds to (default: 0)" << std::endl;
+    std::cout << "  --rx-timestamps <m> Kernel receive stamps on client sockets: software or hardware:<iface> (default: off)" << std::endl;
+    std::cout << "  --busy-poll <us,b>  Busy-poll client sockets and reactor epoll sets for us, budget b optional (default: off)" << std::endl;
+    std::cout << "  --prefer-busy-poll  SO_PREFER_BUSY_POLL; pair with napi_defer_hard_irqs and gro_flush_timeout" << std::endl;
+    std::cout << "  --require-login     Clients must LOGIN before sending application messages (default: off)" << std::endl;
+    std::cout << "  --heartbeat <ms,n>  Session heartbeat interval, reaped after n silent intervals (default: 1000,3)" << std::endl;
+    std::cout << "  --idle-timeout <ms> Close connections without a session after ms of silence (default: off)" << std::endl;
+    std::cout << "  --stats <name[,ms]> Publish counters and histograms to /dev/shm/<name> for hft_stats (default: off, 100 ms)" << std::endl;
     std::cout << "  -h                  Show this help message" << std::endl;
     std::cout << std::endl;
     std::cout << "Performance Target: < 10 microseconds average latency" << std::endl;
 }
 
+// Parse "reactor=spin,service=park" style wait strategy assignments
+bool parseWaitStrategies(const std::string& spec, WaitStrategyType& reactor,
+                         WaitStrategyType& processor, WaitStrategyType& service) {
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        
+        std::string item = spec.substr(start, end - start);
+        size_t eq = item.find('=');
+        WaitStrategyType type;
+        if (eq == std::string::npos || !parseWaitStrategy(item.substr(eq + 1), type)) {
+            return false;
+        }
+        
+        std::string role = item.substr(0, eq);
+        if (role == "reactor") {
+            reactor = type;
+        } else if (role == "processor") {
+            processor = type;
+        } else if (role == "service") {
+            service = type;
+        } else {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+// Stages run inline on the reactor thread for every inbound message
+// Risk reserves exposure, so it stays last: nothing after it may reject
+typedef StaticInterceptorChain<ValidationInterceptor, ThrottlingInterceptor, RiskInterceptor> InboundChain;
+
 void runPerformanceTest() {
     std::cout << "\n[Main] Running performance test..." << std::endl;
     
@@ -52,27 +126,38 @@ void runPerformanceTest() {
     interceptor_chain->addInterceptor(std::make_shared<PerformanceInterceptor>());
     interceptor_chain->addInterceptor(std::make_shared<ThrottlingInterceptor>(1000000)); // 1M msg/s
     
+    // Same stages composed at compile time
+    StaticInterceptorChain<ValidationInterceptor, LoggingInterceptor, PerformanceInterceptor, ThrottlingInterceptor>
+        static_chain(ValidationInterceptor(), LoggingInterceptor(), PerformanceInterceptor(), 1000000);
+    
     // Test message processing
     std::vector<std::shared_ptr<Message>> test_messages = {order_msg, md_msg};
     
     for (auto& msg : test_messages) {
-        InterceptorContext context(msg);
+        InterceptorContext context(*msg);
         
-        auto start_time = std::chrono::high_resolution_clock::now();
+        uint64_t start_ticks = TscClock::now();
         bool result = interceptor_chain->process(context);
-        auto end_time = std::chrono::high_resolution_clock::now();
+        uint64_t latency = TscClock::toNanos(TscClock::nowOrdered() - start_ticks);
         
-        auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+        InterceptorContext static_context(*msg);
+        uint64_t static_start = TscClock::now();
+        bool static_result = static_chain.process(static_context);
+        uint64_t static_latency = TscClock::toNanos(TscClock::nowOrdered() - static_start);
         
         std::cout << "Message Type: " << static_cast<int>(msg->getType())
                   << ", Processing: " << (result ? "SUCCESS" : "FAILED")
-                  << ", Latency: " << (latency / 1000.0) << " μs" << std::endl;
+                  << ", Latency: " << (latency / 1000.0) << " μs"
+                  << ", Static chain: " << (static_result ? "SUCCESS" : "FAILED")
+                  << " in " << (static_latency / 1000.0) << " μs" << std::endl;
         
         if (result) {
-            std::cout << "  Validation: " << context.getMetadata("validation") << std::endl;
-            std::cout << "  Log: " << context.getMetadata("log") << std::endl;
-            std::cout << "  Latency: " << context.getMetadata("latency_us") << " μs" << std::endl;
-            std::cout << "  Throttle: " << context.getMetadata("throttle_status") << std::endl;
+            std::cout << "  Validation: " << (context.hasFlag(FLAG_VALIDATED) ? "passed" : "skipped") << std::endl;
+            std::cout << "  Logged: " << (context.hasFlag(FLAG_LOGGED) ? "yes" : "no") << std::endl;
+            std::cout << "  Latency: " << context.getField(ContextField::LATENCY_NS) << " ns" << std::endl;
+            std::cout << "  Throttle: " << (context.hasFlag(FLAG_THROTTLE_ACCEPTED) ? "accepted" : "skipped") << std::endl;
+        } else {
+            std::cout << "  Rejected: " << interceptStatusName(context.getStatus()) << std::endl;
         }
     }
 }
@@ -86,23 +171,20 @@ void runLatencyBenchmark() {
     
     auto order_msg = std::make_shared<OrderMessage>(12345, "AAPL", 150.50, 100, true);
     
-    auto start_total = std::chrono::high_resolution_clock::now();
+    uint64_t start_total = TscClock::now();
     
     for (size_t i = 0; i < iterations; ++i) {
-        auto start = std::chrono::high_resolution_clock::now();
+        uint64_t start = TscClock::now();
         
         // Simulate message processing
         order_msg->setSequenceNumber(i + 1);
-        order_msg->setTimestamp(std::chrono::duration_cast<std::chrono::microseconds>(
-            std::chrono::high_resolution_clock::now().time_since_epoch()).count());
+        order_msg->setTimestamp(TscClock::wallNanos() / 1000);
         
-        auto end = std::chrono::high_resolution_clock::now();
-        auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        uint64_t latency = TscClock::toNanos(TscClock::nowOrdered() - start);
         latencies.push_back(latency / 1000.0); // Convert to microseconds
     }
     
-    auto end_total = std::chrono::high_resolution_clock::now();
-    auto total_time = std::chrono::duration_cast<std::chrono::microseconds>(end_total - start_total).count();
+    uint64_t total_time = TscClock::toNanos(TscClock::nowOrdered() - start_total) / 1000;
     
     // Calculate statistics
     std::sort(latencies.begin(), latencies.end());
@@ -136,6 +218,125 @@ void runLatencyBenchmark() {
     }
 }
 
+void runMatchingBenchmark() {
+    std::cout << "\n[Main] Running matching engine benchmark..." << std::endl;
+    
+    const size_t iterations = 100000;
+    std::vector<double> latencies;
+    latencies.reserve(iterations);
+    
+    OrderBook book(150.00);
+    size_t executions = 0;
+    book.setExecutionCallback([&executions](const Execution&) { ++executions; });
+    
+    // Seed both sides so new orders alternate between resting and trading
+    uint64_t next_order_id = 1;
+    for (int level = 1; level <= 50; ++level) {
+        book.addOrder(next_order_id++, 1, true, 150.00 - level * 0.01, 100);
+        book.addOrder(next_order_id++, 1, false, 150.00 + level * 0.01, 100);
+    }
+    
+    for (size_t i = 0; i < iterations; ++i) {
+        bool is_buy = (i % 2) == 0;
+        double price = is_buy ? 150.00 + (i % 3) * 0.01 : 150.00 - (i % 3) * 0.01;
+        uint64_t order_id = next_order_id++;
+        
+        uint64_t start = TscClock::now();
+        
+        // Add (may trade), then cancel whatever rested
+        book.addOrder(order_id, 2, is_buy, price, 50);
+        book.cancelOrder(order_id);
+        
+        uint64_t latency = TscClock::toNanos(TscClock::nowOrdered() - start);
+        latencies.push_back(latency / 1000.0); // Convert to microseconds
+        
+        // Replenish liquidity so the book never drains
+        if (i % 4 == 0) {
+            book.addOrder(next_order_id++, 1, true, 149.99, 100);
+            book.addOrder(next_order_id++, 1, false, 150.01, 100);
+        }
+    }
+    
+    std::sort(latencies.begin(), latencies.end());
+    
+    double sum = 0.0;
+    for (double latency : latencies) {
+        sum += latency;
+    }
+    double avg_latency = sum / latencies.size();
+    
+    std::cout << "Matching Benchmark Results (" << iterations << " add+cancel pairs, "
+              << executions << " executions):" << std::endl;
+    std::cout << "  Average Latency: " << avg_latency << " μs" << std::endl;
+    std::cout << "  P50 Latency: " << latencies[latencies.size() * 0.5] << " μs" << std::endl;
+    std::cout << "  P99 Latency: " << latencies[latencies.size() * 0.99] << " μs" << std::endl;
+    std::cout << "  Max Latency: " << latencies.back() << " μs" << std::endl;
+    std::cout << "  Resting Orders: " << book.orderCount() << std::endl;
+    
+    if (latencies[latencies.size() * 0.99] < 10.0) {
+        std::cout << "  ✓ Target achieved: P99 matching latency < 10 μs" << std::endl;
+    } else {
+        std::cout << "  ✗ Target missed: P99 matching latency >= 10 μs" << std::endl;
+    }
+}
+
+// Feeds a journal through a MessageHandler wired to the live callback, at
+// full speed or with the recorded gaps between messages. Each recorded
+// connection gets a stand-in so client routes are learned as they were.
+bool replayJournal(const std::string& path, bool recorded_speed,
+                   const std::function<void(MessageHandle, const MessageView&)>& callback) {
+    JournalReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+    
+    MessageHandler handler;
+    PerformanceMonitor monitor;
+    handler.setMessageCallback(callback);
+    handler.setPerformanceMonitor(&monitor);
+    
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections;
+    JournalRecord record;
+    size_t replayed = 0;
+    uint64_t first_ns = 0;
+    auto start = std::chrono::steady_clock::now();
+    
+    std::cout << "[Replay] Replaying " << path << (recorded_speed ? " at recorded speed" : " at max speed") << std::endl;
+    while (g_running && reader.next(record)) {
+        if (recorded_speed) {
+            if (replayed == 0) first_ns = record.receive_ns;
+            // Reactors journal independently, so receive times can step back slightly
+            int64_t offset_ns = static_cast<int64_t>(record.receive_ns - first_ns);
+            auto due = start + std::chrono::nanoseconds(std::max<int64_t>(offset_ns, 0));
+            for (auto now = std::chrono::steady_clock::now(); now < due; now = std::chrono::steady_clock::now()) {
+                if (due - now > std::chrono::milliseconds(1)) {
+                    std::this_thread::sleep_for(due - now - std::chrono::milliseconds(1));
+                }
+            }
+        }
+        
+        std::unique_ptr<Connection>& connection = connections[record.connection_id];
+        if (!connection) {
+            connection.reset(new Connection(-1, FRAME_HEADER_SIZE + MAX_FRAME_SIZE, record.connection_id));
+        }
+        handler.handleMessage(*connection, record.payload, record.length);
+        ++replayed;
+    }
+    
+    auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    LatencyHistogram latency;
+    monitor.getLatencySnapshot(latency);
+    std::cout << "[Replay] " << replayed << " messages from " << reader.getSegmentCount() << " segment(s), "
+              << connections.size() << " connection(s) in " << elapsed_us / 1000.0 << " ms ("
+              << (elapsed_us > 0 ? replayed * 1000000.0 / elapsed_us : 0.0) << " msg/s)" << std::endl;
+    std::cout << "[Replay] Latency μs: avg " << latency.mean() / 1000.0
+              << " p50 " << latency.percentile(0.50) / 1000.0
+              << " p99 " << latency.percentile(0.99) / 1000.0
+              << " max " << latency.max() / 1000.0 << std::endl;
+    return true;
+}
+
 } // namespace hft
 
 int main(int argc, char* argv[]) {
@@ -144,8 +345,35 @@ int main(int argc, char* argv[]) {
     // Parse command line arguments
     int port = 8080;
     size_t thread_count = 4;
+    size_t matching_shards = 1;
     size_t buffer_size = 8192;
-    bool affinity_enabled = true;
+    std::string core_map = "auto";
+    DispatchPolicy dispatch_policy = DispatchPolicy::ROUND_ROBIN;
+    ListenMode listen_mode = ListenMode::SINGLE;
+    WaitStrategyType reactor_wait = WaitStrategyType::SPIN_PARK;
+    WaitStrategyType processor_wait = WaitStrategyType::SPIN_PARK;
+    WaitStrategyType service_wait = WaitStrategyType::SPIN_PARK;
+    std::string symbol_file;
+    double client_rate = 1000000.0;
+    double client_burst = 0.0;
+    std::unordered_map<uint64_t, std::pair<double, double>> client_limits;   // id -> rate, burst
+    bool zerocopy = false;
+    IoBackend io_backend = IoBackend::EPOLL;
+    bool uring_sqpoll = false;
+    std::string journal_path;
+    std::string replay_path;
+    bool replay_recorded = false;
+    std::string log_path;
+    LogLevel log_level = LogLevel::INFO;
+    std::string trace_path;
+    size_t trace_every = PipelineTracer::DEFAULT_SAMPLE_EVERY;
+    FeedConfig feed_config;
+    RxTimestamping rx_timestamping = RxTimestamping::OFF;
+    std::string timestamp_interface;
+    BusyPollConfig busy_poll;
+    SessionConfig session_config;
+    std::string stats_name;
+    uint32_t stats_interval_ms = StatsPublisher::DEFAULT_INTERVAL_MS;
     
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -156,51 +384,493 @@ int main(int argc, char* argv[]) {
             port = std::stoi(argv[++i]);
         } else if (arg == "-t" && i + 1 < argc) {
             thread_count = std::stoul(argv[++i]);
+        } else if (arg == "-m" && i + 1 < argc) {
+            matching_shards = std::max<size_t>(std::stoul(argv[++i]), 1);
         } else if (arg == "-b" && i + 1 < argc) {
             buffer_size = std::stoul(argv[++i]);
-        } else if (arg == "-a") {
-            affinity_enabled = true;
+        } else if (arg == "-a" && i + 1 < argc) {
+            core_map = argv[++i];
+        } else if (arg == "-d" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            dispatch_policy = (policy == "ll") ? DispatchPolicy::LEAST_LOADED : DispatchPolicy::ROUND_ROBIN;
+        } else if (arg == "-l" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "reuseport") {
+                listen_mode = ListenMode::REUSEPORT;
+            } else if (mode == "reuseport-cpu") {
+                listen_mode = ListenMode::REUSEPORT_CPU;
+            } else {
+                listen_mode = ListenMode::SINGLE;
+            }
+        } else if (arg == "-w" && i + 1 < argc) {
+            if (!parseWaitStrategies(argv[++i], reactor_wait, processor_wait, service_wait)) {
+                std::cerr << "[Main] Invalid wait strategy: " << argv[i] << std::endl;
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "-r" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t comma = spec.find(',');
+            client_rate = std::stod(spec.substr(0, comma));
+            if (comma != std::string::npos) {
+                client_burst = std::stod(spec.substr(comma + 1));
+            }
+        } else if (arg == "--client-rate" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t equals = spec.find('=');
+            if (equals == std::string::npos) {
+                std::cerr << "[Main] Invalid client rate: " << spec << std::endl;
+                printUsage();
+                return 1;
+            }
+            size_t comma = spec.find(',', equals);
+            double rate = std::stod(spec.substr(equals + 1, comma - equals - 1));
+            double burst = (comma != std::string::npos) ? std::stod(spec.substr(comma + 1)) : 0.0;
+            client_limits[std::stoull(spec.substr(0, equals))] = std::make_pair(rate, burst);
+        } else if (arg == "-s" && i + 1 < argc) {
+            symbol_file = argv[++i];
+        } else if (arg == "-z") {
+            zerocopy = true;
+        } else if (arg == "-i" && i + 1 < argc) {
+            std::string backend = argv[++i];
+            io_backend = (backend == "uring" || backend == "uring-sqpoll") ? IoBackend::IO_URING : IoBackend::EPOLL;
+            uring_sqpoll = (backend == "uring-sqpoll");
+        } else if (arg == "-j" && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (arg == "--replay-speed" && i + 1 < argc) {
+            replay_recorded = (std::string(argv[++i]) == "recorded");
+        } else if (arg == "--log" && i + 1 < argc) {
+            log_path = argv[++i];
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            if (!parseLogLevel(argv[++i], log_level)) {
+                std::cerr << "[Main] Invalid log level: " << argv[i] << std::endl;
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--trace" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t comma = spec.find(',');
+            trace_path = spec.substr(0, comma);
+            if (comma != std::string::npos) {
+                trace_every = std::stoul(spec.substr(comma + 1));
+            }
+        } else if (arg == "--feed" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            for (size_t start = 0; start <= spec.size();) {
+                size_t comma = std::min(spec.find(',', start), spec.size());
+                FeedLine line;
+                if (!FeedLine::parse(spec.substr(start, comma - start), line)) {
+                    std::cerr << "[Main] Invalid feed line: " << spec.substr(start, comma - start) << std::endl;
+                    return 1;
+                }
+                feed_config.lines.push_back(line);
+                start = comma + 1;
+            }
+        } else if (arg == "--feed-if" && i + 1 < argc) {
+            feed_config.interface = argv[++i];
+        } else if (arg == "--feed-mode" && i + 1 < argc) {
+            if (!parseFeedMode(argv[++i], feed_config.mode)) {
+                std::cerr << "[Main] Invalid feed mode: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--feed-queue" && i + 1 < argc) {
+            feed_config.xdp_queue = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--rx-timestamps" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t colon = spec.find(':');
+            std::string mode = spec.substr(0, colon);
+            if (mode == "software") {
+                rx_timestamping = RxTimestamping::SOFTWARE;
+            } else if (mode == "hardware" && colon != std::string::npos) {
+                rx_timestamping = RxTimestamping::HARDWARE;
+                timestamp_interface = spec.substr(colon + 1);
+            } else {
+                std::cerr << "[Main] Invalid receive timestamp mode: " << spec << std::endl;
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--busy-poll" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t comma = spec.find(',');
+            busy_poll.usecs = static_cast<uint32_t>(std::stoul(spec.substr(0, comma)));
+            if (comma != std::string::npos) {
+                busy_poll.budget = static_cast<uint16_t>(std::stoul(spec.substr(comma + 1)));
+            }
+        } else if (arg == "--prefer-busy-poll") {
+            busy_poll.prefer = true;
+        } else if (arg == "--require-login") {
+            session_config.require_login = true;
+        } else if (arg == "--heartbeat" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t comma = spec.find(',');
+            session_config.heartbeat_interval_ms = static_cast<uint32_t>(std::stoul(spec.substr(0, comma)));
+            if (comma != std::string::npos) {
+                session_config.missed_heartbeats = static_cast<uint32_t>(std::stoul(spec.substr(comma + 1)));
+            }
+        } else if (arg == "--idle-timeout" && i + 1 < argc) {
+            session_config.idle_timeout_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--stats" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t comma = spec.find(',');
+            stats_name = spec.substr(0, comma);
+            if (comma != std::string::npos) {
+                stats_interval_ms = static_cast<uint32_t>(std::stoul(spec.substr(comma + 1)));
+            }
         }
     }
     
+    // Replaying into a journal would re-record the session; never over the source
+    if (!replay_path.empty() && !journal_path.empty() &&
+        (journal_path == replay_path || Journal::segmentPath(journal_path, 0) == replay_path)) {
+        std::cerr << "[Main] Refusing to journal over the journal being replayed" << std::endl;
+        return 1;
+    }
+    
+    // Symbol ids are assigned once at startup so every stage can index by id
+    auto& symbols = SymbolRegistry::getInstance();
+    if (!symbol_file.empty()) {
+        symbols.loadFromFile(symbol_file);
+    } else {
+        symbols.load({"AAPL", "MSFT", "GOOGL", "AMZN", "NVDA", "META", "TSLA", "SPY", "QQQ", "IWM"});
+    }
+    if (symbols.size() == 0) {
+        std::cerr << "[Main] No symbols loaded" << std::endl;
+        return 1;
+    }
+    
+    // Every long-lived thread pins itself from this map as it starts
+    if (!ThreadPlacement::getInstance().configure(core_map, thread_count, matching_shards)) {
+        std::cerr << "[Main] Invalid thread placement: " << core_map << std::endl;
+        printUsage();
+        return 1;
+    }
+    
     std::cout << "=== HFT Socket Server ===" << std::endl;
     std::cout << "Port: " << port << std::endl;
     std::cout << "Threads: " << thread_count << std::endl;
+    std::cout << "Matching Shards: " << matching_shards << std::endl;
     std::cout << "Buffer Size: " << buffer_size << " bytes" << std::endl;
-    std::cout << "Affinity: " << (affinity_enabled ? "enabled" : "disabled") << std::endl;
+    std::cout << "Affinity: " << core_map << std::endl;
+    std::cout << "Dispatch: " << (dispatch_policy == DispatchPolicy::LEAST_LOADED ? "least-loaded" : "round-robin") << std::endl;
+    std::cout << "Listener: " << (listen_mode == ListenMode::REUSEPORT ? "reuseport" :
+                                  listen_mode == ListenMode::REUSEPORT_CPU ? "reuseport-cpu" : "single") << std::endl;
+    std::cout << "Wait: reactor=" << waitStrategyName(reactor_wait)
+              << " processor=" << waitStrategyName(processor_wait)
+              << " service=" << waitStrategyName(service_wait) << std::endl;
+    std::cout << "Symbols: " << symbols.size() << std::endl;
+    std::cout << "Client Rate Limit: " << client_rate << " msg/s";
+    if (!client_limits.empty()) {
+        std::cout << " (" << client_limits.size() << " client override(s))";
+    }
+    std::cout << std::endl;
+    std::cout << "Zero-copy Send: " << (zerocopy ? "enabled" : "disabled") << std::endl;
+    std::cout << "I/O Backend: " << (io_backend == IoBackend::EPOLL ? "epoll" :
+                                     uring_sqpoll ? "io_uring (SQPOLL)" : "io_uring") << std::endl;
+    std::cout << "RX Timestamps: " << (rx_timestamping == RxTimestamping::OFF ? "off" :
+                                       rx_timestamping == RxTimestamping::SOFTWARE ? "software" :
+                                       "hardware on " + timestamp_interface) << std::endl;
+    if (busy_poll.usecs > 0 || busy_poll.prefer) {
+        std::cout << "Busy Poll: " << busy_poll.usecs << " us, budget "
+                  << (busy_poll.budget > 0 ? std::to_string(busy_poll.budget) : std::string("default"))
+                  << (busy_poll.prefer ? ", preferred" : "") << std::endl;
+    }
+    std::cout << "Sessions: login " << (session_config.require_login ? "required" : "optional")
+              << ", heartbeat " << session_config.heartbeat_interval_ms << " ms x" << session_config.missed_heartbeats
+              << ", idle timeout " << (session_config.idle_timeout_ms > 0 ? std::to_string(session_config.idle_timeout_ms) + " ms"
+                                                                         : std::string("off")) << std::endl;
+    std::cout << "Journal: " << (journal_path.empty() ? "disabled" : journal_path) << std::endl;
+    std::cout << "Log: " << (log_path.empty() ? "stdout" : log_path) << " (" << logLevelName(log_level) << ")" << std::endl;
+    if (!trace_path.empty()) {
+        std::cout << "Trace: " << trace_path << " (1 in " << trace_every << ")" << std::endl;
+    }
+    if (!feed_config.lines.empty()) {
+        std::cout << "Feed: " << feed_config.lines.size() << " line(s) via " << feedModeName(feed_config.mode)
+                  << (feed_config.interface.empty() ? "" : " on " + feed_config.interface) << std::endl;
+    }
+    if (!stats_name.empty()) {
+        std::cout << "Stats: /dev/shm/" << stats_name << " every " << stats_interval_ms << " ms" << std::endl;
+    }
+    if (!replay_path.empty()) {
+        std::cout << "Replay: " << replay_path << (replay_recorded ? " (recorded speed)" : " (max speed)") << std::endl;
+    }
     std::cout << "Target Latency: < 10 microseconds" << std::endl;
     std::cout << "========================" << std::endl;
+    ThreadPlacement::getInstance().printReport();
+    
+    // Warnings from the hot path are formatted off it, on the logger thread
+    auto& logger = AsyncLogger::getInstance();
+    logger.setMinLevel(log_level);
+    if (!logger.start(log_path)) {
+        return 1;
+    }
+    
+    // Stage histograms are always kept; the file only adds sampled raw traces
+    auto& tracer = PipelineTracer::getInstance();
+    if (!trace_path.empty() && !tracer.openTraceFile(trace_path, trace_every)) {
+        return 1;
+    }
     
     // Setup signal handlers
     setupSignalHandlers();
     
     try {
-        // Initialize socket server
+        // Configure server for low latency; listeners are sized from the thread count
         auto& socket_server = SocketServer::getInstance();
-        if (!socket_server.initialize(port, 10000)) {
+        socket_server.setThreadCount(thread_count);
+        socket_server.setBufferSize(buffer_size);
+        socket_server.setAffinity(ThreadPlacement::getInstance().enabled());
+        socket_server.setDispatchPolicy(dispatch_policy);
+        socket_server.setWaitStrategy(reactor_wait);
+        socket_server.setZeroCopy(zerocopy);
+        socket_server.setIoBackend(io_backend, uring_sqpoll);
+        socket_server.setBusyPoll(busy_poll);
+        socket_server.setSessionConfig(session_config);
+        if (rx_timestamping != RxTimestamping::OFF) {
+            socket_server.setRxTimestamping(rx_timestamping, timestamp_interface);
+        }
+        
+        // Initialize socket server; a replay runs the pipeline without listening
+        if (replay_path.empty() && !socket_server.initialize(port, 10000, listen_mode)) {
             std::cerr << "[Main] Failed to initialize socket server" << std::endl;
             return 1;
         }
         
-        // Configure server for low latency
-        socket_server.setThreadCount(thread_count);
-        socket_server.setBufferSize(buffer_size);
-        socket_server.setAffinity(affinity_enabled);
-        
         // Initialize service manager
         auto& service_manager = ServiceManager::getInstance();
         
+        // Matching settles the reservations the risk stage makes
+        auto matching_service = std::make_shared<OrderMatchingService>(matching_shards);
+        auto risk_service = std::make_shared<RiskManagementService>();
+        matching_service->setRiskEngine(&risk_service->engine());
+        
+        // Validate, throttle and risk-check inline on the reactor, then publish to
+        // the services subscribed to the type: orders reach only their matching
+        // shard, quotes only market data and risk
+        InboundChain inbound_chain(ValidationInterceptor(), ThrottleConfig(client_rate, client_burst),
+                                   RiskInterceptor(&risk_service->engine()));
+        for (const auto& limit : client_limits) {
+            inbound_chain.stage<1>().setClientLimits(limit.first, limit.second.first, limit.second.second);
+        }
+        std::atomic<size_t> rejected{0};
+        
+        // Accepted messages are journaled before they reach the services
+        Journal journal;
+        bool journaling = !journal_path.empty();
+        if (journaling && !journal.open(journal_path)) {
+            std::cerr << "[Main] Failed to open journal " << journal_path << std::endl;
+            return 1;
+        }
+        
+        std::function<void(MessageHandle, const MessageView&)> on_message =
+            [&socket_server, &service_manager, &inbound_chain, &rejected, &journal, journaling](
+                MessageHandle message, const MessageView& frame) {
+            InterceptorContext context(*message);
+            bool accepted = inbound_chain.process(context);
+            
+            PipelineTrace& trace = message->trace();
+            uint64_t risk_start = context.getField(ContextField::RISK_START_TICKS);
+            if (risk_start != 0) {
+                trace.mark(TraceStage::INTERCEPT, risk_start);
+                trace.mark(TraceStage::RISK);
+            } else {
+                trace.mark(TraceStage::INTERCEPT);
+            }
+            
+            MessageType type = message->getType();
+            bool is_order = (type == MessageType::ORDER_NEW || type == MessageType::ORDER_CANCEL ||
+                             type == MessageType::ORDER_REPLACE);
+            
+            // An order is only acked accepted once its shard has taken it, so a
+            // full ring or a stopped engine becomes a reject instead of an ack
+            // for an order that never matches. The shard stamps ACK on its copy.
+            bool published = false;
+            if (accepted) {
+                if (is_order) trace.mark(TraceStage::ACK);
+                published = service_manager.publish(*message);
+                if (journaling && (published || !is_order)) {
+                    journal.append(*message, frame.data(), frame.length());
+                }
+            }
+            
+            // Every order request is acked on its own connection; the ack goes
+            // out with the reactor's flush at the end of this read cycle, ahead
+            // of any fill, which is handed over to the reactor afterwards
+            bool dropped = accepted && is_order && !published;
+            if (is_order) {
+                InterceptStatus status = dropped ? InterceptStatus::ENGINE_UNAVAILABLE : context.getStatus();
+                bool acked = accepted && !dropped;
+                OrderAckMessage ack(static_cast<const OrderMessage&>(*message),
+                                    acked ? AckStatus::ACCEPTED : AckStatus::REJECTED,
+                                    acked ? 0 : static_cast<uint8_t>(status));
+                socket_server.send(message->getConnectionId(), ack);
+                if (!acked) trace.mark(TraceStage::ACK);
+            }
+            
+            // The matching shard finishes the trace of an order it took
+            if (!accepted || !is_order || dropped) {
+                PipelineTracer::getInstance().record(trace, message->getSequenceNumber(), message->getClientId(),
+                                                     static_cast<uint8_t>(type));
+            }
+            if (!accepted || dropped) {
+                rejected.fetch_add(1, std::memory_order_relaxed);
+            }
+        };
+        
+        auto market_data_service = std::make_shared<MarketDataService>();
+        
+        // Sessions that log in with LOGIN_MARKET_DATA get every quote through
+        // the outbound path. A backed-up socket leaves its symbols pending, so
+        // a slow client gets the newest quote per symbol once it drains
+        std::mutex md_mutex;
+        std::unordered_map<ConnectionId, MarketDataService::SubscriberId> md_subscribers;
+        auto subscribeQuotes = [&socket_server, &market_data_service](ConnectionId connection_id) {
+            return market_data_service->subscribe(
+                [&socket_server, connection_id](SymbolId symbol_id, const TopOfBook& quote) {
+                if (socket_server.isCongested(connection_id)) return false;
+                MarketDataMessage update(SymbolRegistry::getInstance().name(symbol_id), quote.bid, quote.ask,
+                                         quote.bid_size, quote.ask_size);
+                return socket_server.send(connection_id, update);
+            });
+        };
+        
+        // A login takes the client's risk account, so its first order never
+        // registers one; clients beyond the risk table are refused up front
+        socket_server.setLoginHandler([&risk_service, &subscribeQuotes, &md_mutex, &md_subscribers](
+                                          const LoginMessage& login, ConnectionId connection_id) {
+            if (!risk_service->engine().registerAccount(login.getClientId())) return false;
+            if (!(login.getFlags() & wire::LOGIN_MARKET_DATA)) return true;
+            
+            MarketDataService::SubscriberId subscriber = subscribeQuotes(connection_id);
+            if (subscriber == MarketDataService::INVALID_SUBSCRIBER) return false;
+            std::lock_guard<std::mutex> lock(md_mutex);
+            md_subscribers[connection_id] = subscriber;
+            return true;
+        });
+        socket_server.setSessionEndHandler([&market_data_service, &md_mutex, &md_subscribers](
+                                               uint64_t, ConnectionId connection_id) {
+            std::lock_guard<std::mutex> lock(md_mutex);
+            auto it = md_subscribers.find(connection_id);
+            if (it == md_subscribers.end()) return;
+            market_data_service->unsubscribe(it->second);
+            md_subscribers.erase(it);
+        });
+        
+        // Fills go to the client's session, or whichever connection it last traded on
+        matching_service->setFillCallback([&socket_server](const OrderMessage& fill) {
+            socket_server.sendToClient(fill.getClientId(), fill);
+        });
+        
         // Register services
-        service_manager.registerService(std::make_shared<OrderMatchingService>());
-        service_manager.registerService(std::make_shared<MarketDataService>());
-        service_manager.registerService(std::make_shared<RiskManagementService>());
+        service_manager.registerService(matching_service);
+        service_manager.registerService(market_data_service);
+        service_manager.registerService(risk_service);
+        service_manager.setWaitStrategy(processor_wait, service_wait);
+        
+        // Multicast quotes skip the TCP pipeline and reach the two services
+        // that subscribe to market data directly, on the feed thread. Quotes
+        // arriving before the services start are dropped by them
+        FeedHandler feed;
+        bool feeding = !feed_config.lines.empty() && replay_path.empty();
+        if (feeding) {
+            feed.setWaitStrategy(reactor_wait);
+            feed.setQuoteCallback([&market_data_service, &risk_service](const MarketDataView& quote) {
+                market_data_service->processQuote(quote);
+                risk_service->engine().onMarketData(quote.resolveSymbolId(), quote.getBid(), quote.getAsk());
+            });
+            if (!feed.start(feed_config)) {
+                std::cerr << "[Main] Failed to start the market data feed" << std::endl;
+                return 1;
+            }
+        }
         
         // Start services
         service_manager.startAllServices();
+        journal.start();
+        
+        if (!replay_path.empty()) {
+            bool replayed = replayJournal(replay_path, replay_recorded, on_message);
+            
+            // Stopping drains matching, so the counts below cover the whole journal
+            service_manager.stopAllServices();
+            journal.stop();
+            logger.stop();
+            tracer.closeTraceFile();
+            tracer.printStats();
+            std::cout << "[Replay] Rejected inbound: " << rejected.load(std::memory_order_relaxed)
+                      << ", fills: " << matching_service->getFillCount()
+                      << ", matching rejects: " << matching_service->getRejectCount() << std::endl;
+            return replayed ? 0 : 1;
+        }
         
         // Start socket server
+        socket_server.setMessageCallback(on_message);
         socket_server.start();
         
+        // Everything below is read on the publisher thread from counters and
+        // histograms the components keep anyway; nothing is added to the hot path
+        StatsPublisher stats;
+        if (!stats_name.empty()) {
+            stats.addCounter("server.connections", [&socket_server]() { return socket_server.getConnectionCount(); });
+            stats.addCounter("server.messages_processed", [&socket_server]() { return socket_server.getMessagesProcessed(); });
+            stats.addCounter("server.messages_rejected", [&rejected]() { return rejected.load(std::memory_order_relaxed); });
+            stats.addCounter("server.messages_sent", [&socket_server]() { return socket_server.getMessagesSent(); });
+            stats.addCounter("server.send_calls", [&socket_server]() { return socket_server.getSendCalls(); });
+            stats.addCounter("server.send_drops", [&socket_server]() { return socket_server.getSendDrops(); });
+            if (rx_timestamping != RxTimestamping::OFF) {
+                stats.addCounter("server.hardware_stamps", [&socket_server]() { return socket_server.getHardwareStampCount(); });
+                stats.addCounter("server.software_stamps", [&socket_server]() { return socket_server.getSoftwareStampCount(); });
+            }
+            stats.addCounter("session.logins", [&socket_server]() { return socket_server.getSessionStats().logins; });
+            stats.addCounter("session.logins_rejected", [&socket_server]() { return socket_server.getSessionStats().logins_rejected; });
+            stats.addCounter("session.logouts", [&socket_server]() { return socket_server.getSessionStats().logouts; });
+            stats.addCounter("session.reaped", [&socket_server]() { return socket_server.getSessionStats().reaped; });
+            stats.addCounter("session.heartbeats_sent", [&socket_server]() { return socket_server.getSessionStats().heartbeats_sent; });
+            stats.addCounter("session.sequence_gaps", [&socket_server]() { return socket_server.getSessionStats().sequence_gaps; });
+            stats.addCounter("session.duplicates_dropped", [&socket_server]() { return socket_server.getSessionStats().duplicates_dropped; });
+            for (size_t i = 0; i < socket_server.getReactorCount(); ++i) {
+                std::string prefix = "reactor." + std::to_string(i);
+                stats.addCounter(prefix + ".connections", [&socket_server, i]() { return socket_server.getReactorConnections(i); });
+                stats.addCounter(prefix + ".frames_read", [&socket_server, i]() { return socket_server.getReactorFramesRead(i); });
+            }
+            stats.addCounter("matching.fills", [&matching_service]() { return matching_service->getFillCount(); });
+            stats.addCounter("matching.rejects", [&matching_service]() { return matching_service->getRejectCount(); });
+            stats.addCounter("marketdata.delivered", [&market_data_service]() { return market_data_service->getDeliveredCount(); });
+            stats.addCounter("marketdata.conflated", [&market_data_service]() { return market_data_service->getConflatedCount(); });
+            if (journaling) {
+                stats.addCounter("journal.records", [&journal]() { return journal.getRecordCount(); });
+                stats.addCounter("journal.drops", [&journal]() { return journal.getDropCount(); });
+            }
+            if (feeding) {
+                stats.addCounter("feed.packets", [&feed]() { return feed.getPacketCount(); });
+                stats.addCounter("feed.messages", [&feed]() { return feed.getMessageCount(); });
+                stats.addCounter("feed.duplicates", [&feed]() { return feed.getDuplicateCount(); });
+                stats.addCounter("feed.gaps", [&feed]() { return feed.getGapCount(); });
+                stats.addCounter("feed.missed", [&feed]() { return feed.getMissedCount(); });
+                stats.addCounter("feed.malformed", [&feed]() { return feed.getMalformedCount(); });
+            }
+            stats.addCounter("logger.drops", [&logger]() { return logger.getDropCount(); });
+            
+            stats.addHistogram("server.latency", [&socket_server](LatencyHistogram& out) { socket_server.getLatencySnapshot(out); });
+            for (const std::string& name : service_manager.getServiceNames()) {
+                stats.addHistogram("service." + name, [&service_manager, name](LatencyHistogram& out) {
+                    service_manager.getServiceLatencySnapshot(name, out);
+                });
+            }
+            for (size_t i = 1; i < TRACE_STAGE_COUNT; ++i) {
+                TraceStage stage = static_cast<TraceStage>(i);
+                stats.addHistogram(std::string("trace.") + traceStageName(stage), [&tracer, stage](LatencyHistogram& out) {
+                    tracer.getStageSnapshot(stage, out);
+                });
+            }
+            stats.addHistogram("trace.total", [&tracer](LatencyHistogram& out) { tracer.getTotalSnapshot(out); });
+            
+            if (!stats.start(stats_name, stats_interval_ms)) {
+                std::cerr << "[Main] Failed to start the stats publisher" << std::endl;
+            }
+        }
+        
         std::cout << "[Main] Server started successfully" << std::endl;
         std::cout << "[Main] Listening on port " << port << std::endl;
         std::cout << "[Main] Press Ctrl+C to stop" << std::endl;
@@ -209,27 +879,67 @@ int main(int argc, char* argv[]) {
         if (argc == 1 || std::string(argv[1]) != "--test-mode") {
             runPerformanceTest();
             runLatencyBenchmark();
+            runMatchingBenchmark();
         }
         
         // Main server loop
         while (g_running) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
+            tracer.flushSamples();
             
             // Print periodic statistics
             static int counter = 0;
             if (++counter % 10 == 0) { // Every 10 seconds
                 std::cout << "[Main] Active connections: " << socket_server.getConnectionCount() << std::endl;
                 std::cout << "[Main] Messages processed: " << socket_server.getMessagesProcessed() << std::endl;
-                std::cout << "[Main] Average latency: " << socket_server.getAverageLatency() << " μs" << std::endl;
-                std::cout << "[Main] Active services: " << service_manager.getActiveServiceCount() << std::endl;
+                std::cout << "[Main] Messages rejected: " << rejected.load(std::memory_order_relaxed) << std::endl;
+                if (journaling) {
+                    std::cout << "[Main] Journaled: " << journal.getRecordCount() << " in "
+                              << journal.getSegmentCount() << " segment(s), " << journal.getDropCount() << " dropped" << std::endl;
+                }
+                std::cout << "[Main] Messages sent: " << socket_server.getMessagesSent()
+                          << " in " << socket_server.getSendCalls() << " send calls, "
+                          << socket_server.getSendDrops() << " dropped" << std::endl;
+                SessionStats sessions = socket_server.getSessionStats();
+                std::cout << "[Main] Sessions: " << sessions.logins << " logins (" << sessions.logins_rejected << " rejected), "
+                          << sessions.logouts << " logouts, " << sessions.reaped << " reaped, "
+                          << sessions.heartbeats_sent << " heartbeats sent, " << sessions.sequence_gaps << " sequence gaps, "
+                          << sessions.duplicates_dropped << " duplicates dropped" << std::endl;
+                if (rx_timestamping != RxTimestamping::OFF) {
+                    std::cout << "[Main] Stamped reads: " << socket_server.getHardwareStampCount() << " hardware, "
+                              << socket_server.getSoftwareStampCount() << " software" << std::endl;
+                }
+                LatencyHistogram latency;
+                socket_server.getLatencySnapshot(latency);
+                std::cout << "[Main] Latency μs: avg " << latency.mean() / 1000.0
+                          << " p50 " << latency.percentile(0.50) / 1000.0
+                          << " p99 " << latency.percentile(0.99) / 1000.0
+                          << " p99.9 " << latency.percentile(0.999) / 1000.0
+                          << " p99.99 " << latency.percentile(0.9999) / 1000.0
+                          << " max " << latency.max() / 1000.0
+                          << " (" << latency.count() << " samples)" << std::endl;
+                tracer.printStats();
+                if (feeding) {
+                    feed.printStats();
+                }
+                std::cout << "[Main] Active services: " << service_manager.getActiveServiceCount()
+                          << " (avg " << service_manager.getAverageLatency() << " μs per delivery)" << std::endl;
             }
         }
         
         // Shutdown
         std::cout << "[Main] Shutting down server..." << std::endl;
         
-        socket_server.stop();
+        // Services first, so nothing is still sending once the reactors are gone;
+        // the feed before them, so no quote arrives at a stopped service
+        stats.stop();
+        feed.stop();
         service_manager.stopAllServices();
+        socket_server.stop();
+        journal.stop();
+        logger.stop();
+        tracer.closeTraceFile();
+        tracer.printStats();
         
         std::cout << "[Main] Server stopped successfully" << std::endl;
         
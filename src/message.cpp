@@ -1,4 +1,5 @@
 #include "../include/message.hpp"
+#include "../include/tsc_clock.hpp"
 #include <cstring>
 #include <algorithm>
 #include <sstream>
@@ -8,239 +9,227 @@ namespace hft {
 // Static member initialization
 std::atomic<uint64_t> Message::global_sequence_counter_{0};
 
+constexpr size_t OrderView::ORDER_ID_OFFSET;
+constexpr size_t OrderView::SYMBOL_OFFSET;
+constexpr size_t OrderView::PRICE_OFFSET;
+constexpr size_t OrderView::QUANTITY_OFFSET;
+constexpr size_t OrderView::SIDE_OFFSET;
+constexpr size_t OrderView::SYMBOL_ID_OFFSET;
+constexpr size_t OrderView::SIZE;
+constexpr size_t OrderView::MIN_SIZE;
+
+constexpr size_t MarketDataView::SYMBOL_OFFSET;
+constexpr size_t MarketDataView::BID_OFFSET;
+constexpr size_t MarketDataView::ASK_OFFSET;
+constexpr size_t MarketDataView::BID_SIZE_OFFSET;
+constexpr size_t MarketDataView::ASK_SIZE_OFFSET;
+constexpr size_t MarketDataView::SYMBOL_ID_OFFSET;
+constexpr size_t MarketDataView::SIZE;
+constexpr size_t MarketDataView::MIN_SIZE;
+
+namespace {
+
+void storeSymbol(char* out, const std::string& symbol) {
+    size_t length = std::min(symbol.length(), wire::SYMBOL_LENGTH);
+    memset(out, 0, wire::SYMBOL_LENGTH);
+    memcpy(out, symbol.data(), length);
+}
+
+size_t symbolLength(const char* symbol) {
+    size_t length = 0;
+    while (length < wire::SYMBOL_LENGTH && symbol[length] != '\0') {
+        ++length;
+    }
+    return length;
+}
+
+// A wire id is the client's claim, not a trusted index: it must be assigned
+// and agree with the symbol text when the frame carries both
+SymbolId resolveSymbol(SymbolId wire_id, const char* symbol) {
+    size_t length = symbolLength(symbol);
+    if (wire_id != INVALID_SYMBOL_ID) return SymbolRegistry::getInstance().verify(wire_id, symbol, length);
+    return SymbolRegistry::getInstance().find(symbol, length);
+}
+
+} // namespace
+
 // Base Message implementation
 Message::Message(MessageType type, MessagePriority priority)
-    : type_(type), priority_(priority), sequence_number_(0), timestamp_(0), client_id_(0) {
-    timestamp_ = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-    sequence_number_ = global_sequence_counter_.fetch_add(1);
+    : type_(type), priority_(priority), sequence_number_(0), timestamp_(0), client_id_(0), connection_id_(0), receive_ticks_(0) {
+}
+
+void Message::stamp() {
+    timestamp_ = TscClock::wallNanos() / 1000;
+    sequence_number_ = global_sequence_counter_.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+std::vector<uint8_t> Message::serialize() const {
+    std::vector<uint8_t> data(serializedSize());
+    serializeInto(reinterpret_cast<char*>(data.data()));
+    return data;
+}
+
+bool Message::deserialize(const std::vector<uint8_t>& data) {
+    return deserialize(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+void Message::encodeHeader(wire::Header& header) const {
+    memset(&header, 0, sizeof(header));
+    header.version = wire::SCHEMA_VERSION;
+    header.type = static_cast<uint8_t>(type_);
+    header.priority = static_cast<uint8_t>(priority_);
+    header.sequence_number = sequence_number_;
+    header.timestamp = timestamp_;
+    header.client_id = client_id_;
+}
+
+void Message::decodeHeader(const wire::Header& header) {
+    type_ = static_cast<MessageType>(header.type);
+    priority_ = static_cast<MessagePriority>(header.priority);
+    sequence_number_ = header.sequence_number;
+    timestamp_ = header.timestamp;
+    client_id_ = header.client_id;
+}
+
+// OrderView / MarketDataView implementation
+bool OrderView::valid() const {
+    if (!MessageView::valid() || length_ < MIN_SIZE) return false;
+    
+    switch (getType()) {
+        case MessageType::ORDER_NEW:
+        case MessageType::ORDER_CANCEL:
+        case MessageType::ORDER_REPLACE:
+        case MessageType::ORDER_FILL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+size_t OrderView::getSymbolLength() const {
+    return symbolLength(getSymbolData());
+}
+
+SymbolId OrderView::resolveSymbolId() const {
+    return resolveSymbol(getSymbolId(), getSymbolData());
+}
+
+bool MarketDataView::valid() const {
+    return MessageView::valid() && length_ >= MIN_SIZE && getType() == MessageType::MARKET_DATA;
+}
+
+size_t MarketDataView::getSymbolLength() const {
+    return symbolLength(getSymbolData());
+}
+
+SymbolId MarketDataView::resolveSymbolId() const {
+    return resolveSymbol(getSymbolId(), getSymbolData());
 }
 
 // OrderMessage implementation
 OrderMessage::OrderMessage()
-    : Message(MessageType::ORDER_NEW), order_id_(0), price_(0.0), quantity_(0), is_buy_(true) {
+    : Message(MessageType::ORDER_NEW), order_id_(0), symbol_id_(INVALID_SYMBOL_ID),
+      price_(0.0), quantity_(0), is_buy_(true) {
 }
 
 OrderMessage::OrderMessage(uint64_t order_id, const std::string& symbol, double price, uint32_t quantity, bool is_buy)
-    : Message(MessageType::ORDER_NEW), order_id_(order_id), symbol_(symbol), 
+    : Message(MessageType::ORDER_NEW), order_id_(order_id), symbol_(symbol),
+      symbol_id_(SymbolRegistry::getInstance().find(symbol)),
       price_(price), quantity_(quantity), is_buy_(is_buy) {
+    stamp();
 }
 
-std::vector<uint8_t> OrderMessage::serialize() const {
-    std::vector<uint8_t> data;
-    data.reserve(64); // Pre-allocate for efficiency
-    
-    // Header: type, priority, sequence, timestamp, client_id
-    data.push_back(static_cast<uint8_t>(type_));
-    data.push_back(static_cast<uint8_t>(priority_));
-    
-    // Sequence number (8 bytes)
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((sequence_number_ >> (i * 8)) & 0xFF);
-    }
-    
-    // Timestamp (8 bytes)
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((timestamp_ >> (i * 8)) & 0xFF);
-    }
-    
-    // Client ID (8 bytes)
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((client_id_ >> (i * 8)) & 0xFF);
-    }
-    
-    // Order ID (8 bytes)
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((order_id_ >> (i * 8)) & 0xFF);
-    }
-    
-    // Symbol length and data
-    uint8_t symbol_len = static_cast<uint8_t>(symbol_.length());
-    data.push_back(symbol_len);
-    data.insert(data.end(), symbol_.begin(), symbol_.end());
-    
-    // Price (8 bytes)
-    uint64_t price_bits = *reinterpret_cast<const uint64_t*>(&price_);
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((price_bits >> (i * 8)) & 0xFF);
-    }
-    
-    // Quantity (4 bytes)
-    for (int i = 0; i < 4; ++i) {
-        data.push_back((quantity_ >> (i * 8)) & 0xFF);
-    }
-    
-    // Buy/Sell flag (1 byte)
-    data.push_back(is_buy_ ? 1 : 0);
-    
-    return data;
+void OrderMessage::setSymbol(const std::string& symbol) {
+    symbol_ = symbol;
+    symbol_id_ = SymbolRegistry::getInstance().find(symbol);
 }
 
-bool OrderMessage::deserialize(const std::vector<uint8_t>& data) {
-    if (data.size() < 50) return false; // Minimum size check
-    
-    size_t pos = 0;
-    
-    // Header
-    type_ = static_cast<MessageType>(data[pos++]);
-    priority_ = static_cast<MessagePriority>(data[pos++]);
-    
-    // Sequence number
-    sequence_number_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        sequence_number_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    
-    // Timestamp
-    timestamp_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        timestamp_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    
-    // Client ID
-    client_id_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        client_id_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    
-    // Order ID
-    order_id_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        order_id_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    
-    // Symbol
-    uint8_t symbol_len = data[pos++];
-    if (pos + symbol_len > data.size()) return false;
-    symbol_ = std::string(data.begin() + pos, data.begin() + pos + symbol_len);
-    pos += symbol_len;
-    
-    // Price
-    uint64_t price_bits = 0;
-    for (int i = 0; i < 8; ++i) {
-        price_bits |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    price_ = *reinterpret_cast<double*>(&price_bits);
-    
-    // Quantity
-    quantity_ = 0;
-    for (int i = 0; i < 4; ++i) {
-        quantity_ |= static_cast<uint32_t>(data[pos++]) << (i * 8);
-    }
-    
-    // Buy/Sell flag
-    if (pos < data.size()) {
-        is_buy_ = (data[pos] != 0);
-    }
-    
+void OrderMessage::setSymbolId(SymbolId symbol_id) {
+    symbol_id_ = symbol_id;
+    symbol_ = SymbolRegistry::getInstance().name(symbol_id);
+}
+
+size_t OrderMessage::serializedSize() const {
+    return sizeof(wire::Order);
+}
+
+size_t OrderMessage::serializeInto(char* buf) const {
+    wire::Order out;
+    encodeHeader(out.header);
+    out.order_id = order_id_;
+    storeSymbol(out.symbol, symbol_);
+    out.price = price_;
+    out.quantity = quantity_;
+    out.is_buy = is_buy_ ? 1 : 0;
+    memset(out.reserved, 0, sizeof(out.reserved));
+    out.symbol_id = symbol_id_;
+    out.reserved_v2 = 0;
+    
+    wire::Codec<wire::Order>::encode(out, buf);
+    return sizeof(wire::Order);
+}
+
+bool OrderMessage::deserialize(const char* data, size_t length) {
+    if (!OrderView(data, length).valid()) return false;
+    
+    wire::Order in;
+    if (!wire::Codec<wire::Order>::decode(data, length, in)) return false;
+    
+    decodeHeader(in.header);
+    order_id_ = in.order_id;
+    symbol_.assign(in.symbol, symbolLength(in.symbol));
+    symbol_id_ = resolveSymbol(in.symbol_id, in.symbol);
+    price_ = in.price;
+    quantity_ = in.quantity;
+    is_buy_ = (in.is_buy != 0);
     return true;
 }
 
 // MarketDataMessage implementation
 MarketDataMessage::MarketDataMessage()
-    : Message(MessageType::MARKET_DATA), bid_(0.0), ask_(0.0), bid_size_(0), ask_size_(0) {
+    : Message(MessageType::MARKET_DATA), symbol_id_(INVALID_SYMBOL_ID),
+      bid_(0.0), ask_(0.0), bid_size_(0), ask_size_(0) {
 }
 
 MarketDataMessage::MarketDataMessage(const std::string& symbol, double bid, double ask, uint32_t bid_size, uint32_t ask_size)
-    : Message(MessageType::MARKET_DATA), symbol_(symbol), bid_(bid), ask_(ask), 
+    : Message(MessageType::MARKET_DATA), symbol_(symbol),
+      symbol_id_(SymbolRegistry::getInstance().find(symbol)), bid_(bid), ask_(ask), 
       bid_size_(bid_size), ask_size_(ask_size) {
+    stamp();
 }
 
-std::vector<uint8_t> MarketDataMessage::serialize() const {
-    std::vector<uint8_t> data;
-    data.reserve(64);
-    
-    // Header
-    data.push_back(static_cast<uint8_t>(type_));
-    data.push_back(static_cast<uint8_t>(priority_));
-    
-    // Sequence, timestamp, client_id
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((sequence_number_ >> (i * 8)) & 0xFF);
-    }
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((timestamp_ >> (i * 8)) & 0xFF);
-    }
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((client_id_ >> (i * 8)) & 0xFF);
-    }
-    
-    // Symbol
-    uint8_t symbol_len = static_cast<uint8_t>(symbol_.length());
-    data.push_back(symbol_len);
-    data.insert(data.end(), symbol_.begin(), symbol_.end());
-    
-    // Bid, Ask (8 bytes each)
-    uint64_t bid_bits = *reinterpret_cast<const uint64_t*>(&bid_);
-    uint64_t ask_bits = *reinterpret_cast<const uint64_t*>(&ask_);
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((bid_bits >> (i * 8)) & 0xFF);
-    }
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((ask_bits >> (i * 8)) & 0xFF);
-    }
-    
-    // Sizes (4 bytes each)
-    for (int i = 0; i < 4; ++i) {
-        data.push_back((bid_size_ >> (i * 8)) & 0xFF);
-    }
-    for (int i = 0; i < 4; ++i) {
-        data.push_back((ask_size_ >> (i * 8)) & 0xFF);
-    }
-    
-    return data;
+size_t MarketDataMessage::serializedSize() const {
+    return sizeof(wire::MarketData);
 }
 
-bool MarketDataMessage::deserialize(const std::vector<uint8_t>& data) {
-    if (data.size() < 50) return false;
-    
-    size_t pos = 0;
-    
-    // Header
-    type_ = static_cast<MessageType>(data[pos++]);
-    priority_ = static_cast<MessagePriority>(data[pos++]);
-    
-    // Sequence, timestamp, client_id
-    sequence_number_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        sequence_number_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    timestamp_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        timestamp_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    client_id_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        client_id_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    
-    // Symbol
-    uint8_t symbol_len = data[pos++];
-    if (pos + symbol_len > data.size()) return false;
-    symbol_ = std::string(data.begin() + pos, data.begin() + pos + symbol_len);
-    pos += symbol_len;
-    
-    // Bid, Ask
-    uint64_t bid_bits = 0, ask_bits = 0;
-    for (int i = 0; i < 8; ++i) {
-        bid_bits |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    for (int i = 0; i < 8; ++i) {
-        ask_bits |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    bid_ = *reinterpret_cast<double*>(&bid_bits);
-    ask_ = *reinterpret_cast<double*>(&ask_bits);
-    
-    // Sizes
-    bid_size_ = 0;
-    ask_size_ = 0;
-    for (int i = 0; i < 4; ++i) {
-        bid_size_ |= static_cast<uint32_t>(data[pos++]) << (i * 8);
-    }
-    for (int i = 0; i < 4; ++i) {
-        ask_size_ |= static_cast<uint32_t>(data[pos++]) << (i * 8);
-    }
-    
+size_t MarketDataMessage::serializeInto(char* buf) const {
+    wire::MarketData out;
+    encodeHeader(out.header);
+    storeSymbol(out.symbol, symbol_);
+    out.bid = bid_;
+    out.ask = ask_;
+    out.bid_size = bid_size_;
+    out.ask_size = ask_size_;
+    out.symbol_id = symbol_id_;
+    out.reserved_v2 = 0;
+    
+    wire::Codec<wire::MarketData>::encode(out, buf);
+    return sizeof(wire::MarketData);
+}
+
+bool MarketDataMessage::deserialize(const char* data, size_t length) {
+    if (!MarketDataView(data, length).valid()) return false;
+    
+    wire::MarketData in;
+    if (!wire::Codec<wire::MarketData>::decode(data, length, in)) return false;
+    
+    decodeHeader(in.header);
+    symbol_.assign(in.symbol, symbolLength(in.symbol));
+    symbol_id_ = resolveSymbol(in.symbol_id, in.symbol);
+    bid_ = in.bid;
+    ask_ = in.ask;
+    bid_size_ = in.bid_size;
+    ask_size_ = in.ask_size;
     return true;
 }
 
@@ -252,53 +241,27 @@ HeartbeatMessage::HeartbeatMessage()
 HeartbeatMessage::HeartbeatMessage(uint64_t client_id)
     : Message(MessageType::HEARTBEAT) {
     client_id_ = client_id;
+    stamp();
 }
 
-std::vector<uint8_t> HeartbeatMessage::serialize() const {
-    std::vector<uint8_t> data;
-    data.reserve(32);
-    
-    // Header
-    data.push_back(static_cast<uint8_t>(type_));
-    data.push_back(static_cast<uint8_t>(priority_));
-    
-    // Sequence, timestamp, client_id
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((sequence_number_ >> (i * 8)) & 0xFF);
-    }
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((timestamp_ >> (i * 8)) & 0xFF);
-    }
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((client_id_ >> (i * 8)) & 0xFF);
-    }
-    
-    return data;
+size_t HeartbeatMessage::serializedSize() const {
+    return sizeof(wire::Heartbeat);
 }
 
-bool HeartbeatMessage::deserialize(const std::vector<uint8_t>& data) {
-    if (data.size() < 26) return false;
-    
-    size_t pos = 0;
+size_t HeartbeatMessage::serializeInto(char* buf) const {
+    wire::Heartbeat out;
+    encodeHeader(out.header);
     
-    // Header
-    type_ = static_cast<MessageType>(data[pos++]);
-    priority_ = static_cast<MessagePriority>(data[pos++]);
-    
-    // Sequence, timestamp, client_id
-    sequence_number_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        sequence_number_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    timestamp_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        timestamp_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    client_id_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        client_id_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
+    wire::Codec<wire::Heartbeat>::encode(out, buf);
+    return sizeof(wire::Heartbeat);
+}
+
+bool HeartbeatMessage::deserialize(const char* data, size_t length) {
+    wire::Heartbeat in;
+    if (!wire::Codec<wire::Heartbeat>::decode(data, length, in)) return false;
+    if (static_cast<MessageType>(in.header.type) != MessageType::HEARTBEAT) return false;
     
+    decodeHeader(in.header);
     return true;
 }
 
@@ -309,86 +272,183 @@ ErrorMessage::ErrorMessage()
 
 ErrorMessage::ErrorMessage(uint32_t error_code, const std::string& error_message)
     : Message(MessageType::ERROR), error_code_(error_code), error_message_(error_message) {
+    stamp();
 }
 
-std::vector<uint8_t> ErrorMessage::serialize() const {
-    std::vector<uint8_t> data;
-    data.reserve(64);
-    
-    // Header
-    data.push_back(static_cast<uint8_t>(type_));
-    data.push_back(static_cast<uint8_t>(priority_));
-    
-    // Sequence, timestamp, client_id
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((sequence_number_ >> (i * 8)) & 0xFF);
-    }
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((timestamp_ >> (i * 8)) & 0xFF);
-    }
-    for (int i = 0; i < 8; ++i) {
-        data.push_back((client_id_ >> (i * 8)) & 0xFF);
-    }
-    
-    // Error code
-    for (int i = 0; i < 4; ++i) {
-        data.push_back((error_code_ >> (i * 8)) & 0xFF);
-    }
-    
-    // Error message
-    uint8_t msg_len = static_cast<uint8_t>(error_message_.length());
-    data.push_back(msg_len);
-    data.insert(data.end(), error_message_.begin(), error_message_.end());
-    
-    return data;
+size_t ErrorMessage::serializedSize() const {
+    return sizeof(wire::Error);
 }
 
-bool ErrorMessage::deserialize(const std::vector<uint8_t>& data) {
-    if (data.size() < 30) return false;
-    
-    size_t pos = 0;
-    
-    // Header
-    type_ = static_cast<MessageType>(data[pos++]);
-    priority_ = static_cast<MessagePriority>(data[pos++]);
-    
-    // Sequence, timestamp, client_id
-    sequence_number_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        sequence_number_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    timestamp_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        timestamp_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    client_id_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        client_id_ |= static_cast<uint64_t>(data[pos++]) << (i * 8);
-    }
-    
-    // Error code
-    error_code_ = 0;
-    for (int i = 0; i < 4; ++i) {
-        error_code_ |= static_cast<uint32_t>(data[pos++]) << (i * 8);
-    }
-    
-    // Error message
-    if (pos < data.size()) {
-        uint8_t msg_len = data[pos++];
-        if (pos + msg_len <= data.size()) {
-            error_message_ = std::string(data.begin() + pos, data.begin() + pos + msg_len);
-        }
-    }
+size_t ErrorMessage::serializeInto(char* buf) const {
+    wire::Error out;
+    memset(&out, 0, sizeof(out));
+    encodeHeader(out.header);
+    out.error_code = error_code_;
+    
+    // Text is truncated to the fixed slot
+    out.text_length = static_cast<uint8_t>(std::min(error_message_.length(), wire::ERROR_TEXT_LENGTH));
+    memcpy(out.text, error_message_.data(), out.text_length);
+    
+    wire::Codec<wire::Error>::encode(out, buf);
+    return sizeof(wire::Error);
+}
+
+bool ErrorMessage::deserialize(const char* data, size_t length) {
+    wire::Error in;
+    if (!wire::Codec<wire::Error>::decode(data, length, in)) return false;
+    if (static_cast<MessageType>(in.header.type) != MessageType::ERROR) return false;
+    
+    decodeHeader(in.header);
+    error_code_ = in.error_code;
+    error_message_.assign(in.text, std::min<size_t>(in.text_length, wire::ERROR_TEXT_LENGTH));
+    return true;
+}
+
+// OrderAckMessage implementation
+OrderAckMessage::OrderAckMessage()
+    : Message(MessageType::ORDER_ACK), order_id_(0), client_sequence_(0), client_timestamp_(0),
+      symbol_id_(INVALID_SYMBOL_ID), status_(AckStatus::ACCEPTED), reason_(0),
+      order_type_(MessageType::ORDER_NEW) {
+}
+
+OrderAckMessage::OrderAckMessage(const OrderMessage& order, AckStatus status, uint8_t reason)
+    : Message(MessageType::ORDER_ACK, MessagePriority::HIGH), order_id_(order.getOrderId()),
+      client_sequence_(order.getSequenceNumber()), client_timestamp_(order.getTimestamp()),
+      symbol_id_(order.getSymbolId()), status_(status), reason_(reason), order_type_(order.getType()) {
+    client_id_ = order.getClientId();
+    connection_id_ = order.getConnectionId();
+    stamp();
+}
+
+size_t OrderAckMessage::serializedSize() const {
+    return sizeof(wire::OrderAck);
+}
+
+size_t OrderAckMessage::serializeInto(char* buf) const {
+    wire::OrderAck out;
+    memset(&out, 0, sizeof(out));
+    encodeHeader(out.header);
+    out.order_id = order_id_;
+    out.client_sequence = client_sequence_;
+    out.client_timestamp = client_timestamp_;
+    out.symbol_id = symbol_id_;
+    out.status = static_cast<uint8_t>(status_);
+    out.reason = reason_;
+    out.order_type = static_cast<uint8_t>(order_type_);
+    
+    wire::Codec<wire::OrderAck>::encode(out, buf);
+    return sizeof(wire::OrderAck);
+}
+
+bool OrderAckMessage::deserialize(const char* data, size_t length) {
+    wire::OrderAck in;
+    if (!wire::Codec<wire::OrderAck>::decode(data, length, in)) return false;
+    if (static_cast<MessageType>(in.header.type) != MessageType::ORDER_ACK) return false;
+    
+    decodeHeader(in.header);
+    order_id_ = in.order_id;
+    client_sequence_ = in.client_sequence;
+    client_timestamp_ = in.client_timestamp;
+    symbol_id_ = in.symbol_id;
+    status_ = static_cast<AckStatus>(in.status);
+    reason_ = in.reason;
+    order_type_ = static_cast<MessageType>(in.order_type);
+    return true;
+}
+
+// LoginMessage implementation
+LoginMessage::LoginMessage()
+    : Message(MessageType::LOGIN, MessagePriority::HIGH), heartbeat_interval_ms_(0), flags_(0) {
+}
+
+LoginMessage::LoginMessage(uint64_t client_id, uint32_t heartbeat_interval_ms, const std::string& credentials)
+    : Message(MessageType::LOGIN, MessagePriority::HIGH), heartbeat_interval_ms_(heartbeat_interval_ms), flags_(0),
+      credentials_(credentials.substr(0, wire::CREDENTIALS_LENGTH)) {
+    client_id_ = client_id;
+    stamp();
+}
+
+size_t LoginMessage::serializedSize() const {
+    return sizeof(wire::Login);
+}
+
+size_t LoginMessage::serializeInto(char* buf) const {
+    wire::Login out;
+    memset(&out, 0, sizeof(out));
+    encodeHeader(out.header);
+    out.heartbeat_interval_ms = heartbeat_interval_ms_;
+    out.flags = flags_;
+    memcpy(out.credentials, credentials_.data(), std::min(credentials_.length(), wire::CREDENTIALS_LENGTH));
+    
+    wire::Codec<wire::Login>::encode(out, buf);
+    return sizeof(wire::Login);
+}
+
+bool LoginMessage::deserialize(const char* data, size_t length) {
+    wire::Login in;
+    if (!wire::Codec<wire::Login>::decode(data, length, in)) return false;
+    if (static_cast<MessageType>(in.header.type) != MessageType::LOGIN) return false;
+    
+    decodeHeader(in.header);
+    heartbeat_interval_ms_ = in.heartbeat_interval_ms;
+    flags_ = in.flags;
+    size_t credentials_length = 0;
+    while (credentials_length < wire::CREDENTIALS_LENGTH && in.credentials[credentials_length] != '\0') {
+        ++credentials_length;
+    }
+    credentials_.assign(in.credentials, credentials_length);
+    return true;
+}
+
+// LogoutMessage implementation
+LogoutMessage::LogoutMessage()
+    : Message(MessageType::LOGOUT, MessagePriority::HIGH), reason_(LogoutReason::NORMAL) {
+}
+
+LogoutMessage::LogoutMessage(uint64_t client_id, LogoutReason reason)
+    : Message(MessageType::LOGOUT, MessagePriority::HIGH), reason_(reason) {
+    client_id_ = client_id;
+    stamp();
+}
+
+size_t LogoutMessage::serializedSize() const {
+    return sizeof(wire::Logout);
+}
+
+size_t LogoutMessage::serializeInto(char* buf) const {
+    wire::Logout out;
+    memset(&out, 0, sizeof(out));
+    encodeHeader(out.header);
+    out.reason = static_cast<uint8_t>(reason_);
+    
+    wire::Codec<wire::Logout>::encode(out, buf);
+    return sizeof(wire::Logout);
+}
+
+bool LogoutMessage::deserialize(const char* data, size_t length) {
+    wire::Logout in;
+    if (!wire::Codec<wire::Logout>::decode(data, length, in)) return false;
+    if (static_cast<MessageType>(in.header.type) != MessageType::LOGOUT) return false;
     
+    decodeHeader(in.header);
+    reason_ = static_cast<LogoutReason>(in.reason);
     return true;
 }
 
 // MessageFactory implementation
 std::shared_ptr<Message> MessageFactory::createMessage(const std::vector<uint8_t>& data) {
-    if (data.empty()) return nullptr;
+    return createMessage(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+std::shared_ptr<Message> MessageFactory::createMessage(const char* data, size_t length) {
+    if (!data || length == 0) return nullptr;
     
-    MessageType type = static_cast<MessageType>(data[0]);
-    return createMessage(type);
+    MessageType type = static_cast<MessageType>(data[wire::TYPE_OFFSET]);
+    auto message = createMessage(type);
+    if (!message || !message->deserialize(data, length)) {
+        return nullptr;
+    }
+    return message;
 }
 
 std::shared_ptr<Message> MessageFactory::createMessage(MessageType type) {
@@ -404,9 +464,15 @@ std::shared_ptr<Message> MessageFactory::createMessage(MessageType type) {
             return std::make_shared<HeartbeatMessage>();
         case MessageType::ERROR:
             return std::make_shared<ErrorMessage>();
+        case MessageType::ORDER_ACK:
+            return std::make_shared<OrderAckMessage>();
+        case MessageType::LOGIN:
+            return std::make_shared<LoginMessage>();
+        case MessageType::LOGOUT:
+            return std::make_shared<LogoutMessage>();
         default:
             return nullptr;
     }
 }
 
-} // namespace hft 
\ No newline at end of file
+} // namespace hft
@@ -0,0 +1,183 @@
+#include "../include/message_pool.hpp"
+#include <mutex>
+
+namespace hft {
+
+constexpr size_t MessagePool::PREALLOCATED_PER_TYPE;
+constexpr size_t MessagePool::RETURN_QUEUE_CAPACITY;
+
+thread_local MessagePool::LocalSlot MessagePool::local_;
+
+namespace {
+
+// Pools whose threads have exited, waiting to be adopted
+std::mutex& parkedMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<MessagePool*>& parkedPools() {
+    static std::vector<MessagePool*>* pools = new std::vector<MessagePool*>();
+    return *pools;
+}
+
+} // namespace
+
+void MessageHandle::reset() {
+    if (!message_) return;
+    
+    if (pool_) {
+        pool_->release(message_);
+    } else {
+        delete message_;
+    }
+    message_ = nullptr;
+}
+
+MessagePool::LocalSlot::~LocalSlot() {
+    if (pool) {
+        MessagePool::park(pool);
+    }
+}
+
+MessagePool& MessagePool::local() {
+    if (!local_.pool) {
+        local_.pool = adopt();
+    }
+    return *local_.pool;
+}
+
+MessagePool* MessagePool::adopt() {
+    {
+        std::lock_guard<std::mutex> lock(parkedMutex());
+        auto& parked = parkedPools();
+        if (!parked.empty()) {
+            MessagePool* pool = parked.back();
+            parked.pop_back();
+            return pool;
+        }
+    }
+    return new MessagePool();
+}
+
+void MessagePool::park(MessagePool* pool) {
+    std::lock_guard<std::mutex> lock(parkedMutex());
+    parkedPools().push_back(pool);
+}
+
+MessagePool::MessagePool() : returns_(RETURN_QUEUE_CAPACITY) {
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        free_[kind].reserve(PREALLOCATED_PER_TYPE * 4);
+        for (size_t i = 0; i < PREALLOCATED_PER_TYPE; ++i) {
+            free_[kind].push_back(create(kind));
+        }
+        allocated_ += PREALLOCATED_PER_TYPE;
+    }
+}
+
+int MessagePool::kindOf(MessageType type) {
+    switch (type) {
+        case MessageType::ORDER_NEW:
+        case MessageType::ORDER_CANCEL:
+        case MessageType::ORDER_REPLACE:
+        case MessageType::ORDER_FILL:
+            return ORDER;
+        case MessageType::MARKET_DATA:
+            return MARKET_DATA;
+        case MessageType::HEARTBEAT:
+            return HEARTBEAT;
+        case MessageType::ERROR:
+            return ERROR_MSG;
+        default:
+            return -1;
+    }
+}
+
+Message* MessagePool::create(int kind) {
+    switch (kind) {
+        case ORDER: return new OrderMessage();
+        case MARKET_DATA: return new MarketDataMessage();
+        case HEARTBEAT: return new HeartbeatMessage();
+        case ERROR_MSG: return new ErrorMessage();
+        default: return nullptr;
+    }
+}
+
+Message* MessagePool::take(int kind) {
+    std::vector<Message*>& list = free_[kind];
+    if (list.empty()) {
+        reclaimReturns();
+    }
+    if (list.empty()) {
+        ++allocated_;
+        return create(kind);
+    }
+    
+    Message* message = list.back();
+    list.pop_back();
+    return message;
+}
+
+MessageHandle MessagePool::acquire(MessageType type) {
+    int kind = kindOf(type);
+    if (kind < 0) return MessageHandle();
+    
+    Message* message = take(kind);
+    switch (kind) {
+        case ORDER:
+            *static_cast<OrderMessage*>(message) = OrderMessage();
+            static_cast<OrderMessage*>(message)->setType(type);
+            break;
+        case MARKET_DATA:
+            *static_cast<MarketDataMessage*>(message) = MarketDataMessage();
+            break;
+        case HEARTBEAT:
+            *static_cast<HeartbeatMessage*>(message) = HeartbeatMessage();
+            break;
+        case ERROR_MSG:
+            *static_cast<ErrorMessage*>(message) = ErrorMessage();
+            break;
+    }
+    return MessageHandle(message, this);
+}
+
+MessageHandle MessagePool::decode(const char* data, size_t length) {
+    if (!data || length < wire::HEADER_SIZE) return MessageHandle();
+    
+    int kind = kindOf(static_cast<MessageType>(data[wire::TYPE_OFFSET]));
+    if (kind < 0) return MessageHandle();
+    
+    // deserialize() overwrites every field, so no reset is needed
+    MessageHandle message(take(kind), this);
+    if (!message->deserialize(data, length)) {
+        return MessageHandle();
+    }
+    return message;
+}
+
+void MessagePool::release(Message* message) {
+    if (local_.pool == this) {
+        recycle(message);
+    } else if (!returns_.tryPush(std::move(message))) {
+        // Owner is not keeping up with returns; let this one go
+        delete message;
+    }
+}
+
+void MessagePool::recycle(Message* message) {
+    int kind = kindOf(message->getType());
+    if (kind < 0) {
+        delete message;
+        return;
+    }
+    free_[kind].push_back(message);
+}
+
+void MessagePool::reclaimReturns() {
+    Message* message = nullptr;
+    while (returns_.tryPop(message)) {
+        recycle(message);
+    }
+}
+
+} // namespace hft
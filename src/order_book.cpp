@@ -0,0 +1,321 @@
+#include "../include/order_book.hpp"
+#include <cmath>
+
+namespace hft {
+
+constexpr uint32_t OrderBook::NIL;
+
+const char* bookResultName(BookResult result) {
+    switch (result) {
+        case BookResult::OK: return "ok";
+        case BookResult::DUPLICATE_ORDER_ID: return "duplicate order id";
+        case BookResult::UNKNOWN_ORDER_ID: return "unknown order id";
+        case BookResult::PRICE_OUT_OF_RANGE: return "price out of range";
+        case BookResult::BOOK_FULL: return "book full";
+        case BookResult::INVALID_QUANTITY: return "invalid quantity";
+    }
+    return "unknown";
+}
+
+// FlatOrderIndex implementation
+FlatOrderIndex::FlatOrderIndex(size_t max_orders) {
+    // Keep the load factor at or below 50%
+    size_t capacity = 16;
+    while (capacity < max_orders * 2) capacity <<= 1;
+    
+    Entry empty = {0, 0};
+    entries_.assign(capacity, empty);
+    mask_ = capacity - 1;
+}
+
+size_t FlatOrderIndex::slotFor(uint64_t order_id) const {
+    uint64_t hash = order_id * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash ^ (hash >> 32)) & mask_;
+}
+
+bool FlatOrderIndex::insert(uint64_t order_id, uint32_t node) {
+    if (order_id == 0 || size_ * 2 >= entries_.size()) return false;
+    
+    size_t slot = slotFor(order_id);
+    while (entries_[slot].order_id != 0) {
+        if (entries_[slot].order_id == order_id) return false;
+        slot = (slot + 1) & mask_;
+    }
+    
+    entries_[slot].order_id = order_id;
+    entries_[slot].node = node;
+    ++size_;
+    return true;
+}
+
+bool FlatOrderIndex::find(uint64_t order_id, uint32_t& node) const {
+    if (order_id == 0) return false;
+    
+    size_t slot = slotFor(order_id);
+    while (entries_[slot].order_id != 0) {
+        if (entries_[slot].order_id == order_id) {
+            node = entries_[slot].node;
+            return true;
+        }
+        slot = (slot + 1) & mask_;
+    }
+    return false;
+}
+
+bool FlatOrderIndex::erase(uint64_t order_id) {
+    if (order_id == 0) return false;
+    
+    size_t hole = slotFor(order_id);
+    while (entries_[hole].order_id != order_id) {
+        if (entries_[hole].order_id == 0) return false;
+        hole = (hole + 1) & mask_;
+    }
+    
+    // Backward-shift later entries of the probe run into the hole
+    size_t next = hole;
+    while (true) {
+        next = (next + 1) & mask_;
+        if (entries_[next].order_id == 0) break;
+        
+        size_t home = slotFor(entries_[next].order_id);
+        bool movable = (hole <= next) ? (home <= hole || home > next)
+                                      : (home <= hole && home > next);
+        if (movable) {
+            entries_[hole] = entries_[next];
+            hole = next;
+        }
+    }
+    
+    entries_[hole].order_id = 0;
+    --size_;
+    return true;
+}
+
+// OrderBook implementation
+OrderBook::OrderBook(double reference_price, double tick_size, size_t price_levels, size_t max_orders)
+    : tick_size_(tick_size),
+      base_tick_(std::llround(reference_price / tick_size) - static_cast<int64_t>(price_levels / 2)),
+      bids_(price_levels),
+      asks_(price_levels),
+      best_ask_(static_cast<int64_t>(price_levels)),
+      nodes_(max_orders),
+      free_head_(0),
+      index_(max_orders) {
+    // Thread every node onto the free list
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        nodes_[i].next = (i + 1 < nodes_.size()) ? static_cast<uint32_t>(i + 1) : NIL;
+    }
+    if (nodes_.empty()) {
+        free_head_ = NIL;
+    }
+}
+
+bool OrderBook::toLevel(double price, uint32_t& level) const {
+    int64_t offset = std::llround(price / tick_size_) - base_tick_;
+    if (offset < 0 || offset >= static_cast<int64_t>(bids_.size())) return false;
+    
+    level = static_cast<uint32_t>(offset);
+    return true;
+}
+
+double OrderBook::toPrice(uint32_t level) const {
+    return (base_tick_ + static_cast<int64_t>(level)) * tick_size_;
+}
+
+BookResult OrderBook::addOrder(uint64_t order_id, uint64_t client_id, bool is_buy, double price, uint32_t quantity) {
+    if (quantity == 0) return BookResult::INVALID_QUANTITY;
+    
+    uint32_t level;
+    if (!toLevel(price, level)) return BookResult::PRICE_OUT_OF_RANGE;
+    
+    uint32_t existing;
+    if (index_.find(order_id, existing)) return BookResult::DUPLICATE_ORDER_ID;
+    
+    uint32_t remaining = match(order_id, client_id, is_buy, level, quantity);
+    if (remaining == 0) return BookResult::OK;
+    
+    return rest(order_id, client_id, is_buy, level, remaining);
+}
+
+BookResult OrderBook::cancelOrder(uint64_t order_id) {
+    uint32_t node_index;
+    if (!index_.find(order_id, node_index)) return BookResult::UNKNOWN_ORDER_ID;
+    
+    unlink(node_index);
+    index_.erase(order_id);
+    
+    nodes_[node_index].next = free_head_;
+    free_head_ = node_index;
+    return BookResult::OK;
+}
+
+BookResult OrderBook::replaceOrder(uint64_t order_id, double new_price, uint32_t new_quantity) {
+    if (new_quantity == 0) return BookResult::INVALID_QUANTITY;
+    
+    uint32_t node_index;
+    if (!index_.find(order_id, node_index)) return BookResult::UNKNOWN_ORDER_ID;
+    
+    uint32_t new_level;
+    if (!toLevel(new_price, new_level)) return BookResult::PRICE_OUT_OF_RANGE;
+    
+    OrderNode& node = nodes_[node_index];
+    
+    // Size-down in place keeps time priority
+    if (new_level == node.level && new_quantity <= node.quantity) {
+        PriceLevel& level = node.is_buy ? bids_[node.level] : asks_[node.level];
+        level.total_quantity -= (node.quantity - new_quantity);
+        node.quantity = new_quantity;
+        return BookResult::OK;
+    }
+    
+    uint64_t client_id = node.client_id;
+    bool is_buy = node.is_buy;
+    cancelOrder(order_id);
+    return addOrder(order_id, client_id, is_buy, new_price, new_quantity);
+}
+
+bool OrderBook::findOrder(uint64_t order_id, RestingOrder& order) const {
+    uint32_t node_index;
+    if (!index_.find(order_id, node_index)) return false;
+    
+    const OrderNode& node = nodes_[node_index];
+    order.client_id = node.client_id;
+    order.price = toPrice(node.level);
+    order.quantity = node.quantity;
+    order.is_buy = node.is_buy;
+    return true;
+}
+
+bool OrderBook::bestBid(double& price, uint64_t& quantity) const {
+    if (best_bid_ < 0) return false;
+    
+    price = toPrice(static_cast<uint32_t>(best_bid_));
+    quantity = bids_[best_bid_].total_quantity;
+    return true;
+}
+
+bool OrderBook::bestAsk(double& price, uint64_t& quantity) const {
+    if (best_ask_ >= static_cast<int64_t>(asks_.size())) return false;
+    
+    price = toPrice(static_cast<uint32_t>(best_ask_));
+    quantity = asks_[best_ask_].total_quantity;
+    return true;
+}
+
+uint32_t OrderBook::match(uint64_t order_id, uint64_t client_id, bool is_buy, uint32_t limit, uint32_t quantity) {
+    std::vector<PriceLevel>& opposite = is_buy ? asks_ : bids_;
+    int64_t limit_level = static_cast<int64_t>(limit);
+    
+    while (quantity > 0) {
+        int64_t best = is_buy ? best_ask_ : best_bid_;
+        bool crosses = is_buy ? (best < static_cast<int64_t>(asks_.size()) && best <= limit_level)
+                              : (best >= 0 && best >= limit_level);
+        if (!crosses) break;
+        
+        PriceLevel& level = opposite[best];
+        uint32_t maker_index = level.head;
+        OrderNode& maker = nodes_[maker_index];
+        
+        uint32_t fill = (quantity < maker.quantity) ? quantity : maker.quantity;
+        quantity -= fill;
+        maker.quantity -= fill;
+        level.total_quantity -= fill;
+        
+        if (execution_callback_) {
+            Execution execution;
+            execution.taker_order_id = order_id;
+            execution.maker_order_id = maker.order_id;
+            execution.taker_client_id = client_id;
+            execution.maker_client_id = maker.client_id;
+            execution.price = toPrice(static_cast<uint32_t>(best));
+            execution.quantity = fill;
+            execution.taker_remaining = quantity;
+            execution.maker_remaining = maker.quantity;
+            execution.taker_is_buy = is_buy;
+            execution_callback_(execution);
+        }
+        
+        if (maker.quantity == 0) {
+            uint64_t maker_id = maker.order_id;
+            unlink(maker_index);
+            index_.erase(maker_id);
+            nodes_[maker_index].next = free_head_;
+            free_head_ = maker_index;
+        }
+    }
+    
+    return quantity;
+}
+
+BookResult OrderBook::rest(uint64_t order_id, uint64_t client_id, bool is_buy, uint32_t level_index, uint32_t quantity) {
+    if (free_head_ == NIL) return BookResult::BOOK_FULL;
+    
+    uint32_t node_index = free_head_;
+    if (!index_.insert(order_id, node_index)) return BookResult::BOOK_FULL;
+    
+    OrderNode& node = nodes_[node_index];
+    free_head_ = node.next;
+    
+    node.order_id = order_id;
+    node.client_id = client_id;
+    node.level = level_index;
+    node.quantity = quantity;
+    node.is_buy = is_buy;
+    node.next = NIL;
+    
+    // Append at the tail for time priority
+    PriceLevel& level = is_buy ? bids_[level_index] : asks_[level_index];
+    node.prev = level.tail;
+    if (level.tail != NIL) {
+        nodes_[level.tail].next = node_index;
+    } else {
+        level.head = node_index;
+    }
+    level.tail = node_index;
+    level.total_quantity += quantity;
+    
+    if (is_buy) {
+        if (static_cast<int64_t>(level_index) > best_bid_) best_bid_ = level_index;
+    } else {
+        if (static_cast<int64_t>(level_index) < best_ask_) best_ask_ = level_index;
+    }
+    return BookResult::OK;
+}
+
+void OrderBook::unlink(uint32_t node_index) {
+    OrderNode& node = nodes_[node_index];
+    PriceLevel& level = node.is_buy ? bids_[node.level] : asks_[node.level];
+    
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        level.head = node.next;
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    } else {
+        level.tail = node.prev;
+    }
+    level.total_quantity -= node.quantity;
+    
+    if (level.head == NIL) {
+        updateBestAfterRemoval(node.is_buy, node.level);
+    }
+}
+
+void OrderBook::updateBestAfterRemoval(bool is_buy, uint32_t level) {
+    if (is_buy) {
+        if (static_cast<int64_t>(level) != best_bid_) return;
+        while (best_bid_ >= 0 && bids_[best_bid_].head == NIL) {
+            --best_bid_;
+        }
+    } else {
+        if (static_cast<int64_t>(level) != best_ask_) return;
+        int64_t levels = static_cast<int64_t>(asks_.size());
+        while (best_ask_ < levels && asks_[best_ask_].head == NIL) {
+            ++best_ask_;
+        }
+    }
+}
+
+} // namespace hft
@@ -0,0 +1,153 @@
+#include "../include/outbound_buffer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+
+// Older libc headers predate zero-copy send
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+
+namespace hft {
+
+constexpr size_t OutboundBuffer::CAPACITY;
+constexpr size_t OutboundBuffer::ZEROCOPY_THRESHOLD;
+constexpr size_t OutboundBuffer::MAX_ZEROCOPY_INFLIGHT;
+
+OutboundBuffer::OutboundBuffer() {
+}
+
+bool OutboundBuffer::append(const char* data, size_t length) {
+    if (queued() + length > CAPACITY) return false;
+    if (data_.empty()) {
+        data_.resize(CAPACITY);
+    }
+    
+    size_t offset = static_cast<size_t>(tail_ & (CAPACITY - 1));
+    size_t first = std::min(length, CAPACITY - offset);
+    memcpy(data_.data() + offset, data, first);
+    memcpy(data_.data(), data + first, length - first);
+    tail_ += length;
+    return true;
+}
+
+size_t OutboundBuffer::peek(struct iovec* iov) const {
+    if (head_ == tail_) return 0;
+    
+    size_t offset = static_cast<size_t>(head_ & (CAPACITY - 1));
+    size_t length = pending();
+    size_t first = std::min(length, CAPACITY - offset);
+    
+    // data_ is only allocated by append, so it exists once anything is pending
+    char* base = const_cast<char*>(data_.data());
+    iov[0].iov_base = base + offset;
+    iov[0].iov_len = first;
+    if (length == first) return 1;
+    
+    iov[1].iov_base = base;
+    iov[1].iov_len = length - first;
+    return 2;
+}
+
+void OutboundBuffer::consume(size_t length) {
+    head_ += std::min(static_cast<uint64_t>(length), tail_ - head_);
+    updateReleased();
+}
+
+OutboundBuffer::FlushResult OutboundBuffer::flush(int fd, bool zerocopy) {
+    while (head_ != tail_) {
+        struct iovec iov[2];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = peek(iov);
+        
+        size_t length = pending();
+        bool use_zerocopy = zerocopy && length >= ZEROCOPY_THRESHOLD &&
+                            inflight_count_ < MAX_ZEROCOPY_INFLIGHT;
+        int flags = MSG_NOSIGNAL | MSG_DONTWAIT | (use_zerocopy ? MSG_ZEROCOPY : 0);
+        
+        ssize_t n = sendmsg(fd, &msg, flags);
+        ++send_calls_;
+        
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return FLUSH_BLOCKED;
+            // Out of pinned-page budget: fall back to copying for this flush
+            if (errno == ENOBUFS && use_zerocopy) {
+                zerocopy = false;
+                continue;
+            }
+            return FLUSH_ERROR;
+        }
+        
+        if (use_zerocopy) {
+            size_t index = (inflight_head_ + inflight_count_) % MAX_ZEROCOPY_INFLIGHT;
+            inflight_[index].id = next_zerocopy_id_++;
+            inflight_[index].start = head_;
+            inflight_[index].end = head_ + static_cast<uint64_t>(n);
+            ++inflight_count_;
+            ++zerocopy_sends_;
+        }
+        
+        head_ += static_cast<uint64_t>(n);
+        updateReleased();
+    }
+    return FLUSH_DONE;
+}
+
+size_t OutboundBuffer::reapCompletions(int fd) {
+    size_t notifications = 0;
+    
+    while (true) {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            bool recverr = (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                           (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+            if (!recverr) continue;
+            
+            struct sock_extended_err err;
+            memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+            
+            // Notifications cover the inclusive id range [ee_info, ee_data]
+            complete(err.ee_data);
+            ++notifications;
+        }
+    }
+    
+    return notifications;
+}
+
+void OutboundBuffer::complete(uint32_t last_id) {
+    // TCP completes sends in order, so everything up to last_id is done
+    while (inflight_count_ > 0 &&
+           static_cast<int32_t>(inflight_[inflight_head_].id - last_id) <= 0) {
+        inflight_head_ = (inflight_head_ + 1) % MAX_ZEROCOPY_INFLIGHT;
+        --inflight_count_;
+    }
+    updateReleased();
+}
+
+void OutboundBuffer::updateReleased() {
+    released_ = inflight_count_ > 0 ? inflight_[inflight_head_].start : head_;
+}
+
+} // namespace hft
@@ -0,0 +1,163 @@
+#include "../include/pipeline_trace.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+namespace hft {
+
+namespace {
+
+// Traces this thread has recorded, for picking every Nth one to sample
+thread_local uint64_t traced_count = 0;
+
+} // namespace
+
+const char* traceStageName(TraceStage stage) {
+    switch (stage) {
+        case TraceStage::WIRE: return "wire";
+        case TraceStage::READ: return "read";
+        case TraceStage::DECODE: return "decode";
+        case TraceStage::INTERCEPT: return "intercept";
+        case TraceStage::RISK: return "risk";
+        case TraceStage::ACK: return "ack";
+        case TraceStage::DEQUEUE: return "dequeue";
+        case TraceStage::MATCH: return "match";
+        case TraceStage::STAGE_COUNT: break;
+    }
+    return "unknown";
+}
+
+// PipelineTracer implementation
+constexpr size_t PipelineTracer::DEFAULT_SAMPLE_EVERY;
+constexpr size_t PipelineTracer::SAMPLE_QUEUE_CAPACITY;
+
+PipelineTracer::PipelineTracer() : samples_(SAMPLE_QUEUE_CAPACITY) {}
+
+PipelineTracer::~PipelineTracer() {
+    closeTraceFile();
+}
+
+bool PipelineTracer::openTraceFile(const std::string& path, size_t sample_every) {
+    closeTraceFile();
+    
+    out_ = fopen(path.c_str(), "w");
+    if (!out_) {
+        std::cerr << "[Trace] Failed to open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    // Stage columns are nanoseconds from the previous stamped stage, empty if
+    // skipped; the first stamped stage has none and gives the wall time instead
+    fprintf(out_, "sequence,client_id,type,first_wall_ns");
+    for (size_t i = 1; i < TRACE_STAGE_COUNT; ++i) {
+        fprintf(out_, ",%s_ns", traceStageName(static_cast<TraceStage>(i)));
+    }
+    fprintf(out_, ",total_ns\n");
+    
+    TscClock::calibrate();
+    sample_every_.store(sample_every > 0 ? sample_every : 1, std::memory_order_release);
+    return true;
+}
+
+void PipelineTracer::closeTraceFile() {
+    if (!out_) return;
+    
+    sample_every_.store(0, std::memory_order_release);
+    flushSamples();
+    fclose(out_);
+    out_ = nullptr;
+    
+    if (getSampleDropCount() > 0) {
+        std::cerr << "[Trace] Dropped " << getSampleDropCount() << " samples on full rings" << std::endl;
+    }
+}
+
+void PipelineTracer::record(const PipelineTrace& trace, uint64_t sequence, uint64_t client_id, uint8_t type) {
+    uint64_t first = 0;
+    uint64_t previous = 0;
+    for (size_t i = 0; i < TRACE_STAGE_COUNT; ++i) {
+        uint64_t stamp = trace.ticks[i];
+        if (stamp == 0) continue;
+        
+        // Stamps from different cores may be a few ticks out of order
+        if (previous != 0) {
+            stages_[i].record(stamp > previous ? TscClock::toNanos(stamp - previous) : 0);
+        } else {
+            first = stamp;
+        }
+        previous = stamp;
+    }
+    if (first == 0) return;
+    total_.record(previous > first ? TscClock::toNanos(previous - first) : 0);
+    
+    size_t sample_every = sample_every_.load(std::memory_order_relaxed);
+    if (sample_every == 0 || ++traced_count % sample_every != 0) return;
+    
+    Sample sample;
+    sample.sequence = sequence;
+    sample.client_id = client_id;
+    sample.type = type;
+    sample.trace = trace;
+    if (!samples_.producer()->tryPush(sample)) {
+        sample_drops_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t PipelineTracer::flushSamples() {
+    if (!out_) return 0;
+    
+    // At most one full ring per producer per flush
+    size_t written = samples_.drain([this](Sample&& sample) { write(sample); }, SAMPLE_QUEUE_CAPACITY);
+    if (written > 0) {
+        fflush(out_);
+    }
+    return written;
+}
+
+void PipelineTracer::write(const Sample& sample) {
+    const PipelineTrace& trace = sample.trace;
+    fprintf(out_, "%llu,%llu,%u,", static_cast<unsigned long long>(sample.sequence),
+            static_cast<unsigned long long>(sample.client_id), static_cast<unsigned>(sample.type));
+    
+    uint64_t first = 0;
+    for (size_t i = 0; i < TRACE_STAGE_COUNT && first == 0; ++i) {
+        first = trace.ticks[i];
+    }
+    if (first != 0) fprintf(out_, "%llu", static_cast<unsigned long long>(TscClock::toWallNanos(first)));
+    
+    uint64_t previous = 0;
+    for (size_t i = 0; i < TRACE_STAGE_COUNT; ++i) {
+        uint64_t stamp = trace.ticks[i];
+        if (i > 0) {
+            fputc(',', out_);
+            if (stamp != 0 && previous != 0) {
+                fprintf(out_, "%llu", static_cast<unsigned long long>(stamp > previous ? TscClock::toNanos(stamp - previous) : 0));
+            }
+        }
+        if (stamp != 0) previous = stamp;
+    }
+    fprintf(out_, ",%llu\n", static_cast<unsigned long long>(previous > first ? TscClock::toNanos(previous - first) : 0));
+}
+
+void PipelineTracer::getStageSnapshot(TraceStage stage, LatencyHistogram& out) const {
+    stages_[static_cast<size_t>(stage)].snapshot(out);
+}
+
+void PipelineTracer::printStats() const {
+    LatencyHistogram snapshot;
+    std::cout << "[Trace] Stage μs (p50/p99/max):";
+    for (size_t i = 1; i < TRACE_STAGE_COUNT; ++i) {
+        stages_[i].snapshot(snapshot);
+        if (snapshot.count() == 0) continue;
+        std::cout << " " << traceStageName(static_cast<TraceStage>(i)) << " "
+                  << snapshot.percentile(0.50) / 1000.0 << "/"
+                  << snapshot.percentile(0.99) / 1000.0 << "/"
+                  << snapshot.max() / 1000.0;
+    }
+    total_.snapshot(snapshot);
+    std::cout << " | total " << snapshot.percentile(0.50) / 1000.0 << "/"
+              << snapshot.percentile(0.99) / 1000.0 << "/" << snapshot.max() / 1000.0
+              << " (" << snapshot.count() << " traces)" << std::endl;
+}
+
+} // namespace hft
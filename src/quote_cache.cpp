@@ -0,0 +1,79 @@
+#include "../include/quote_cache.hpp"
+#include "../include/wait_strategy.hpp"
+#include <cstring>
+
+namespace hft {
+
+namespace {
+
+uint64_t toBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double fromBits(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+QuoteCache::QuoteCache() : entries_(SymbolRegistry::MAX_SYMBOLS + 1) {
+}
+
+void QuoteCache::update(SymbolId symbol_id, double bid, double ask,
+                        uint32_t bid_size, uint32_t ask_size, uint64_t timestamp) {
+    if (symbol_id == INVALID_SYMBOL_ID || symbol_id >= entries_.size()) return;
+    
+    Entry& entry = entries_[symbol_id];
+    
+    // Claim the entry by making the sequence odd; only other writers wait here
+    uint64_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    while ((sequence & 1) || !entry.sequence.compare_exchange_weak(sequence, sequence + 1,
+                                                                    std::memory_order_acquire,
+                                                                    std::memory_order_relaxed)) {
+        cpuRelax();
+        sequence = entry.sequence.load(std::memory_order_relaxed);
+    }
+    // Keeps the field stores below after the odd sequence; pairs with the reader's acquire fence
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    entry.bid.store(toBits(bid), std::memory_order_relaxed);
+    entry.ask.store(toBits(ask), std::memory_order_relaxed);
+    entry.sizes.store((static_cast<uint64_t>(bid_size) << 32) | ask_size, std::memory_order_relaxed);
+    entry.timestamp.store(timestamp, std::memory_order_relaxed);
+    
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool QuoteCache::read(SymbolId symbol_id, TopOfBook& quote) const {
+    if (symbol_id == INVALID_SYMBOL_ID || symbol_id >= entries_.size()) return false;
+    
+    const Entry& entry = entries_[symbol_id];
+    uint64_t before;
+    uint64_t after;
+    do {
+        before = entry.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            cpuRelax();
+            continue;
+        }
+        
+        quote.bid = fromBits(entry.bid.load(std::memory_order_relaxed));
+        quote.ask = fromBits(entry.ask.load(std::memory_order_relaxed));
+        uint64_t sizes = entry.sizes.load(std::memory_order_relaxed);
+        quote.bid_size = static_cast<uint32_t>(sizes >> 32);
+        quote.ask_size = static_cast<uint32_t>(sizes);
+        quote.timestamp = entry.timestamp.load(std::memory_order_relaxed);
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = entry.sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    
+    quote.sequence = before / 2;
+    return before != 0;
+}
+
+} // namespace hft
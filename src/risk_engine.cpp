@@ -0,0 +1,202 @@
+#include "../include/risk_engine.hpp"
+#include "../include/message.hpp"
+#include <cmath>
+#include <iostream>
+
+namespace hft {
+
+constexpr size_t RiskEngine::MAX_ACCOUNTS;
+
+const char* riskResultName(RiskResult result) {
+    switch (result) {
+        case RiskResult::OK: return "ok";
+        case RiskResult::UNKNOWN_SYMBOL: return "unknown symbol";
+        case RiskResult::ORDER_SIZE: return "order size limit";
+        case RiskResult::FAT_FINGER: return "order notional limit";
+        case RiskResult::PRICE_COLLAR: return "outside price collar";
+        case RiskResult::POSITION_LIMIT: return "position limit";
+        case RiskResult::NOTIONAL_LIMIT: return "open notional limit";
+        case RiskResult::ACCOUNT_TABLE_FULL: return "account table full";
+    }
+    return "unknown";
+}
+
+RiskEngine::RiskEngine()
+    : symbols_(SymbolRegistry::MAX_SYMBOLS + 1),
+      accounts_(MAX_ACCOUNTS + 1),
+      index_(MAX_ACCOUNTS * 2) {
+}
+
+void RiskEngine::setDefaultSymbolLimits(const SymbolRiskLimits& limits) {
+    for (auto& symbol : symbols_) {
+        symbol.limits = limits;
+    }
+}
+
+void RiskEngine::setSymbolLimits(SymbolId symbol_id, const SymbolRiskLimits& limits) {
+    if (symbol_id == INVALID_SYMBOL_ID || symbol_id >= symbols_.size()) return;
+    symbols_[symbol_id].limits = limits;
+}
+
+bool RiskEngine::setAccountLimits(uint64_t client_id, const AccountRiskLimits& limits) {
+    Account* account = getAccount(client_id);
+    if (!account) return false;
+    account->limits = limits;
+    return true;
+}
+
+size_t RiskEngine::slotFor(uint64_t client_id) const {
+    uint64_t hash = client_id * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash ^ (hash >> 32)) & (index_.size() - 1);
+}
+
+RiskEngine::Account* RiskEngine::findAccount(uint64_t client_id) const {
+    size_t slot = slotFor(client_id);
+    while (true) {
+        uint32_t account = index_[slot].account.load(std::memory_order_acquire);
+        if (account == 0) return nullptr;
+        if (index_[slot].client_id.load(std::memory_order_relaxed) == client_id) {
+            return const_cast<Account*>(&accounts_[account]);
+        }
+        slot = (slot + 1) & (index_.size() - 1);
+    }
+}
+
+RiskEngine::Account* RiskEngine::getAccount(uint64_t client_id) {
+    Account* account = findAccount(client_id);
+    if (account) return account;
+    
+    // First order from this account; registration is the only locked path
+    std::lock_guard<std::mutex> lock(accounts_mutex_);
+    account = findAccount(client_id);
+    if (account) return account;
+    
+    size_t count = account_count_.load(std::memory_order_relaxed);
+    if (count >= MAX_ACCOUNTS) {
+        std::cerr << "[RiskEngine] Account table full, rejecting client " << client_id << std::endl;
+        return nullptr;
+    }
+    
+    uint32_t index = static_cast<uint32_t>(count + 1);
+    Account& created = accounts_[index];
+    created.client_id = client_id;
+    created.limits = default_account_limits_;
+    created.positions.reset(new PositionState[SymbolRegistry::MAX_SYMBOLS + 1]);
+    
+    size_t slot = slotFor(client_id);
+    while (index_[slot].account.load(std::memory_order_relaxed) != 0) {
+        slot = (slot + 1) & (index_.size() - 1);
+    }
+    index_[slot].client_id.store(client_id, std::memory_order_relaxed);
+    index_[slot].account.store(index, std::memory_order_release);
+    account_count_.store(count + 1, std::memory_order_relaxed);
+    return &created;
+}
+
+RiskResult RiskEngine::checkOrder(const OrderMessage& order) {
+    if (order.getType() != MessageType::ORDER_NEW && order.getType() != MessageType::ORDER_REPLACE) {
+        return RiskResult::OK;
+    }
+    
+    SymbolId symbol_id = order.getSymbolId();
+    if (symbol_id == INVALID_SYMBOL_ID || symbol_id >= symbols_.size()) {
+        return RiskResult::UNKNOWN_SYMBOL;
+    }
+    
+    // Static per-order checks first; they touch no shared writable state
+    const SymbolState& symbol = symbols_[symbol_id];
+    double price = order.getPrice();
+    uint32_t quantity = order.getQuantity();
+    
+    if (quantity > symbol.limits.max_order_quantity) {
+        return RiskResult::ORDER_SIZE;
+    }
+    if (price * quantity > symbol.limits.max_order_notional) {
+        return RiskResult::FAT_FINGER;
+    }
+    
+    double reference = symbol.reference_price.load(std::memory_order_relaxed);
+    if (reference > 0.0 && symbol.limits.price_collar > 0.0 &&
+        std::fabs(price - reference) > reference * symbol.limits.price_collar) {
+        return RiskResult::PRICE_COLLAR;
+    }
+    
+    Account* account = getAccount(order.getClientId());
+    if (!account) {
+        return RiskResult::ACCOUNT_TABLE_FULL;
+    }
+    
+    // Reserve, then verify; roll back on breach
+    int64_t notional = toCents(price) * quantity;
+    int64_t max_notional = toCents(account->limits.max_open_notional);
+    if (account->open_notional_cents.fetch_add(notional, std::memory_order_relaxed) + notional > max_notional) {
+        account->open_notional_cents.fetch_sub(notional, std::memory_order_relaxed);
+        return RiskResult::NOTIONAL_LIMIT;
+    }
+    
+    PositionState& state = account->positions[symbol_id];
+    int64_t max_position = account->limits.max_position;
+    if (order.isBuy()) {
+        int64_t open = state.open_buy.fetch_add(quantity, std::memory_order_relaxed) + quantity;
+        if (state.position.load(std::memory_order_relaxed) + open > max_position) {
+            state.open_buy.fetch_sub(quantity, std::memory_order_relaxed);
+            account->open_notional_cents.fetch_sub(notional, std::memory_order_relaxed);
+            return RiskResult::POSITION_LIMIT;
+        }
+    } else {
+        int64_t open = state.open_sell.fetch_add(quantity, std::memory_order_relaxed) + quantity;
+        if (state.position.load(std::memory_order_relaxed) - open < -max_position) {
+            state.open_sell.fetch_sub(quantity, std::memory_order_relaxed);
+            account->open_notional_cents.fetch_sub(notional, std::memory_order_relaxed);
+            return RiskResult::POSITION_LIMIT;
+        }
+    }
+    
+    return RiskResult::OK;
+}
+
+void RiskEngine::release(uint64_t client_id, SymbolId symbol_id, bool is_buy, double limit_price, uint32_t quantity) {
+    if (quantity == 0 || symbol_id == INVALID_SYMBOL_ID || symbol_id >= symbols_.size()) return;
+    
+    Account* account = findAccount(client_id);
+    if (!account) return;
+    
+    PositionState& state = account->positions[symbol_id];
+    (is_buy ? state.open_buy : state.open_sell).fetch_sub(quantity, std::memory_order_relaxed);
+    account->open_notional_cents.fetch_sub(toCents(limit_price) * quantity, std::memory_order_relaxed);
+}
+
+void RiskEngine::onFill(uint64_t client_id, SymbolId symbol_id, bool is_buy, double limit_price, uint32_t quantity) {
+    if (quantity == 0 || symbol_id == INVALID_SYMBOL_ID || symbol_id >= symbols_.size()) return;
+    
+    Account* account = findAccount(client_id);
+    if (!account) return;
+    
+    // Move the quantity from open to filled before dropping the reservation
+    // so concurrent checks never see less exposure than there is
+    PositionState& state = account->positions[symbol_id];
+    int64_t signed_quantity = is_buy ? static_cast<int64_t>(quantity) : -static_cast<int64_t>(quantity);
+    state.position.fetch_add(signed_quantity, std::memory_order_relaxed);
+    release(client_id, symbol_id, is_buy, limit_price, quantity);
+}
+
+void RiskEngine::onMarketData(SymbolId symbol_id, double bid, double ask) {
+    if (symbol_id == INVALID_SYMBOL_ID || symbol_id >= symbols_.size()) return;
+    if (bid <= 0.0 || ask <= 0.0) return;
+    
+    symbols_[symbol_id].reference_price.store((bid + ask) * 0.5, std::memory_order_relaxed);
+}
+
+int64_t RiskEngine::getPosition(uint64_t client_id, SymbolId symbol_id) const {
+    if (symbol_id == INVALID_SYMBOL_ID || symbol_id >= symbols_.size()) return 0;
+    
+    Account* account = findAccount(client_id);
+    return account ? account->positions[symbol_id].position.load(std::memory_order_relaxed) : 0;
+}
+
+double RiskEngine::getOpenNotional(uint64_t client_id) const {
+    Account* account = findAccount(client_id);
+    return account ? account->open_notional_cents.load(std::memory_order_relaxed) / 100.0 : 0.0;
+}
+
+} // namespace hft
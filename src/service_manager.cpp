@@ -1,12 +1,32 @@
 #include "../include/service_manager.hpp"
 #include "../include/message.hpp"
+#include "../include/cpu_topology.hpp"
+#include "../include/async_logger.hpp"
+#include "../include/tsc_clock.hpp"
+#include "../include/pipeline_trace.hpp"
 #include <iostream>
 #include <algorithm>
-#include <chrono>
 
 namespace hft {
 
+namespace {
+
+const LogSite LOG_MATCHING_LATENCY = {LogLevel::WARN, "OrderMatching", "High latency detected: {} microseconds (order {})"};
+const LogSite LOG_MARKET_DATA_LATENCY = {LogLevel::WARN, "MarketData", "High latency detected: {} microseconds"};
+
+} // namespace
+
 // ServiceManager implementation
+constexpr size_t ServiceHandle::INVALID_INDEX;
+constexpr size_t ServiceManager::MAX_SERVICES;
+constexpr size_t ServiceManager::SERVICE_QUEUE_CAPACITY;
+constexpr size_t ServiceManager::MAX_BATCH;
+constexpr size_t ServiceManager::MESSAGE_TYPE_SLOTS;
+
+ServiceManager::ServiceManager()
+    : slots_(MAX_SERVICES) {
+}
+
 ServiceManager::~ServiceManager() {
     stopAllServices();
     if (message_processor_thread_.joinable()) {
@@ -18,19 +38,55 @@ void ServiceManager::registerService(std::shared_ptr<IService> service) {
     if (!service) return;
     
     std::lock_guard<std::mutex> lock(services_mutex_);
-    services_[service->getName()] = service;
+    
+    auto it = service_index_.find(service->getName());
+    if (it != service_index_.end()) {
+        std::cerr << "[ServiceManager] Service already registered: " << service->getName() << std::endl;
+        return;
+    }
+    
+    size_t index = slot_count_.load(std::memory_order_relaxed);
+    if (index >= MAX_SERVICES) {
+        std::cerr << "[ServiceManager] Service table full, cannot register: " << service->getName() << std::endl;
+        return;
+    }
+    
+    ServiceSlot& slot = slots_[index];
+    slot.service = service;
+    slot.queue.reset(new MpscQueue<MessageHandle>(SERVICE_QUEUE_CAPACITY));
+    slot.active = true;
+    
+    ServiceHandle handle;
+    handle.index = index;
+    service_index_[service->getName()] = handle;
+    
+    // Publish the slot to lock-free readers
+    slot_count_.store(index + 1, std::memory_order_release);
+    
+    // Each route gains at most one entry per slot, so it cannot overflow
+    for (MessageType type : service->getSubscriptions()) {
+        size_t type_index = static_cast<size_t>(type);
+        if (type_index >= MESSAGE_TYPE_SLOTS) continue;
+        Route& route = routes_[type_index];
+        size_t count = route.count.load(std::memory_order_relaxed);
+        if (std::find(route.subscribers, route.subscribers + count, &slot) != route.subscribers + count) continue;
+        route.subscribers[count] = &slot;
+        route.count.store(count + 1, std::memory_order_release);
+    }
     
     std::cout << "[ServiceManager] Registered service: " << service->getName() << std::endl;
 }
 
 void ServiceManager::unregisterService(const std::string& service_name) {
     std::lock_guard<std::mutex> lock(services_mutex_);
-    auto it = services_.find(service_name);
-    if (it != services_.end()) {
-        if (it->second->isRunning()) {
-            it->second->stop();
+    auto it = service_index_.find(service_name);
+    if (it != service_index_.end()) {
+        ServiceSlot& slot = slots_[it->second.index];
+        slot.active = false;
+        if (slot.service->isRunning()) {
+            slot.service->stop();
         }
-        services_.erase(it);
+        service_index_.erase(it);
         std::cout << "[ServiceManager] Unregistered service: " << service_name << std::endl;
     }
 }
@@ -38,10 +94,11 @@ void ServiceManager::unregisterService(const std::string& service_name) {
 void ServiceManager::startAllServices() {
     std::lock_guard<std::mutex> lock(services_mutex_);
     
-    for (auto& service_pair : services_) {
-        if (!service_pair.second->isRunning()) {
-            service_pair.second->start();
-            std::cout << "[ServiceManager] Started service: " << service_pair.first << std::endl;
+    for (auto& entry : service_index_) {
+        auto& service = slots_[entry.second.index].service;
+        if (!service->isRunning()) {
+            service->start();
+            std::cout << "[ServiceManager] Started service: " << entry.first << std::endl;
         }
     }
     
@@ -57,92 +114,182 @@ void ServiceManager::stopAllServices() {
     running_ = false;
     
     std::lock_guard<std::mutex> lock(services_mutex_);
-    for (auto& service_pair : services_) {
-        if (service_pair.second->isRunning()) {
-            service_pair.second->stop();
-            std::cout << "[ServiceManager] Stopped service: " << service_pair.first << std::endl;
+    for (auto& entry : service_index_) {
+        auto& service = slots_[entry.second.index].service;
+        if (service->isRunning()) {
+            service->stop();
+            std::cout << "[ServiceManager] Stopped service: " << entry.first << std::endl;
         }
     }
 }
 
-void ServiceManager::sendMessage(const std::string& service_name, std::shared_ptr<Message> message) {
-    if (!message) return;
+void ServiceManager::setWaitStrategy(WaitStrategyType processor, WaitStrategyType services) {
+    std::lock_guard<std::mutex> lock(services_mutex_);
+    processor_wait_ = processor;
+    for (auto& entry : service_index_) {
+        slots_[entry.second.index].service->setWaitStrategy(services);
+    }
+}
+
+ServiceHandle ServiceManager::resolveService(const std::string& service_name) const {
+    std::lock_guard<std::mutex> lock(services_mutex_);
+    auto it = service_index_.find(service_name);
+    return (it != service_index_.end()) ? it->second : ServiceHandle();
+}
+
+bool ServiceManager::sendMessage(ServiceHandle handle, MessageHandle message) {
+    if (!message || !handle.valid()) return false;
+    if (handle.index >= slot_count_.load(std::memory_order_acquire)) return false;
     
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    message_queue_.emplace(service_name, message);
-    queue_cv_.notify_one();
+    ServiceSlot& slot = slots_[handle.index];
+    if (!slot.active.load(std::memory_order_relaxed)) return false;
+    
+    if (!slot.queue->tryPush(std::move(message))) return false;
+    
+    queue_notifier_.notify();
+    return true;
 }
 
-void ServiceManager::broadcastMessage(std::shared_ptr<Message> message) {
-    if (!message) return;
+bool ServiceManager::sendMessage(const std::string& service_name, MessageHandle message) {
+    return sendMessage(resolveService(service_name), std::move(message));
+}
+
+bool ServiceManager::publish(const Message& message) {
+    size_t type_index = static_cast<size_t>(message.getType());
+    if (type_index >= MESSAGE_TYPE_SLOTS) return false;
     
-    std::lock_guard<std::mutex> lock(services_mutex_);
-    for (auto& service_pair : services_) {
-        if (service_pair.second->isRunning()) {
-            service_pair.second->processMessage(message);
+    // Unregistered slots keep their service, so a stale entry is safe to skip
+    const Route& route = routes_[type_index];
+    size_t count = route.count.load(std::memory_order_acquire);
+    size_t delivered = 0;
+    bool dropped = false;
+    for (size_t i = 0; i < count; ++i) {
+        ServiceSlot& slot = *route.subscribers[i];
+        if (slot.active.load(std::memory_order_relaxed) && slot.service->isRunning()) {
+            uint64_t start_ticks = TscClock::now();
+            dropped |= !slot.service->processMessage(message);
+            slot.latency.record(TscClock::toNanos(TscClock::now() - start_ticks));
+            ++delivered;
         }
     }
+    return delivered > 0 && !dropped;
 }
 
 std::shared_ptr<IService> ServiceManager::getService(const std::string& service_name) {
     std::lock_guard<std::mutex> lock(services_mutex_);
-    auto it = services_.find(service_name);
-    return (it != services_.end()) ? it->second : nullptr;
+    auto it = service_index_.find(service_name);
+    return (it != service_index_.end()) ? slots_[it->second.index].service : nullptr;
 }
 
 size_t ServiceManager::getActiveServiceCount() const {
     std::lock_guard<std::mutex> lock(services_mutex_);
     size_t count = 0;
-    for (const auto& service_pair : services_) {
-        if (service_pair.second->isRunning()) count++;
+    for (const auto& entry : service_index_) {
+        if (slots_[entry.second.index].service->isRunning()) count++;
     }
     return count;
 }
 
 double ServiceManager::getAverageLatency() const {
-    // This would be implemented with actual latency tracking
-    // For now, return a placeholder value
-    return 5.0; // 5 microseconds average
+    std::lock_guard<std::mutex> lock(services_mutex_);
+    LatencyHistogram merged;
+    LatencyHistogram snapshot;
+    for (const auto& entry : service_index_) {
+        const ServiceSlot& slot = slots_[entry.second.index];
+        if (!slot.service->isRunning()) continue;
+        slot.latency.snapshot(snapshot);
+        merged.merge(snapshot);
+    }
+    return merged.mean() / 1000.0;
 }
 
-void ServiceManager::messageProcessorLoop() {
-    while (running_) {
-        processMessageQueue();
-        std::this_thread::sleep_for(std::chrono::microseconds(1)); // 1 microsecond sleep for low latency
+bool ServiceManager::getServiceLatencySnapshot(const std::string& service_name, LatencyHistogram& out) const {
+    std::lock_guard<std::mutex> lock(services_mutex_);
+    auto it = service_index_.find(service_name);
+    if (it == service_index_.end()) {
+        out.reset();
+        return false;
     }
+    slots_[it->second.index].latency.snapshot(out);
+    return true;
 }
 
-void ServiceManager::processMessageQueue() {
-    std::unique_lock<std::mutex> lock(queue_mutex_);
-    
-    if (message_queue_.empty()) {
-        queue_cv_.wait_for(lock, std::chrono::microseconds(10)); // 10 microseconds timeout
-        return;
+std::vector<std::string> ServiceManager::getServiceNames() const {
+    std::lock_guard<std::mutex> lock(services_mutex_);
+    std::vector<std::string> names;
+    for (size_t i = 0; i < slot_count_.load(std::memory_order_acquire); ++i) {
+        if (slots_[i].active.load(std::memory_order_relaxed)) {
+            names.push_back(slots_[i].service->getName());
+        }
     }
+    return names;
+}
+
+void ServiceManager::messageProcessorLoop() {
+    ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::PROCESSOR);
+    WaitStrategy wait(processor_wait_, &queue_notifier_);
+    auto pending = [this]() {
+        size_t slot_count = slot_count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < slot_count; ++i) {
+            if (!slots_[i].queue->empty()) return true;
+        }
+        return false;
+    };
     
-    // Process up to 100 messages per batch for efficiency
+    while (running_) {
+        if (processMessageQueue() == 0) {
+            wait.idle(pending);
+        } else {
+            wait.reset();
+        }
+    }
+}
+
+size_t ServiceManager::processMessageQueue() {
     size_t processed = 0;
-    const size_t max_batch = 100;
+    size_t slot_count = slot_count_.load(std::memory_order_acquire);
     
-    while (!message_queue_.empty() && processed < max_batch) {
-        auto service_name = message_queue_.front().first;
-        auto message = message_queue_.front().second;
-        message_queue_.pop();
-        lock.unlock();
+    // Drain up to MAX_BATCH messages per service; no locks or name lookups
+    for (size_t i = 0; i < slot_count; ++i) {
+        ServiceSlot& slot = slots_[i];
+        IService* service = slot.service.get();
+        bool deliver = slot.active.load(std::memory_order_relaxed) && service->isRunning();
+        ConcurrentHistogram& latency = slot.latency;
         
-        auto service = getService(service_name);
-        if (service && service->isRunning()) {
-            service->processMessage(message);
-        }
-        
-        processed++;
-        lock.lock();
+        // Taking the handle by value recycles the message as soon as it is delivered
+        processed += slot.queue->popBatch([service, deliver, &latency](MessageHandle message) {
+            if (deliver) {
+                uint64_t start_ticks = TscClock::now();
+                service->processMessage(*message);
+                latency.record(TscClock::toNanos(TscClock::now() - start_ticks));
+            }
+        }, MAX_BATCH);
     }
+    
+    return processed;
 }
 
 // OrderMatchingService implementation
-OrderMatchingService::OrderMatchingService() {
-    // Initialize order book and matching engine
+constexpr size_t OrderMatchingService::PRODUCER_QUEUE_CAPACITY;
+constexpr size_t OrderMatchingService::MAX_BATCH;
+constexpr size_t MarketDataService::MAX_SUBSCRIBERS;
+constexpr MarketDataService::SubscriberId MarketDataService::INVALID_SUBSCRIBER;
+constexpr size_t MarketDataService::MAX_BATCH;
+
+OrderMatchingService::Shard::Shard()
+    : inbound(PRODUCER_QUEUE_CAPACITY), books(SymbolRegistry::MAX_SYMBOLS + 1), fill_message(new OrderMessage()) {
+    fill_message->setType(MessageType::ORDER_FILL);
+}
+
+OrderMatchingService::Shard::~Shard() {}
+
+OrderMatchingService::OrderMatchingService(size_t shard_count) {
+    if (shard_count == 0) shard_count = 1;
+    for (size_t i = 0; i < shard_count; ++i) {
+        std::unique_ptr<Shard> shard(new Shard());
+        shard->index = i;
+        shards_.push_back(std::move(shard));
+    }
 }
 
 OrderMatchingService::~OrderMatchingService() {
@@ -153,16 +300,21 @@ void OrderMatchingService::start() {
     if (running_.load()) return;
     
     running_ = true;
-    worker_thread_ = std::thread(&OrderMatchingService::workerLoop, this);
-    std::cout << "[OrderMatching] Service started" << std::endl;
+    for (auto& shard : shards_) {
+        shard->thread = std::thread(&OrderMatchingService::workerLoop, this, shard.get());
+    }
+    std::cout << "[OrderMatching] Service started with " << shards_.size() << " shard(s)" << std::endl;
 }
 
 void OrderMatchingService::stop() {
     if (!running_.load()) return;
     
     running_ = false;
-    if (worker_thread_.joinable()) {
-        worker_thread_.join();
+    for (auto& shard : shards_) {
+        shard->notifier.notify();
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
     }
     std::cout << "[OrderMatching] Service stopped" << std::endl;
 }
@@ -171,55 +323,193 @@ bool OrderMatchingService::isRunning() const {
     return running_.load();
 }
 
-void OrderMatchingService::processMessage(std::shared_ptr<Message> message) {
-    if (!message || !running_.load()) return;
+bool OrderMatchingService::processMessage(const Message& message) {
+    if (!running_.load()) return false;
     
-    // Process order messages with ultra-low latency
-    auto start_time = std::chrono::high_resolution_clock::now();
+    switch (message.getType()) {
+        case MessageType::ORDER_NEW:
+        case MessageType::ORDER_CANCEL:
+        case MessageType::ORDER_REPLACE: {
+            // Order types are always OrderMessages. Copied by value into the
+            // ring; the caller's message goes back to its pool
+            const OrderMessage& order_msg = static_cast<const OrderMessage&>(message);
+            Shard& shard = *shards_[shardFor(order_msg.getSymbolId())];
+            if (!shard.inbound.producer()->tryPush(order_msg)) {
+                reject_count_.fetch_add(1, std::memory_order_relaxed);
+                releaseOrder(order_msg, order_msg.getQuantity());
+                return false;
+            }
+            shard.notifier.notify();
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+void OrderMatchingService::workerLoop(Shard* shard) {
+    ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::MATCHING, shard->index);
+    WaitStrategy wait(wait_strategy_, &shard->notifier);
+    
+    auto handle = [this, shard](OrderMessage&& order) {
+        // Process order messages with ultra-low latency
+        uint64_t start_ticks = TscClock::now();
+        handleOrder(*shard, order);
+        uint64_t end_ticks = TscClock::nowOrdered();
+        uint64_t latency = TscClock::toNanos(end_ticks - start_ticks);
+        
+        // Accepted orders finish their trace here rather than on the reactor
+        PipelineTrace& trace = order.trace();
+        trace.mark(TraceStage::DEQUEUE, start_ticks);
+        trace.mark(TraceStage::MATCH, end_ticks);
+        PipelineTracer::getInstance().record(trace, order.getSequenceNumber(), order.getClientId(),
+                                             static_cast<uint8_t>(order.getType()));
+        
+        // Track performance - should be under 10 microseconds
+        if (latency > 10000) { // 10 microseconds in nanoseconds
+            AsyncLogger::getInstance().log(LOG_MATCHING_LATENCY, latency / 1000.0, order.getOrderId());
+        }
+    };
+    
+    // Up to MAX_BATCH from each producer per pass, so one busy reactor
+    // cannot starve the others
+    auto drain = [shard, &handle]() { return shard->inbound.drain(handle, MAX_BATCH); };
+    auto pending = [shard]() { return shard->inbound.pending(); };
+    
+    while (running_.load()) {
+        if (drain() == 0) {
+            wait.idle(pending);
+        } else {
+            wait.reset();
+        }
+    }
     
-    switch (message->getType()) {
+    // Orders already acked as accepted still get matched
+    while (drain() > 0) {
+    }
+}
+
+void OrderMatchingService::handleOrder(Shard& shard, const OrderMessage& order) {
+    BookResult result = BookResult::UNKNOWN_ORDER_ID;
+    shard.taker_price = order.getPrice();
+    shard.taker_filled = 0;
+    
+    switch (order.getType()) {
         case MessageType::ORDER_NEW: {
-            auto order_msg = std::dynamic_pointer_cast<OrderMessage>(message);
-            if (order_msg) {
-                // Process new order
-                // In a real implementation, this would add to order book and attempt matching
+            OrderBook* book = getBook(shard, order.getSymbolId(), order.getPrice());
+            if (book) {
+                result = book->addOrder(order.getOrderId(), order.getClientId(), order.isBuy(),
+                                        order.getPrice(), order.getQuantity());
+            }
+            if (result != BookResult::OK) {
+                releaseOrder(order, order.getQuantity() - shard.taker_filled);
             }
             break;
         }
         case MessageType::ORDER_CANCEL: {
-            // Process order cancellation
+            OrderBook* book = findBook(shard, order.getSymbolId());
+            RestingOrder resting;
+            if (book && book->findOrder(order.getOrderId(), resting)) {
+                result = book->cancelOrder(order.getOrderId());
+                if (result == BookResult::OK) {
+                    releaseResting(resting, order.getSymbolId());
+                }
+            }
             break;
         }
         case MessageType::ORDER_REPLACE: {
-            // Process order replacement
+            // The new terms were reserved up front; whichever side of the
+            // replace does not survive gets its reservation back
+            OrderBook* book = findBook(shard, order.getSymbolId());
+            RestingOrder resting;
+            if (book && book->findOrder(order.getOrderId(), resting) &&
+                resting.client_id == order.getClientId() && resting.is_buy == order.isBuy()) {
+                result = book->replaceOrder(order.getOrderId(), order.getPrice(), order.getQuantity());
+                RestingOrder current;
+                if (result == BookResult::OK || !book->findOrder(order.getOrderId(), current)) {
+                    releaseResting(resting, order.getSymbolId());
+                }
+            }
+            if (result != BookResult::OK) {
+                releaseOrder(order, order.getQuantity() - shard.taker_filled);
+            }
             break;
         }
         default:
+            result = BookResult::OK;
             break;
     }
     
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+    if (result != BookResult::OK) {
+        reject_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void OrderMatchingService::releaseOrder(const OrderMessage& order, uint32_t quantity) {
+    if (!risk_engine_ || order.getType() == MessageType::ORDER_CANCEL) return;
+    risk_engine_->release(order.getClientId(), order.getSymbolId(), order.isBuy(), order.getPrice(), quantity);
+}
+
+void OrderMatchingService::releaseResting(const RestingOrder& order, SymbolId symbol_id) {
+    if (!risk_engine_) return;
+    risk_engine_->release(order.client_id, symbol_id, order.is_buy, order.price, order.quantity);
+}
+
+OrderBook* OrderMatchingService::findBook(Shard& shard, SymbolId symbol_id) const {
+    if (symbol_id == INVALID_SYMBOL_ID || symbol_id >= shard.books.size()) return nullptr;
+    return shard.books[symbol_id].get();
+}
+
+OrderBook* OrderMatchingService::getBook(Shard& shard, SymbolId symbol_id, double reference_price) {
+    if (symbol_id == INVALID_SYMBOL_ID || symbol_id >= shard.books.size()) return nullptr;
     
-    // Track performance - should be under 10 microseconds
-    if (latency > 10000) { // 10 microseconds in nanoseconds
-        std::cout << "[OrderMatching] Warning: High latency detected: " 
-                  << (latency / 1000.0) << " microseconds" << std::endl;
+    std::unique_ptr<OrderBook>& slot = shard.books[symbol_id];
+    if (!slot) {
+        // First order for a symbol centres its price window; this is the only allocation
+        slot.reset(new OrderBook(reference_price));
+        slot->setExecutionCallback([this, &shard, symbol_id](const Execution& execution) {
+            onExecution(shard, symbol_id, execution);
+        });
     }
+    return slot.get();
 }
 
-void OrderMatchingService::workerLoop() {
-    while (running_.load()) {
-        // Process pending orders and perform matching
-        // This would implement the actual matching engine logic
-        
-        std::this_thread::sleep_for(std::chrono::microseconds(1)); // 1 microsecond sleep
+void OrderMatchingService::onExecution(Shard& shard, SymbolId symbol_id, const Execution& execution) {
+    shard.taker_filled += execution.quantity;
+    if (risk_engine_) {
+        // Makers rest at their limit, so the trade price is what they reserved at
+        risk_engine_->onFill(execution.taker_client_id, symbol_id, execution.taker_is_buy,
+                             shard.taker_price, execution.quantity);
+        risk_engine_->onFill(execution.maker_client_id, symbol_id, !execution.taker_is_buy,
+                             execution.price, execution.quantity);
     }
+    
+    emitFill(shard, symbol_id, execution.taker_order_id, execution.taker_client_id,
+             execution.taker_is_buy, execution.price, execution.quantity);
+    emitFill(shard, symbol_id, execution.maker_order_id, execution.maker_client_id,
+             !execution.taker_is_buy, execution.price, execution.quantity);
+}
+
+void OrderMatchingService::emitFill(Shard& shard, SymbolId symbol_id, uint64_t order_id, uint64_t client_id,
+                                    bool is_buy, double price, uint32_t quantity) {
+    fill_count_.fetch_add(1, std::memory_order_relaxed);
+    if (!fill_callback_) return;
+    
+    // Shards number fills in interleaved ranges so sequence numbers stay unique
+    OrderMessage& fill = *shard.fill_message;
+    fill.setSequenceNumber(++shard.fill_sequence * shards_.size() + shard.index);
+    fill.setTimestamp(TscClock::wallNanos() / 1000);
+    fill.setClientId(client_id);
+    fill.setOrderId(order_id);
+    fill.setSymbolId(symbol_id);
+    fill.setPrice(price);
+    fill.setQuantity(quantity);
+    fill.setBuy(is_buy);
+    fill_callback_(fill);
 }
 
 // MarketDataService implementation
-MarketDataService::MarketDataService() {
-    // Initialize market data structures
+MarketDataService::MarketDataService() : subscribers_(new Subscriber[MAX_SUBSCRIBERS]) {
 }
 
 MarketDataService::~MarketDataService() {
@@ -248,34 +538,185 @@ bool MarketDataService::isRunning() const {
     return running_.load();
 }
 
-void MarketDataService::processMessage(std::shared_ptr<Message> message) {
-    if (!message || !running_.load()) return;
+bool MarketDataService::processMessage(const Message& message) {
+    if (!running_.load()) return false;
+    if (message.getType() != MessageType::MARKET_DATA) return true;
+    
+    // Only MarketDataMessages carry this type
+    const MarketDataMessage* md_msg = static_cast<const MarketDataMessage*>(&message);
+    updateQuote(md_msg->getSymbolId(), md_msg->getBid(), md_msg->getAsk(),
+                md_msg->getBidSize(), md_msg->getAskSize(), md_msg->getTimestamp());
+    return true;
+}
+
+void MarketDataService::processQuote(const MarketDataView& quote) {
+    if (!running_.load()) return;
     
-    auto start_time = std::chrono::high_resolution_clock::now();
+    updateQuote(quote.resolveSymbolId(), quote.getBid(), quote.getAsk(),
+                quote.getBidSize(), quote.getAskSize(), quote.getTimestamp());
+}
+
+void MarketDataService::updateQuote(SymbolId symbol_id, double bid, double ask,
+                                    uint32_t bid_size, uint32_t ask_size, uint64_t timestamp) {
+    uint64_t start_ticks = TscClock::now();
     
-    if (message->getType() == MessageType::MARKET_DATA) {
-        auto md_msg = std::dynamic_pointer_cast<MarketDataMessage>(message);
-        if (md_msg) {
-            // Process market data update
-            // This would update internal market data structures
+    cache_.update(symbol_id, bid, ask, bid_size, ask_size, timestamp);
+    
+    // Mark the symbol pending for each subscriber; one already
+    // pending will pick up this quote instead of the one it missed
+    bool queued = false;
+    size_t count = subscriber_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count && symbol_id <= SymbolRegistry::MAX_SYMBOLS; ++i) {
+        Subscriber& subscriber = subscribers_[i];
+        if (subscriber.state.load(std::memory_order_acquire) != SUBSCRIBER_ACTIVE) continue;
+        
+        std::atomic<uint8_t>& flags = subscriber.symbols[symbol_id];
+        if (!(flags.load(std::memory_order_relaxed) & SYMBOL_SUBSCRIBED)) continue;
+        
+        if (flags.fetch_or(SYMBOL_PENDING, std::memory_order_acq_rel) & SYMBOL_PENDING) {
+            conflated_count_.fetch_add(1, std::memory_order_relaxed);
+        } else if (subscriber.pending->tryPush(symbol_id)) {
+            queued = true;
+        } else {
+            flags.fetch_and(static_cast<uint8_t>(~SYMBOL_PENDING), std::memory_order_relaxed);
         }
     }
+    if (queued) {
+        notifier_.notify();
+    }
     
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+    uint64_t latency = TscClock::toNanos(TscClock::nowOrdered() - start_ticks);
     
     if (latency > 10000) {
-        std::cout << "[MarketData] Warning: High latency detected: " 
-                  << (latency / 1000.0) << " microseconds" << std::endl;
+        AsyncLogger::getInstance().log(LOG_MARKET_DATA_LATENCY, latency / 1000.0);
     }
 }
 
+MarketDataService::SubscriberId MarketDataService::subscribe(QuoteSink sink, const std::vector<SymbolId>& symbols) {
+    if (!sink) return INVALID_SUBSCRIBER;
+    
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
+    size_t count = subscriber_count_.load(std::memory_order_relaxed);
+    size_t index = 0;
+    while (index < count && subscribers_[index].state.load(std::memory_order_acquire) != SUBSCRIBER_FREE) {
+        ++index;
+    }
+    if (index == MAX_SUBSCRIBERS) {
+        std::cerr << "[MarketData] Subscriber table full" << std::endl;
+        return INVALID_SUBSCRIBER;
+    }
+    
+    Subscriber& subscriber = subscribers_[index];
+    const size_t symbol_slots = SymbolRegistry::MAX_SYMBOLS + 1;
+    if (!subscriber.symbols) {
+        subscriber.symbols.reset(new std::atomic<uint8_t>[symbol_slots]);
+        subscriber.pending.reset(new MpscQueue<SymbolId>(symbol_slots * 2));
+    }
+    
+    uint8_t all = symbols.empty() ? SYMBOL_SUBSCRIBED : 0;
+    for (size_t i = 0; i < symbol_slots; ++i) {
+        subscriber.symbols[i].store(all, std::memory_order_relaxed);
+    }
+    for (SymbolId symbol_id : symbols) {
+        if (symbol_id != INVALID_SYMBOL_ID && symbol_id < symbol_slots) {
+            subscriber.symbols[symbol_id].store(SYMBOL_SUBSCRIBED, std::memory_order_relaxed);
+        }
+    }
+    subscriber.sink = std::move(sink);
+    subscriber.state.store(SUBSCRIBER_ACTIVE, std::memory_order_release);
+    
+    if (index == count) {
+        subscriber_count_.store(count + 1, std::memory_order_release);
+    }
+    std::cout << "[MarketData] Subscriber " << index << " added" << std::endl;
+    return index;
+}
+
+void MarketDataService::unsubscribe(SubscriberId id) {
+    if (id >= MAX_SUBSCRIBERS) return;
+    
+    // The service thread is the only caller of the sink, so it retires the slot
+    uint8_t expected = SUBSCRIBER_ACTIVE;
+    subscribers_[id].state.compare_exchange_strong(expected, SUBSCRIBER_CLOSING, std::memory_order_acq_rel);
+    if (!running_.load()) {
+        std::lock_guard<std::mutex> lock(subscribers_mutex_);
+        if (subscribers_[id].state.load(std::memory_order_acquire) == SUBSCRIBER_CLOSING) {
+            retire(subscribers_[id]);
+        }
+    }
+}
+
+size_t MarketDataService::deliver(Subscriber& subscriber) {
+    size_t delivered = 0;
+    SymbolId symbol_id;
+    while (delivered < MAX_BATCH && subscriber.pending->tryPop(symbol_id)) {
+        // Clear the flag before reading so a quote written after the read re-queues
+        std::atomic<uint8_t>& flags = subscriber.symbols[symbol_id];
+        flags.fetch_and(static_cast<uint8_t>(~SYMBOL_PENDING), std::memory_order_acq_rel);
+        
+        TopOfBook quote;
+        if (!cache_.read(symbol_id, quote)) continue;
+        
+        if (!subscriber.sink(symbol_id, quote)) {
+            // Slow subscriber: leave the symbol pending and move on; later
+            // quotes conflate into it until the subscriber drains
+            if (!(flags.fetch_or(SYMBOL_PENDING, std::memory_order_acq_rel) & SYMBOL_PENDING) &&
+                !subscriber.pending->tryPush(symbol_id)) {
+                flags.fetch_and(static_cast<uint8_t>(~SYMBOL_PENDING), std::memory_order_relaxed);
+            }
+            break;
+        }
+        ++delivered;
+    }
+    return delivered;
+}
+
+void MarketDataService::retire(Subscriber& subscriber) {
+    SymbolId symbol_id;
+    while (subscriber.pending->tryPop(symbol_id)) {
+    }
+    const size_t symbol_slots = SymbolRegistry::MAX_SYMBOLS + 1;
+    for (size_t i = 0; i < symbol_slots; ++i) {
+        subscriber.symbols[i].store(0, std::memory_order_relaxed);
+    }
+    subscriber.sink = QuoteSink();
+    subscriber.state.store(SUBSCRIBER_FREE, std::memory_order_release);
+}
+
 void MarketDataService::workerLoop() {
+    ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::MARKET_DATA);
+    WaitStrategy wait(wait_strategy_, &notifier_);
+    auto pending = [this]() {
+        size_t count = subscriber_count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const Subscriber& subscriber = subscribers_[i];
+            uint8_t state = subscriber.state.load(std::memory_order_acquire);
+            if (state == SUBSCRIBER_CLOSING) return true;
+            if (state == SUBSCRIBER_ACTIVE && !subscriber.pending->empty()) return true;
+        }
+        return false;
+    };
+    
     while (running_.load()) {
-        // Process market data updates and disseminate to subscribers
-        // This would implement market data distribution logic
+        size_t delivered = 0;
+        size_t count = subscriber_count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            Subscriber& subscriber = subscribers_[i];
+            uint8_t state = subscriber.state.load(std::memory_order_acquire);
+            if (state == SUBSCRIBER_ACTIVE) {
+                delivered += deliver(subscriber);
+            } else if (state == SUBSCRIBER_CLOSING) {
+                std::lock_guard<std::mutex> lock(subscribers_mutex_);
+                retire(subscriber);
+            }
+        }
         
-        std::this_thread::sleep_for(std::chrono::microseconds(1));
+        if (delivered == 0) {
+            wait.idle(pending);
+        } else {
+            delivered_count_.fetch_add(delivered, std::memory_order_relaxed);
+            wait.reset();
+        }
     }
 }
 
@@ -310,35 +751,26 @@ bool RiskManagementService::isRunning() const {
     return running_.load();
 }
 
-void RiskManagementService::processMessage(std::shared_ptr<Message> message) {
-    if (!message || !running_.load()) return;
-    
-    auto start_time = std::chrono::high_resolution_clock::now();
+bool RiskManagementService::processMessage(const Message& message) {
+    if (!running_.load()) return false;
     
-    // Perform risk checks on orders
-    if (message->getType() == MessageType::ORDER_NEW) {
-        auto order_msg = std::dynamic_pointer_cast<OrderMessage>(message);
-        if (order_msg) {
-            // Perform risk validation
-            // Check position limits, exposure limits, etc.
-        }
-    }
-    
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
-    
-    if (latency > 10000) {
-        std::cout << "[RiskManagement] Warning: High latency detected: " 
-                  << (latency / 1000.0) << " microseconds" << std::endl;
+    // Order checks already ran inline; quotes move the collar reference
+    if (message.getType() == MessageType::MARKET_DATA) {
+        const MarketDataMessage& md_msg = static_cast<const MarketDataMessage&>(message);
+        engine_.onMarketData(md_msg.getSymbolId(), md_msg.getBid(), md_msg.getAsk());
     }
+    return true;
 }
 
 void RiskManagementService::workerLoop() {
+    ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::RISK);
+    WaitStrategy wait(wait_strategy_);
+    
     while (running_.load()) {
         // Perform periodic risk checks and monitoring
         // This would implement risk monitoring and alerting logic
         
-        std::this_thread::sleep_for(std::chrono::microseconds(1));
+        wait.idle();
     }
 }
 
@@ -1,22 +1,148 @@
 #include "../include/socket_server.hpp"
 #include "../include/message.hpp"
+#include "../include/message_pool.hpp"
+#include "../include/tsc_clock.hpp"
+#include "../include/cpu_topology.hpp"
 #include <iostream>
 #include <cstring>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
+#include <sys/eventfd.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
-#include <sched.h>
-#include <pthread.h>
 #include <netinet/tcp.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
 #include <algorithm>
 #include <numeric>
+#include <tuple>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET 70
+#endif
+
+// Per-epoll busy-poll parameters, Linux 6.9+
+#ifndef EPIOCSPARAMS
+struct epoll_params {
+    uint32_t busy_poll_usecs;
+    uint16_t busy_poll_budget;
+    uint8_t prefer_busy_poll;
+    uint8_t __pad;
+};
+#define EPIOCSPARAMS _IOW(0x8A, 0x01, struct epoll_params)
+#endif
 
 namespace hft {
 
+namespace {
+
+// Reactor owned by the calling thread, so sends to its own connections skip the handoff
+thread_local Reactor* current_reactor = nullptr;
+
+size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = 2;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+// Turn on receive stamping of every packet in the NIC. Needs CAP_NET_ADMIN;
+// the driver may widen the filter but must not refuse it entirely.
+bool enableHardwareTimestamps(const std::string& interface) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    
+    struct hwtstamp_config config;
+    memset(&config, 0, sizeof(config));
+    config.tx_type = HWTSTAMP_TX_OFF;
+    config.rx_filter = HWTSTAMP_FILTER_ALL;
+    
+    struct ifreq request;
+    memset(&request, 0, sizeof(request));
+    strncpy(request.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+    request.ifr_data = reinterpret_cast<char*>(&config);
+    
+    int result = ioctl(fd, SIOCSHWTSTAMP, &request);
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    return result == 0 && config.rx_filter != HWTSTAMP_FILTER_NONE;
+}
+
+// Nanoseconds on CLOCK_REALTIME, the clock kernel stamps are taken on
+// (and hardware ones once phc2sys keeps the NIC clock in step)
+uint64_t realtimeNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
 // SocketServer implementation
+constexpr size_t SocketServer::MAX_EVENTS;
+constexpr size_t SocketServer::MAX_BUFFER_SIZE;
+constexpr int SocketServer::BUSY_POLL_USEC;
+constexpr size_t SocketServer::OUTBOUND_QUEUE_CAPACITY;
+constexpr size_t SocketServer::CONGESTION_WATERMARK;
+constexpr unsigned SocketServer::URING_ENTRIES;
+constexpr uint32_t SocketServer::URING_RECV_BUFFERS;
+constexpr size_t OutboundFrame::MAX_SIZE;
+
+// ClientRouteTable implementation
+ClientRouteTable::ClientRouteTable(size_t max_clients)
+    : entries_(roundUpPowerOfTwo(max_clients * 2)), mask_(entries_.size() - 1) {
+}
+
+size_t ClientRouteTable::slotFor(uint64_t client_id) const {
+    uint64_t hash = client_id * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash ^ (hash >> 32)) & mask_;
+}
+
+ConnectionId ClientRouteTable::find(uint64_t client_id) const {
+    size_t slot = slotFor(client_id);
+    while (true) {
+        ConnectionId connection_id = entries_[slot].connection_id.load(std::memory_order_acquire);
+        if (connection_id == INVALID_CONNECTION_ID) return INVALID_CONNECTION_ID;
+        if (entries_[slot].client_id.load(std::memory_order_relaxed) == client_id) return connection_id;
+        slot = (slot + 1) & mask_;
+    }
+}
+
+void ClientRouteTable::bind(uint64_t client_id, ConnectionId connection_id) {
+    if (connection_id == INVALID_CONNECTION_ID) return;
+    
+    std::lock_guard<std::mutex> lock(insert_mutex_);
+    size_t slot = slotFor(client_id);
+    while (entries_[slot].connection_id.load(std::memory_order_relaxed) != INVALID_CONNECTION_ID) {
+        if (entries_[slot].client_id.load(std::memory_order_relaxed) == client_id) {
+            entries_[slot].connection_id.store(connection_id, std::memory_order_release);
+            return;
+        }
+        slot = (slot + 1) & mask_;
+    }
+    
+    // Keep the table at most half full so probes stay short
+    if (size_ * 2 >= entries_.size()) {
+        std::cerr << "[SocketServer] Client route table full, client " << client_id << " not routable" << std::endl;
+        return;
+    }
+    entries_[slot].client_id.store(client_id, std::memory_order_relaxed);
+    entries_[slot].connection_id.store(connection_id, std::memory_order_release);
+    ++size_;
+}
+
 SocketServer::~SocketServer() {
     stop();
     
@@ -26,21 +152,104 @@ SocketServer::~SocketServer() {
     if (epoll_fd_ >= 0) {
         close(epoll_fd_);
     }
+    closeListeners();
 }
 
-bool SocketServer::initialize(int port, int max_connections) {
+bool SocketServer::initialize(int port, int max_connections, ListenMode listen_mode) {
     port_ = port;
     max_connections_ = max_connections;
+    listen_mode_ = listen_mode;
+    
+    if (listen_mode_ != ListenMode::SINGLE) {
+        // One SO_REUSEPORT listener per reactor; the kernel balances SYNs across them
+        for (size_t i = 0; i < thread_count_; ++i) {
+            int listen_fd = createListener(true);
+            if (listen_fd < 0) {
+                closeListeners();
+                return false;
+            }
+            listener_fds_.push_back(listen_fd);
+        }
+        
+        if (listen_mode_ == ListenMode::REUSEPORT_CPU && !attachReuseportCpuFilter()) {
+            closeListeners();
+            return false;
+        }
+    } else {
+        server_fd_ = createListener(false);
+        if (server_fd_ < 0) {
+            return false;
+        }
+        
+        // Create epoll instance
+        epoll_fd_ = epoll_create1(0);
+        if (epoll_fd_ < 0) {
+            std::cerr << "[SocketServer] Failed to create epoll: " << strerror(errno) << std::endl;
+            close(server_fd_);
+            server_fd_ = -1;
+            return false;
+        }
+        
+        // Add server socket to epoll
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        event.data.fd = server_fd_;
+        
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_fd_, &event) < 0) {
+            std::cerr << "[SocketServer] Failed to add server socket to epoll: " << strerror(errno) << std::endl;
+            close(epoll_fd_);
+            close(server_fd_);
+            epoll_fd_ = -1;
+            server_fd_ = -1;
+            return false;
+        }
+    }
+    
+    // Connection slots are fixed for the server's lifetime so senders never race a resize
+    slot_capacity_ = max_connections_;
+    slots_.reset(new ConnectionSlot[slot_capacity_]);
+    free_slots_.clear();
+    for (size_t i = slot_capacity_; i > 0; --i) {
+        free_slots_.push_back(static_cast<uint32_t>(i - 1));
+    }
     
-    // Create server socket
-    server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd_ < 0) {
+    // Initialize message handler and performance monitor
+    message_handler_ = std::make_shared<MessageHandler>();
+    performance_monitor_ = std::make_shared<PerformanceMonitor>();
+    message_handler_->setPerformanceMonitor(performance_monitor_.get());
+    message_handler_->setRouteTable(&routes_);
+    message_handler_->setSessionCallback([this](Connection& connection, const MessageView& view) {
+        return onSessionFrame(connection, view);
+    });
+    
+    std::cout << "[SocketServer] Initialized on port " << port_;
+    if (!listener_fds_.empty()) {
+        std::cout << " with " << listener_fds_.size() << " SO_REUSEPORT listeners"
+                  << (listen_mode_ == ListenMode::REUSEPORT_CPU ? " (CPU steering)" : "");
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+int SocketServer::createListener(bool reuse_port) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
         std::cerr << "[SocketServer] Failed to create socket: " << strerror(errno) << std::endl;
-        return false;
+        return -1;
     }
     
     // Set socket options for low latency
-    setSocketOptions(server_fd_);
+    setSocketOptions(listen_fd);
+    
+    if (reuse_port) {
+        int flag = 1;
+        if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &flag, sizeof(flag)) < 0) {
+            std::cerr << "[SocketServer] Failed to set SO_REUSEPORT: " << strerror(errno) << std::endl;
+            close(listen_fd);
+            return -1;
+        }
+    }
     
     // Bind socket
     struct sockaddr_in server_addr;
@@ -49,60 +258,79 @@ bool SocketServer::initialize(int port, int max_connections) {
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(port_);
     
-    if (bind(server_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    if (bind(listen_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         std::cerr << "[SocketServer] Failed to bind socket: " << strerror(errno) << std::endl;
-        close(server_fd_);
-        server_fd_ = -1;
-        return false;
+        close(listen_fd);
+        return -1;
     }
     
     // Listen for connections
-    if (listen(server_fd_, SOMAXCONN) < 0) {
+    if (listen(listen_fd, SOMAXCONN) < 0) {
         std::cerr << "[SocketServer] Failed to listen: " << strerror(errno) << std::endl;
-        close(server_fd_);
-        server_fd_ = -1;
-        return false;
+        close(listen_fd);
+        return -1;
     }
     
-    // Create epoll instance
-    epoll_fd_ = epoll_create1(0);
-    if (epoll_fd_ < 0) {
-        std::cerr << "[SocketServer] Failed to create epoll: " << strerror(errno) << std::endl;
-        close(server_fd_);
-        server_fd_ = -1;
-        return false;
+    return listen_fd;
+}
+
+bool SocketServer::attachReuseportCpuFilter() {
+    // The kernel indexes the reuseport group in bind order and listener i belongs
+    // to reactor i, so map each reactor's pinned CPU to its index: a SYN handled
+    // on that CPU lands on the reactor running there. CPUs hosting no reactor
+    // (or all of them, with placement off) fall back to cpu % n.
+    const ThreadPlacement& placement = ThreadPlacement::getInstance();
+    std::vector<struct sock_filter> code;
+    std::vector<int> mapped;
+    code.push_back({ BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) });
+    for (size_t i = 0; i < listener_fds_.size(); ++i) {
+        int cpu = placement.cpuFor(ThreadRole::REACTOR, i);
+        // A CPU shared by several reactors steers to the first of them
+        if (cpu < 0 || std::find(mapped.begin(), mapped.end(), cpu) != mapped.end()) continue;
+        mapped.push_back(cpu);
+        code.push_back({ BPF_JMP | BPF_JEQ | BPF_K, 0, 1, static_cast<uint32_t>(cpu) });
+        code.push_back({ BPF_RET | BPF_K,           0, 0, static_cast<uint32_t>(i) });
     }
+    code.push_back({ BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(listener_fds_.size()) });
+    code.push_back({ BPF_RET | BPF_A,           0, 0, 0 });
     
-    // Add server socket to epoll
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.ptr = nullptr;
-    event.data.fd = server_fd_;
+    struct sock_fprog prog;
+    prog.len = static_cast<unsigned short>(code.size());
+    prog.filter = code.data();
     
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_fd_, &event) < 0) {
-        std::cerr << "[SocketServer] Failed to add server socket to epoll: " << strerror(errno) << std::endl;
-        close(epoll_fd_);
-        close(server_fd_);
-        epoll_fd_ = -1;
-        server_fd_ = -1;
+    // Attaching to any member applies the program to the whole group
+    if (setsockopt(listener_fds_.front(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+        std::cerr << "[SocketServer] Failed to attach reuseport CPU filter: " << strerror(errno) << std::endl;
         return false;
     }
-    
-    // Initialize message handler and performance monitor
-    message_handler_ = std::make_shared<MessageHandler>();
-    performance_monitor_ = std::make_shared<PerformanceMonitor>();
-    
-    std::cout << "[SocketServer] Initialized on port " << port_ << std::endl;
     return true;
 }
 
+void SocketServer::closeListeners() {
+    for (int listen_fd : listener_fds_) {
+        close(listen_fd);
+    }
+    listener_fds_.clear();
+}
+
 void SocketServer::start() {
     if (running_.load()) return;
     
+    if (rx_timestamping_ != RxTimestamping::OFF && io_backend_ == IoBackend::IO_URING) {
+        std::cerr << "[SocketServer] Receive timestamps are only read on epoll reactors" << std::endl;
+    }
+    
+    if (!createReactors()) {
+        std::cerr << "[SocketServer] Failed to create reactors" << std::endl;
+        return;
+    }
+    
     running_ = true;
     
-    // Start accept thread
-    accept_thread_ = std::thread(&SocketServer::acceptLoop, this);
+    // Start accept thread; reactors accept on their own listeners in SO_REUSEPORT mode
+    if (listener_fds_.empty()) {
+        accept_thread_ = std::thread(&SocketServer::acceptLoop, this);
+    }
     
     // Start worker threads
     for (size_t i = 0; i < thread_count_; ++i) {
@@ -130,6 +358,8 @@ void SocketServer::stop() {
     }
     worker_threads_.clear();
     
+    destroyReactors();
+    
     std::cout << "[SocketServer] Stopped" << std::endl;
 }
 
@@ -149,6 +379,80 @@ void SocketServer::setAffinity(bool enable) {
     affinity_enabled_ = enable;
 }
 
+void SocketServer::setDispatchPolicy(DispatchPolicy policy) {
+    dispatch_policy_ = policy;
+}
+
+void SocketServer::setWaitStrategy(WaitStrategyType type) {
+    if (running_.load()) {
+        std::cerr << "[SocketServer] Cannot change wait strategy while running" << std::endl;
+        return;
+    }
+    wait_strategy_ = type;
+}
+
+void SocketServer::setIoBackend(IoBackend backend, bool sqpoll) {
+    if (running_.load()) {
+        std::cerr << "[SocketServer] Cannot change I/O backend while running" << std::endl;
+        return;
+    }
+    io_backend_ = backend;
+    uring_sqpoll_ = sqpoll;
+}
+
+void SocketServer::setZeroCopy(bool enable) {
+    if (running_.load()) {
+        std::cerr << "[SocketServer] Cannot change zero-copy mode while running" << std::endl;
+        return;
+    }
+    zerocopy_enabled_ = enable;
+}
+
+bool SocketServer::setRxTimestamping(RxTimestamping mode, const std::string& interface) {
+    if (running_.load()) {
+        std::cerr << "[SocketServer] Cannot change receive timestamping while running" << std::endl;
+        return false;
+    }
+    
+    if (mode == RxTimestamping::HARDWARE) {
+        if (interface.empty()) {
+            std::cerr << "[SocketServer] Hardware timestamps need an interface, using software" << std::endl;
+            mode = RxTimestamping::SOFTWARE;
+        } else if (!enableHardwareTimestamps(interface)) {
+            std::cerr << "[SocketServer] " << interface << " refused hardware timestamping ("
+                      << strerror(errno) << "), using software" << std::endl;
+            mode = RxTimestamping::SOFTWARE;
+        }
+    }
+    
+    rx_timestamping_ = mode;
+    return mode != RxTimestamping::OFF;
+}
+
+void SocketServer::setBusyPoll(const BusyPollConfig& config) {
+    if (running_.load()) {
+        std::cerr << "[SocketServer] Cannot change busy polling while running" << std::endl;
+        return;
+    }
+    busy_poll_ = config;
+}
+
+void SocketServer::setMessageCallback(std::function<void(MessageHandle, const MessageView&)> callback) {
+    if (!message_handler_) {
+        std::cerr << "[SocketServer] Message handler not initialized" << std::endl;
+        return;
+    }
+    message_handler_->setMessageCallback(callback);
+}
+
+void SocketServer::setViewCallback(std::function<void(int, const MessageView&)> callback) {
+    if (!message_handler_) {
+        std::cerr << "[SocketServer] Message handler not initialized" << std::endl;
+        return;
+    }
+    message_handler_->setViewCallback(callback);
+}
+
 size_t SocketServer::getConnectionCount() const {
     return connection_count_.load();
 }
@@ -157,11 +461,31 @@ double SocketServer::getAverageLatency() const {
     return performance_monitor_ ? performance_monitor_->getAverageLatency() : 0.0;
 }
 
+size_t SocketServer::getReactorConnections(size_t index) const {
+    return index < reactors_.size() ? reactors_[index]->connection_count.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t SocketServer::getReactorFramesRead(size_t index) const {
+    return index < reactors_.size() ? reactors_[index]->frames_read.load(std::memory_order_relaxed) : 0;
+}
+
+void SocketServer::getLatencySnapshot(LatencyHistogram& out) const {
+    if (performance_monitor_) {
+        performance_monitor_->getLatencySnapshot(out);
+    } else {
+        out.reset();
+    }
+}
+
 size_t SocketServer::getMessagesProcessed() const {
     return messages_processed_.load();
 }
 
 void SocketServer::acceptLoop() {
+    if (affinity_enabled_) {
+        ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::ACCEPT);
+    }
+    
     while (running_.load()) {
         struct epoll_event events[MAX_EVENTS];
         int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, 1); // 1ms timeout
@@ -174,10 +498,24 @@ void SocketServer::acceptLoop() {
         
         for (int i = 0; i < nfds; ++i) {
             if (events[i].data.fd == server_fd_) {
-                // New connection
-                handleConnection(server_fd_);
+                acceptConnections(server_fd_, nullptr);
+            }
+        }
+    }
+}
+
+void SocketServer::acceptConnections(int listen_fd, Reactor* owner) {
+    // Drain the accept backlog
+    while (true) {
+        int client_fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "[SocketServer] accept4 error: " << strerror(errno) << std::endl;
             }
+            return;
         }
+        handleConnection(client_fd, owner);
     }
 }
 
@@ -186,15 +524,94 @@ void SocketServer::workerLoop(int worker_id) {
         setThreadAffinity(worker_id);
     }
     
+    Reactor& reactor = *reactors_[worker_id];
+    current_reactor = &reactor;
+    
+    // Set up on the pinned thread so the ring and its buffers are node-local;
+    // the epoll set made in createReactors stays as the fallback
+    if (io_backend_ == IoBackend::IO_URING && !setupUring(reactor)) {
+        std::cerr << "[SocketServer] Reactor " << worker_id << " falling back to epoll" << std::endl;
+    }
+    
+    if (reactor.uring) {
+        uringWorkerLoop(reactor);
+        current_reactor = nullptr;
+        return;
+    }
+    
+    struct epoll_event events[MAX_EVENTS];
+    WaitStrategy wait = WaitStrategy::forEventLoop(wait_strategy_);
+    
     while (running_.load()) {
-        // Worker threads handle data processing
-        // In a real implementation, this would process messages from a queue
+        // Spinning strategies poll with a zero timeout; parking ones block in epoll
+        int timeout_ms = wait.pollTimeoutMs();
+        int nfds = epoll_wait(reactor.epoll_fd, events, MAX_EVENTS, timeout_ms);
+        
+        if (nfds < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[SocketServer] Reactor " << worker_id << " epoll_wait error: " << strerror(errno) << std::endl;
+            break;
+        }
+        
+        for (int i = 0; i < nfds; ++i) {
+            int fd = events[i].data.fd;
+            uint32_t ready = events[i].events;
+            
+            if (fd == reactor.wakeup_fd) {
+                uint64_t value;
+                while (read(reactor.wakeup_fd, &value, sizeof(value)) > 0) {}
+                registerPendingConnections(reactor);
+                continue;
+            }
+            
+            if (fd == reactor.listen_fd) {
+                acceptConnections(reactor.listen_fd, &reactor);
+                continue;
+            }
+            
+            // Read first so data that arrived together with a hangup is not lost
+            if (ready & EPOLLIN) {
+                readConnection(reactor, fd);
+            }
+            
+            auto it = reactor.connections.find(fd);
+            if (it == reactor.connections.end()) continue;
+            Connection& connection = it->second;
+            
+            if (((ready & EPOLLERR) && !handleSocketError(connection)) ||
+                (ready & (EPOLLHUP | EPOLLRDHUP))) {
+                closeConnection(reactor, fd);
+                continue;
+            }
+            if ((ready & EPOLLOUT) && connection.write_blocked) {
+                flushConnection(reactor, connection);
+            }
+        }
+        
+        // Heartbeats queued by due timers go out with this cycle's flush
+        uint64_t now_ticks = TscClock::now();
+        if (now_ticks >= reactor.next_tick_ticks) {
+            advanceTimers(reactor, now_ticks);
+        }
         
-        std::this_thread::sleep_for(std::chrono::microseconds(1)); // 1 microsecond sleep
+        // One flush per connection per cycle, covering everything queued
+        // while handling this batch of events and everything handed over
+        size_t handed_over = drainOutbound(reactor);
+        size_t flushed = flushDirty(reactor);
+        
+        if (nfds == 0 && handed_over == 0 && flushed == 0) {
+            if (timeout_ms == 0) {
+                wait.idle();
+            }
+            continue;
+        }
+        wait.reset();
     }
+    
+    current_reactor = nullptr;
 }
 
-void SocketServer::handleConnection(int client_fd) {
+void SocketServer::handleConnection(int client_fd, Reactor* owner) {
     if (connection_count_.load() >= max_connections_) {
         close(client_fd);
         return;
@@ -203,29 +620,473 @@ void SocketServer::handleConnection(int client_fd) {
     // Set client socket options
     setSocketOptions(client_fd);
     
-    // Add to epoll for monitoring
-    struct epoll_event event;
-    event.events = EPOLLIN | EPOLLET; // Edge-triggered
-    event.data.fd = client_fd;
-    
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &event) < 0) {
-        if (errno == EEXIST) {
-            // Client already exists in epoll, remove and re-add
-            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client_fd, nullptr);
-            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &event) < 0) {
-                std::cerr << "[SocketServer] Failed to add client to epoll after retry: " << strerror(errno) << std::endl;
-                close(client_fd);
-                return;
+    // Hand the connection to a reactor; it registers the fd in its own epoll set
+    Reactor& reactor = owner ? *owner : selectReactor();
+    {
+        std::lock_guard<std::mutex> lock(reactor.pending_mutex);
+        reactor.pending_fds.push_back(client_fd);
+    }
+    reactor.connection_count.fetch_add(1);
+    connection_count_.fetch_add(1);
+    
+    if (owner) {
+        // Accepted on the reactor's own listener: register inline
+        registerPendingConnections(reactor);
+    } else {
+        uint64_t value = 1;
+        if (write(reactor.wakeup_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            std::cerr << "[SocketServer] Failed to wake reactor " << reactor.id << ": " << strerror(errno) << std::endl;
+        }
+    }
+    
+    std::cout << "[SocketServer] New connection accepted on reactor " << reactor.id
+              << ", total: " << connection_count_.load() << std::endl;
+}
+
+bool SocketServer::createReactors() {
+    if (thread_count_ == 0) {
+        std::cerr << "[SocketServer] Thread count must be at least 1" << std::endl;
+        return false;
+    }
+    if (!listener_fds_.empty() && listener_fds_.size() != thread_count_) {
+        std::cerr << "[SocketServer] Thread count changed after opening " << listener_fds_.size()
+                  << " SO_REUSEPORT listeners" << std::endl;
+        return false;
+    }
+    
+    reactors_.clear();
+    reactors_.reserve(thread_count_);
+    next_reactor_ = 0;
+    
+    for (size_t i = 0; i < thread_count_; ++i) {
+        std::unique_ptr<Reactor> reactor(new Reactor());
+        reactor->id = static_cast<int>(i);
+        
+        reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (reactor->epoll_fd < 0) {
+            std::cerr << "[SocketServer] Failed to create reactor epoll: " << strerror(errno) << std::endl;
+            reactors_.push_back(std::move(reactor));
+            destroyReactors();
+            return false;
+        }
+        
+        setEpollBusyPoll(reactor->epoll_fd);
+        reactor->outbound.reset(new MpscQueue<OutboundFrame>(OUTBOUND_QUEUE_CAPACITY));
+        reactor->start_ticks = TscClock::now();
+        reactor->next_tick_ticks = reactor->start_ticks;
+        
+        reactor->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (reactor->wakeup_fd < 0) {
+            std::cerr << "[SocketServer] Failed to create reactor eventfd: " << strerror(errno) << std::endl;
+            reactors_.push_back(std::move(reactor));
+            destroyReactors();
+            return false;
+        }
+        
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = reactor->wakeup_fd;
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->wakeup_fd, &event) < 0) {
+            std::cerr << "[SocketServer] Failed to add eventfd to reactor epoll: " << strerror(errno) << std::endl;
+            reactors_.push_back(std::move(reactor));
+            destroyReactors();
+            return false;
+        }
+        
+        if (!listener_fds_.empty()) {
+            reactor->listen_fd = listener_fds_[i];
+            event.events = EPOLLIN;
+            event.data.fd = reactor->listen_fd;
+            if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->listen_fd, &event) < 0) {
+                std::cerr << "[SocketServer] Failed to add listener to reactor epoll: " << strerror(errno) << std::endl;
+                reactors_.push_back(std::move(reactor));
+                destroyReactors();
+                return false;
             }
-        } else {
-            std::cerr << "[SocketServer] Failed to add client to epoll: " << strerror(errno) << std::endl;
+        }
+        
+        reactors_.push_back(std::move(reactor));
+    }
+    
+    return true;
+}
+
+void SocketServer::destroyReactors() {
+    for (auto& reactor : reactors_) {
+        // Closing the ring cancels its operations and drops their file references
+        reactor->uring.reset();
+        reactor->retired_tx.clear();
+        
+        // Connections handed over but never registered
+        for (int fd : reactor->pending_fds) {
+            close(fd);
+            connection_count_.fetch_sub(1);
+        }
+        reactor->pending_fds.clear();
+        
+        for (auto& connection : reactor->connections) {
+            const Session& session = connection.second.session;
+            if (session.client_id != 0 && session_end_handler_) {
+                session_end_handler_(session.client_id, connection.second.id);
+            }
+            releaseSlot(connection.second.id);
+            close(connection.first);
+            connection_count_.fetch_sub(1);
+        }
+        // The wheel goes with the reactor, so its links into these are never followed
+        reactor->connections.clear();
+        reactor->dirty.clear();
+        reactor->connection_count = 0;
+        
+        if (reactor->wakeup_fd >= 0) {
+            close(reactor->wakeup_fd);
+        }
+        if (reactor->epoll_fd >= 0) {
+            close(reactor->epoll_fd);
+        }
+    }
+    reactors_.clear();
+    
+    std::lock_guard<std::mutex> lock(logged_in_mutex_);
+    logged_in_clients_.clear();
+}
+
+Reactor& SocketServer::selectReactor() {
+    if (dispatch_policy_ == DispatchPolicy::LEAST_LOADED) {
+        size_t best = 0;
+        for (size_t i = 1; i < reactors_.size(); ++i) {
+            if (reactors_[i]->connection_count.load() < reactors_[best]->connection_count.load()) {
+                best = i;
+            }
+        }
+        return *reactors_[best];
+    }
+    
+    Reactor& reactor = *reactors_[next_reactor_];
+    next_reactor_ = (next_reactor_ + 1) % reactors_.size();
+    return reactor;
+}
+
+void SocketServer::registerPendingConnections(Reactor& reactor) {
+    std::vector<int> pending;
+    {
+        std::lock_guard<std::mutex> lock(reactor.pending_mutex);
+        pending.swap(reactor.pending_fds);
+    }
+    
+    for (int client_fd : pending) {
+        ConnectionId connection_id = allocateSlot(client_fd, reactor.id);
+        if (connection_id == INVALID_CONNECTION_ID) {
+            std::cerr << "[SocketServer] No free connection slot, closing fd " << client_fd << std::endl;
+            close(client_fd);
+            reactor.connection_count.fetch_sub(1);
+            connection_count_.fetch_sub(1);
+            continue;
+        }
+        
+        if (reactor.uring) {
+            auto inserted = reactor.connections.emplace(std::piecewise_construct,
+                                                        std::forward_as_tuple(client_fd),
+                                                        std::forward_as_tuple(client_fd, buffer_size_, connection_id));
+            startSession(reactor, inserted.first->second);
+            armUringConnection(reactor, inserted.first->second);
+            continue;
+        }
+        
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLET | EPOLLRDHUP; // Edge-triggered
+        event.data.fd = client_fd;
+        
+        if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, client_fd, &event) < 0) {
+            std::cerr << "[SocketServer] Failed to add client to reactor epoll: " << strerror(errno) << std::endl;
+            releaseSlot(connection_id);
             close(client_fd);
+            reactor.connection_count.fetch_sub(1);
+            connection_count_.fetch_sub(1);
+            continue;
+        }
+        auto inserted = reactor.connections.emplace(std::piecewise_construct,
+                                                    std::forward_as_tuple(client_fd),
+                                                    std::forward_as_tuple(client_fd, buffer_size_, connection_id));
+        startSession(reactor, inserted.first->second);
+        
+        // Without SO_ZEROCOPY the kernel ignores MSG_ZEROCOPY and never sends
+        // completions, so only flag connections where it took
+        if (zerocopy_enabled_) {
+            int flag = 1;
+            if (setsockopt(client_fd, SOL_SOCKET, SO_ZEROCOPY, &flag, sizeof(flag)) == 0) {
+                inserted.first->second.zerocopy = true;
+            } else {
+                std::cerr << "[SocketServer] SO_ZEROCOPY unavailable on fd " << client_fd
+                          << ": " << strerror(errno) << std::endl;
+            }
+        }
+    }
+}
+
+void SocketServer::readConnection(Reactor& reactor, int client_fd) {
+    auto it = reactor.connections.find(client_fd);
+    if (it == reactor.connections.end()) return;
+    Connection& connection = it->second;
+    FrameBuffer& rx = connection.rx;
+    
+    // Edge-triggered: read until the socket is drained
+    while (true) {
+        ssize_t n = rx_timestamping_ != RxTimestamping::OFF
+                        ? readStamped(connection, rx.writePtr(), rx.writable())
+                        : read(client_fd, rx.writePtr(), rx.writable());
+        
+        if (n > 0) {
+            // readStamped takes its own reading to age the kernel stamp against
+            if (rx_timestamping_ == RxTimestamping::OFF) connection.read_ticks = TscClock::now();
+            connection.session.last_rx_ms = reactor.timers.now();
+            rx.commit(static_cast<size_t>(n));
+            
+            // Parse every complete frame from this read in one pass
+            int frames = message_handler_->handleFrames(connection);
+            if (frames < 0) {
+                std::cerr << "[SocketServer] Malformed frame on fd " << client_fd << ", closing" << std::endl;
+                closeConnection(reactor, client_fd);
+                return;
+            }
+            messages_processed_.fetch_add(frames, std::memory_order_relaxed);
+            reactor.frames_read.store(reactor.frames_read.load(std::memory_order_relaxed) + frames,
+                                      std::memory_order_relaxed);
+            if (connection.session.state == SessionState::CLOSING) {
+                closeSession(reactor, connection);
+                return;
+            }
+            continue;
+        }
+        
+        if (n == 0) {
+            closeConnection(reactor, client_fd);
             return;
         }
+        
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+        
+        std::cerr << "[SocketServer] Read error on fd " << client_fd << ": " << strerror(errno) << std::endl;
+        closeConnection(reactor, client_fd);
+        return;
     }
+}
+
+void SocketServer::closeConnection(Reactor& reactor, int client_fd) {
+    auto it = reactor.connections.find(client_fd);
+    if (it == reactor.connections.end()) return;
     
-    connection_count_.fetch_add(1);
-    std::cout << "[SocketServer] New connection accepted, total: " << connection_count_.load() << std::endl;
+    Session& session = it->second.session;
+    reactor.timers.cancel(session.timer);
+    if (session.client_id != 0) {
+        if (session_end_handler_) session_end_handler_(session.client_id, it->second.id);
+        releaseClient(session.client_id);
+    }
+    releaseSlot(it->second.id);
+    
+    if (reactor.uring) {
+        // The kernel may still be reading the send ring; keep it until the completion
+        if (it->second.send_inflight) {
+            reactor.retired_tx.emplace(it->second.id, std::move(it->second.tx));
+        }
+        // Armed operations hold the socket open past close(); shutdown ends them
+        shutdown(client_fd, SHUT_RDWR);
+    } else {
+        epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, client_fd, nullptr);
+    }
+    reactor.connections.erase(it);
+    close(client_fd);
+    
+    reactor.connection_count.fetch_sub(1);
+    connection_count_.fetch_sub(1);
+}
+
+ConnectionId SocketServer::allocateSlot(int client_fd, int reactor_id) {
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    if (free_slots_.empty()) return INVALID_CONNECTION_ID;
+    
+    uint32_t index = free_slots_.back();
+    free_slots_.pop_back();
+    
+    uint32_t generation = next_generation_++;
+    if (next_generation_ == 0) next_generation_ = 1;
+    ConnectionId connection_id = (static_cast<uint64_t>(generation) << 32) | index;
+    
+    ConnectionSlot& slot = slots_[index];
+    slot.fd.store(client_fd, std::memory_order_relaxed);
+    slot.reactor.store(reactor_id, std::memory_order_relaxed);
+    slot.queued_bytes.store(0, std::memory_order_relaxed);
+    slot.id.store(connection_id, std::memory_order_release);
+    return connection_id;
+}
+
+void SocketServer::releaseSlot(ConnectionId connection_id) {
+    uint32_t index = static_cast<uint32_t>(connection_id);
+    if (connection_id == INVALID_CONNECTION_ID || index >= slot_capacity_) return;
+    
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    slots_[index].id.store(INVALID_CONNECTION_ID, std::memory_order_release);
+    free_slots_.push_back(index);
+}
+
+bool SocketServer::send(ConnectionId connection_id, const Message& message) {
+    uint32_t index = static_cast<uint32_t>(connection_id);
+    if (!running_.load(std::memory_order_relaxed) || index >= slot_capacity_) return false;
+    
+    ConnectionSlot& slot = slots_[index];
+    if (connection_id == INVALID_CONNECTION_ID || slot.id.load(std::memory_order_acquire) != connection_id) {
+        return false;
+    }
+    
+    size_t payload_length = message.serializedSize();
+    size_t length = FRAME_HEADER_SIZE + payload_length;
+    if (length > OutboundFrame::MAX_SIZE ||
+        slot.queued_bytes.load(std::memory_order_relaxed) + length > OutboundBuffer::CAPACITY) {
+        send_drops_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    Reactor& reactor = *reactors_[slot.reactor.load(std::memory_order_relaxed)];
+    OutboundFrame frame;
+    encodeFrameHeader(static_cast<uint32_t>(payload_length), reinterpret_cast<uint8_t*>(frame.data));
+    message.serializeInto(frame.data + FRAME_HEADER_SIZE);
+    
+    // The owning reactor appends straight to the ring; it flushes at the end of this cycle
+    if (&reactor == current_reactor) {
+        auto it = reactor.connections.find(slot.fd.load(std::memory_order_relaxed));
+        if (it == reactor.connections.end() || it->second.id != connection_id) return false;
+        return appendFrame(reactor, it->second, frame.data, length);
+    }
+    
+    frame.connection_id = connection_id;
+    frame.length = static_cast<uint32_t>(length);
+    if (!reactor.outbound->tryPush(frame)) {
+        send_drops_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    // Only the first handoff since the reactor last drained pays for a wakeup
+    if (!reactor.outbound_signalled.exchange(true, std::memory_order_acq_rel)) {
+        uint64_t value = 1;
+        if (write(reactor.wakeup_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            std::cerr << "[SocketServer] Failed to wake reactor " << reactor.id << ": " << strerror(errno) << std::endl;
+        }
+    }
+    return true;
+}
+
+bool SocketServer::sendToClient(uint64_t client_id, const Message& message) {
+    ConnectionId connection_id = routes_.find(client_id);
+    return connection_id != INVALID_CONNECTION_ID && send(connection_id, message);
+}
+
+bool SocketServer::isCongested(ConnectionId connection_id) const {
+    uint32_t index = static_cast<uint32_t>(connection_id);
+    if (index >= slot_capacity_ || slots_[index].id.load(std::memory_order_acquire) != connection_id) return true;
+    return slots_[index].queued_bytes.load(std::memory_order_relaxed) > CONGESTION_WATERMARK;
+}
+
+bool SocketServer::appendFrame(Reactor& reactor, Connection& connection, const char* frame, size_t length) {
+    if (!connection.tx.append(frame, length)) {
+        send_drops_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ++reactor.messages_queued;
+    connection.session.last_tx_ms = reactor.timers.now();
+    slots_[static_cast<uint32_t>(connection.id)].queued_bytes.store(
+        static_cast<uint32_t>(connection.tx.queued()), std::memory_order_relaxed);
+    
+    // Blocked connections are flushed from EPOLLOUT instead
+    if (!connection.flush_queued && !connection.write_blocked) {
+        connection.flush_queued = true;
+        reactor.dirty.emplace_back(connection.fd, connection.id);
+    }
+    return true;
+}
+
+size_t SocketServer::drainOutbound(Reactor& reactor) {
+    // Clear first so a handoff racing with this drain signals again
+    reactor.outbound_signalled.store(false, std::memory_order_release);
+    
+    return reactor.outbound->popBatch([this, &reactor](OutboundFrame&& frame) {
+        ConnectionSlot& slot = slots_[static_cast<uint32_t>(frame.connection_id)];
+        if (slot.id.load(std::memory_order_acquire) != frame.connection_id) return;
+        
+        auto it = reactor.connections.find(slot.fd.load(std::memory_order_relaxed));
+        if (it == reactor.connections.end() || it->second.id != frame.connection_id) return;
+        appendFrame(reactor, it->second, frame.data, frame.length);
+    }, MAX_EVENTS);
+}
+
+size_t SocketServer::flushDirty(Reactor& reactor) {
+    size_t flushed = 0;
+    for (const auto& entry : reactor.dirty) {
+        auto it = reactor.connections.find(entry.first);
+        if (it == reactor.connections.end() || it->second.id != entry.second) continue;
+        
+        it->second.flush_queued = false;
+        flushConnection(reactor, it->second);
+        ++flushed;
+    }
+    reactor.dirty.clear();
+    
+    if (reactor.messages_queued > 0) {
+        messages_sent_.fetch_add(reactor.messages_queued, std::memory_order_relaxed);
+        reactor.messages_queued = 0;
+    }
+    return flushed;
+}
+
+void SocketServer::flushConnection(Reactor& reactor, Connection& connection) {
+    if (reactor.uring) {
+        submitUringSend(reactor, connection);
+        return;
+    }
+    
+    size_t calls_before = connection.tx.sendCalls();
+    OutboundBuffer::FlushResult result = connection.tx.flush(connection.fd, connection.zerocopy);
+    send_calls_.fetch_add(connection.tx.sendCalls() - calls_before, std::memory_order_relaxed);
+    
+    if (result == OutboundBuffer::FLUSH_ERROR) {
+        std::cerr << "[SocketServer] Send error on fd " << connection.fd << ": " << strerror(errno) << std::endl;
+        closeConnection(reactor, connection.fd);
+        return;
+    }
+    
+    slots_[static_cast<uint32_t>(connection.id)].queued_bytes.store(
+        static_cast<uint32_t>(connection.tx.queued()), std::memory_order_relaxed);
+    
+    // Backpressure: park the rest until the socket drains instead of blocking
+    bool blocked = (result == OutboundBuffer::FLUSH_BLOCKED);
+    if (blocked != connection.write_blocked) {
+        setWriteInterest(reactor, connection, blocked);
+    }
+}
+
+bool SocketServer::handleSocketError(Connection& connection) {
+    // Zero-copy completions are delivered on the error queue and raise EPOLLERR too
+    if (!connection.zerocopy) return false;
+    
+    connection.tx.reapCompletions(connection.fd);
+    slots_[static_cast<uint32_t>(connection.id)].queued_bytes.store(
+        static_cast<uint32_t>(connection.tx.queued()), std::memory_order_relaxed);
+    
+    int error = 0;
+    socklen_t length = sizeof(error);
+    return getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0;
+}
+
+void SocketServer::setWriteInterest(Reactor& reactor, Connection& connection, bool enable) {
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLET | EPOLLRDHUP | (enable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    event.data.fd = connection.fd;
+    if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_MOD, connection.fd, &event) < 0) {
+        std::cerr << "[SocketServer] Failed to update write interest on fd " << connection.fd
+                  << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    connection.write_blocked = enable;
 }
 
 void SocketServer::setSocketOptions(int sock_fd) {
@@ -245,19 +1106,106 @@ void SocketServer::setSocketOptions(int sock_fd) {
     int recv_buf_size = buffer_size_;
     setsockopt(sock_fd, SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(send_buf_size));
     setsockopt(sock_fd, SOL_SOCKET, SO_RCVBUF, &recv_buf_size, sizeof(recv_buf_size));
+    
+    setBusyPollOptions(sock_fd);
+    
+    if (rx_timestamping_ != RxTimestamping::OFF) {
+        int stamp_flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (rx_timestamping_ == RxTimestamping::HARDWARE) {
+            stamp_flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+        }
+        if (setsockopt(sock_fd, SOL_SOCKET, SO_TIMESTAMPING, &stamp_flags, sizeof(stamp_flags)) < 0) {
+            std::cerr << "[SocketServer] Failed to set SO_TIMESTAMPING: " << strerror(errno) << std::endl;
+        }
+    }
 }
 
-void SocketServer::setThreadAffinity(int worker_id) {
-    cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);
-    CPU_SET(worker_id % 8, &cpuset); // Assuming 8 cores, adjust as needed
+void SocketServer::setBusyPollOptions(int sock_fd) {
+    // Let the kernel busy-poll the device queue on reads instead of sleeping
+    int busy_poll_usec = busy_poll_.usecs > 0 ? static_cast<int>(busy_poll_.usecs)
+                         : wait_strategy_ == WaitStrategyType::BUSY_POLL ? BUSY_POLL_USEC : 0;
+    if (busy_poll_usec > 0 &&
+        setsockopt(sock_fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_usec, sizeof(busy_poll_usec)) < 0) {
+        std::cerr << "[SocketServer] Failed to set SO_BUSY_POLL: " << strerror(errno) << std::endl;
+    }
+    
+    int prefer = 1;
+    if (busy_poll_.prefer &&
+        setsockopt(sock_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) < 0) {
+        std::cerr << "[SocketServer] Failed to set SO_PREFER_BUSY_POLL: " << strerror(errno) << std::endl;
+    }
+    
+    // Raising the budget above the default needs CAP_NET_ADMIN
+    int budget = busy_poll_.budget;
+    if (budget > 0 &&
+        setsockopt(sock_fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget)) < 0) {
+        std::cerr << "[SocketServer] Failed to set SO_BUSY_POLL_BUDGET: " << strerror(errno) << std::endl;
+    }
+}
+
+void SocketServer::setEpollBusyPoll(int epoll_fd) {
+    // epoll_wait only busy-polls on its own settings or the net.core.busy_poll
+    // sysctl; the socket options above cover the blocking read path
+    if (busy_poll_.usecs == 0 && !busy_poll_.prefer && busy_poll_.budget == 0) return;
     
-    pthread_t current_thread = pthread_self();
-    if (pthread_setaffinity_np(current_thread, sizeof(cpu_set_t), &cpuset) != 0) {
-        std::cerr << "[SocketServer] Failed to set thread affinity for worker " << worker_id << std::endl;
+    struct epoll_params params;
+    memset(&params, 0, sizeof(params));
+    params.busy_poll_usecs = busy_poll_.usecs > 0 ? busy_poll_.usecs : static_cast<uint32_t>(BUSY_POLL_USEC);
+    params.busy_poll_budget = busy_poll_.budget;
+    params.prefer_busy_poll = busy_poll_.prefer ? 1 : 0;
+    if (ioctl(epoll_fd, EPIOCSPARAMS, &params) < 0) {
+        std::cerr << "[SocketServer] epoll busy-poll parameters not supported (" << strerror(errno)
+                  << "), set net.core.busy_poll instead" << std::endl;
     }
 }
 
+ssize_t SocketServer::readStamped(Connection& connection, char* buffer, size_t length) {
+    struct iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = length;
+    
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(struct scm_timestamping))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    
+    ssize_t n = recvmsg(connection.fd, &msg, 0);
+    if (n <= 0) return n;
+    
+    connection.read_ticks = TscClock::now();
+    connection.wire_ticks = 0;
+    
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_TIMESTAMPING) continue;
+        
+        // ts[0] software, ts[2] raw hardware; either may be zero. TCP reports
+        // the last segment this read consumed, so all its frames share it.
+        struct scm_timestamping stamps;
+        memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+        const struct timespec& hardware = stamps.ts[2];
+        bool is_hardware = hardware.tv_sec != 0 || hardware.tv_nsec != 0;
+        const struct timespec& stamp = is_hardware ? hardware : stamps.ts[0];
+        uint64_t stamp_ns = static_cast<uint64_t>(stamp.tv_sec) * 1000000000ULL + static_cast<uint64_t>(stamp.tv_nsec);
+        if (stamp_ns == 0) break;
+        
+        // Age the stamp against the realtime clock now rather than mapping it
+        // onto the TSC through the calibration, which drifts as NTP slews
+        uint64_t now_ns = realtimeNanos();
+        uint64_t age_ticks = now_ns > stamp_ns ? TscClock::fromNanos(now_ns - stamp_ns) : 0;
+        connection.wire_ticks = connection.read_ticks > age_ticks ? connection.read_ticks - age_ticks : 1;
+        (is_hardware ? hardware_stamps_ : software_stamps_).fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+    return n;
+}
+
+void SocketServer::setThreadAffinity(int worker_id) {
+    ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::REACTOR, static_cast<size_t>(worker_id));
+}
+
 // MessageHandler implementation
 MessageHandler::MessageHandler() {
     // Pre-allocate buffers for zero-copy operations
@@ -269,32 +1217,97 @@ MessageHandler::~MessageHandler() {
     // Cleanup
 }
 
-void MessageHandler::handleMessage(int client_fd, const char* data, size_t length) {
+void MessageHandler::handleMessage(Connection& connection, const char* data, size_t length) {
     if (!data || length == 0) return;
     
-    // Convert data to vector for message processing
-    std::vector<uint8_t> message_data(data, data + length);
+    // Session frames and rejected application frames stop here
+    MessageView view(data, length);
+    if (session_callback_ && view.valid() && !session_callback_(connection, view)) return;
+    
+    // Zero-copy path: hand out a view over the receive buffer
+    if (view_callback_) {
+        if (!view.valid()) {
+            std::cerr << "[MessageHandler] Dropping truncated message" << std::endl;
+            return;
+        }
+        view_callback_(connection.fd, view);
+        return;
+    }
+    
+    uint64_t start_ticks = TscClock::now();
     
-    // Create message from data
-    auto message = MessageFactory::createMessage(message_data);
+    // Decode into a message recycled through this reactor's pool
+    MessageHandle message = MessagePool::local().decode(data, length);
     if (!message) {
         std::cerr << "[MessageHandler] Failed to create message from data" << std::endl;
         return;
     }
     
-    // Set receive time for latency tracking
-    message->setReceiveTime(std::chrono::high_resolution_clock::now());
+    // The decode start doubles as the receive time; no second clock read
+    message->setReceiveTicks(start_ticks);
+    message->setConnectionId(connection.id);
+    
+    // Pooled messages carry the previous trace; replayed ones have no read
+    PipelineTrace& trace = message->trace();
+    trace.reset();
+    if (connection.wire_ticks != 0) trace.mark(TraceStage::WIRE, connection.wire_ticks);
+    trace.mark(TraceStage::READ, connection.read_ticks);
+    trace.mark(TraceStage::DECODE);
+    
+    // Learn where to route this client's fills; only when it changes
+    if (routes_ && (!connection.routed || connection.routed_client_id != message->getClientId())) {
+        routes_->bind(message->getClientId(), connection.id);
+        connection.routed_client_id = message->getClientId();
+        connection.routed = true;
+    }
     
     // Process message through callback if set
     if (message_callback_) {
-        message_callback_(message);
+        message_callback_(std::move(message), view);
+    }
+    
+    if (performance_monitor_) {
+        performance_monitor_->recordLatencyNs(TscClock::toNanos(TscClock::nowOrdered() - start_ticks));
     }
 }
 
-void MessageHandler::setMessageCallback(std::function<void(std::shared_ptr<Message>)> callback) {
+int MessageHandler::handleFrames(Connection& connection) {
+    FrameBuffer& buffer = connection.rx;
+    int frames = 0;
+    
+    while (buffer.readable() >= FRAME_HEADER_SIZE) {
+        uint32_t payload_length = decodeFrameHeader(reinterpret_cast<const uint8_t*>(buffer.readPtr()));
+        if (payload_length == 0 || payload_length > MAX_FRAME_SIZE) {
+            return -1;
+        }
+        
+        // Partial frame: wait for the rest
+        if (buffer.readable() < FRAME_HEADER_SIZE + payload_length) break;
+        
+        handleMessage(connection, buffer.readPtr() + FRAME_HEADER_SIZE, payload_length);
+        buffer.consume(FRAME_HEADER_SIZE + payload_length);
+        ++frames;
+        
+        // Whatever follows a LOGOUT or a session violation is not processed
+        if (connection.session.state == SessionState::CLOSING) break;
+    }
+    
+    buffer.compact();
+    return frames;
+}
+
+void MessageHandler::setMessageCallback(std::function<void(MessageHandle, const MessageView&)> callback) {
     message_callback_ = callback;
 }
 
+void MessageHandler::setViewCallback(std::function<void(int, const MessageView&)> callback) {
+    view_callback_ = callback;
+}
+
+void MessageHandler::setSessionCallback(std::function<bool(Connection&, const MessageView&)> callback) {
+    session_callback_ = callback;
+}
+
 void MessageHandler::preallocateBuffers(size_t count) {
     std::lock_guard<std::mutex> lock(buffer_pool_mutex_);
     buffer_pool_.reserve(count);
@@ -326,8 +1339,10 @@ void MessageHandler::returnBuffer(std::vector<char> buffer) {
 }
 
 // PerformanceMonitor implementation
-PerformanceMonitor::PerformanceMonitor() {
-    latency_samples_.reserve(MAX_SAMPLES);
+constexpr size_t PerformanceMonitor::THROUGHPUT_UPDATE_INTERVAL_MS;
+
+PerformanceMonitor::PerformanceMonitor()
+    : last_throughput_update_(std::chrono::steady_clock::now()) {
 }
 
 PerformanceMonitor::~PerformanceMonitor() {
@@ -335,75 +1350,64 @@ PerformanceMonitor::~PerformanceMonitor() {
 }
 
 void PerformanceMonitor::recordLatency(double latency_us) {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    
-    if (latency_samples_.size() >= MAX_SAMPLES) {
-        latency_samples_.erase(latency_samples_.begin());
-    }
-    latency_samples_.push_back(latency_us);
+    latencies_.record(static_cast<uint64_t>(latency_us * 1000.0));
 }
 
 void PerformanceMonitor::recordThroughput(size_t messages_per_second) {
+    std::lock_guard<std::mutex> lock(throughput_mutex_);
+    
     auto now = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         now - last_throughput_update_).count();
     
-    if (elapsed >= THROUGHPUT_UPDATE_INTERVAL_MS) {
+    if (elapsed >= static_cast<long>(THROUGHPUT_UPDATE_INTERVAL_MS)) {
         throughput_ = messages_per_second;
         last_throughput_update_ = now;
     }
 }
 
+double PerformanceMonitor::percentileUs(double q) const {
+    LatencyHistogram snapshot;
+    latencies_.snapshot(snapshot);
+    return snapshot.percentile(q) / 1000.0;
+}
+
 double PerformanceMonitor::getAverageLatency() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    
-    if (latency_samples_.empty()) return 0.0;
-    
-    double sum = std::accumulate(latency_samples_.begin(), latency_samples_.end(), 0.0);
-    return sum / latency_samples_.size();
+    LatencyHistogram snapshot;
+    latencies_.snapshot(snapshot);
+    return snapshot.mean() / 1000.0;
 }
 
 double PerformanceMonitor::getP95Latency() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    
-    if (latency_samples_.size() < 20) return getAverageLatency();
-    
-    std::vector<double> sorted_samples = latency_samples_;
-    std::sort(sorted_samples.begin(), sorted_samples.end());
-    
-    size_t index = static_cast<size_t>(sorted_samples.size() * 0.95);
-    return sorted_samples[index];
+    return percentileUs(0.95);
 }
 
 double PerformanceMonitor::getP99Latency() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    
-    if (latency_samples_.size() < 100) return getAverageLatency();
-    
-    std::vector<double> sorted_samples = latency_samples_;
-    std::sort(sorted_samples.begin(), sorted_samples.end());
-    
-    size_t index = static_cast<size_t>(sorted_samples.size() * 0.99);
-    return sorted_samples[index];
+    return percentileUs(0.99);
 }
 
 size_t PerformanceMonitor::getThroughput() const {
-    return throughput_;
+    return throughput_.load(std::memory_order_relaxed);
 }
 
 void PerformanceMonitor::reset() {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    latency_samples_.clear();
+    latencies_.reset();
     throughput_ = 0;
 }
 
 void PerformanceMonitor::printStats() const {
+    LatencyHistogram snapshot;
+    latencies_.snapshot(snapshot);
+    
     std::cout << "\n=== Performance Statistics ===" << std::endl;
-    std::cout << "Average Latency: " << getAverageLatency() << " μs" << std::endl;
-    std::cout << "P95 Latency: " << getP95Latency() << " μs" << std::endl;
-    std::cout << "P99 Latency: " << getP99Latency() << " μs" << std::endl;
+    std::cout << "Average Latency: " << snapshot.mean() / 1000.0 << " μs" << std::endl;
+    std::cout << "P50 Latency: " << snapshot.percentile(0.50) / 1000.0 << " μs" << std::endl;
+    std::cout << "P99 Latency: " << snapshot.percentile(0.99) / 1000.0 << " μs" << std::endl;
+    std::cout << "P99.9 Latency: " << snapshot.percentile(0.999) / 1000.0 << " μs" << std::endl;
+    std::cout << "P99.99 Latency: " << snapshot.percentile(0.9999) / 1000.0 << " μs" << std::endl;
+    std::cout << "Max Latency: " << snapshot.max() / 1000.0 << " μs" << std::endl;
     std::cout << "Throughput: " << getThroughput() << " msg/s" << std::endl;
-    std::cout << "Sample Count: " << latency_samples_.size() << std::endl;
+    std::cout << "Sample Count: " << snapshot.count() << std::endl;
     std::cout << "=============================" << std::endl;
 }
 
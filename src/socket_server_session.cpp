@@ -0,0 +1,308 @@
+#include "../include/socket_server.hpp"
+#include "../include/message.hpp"
+#include "../include/tsc_clock.hpp"
+#include <iostream>
+#include <algorithm>
+
+// Session layer. Every frame passes onSessionFrame() before it is decoded:
+// LOGIN binds an authenticated client id to the connection, LOGOUT and
+// HEARTBEAT are answered here, and logged-in sessions have their client id
+// and sequence numbers checked. Each connection keeps one timer on its
+// reactor's wheel, armed for whichever comes first of its next heartbeat
+// and its timeout, so liveness costs a store per read and a timer firing
+// per interval instead of a scan over every connection.
+
+namespace hft {
+
+namespace {
+
+constexpr uint64_t NANOS_PER_TICK = 1000000;    // Wheel ticks are milliseconds
+
+const char* reasonName(LogoutReason reason) {
+    switch (reason) {
+        case LogoutReason::NORMAL: return "logout";
+        case LogoutReason::LOGIN_REJECTED: return "login rejected";
+        case LogoutReason::NOT_LOGGED_IN: return "not logged in";
+        case LogoutReason::DUPLICATE_LOGIN: return "duplicate login";
+        case LogoutReason::CLIENT_MISMATCH: return "client id mismatch";
+        case LogoutReason::LOGIN_TIMEOUT: return "login timeout";
+        case LogoutReason::HEARTBEAT_TIMEOUT: return "heartbeat timeout";
+        case LogoutReason::IDLE_TIMEOUT: return "idle timeout";
+    }
+    return "unknown";
+}
+
+// Earliest check due on a connection that has not logged in; 0 if none applies
+uint64_t connectedDeadline(const SessionConfig& config, const Session& session, LogoutReason& reason) {
+    uint64_t deadline = 0;
+    if (config.require_login && config.login_timeout_ms > 0) {
+        deadline = session.connected_ms + config.login_timeout_ms;
+        reason = LogoutReason::LOGIN_TIMEOUT;
+    }
+    if (config.idle_timeout_ms > 0) {
+        uint64_t idle = session.last_rx_ms + config.idle_timeout_ms;
+        if (deadline == 0 || idle < deadline) {
+            deadline = idle;
+            reason = LogoutReason::IDLE_TIMEOUT;
+        }
+    }
+    return deadline;
+}
+
+} // namespace
+
+void SocketServer::setSessionConfig(const SessionConfig& config) {
+    if (running_.load()) {
+        std::cerr << "[SocketServer] Cannot change session settings while running" << std::endl;
+        return;
+    }
+    session_config_ = config;
+    session_config_.min_heartbeat_interval_ms = std::max<uint32_t>(session_config_.min_heartbeat_interval_ms, 1);
+    session_config_.max_heartbeat_interval_ms = std::max(session_config_.max_heartbeat_interval_ms,
+                                                         session_config_.min_heartbeat_interval_ms);
+    session_config_.heartbeat_interval_ms = std::min(std::max(session_config_.heartbeat_interval_ms,
+                                                              session_config_.min_heartbeat_interval_ms),
+                                                     session_config_.max_heartbeat_interval_ms);
+    session_config_.missed_heartbeats = std::max<uint32_t>(session_config_.missed_heartbeats, 1);
+}
+
+SessionStats SocketServer::getSessionStats() const {
+    SessionStats stats;
+    stats.logins = logins_.load(std::memory_order_relaxed);
+    stats.logins_rejected = logins_rejected_.load(std::memory_order_relaxed);
+    stats.logouts = logouts_.load(std::memory_order_relaxed);
+    stats.reaped = sessions_reaped_.load(std::memory_order_relaxed);
+    stats.heartbeats_sent = heartbeats_sent_.load(std::memory_order_relaxed);
+    stats.sequence_gaps = sequence_gaps_.load(std::memory_order_relaxed);
+    stats.duplicates_dropped = duplicates_dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SocketServer::startSession(Reactor& reactor, Connection& connection) {
+    Session& session = connection.session;
+    session.timer.key = static_cast<uint64_t>(connection.fd);
+    session.connected_ms = reactor.timers.now();
+    session.last_rx_ms = session.connected_ms;
+    session.last_tx_ms = session.connected_ms;
+    
+    // Connections that need no login and have no idle limit never arm a timer
+    LogoutReason reason;
+    uint64_t deadline = connectedDeadline(session_config_, session, reason);
+    if (deadline != 0) {
+        reactor.timers.schedule(session.timer, deadline - session.connected_ms);
+    }
+}
+
+bool SocketServer::onSessionFrame(Connection& connection, const MessageView& view) {
+    Session& session = connection.session;
+    MessageType type = view.getType();
+    bool session_message = type == MessageType::HEARTBEAT || type == MessageType::LOGIN ||
+                           type == MessageType::LOGOUT;
+    
+    // Everything below the fast path runs rarely: find the owning reactor then
+    auto owner = [this, &connection]() -> Reactor& {
+        return *reactors_[slots_[static_cast<uint32_t>(connection.id)].reactor.load(std::memory_order_relaxed)];
+    };
+    
+    if (session.state == SessionState::ACTIVE) {
+        // Logged-in sessions speak for their own client id only, in sequence
+        if (view.getClientId() != session.client_id) {
+            queueLogout(owner(), connection, LogoutReason::CLIENT_MISMATCH);
+            return false;
+        }
+        uint64_t sequence = view.getSequenceNumber();
+        if (sequence <= session.last_sequence) {
+            duplicates_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (sequence != session.last_sequence + 1) {
+            sequence_gaps_.fetch_add(1, std::memory_order_relaxed);
+        }
+        session.last_sequence = sequence;
+        if (!session_message) return true;
+    } else if (!session_message) {
+        if (!session_config_.require_login) return true;
+        queueLogout(owner(), connection, LogoutReason::NOT_LOGGED_IN);
+        return false;
+    }
+    
+    switch (type) {
+        case MessageType::LOGIN:
+            if (session.state == SessionState::ACTIVE) {
+                queueLogout(owner(), connection, LogoutReason::DUPLICATE_LOGIN);
+            } else {
+                handleLogin(owner(), connection, view);
+            }
+            break;
+        case MessageType::LOGOUT:
+            if (session.state == SessionState::ACTIVE) {
+                logouts_.fetch_add(1, std::memory_order_relaxed);
+            }
+            queueLogout(owner(), connection, LogoutReason::NORMAL);
+            break;
+        default:
+            // Heartbeats only prove liveness, and the read already recorded that
+            break;
+    }
+    return false;
+}
+
+bool SocketServer::handleLogin(Reactor& reactor, Connection& connection, const MessageView& view) {
+    Session& session = connection.session;
+    LoginMessage login;
+    if (!login.deserialize(view.data(), view.length()) || login.getClientId() == 0) {
+        std::cerr << "[SocketServer] Malformed LOGIN on fd " << connection.fd << std::endl;
+        logins_rejected_.fetch_add(1, std::memory_order_relaxed);
+        queueLogout(reactor, connection, LogoutReason::LOGIN_REJECTED);
+        return false;
+    }
+    
+    uint64_t client_id = login.getClientId();
+    if (!claimClient(client_id)) {
+        std::cerr << "[SocketServer] Client " << client_id << " already logged in, refusing fd " << connection.fd << std::endl;
+        logins_rejected_.fetch_add(1, std::memory_order_relaxed);
+        queueLogout(reactor, connection, LogoutReason::DUPLICATE_LOGIN);
+        return false;
+    }
+    if (login_handler_ && !login_handler_(login, connection.id)) {
+        releaseClient(client_id);
+        std::cerr << "[SocketServer] Login refused for client " << client_id << " on fd " << connection.fd << std::endl;
+        logins_rejected_.fetch_add(1, std::memory_order_relaxed);
+        queueLogout(reactor, connection, LogoutReason::LOGIN_REJECTED);
+        return false;
+    }
+    
+    uint32_t interval = login.getHeartbeatIntervalMs();
+    interval = interval == 0 ? session_config_.heartbeat_interval_ms
+                             : std::min(std::max(interval, session_config_.min_heartbeat_interval_ms),
+                                        session_config_.max_heartbeat_interval_ms);
+    
+    session.state = SessionState::ACTIVE;
+    session.client_id = client_id;
+    session.last_sequence = login.getSequenceNumber();
+    session.heartbeat_interval_ms = interval;
+    
+    // Fills route here from the first order on, not from whenever one arrives
+    routes_.bind(client_id, connection.id);
+    connection.routed_client_id = client_id;
+    connection.routed = true;
+    
+    LoginMessage reply(client_id, interval);
+    reply.setFlags(login.getFlags() & wire::LOGIN_MARKET_DATA);
+    queueMessage(reactor, connection, reply);
+    reactor.timers.schedule(session.timer, interval);
+    logins_.fetch_add(1, std::memory_order_relaxed);
+    
+    std::cout << "[SocketServer] Client " << client_id << " logged in on fd " << connection.fd
+              << ", heartbeat " << interval << " ms" << std::endl;
+    return true;
+}
+
+void SocketServer::onSessionTimer(Reactor& reactor, int client_fd) {
+    auto it = reactor.connections.find(client_fd);
+    if (it == reactor.connections.end()) return;
+    Connection& connection = it->second;
+    Session& session = connection.session;
+    uint64_t now = reactor.timers.now();
+    
+    if (session.state == SessionState::ACTIVE) {
+        uint64_t interval = session.heartbeat_interval_ms;
+        uint64_t deadline = session.last_rx_ms + interval * session_config_.missed_heartbeats;
+        if (now >= deadline) {
+            sessions_reaped_.fetch_add(1, std::memory_order_relaxed);
+            endSession(reactor, connection, LogoutReason::HEARTBEAT_TIMEOUT);
+            return;
+        }
+        
+        // Our half of the contract: the client hears from us at least once an interval
+        if (now >= session.last_tx_ms + interval) {
+            HeartbeatMessage heartbeat(session.client_id);
+            if (queueMessage(reactor, connection, heartbeat)) {
+                heartbeats_sent_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        
+        uint64_t next = std::min(session.last_tx_ms + interval, deadline);
+        reactor.timers.schedule(session.timer, next > now ? next - now : 1);
+        return;
+    }
+    
+    if (session.state == SessionState::CONNECTED) {
+        LogoutReason reason = LogoutReason::IDLE_TIMEOUT;
+        uint64_t deadline = connectedDeadline(session_config_, session, reason);
+        if (deadline == 0) return;
+        if (now >= deadline) {
+            sessions_reaped_.fetch_add(1, std::memory_order_relaxed);
+            endSession(reactor, connection, reason);
+            return;
+        }
+        reactor.timers.schedule(session.timer, deadline - now);
+    }
+}
+
+void SocketServer::advanceTimers(Reactor& reactor, uint64_t now_ticks) {
+    uint64_t now_ms = TscClock::toNanos(now_ticks - reactor.start_ticks) / NANOS_PER_TICK;
+    reactor.next_tick_ticks = reactor.start_ticks + TscClock::fromNanos((now_ms + 1) * NANOS_PER_TICK);
+    
+    reactor.timers.advance(now_ms, [this, &reactor](TimerWheel::Timer& timer) {
+        onSessionTimer(reactor, static_cast<int>(timer.key));
+    });
+}
+
+bool SocketServer::queueMessage(Reactor& reactor, Connection& connection, const Message& message) {
+    char frame[OutboundFrame::MAX_SIZE];
+    size_t payload_length = message.serializedSize();
+    encodeFrameHeader(static_cast<uint32_t>(payload_length), reinterpret_cast<uint8_t*>(frame));
+    message.serializeInto(frame + FRAME_HEADER_SIZE);
+    return appendFrame(reactor, connection, frame, FRAME_HEADER_SIZE + payload_length);
+}
+
+void SocketServer::queueLogout(Reactor& reactor, Connection& connection, LogoutReason reason) {
+    Session& session = connection.session;
+    if (session.state == SessionState::CLOSING) return;
+    
+    if (reason != LogoutReason::NORMAL) {
+        std::cout << "[SocketServer] Ending session on fd " << connection.fd;
+        if (session.client_id != 0) std::cout << " (client " << session.client_id << ")";
+        std::cout << ": " << reasonName(reason) << std::endl;
+    }
+    
+    LogoutMessage logout(session.client_id, reason);
+    queueMessage(reactor, connection, logout);
+    session.state = SessionState::CLOSING;
+}
+
+void SocketServer::endSession(Reactor& reactor, Connection& connection, LogoutReason reason) {
+    queueLogout(reactor, connection, reason);
+    closeSession(reactor, connection);
+}
+
+void SocketServer::closeSession(Reactor& reactor, Connection& connection) {
+    int client_fd = connection.fd;
+    ConnectionId connection_id = connection.id;
+    
+    // The LOGOUT goes out best effort: epoll writes what the socket takes
+    // now, io_uring gets its sendmsg submitted ahead of the shutdown
+    flushConnection(reactor, connection);
+    if (reactor.uring) {
+        reactor.uring->submit();
+    }
+    
+    // A failed flush has already closed it
+    auto it = reactor.connections.find(client_fd);
+    if (it != reactor.connections.end() && it->second.id == connection_id) {
+        closeConnection(reactor, client_fd);
+    }
+}
+
+bool SocketServer::claimClient(uint64_t client_id) {
+    std::lock_guard<std::mutex> lock(logged_in_mutex_);
+    return logged_in_clients_.insert(client_id).second;
+}
+
+void SocketServer::releaseClient(uint64_t client_id) {
+    std::lock_guard<std::mutex> lock(logged_in_mutex_);
+    logged_in_clients_.erase(client_id);
+}
+
+} // namespace hft
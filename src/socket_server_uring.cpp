@@ -0,0 +1,318 @@
+#include "../include/socket_server.hpp"
+#include "../include/tsc_clock.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+// io_uring reactor loop. Each reactor owns one ring: the listener (in the
+// SO_REUSEPORT modes) has a multishot accept armed, every connection a
+// multishot recv drawing from the reactor's provided buffers, and the
+// wakeup eventfd a pending read. Sends keep one sendmsg in flight per
+// connection covering everything queued; frames appended meanwhile go out
+// with the next one, so batching falls out of the completion cadence.
+
+namespace hft {
+
+namespace {
+
+// Completion tags: operation in the top byte, connection id below it
+enum UringOp : uint64_t {
+    URING_BUFFERS = 0,      // Legacy buffer recycle; only posted without CQE skip
+    URING_ACCEPT = 1,
+    URING_WAKEUP = 2,
+    URING_RECV = 3,
+    URING_SEND = 4
+};
+
+constexpr uint64_t URING_ID_MASK = (1ull << 56) - 1;
+constexpr size_t URING_BATCH = 256;
+
+inline uint64_t uringTag(UringOp op, ConnectionId connection_id) {
+    return (static_cast<uint64_t>(op) << 56) | (connection_id & URING_ID_MASK);
+}
+
+inline UringOp uringOp(uint64_t user_data) {
+    return static_cast<UringOp>(user_data >> 56);
+}
+
+// io_uring parks operations on EAGAIN and retries them itself; on an
+// O_NONBLOCK file the EAGAIN would come back as a completion instead
+void clearNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0 && (flags & O_NONBLOCK)) {
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+}
+
+} // namespace
+
+bool SocketServer::setupUring(Reactor& reactor) {
+    std::unique_ptr<IoUring> ring(new IoUring());
+    if (!ring->init(URING_ENTRIES, uring_sqpoll_)) {
+        return false;
+    }
+    // Receive buffers are sized like the epoll path's read buffer
+    if (!ring->setupBuffers(0, URING_RECV_BUFFERS, static_cast<uint32_t>(buffer_size_))) {
+        return false;
+    }
+    
+    if (!ring->prepRead(reactor.wakeup_fd, &reactor.wakeup_value, sizeof(reactor.wakeup_value),
+                        uringTag(URING_WAKEUP, 0))) {
+        return false;
+    }
+    if (reactor.listen_fd >= 0 &&
+        !ring->prepAccept(reactor.listen_fd, reactor.multishot_accept, uringTag(URING_ACCEPT, 0))) {
+        return false;
+    }
+    
+    // Nothing reaches the kernel before submit, so the epoll fallback still
+    // sees a non-blocking eventfd if this fails
+    clearNonBlocking(reactor.wakeup_fd);
+    if (ring->submit() < 0) {
+        std::cerr << "[SocketServer] Reactor " << reactor.id << " io_uring submit failed: " << strerror(errno) << std::endl;
+        fcntl(reactor.wakeup_fd, F_SETFL, fcntl(reactor.wakeup_fd, F_GETFL, 0) | O_NONBLOCK);
+        return false;
+    }
+    
+    std::cout << "[SocketServer] Reactor " << reactor.id << " using io_uring"
+              << (ring->sqpoll() ? " with SQPOLL" : "")
+              << (ring->bufferRing() ? "" : " (legacy provided buffers)") << std::endl;
+    reactor.uring = std::move(ring);
+    return true;
+}
+
+void SocketServer::uringWorkerLoop(Reactor& reactor) {
+    IoUring& ring = *reactor.uring;
+    IoUring::Completion completions[URING_BATCH];
+    WaitStrategy wait = WaitStrategy::forEventLoop(wait_strategy_);
+    
+    while (running_.load()) {
+        // Spinning strategies only submit; parking ones block for a completion
+        int timeout_ms = wait.pollTimeoutMs();
+        int ret = (timeout_ms > 0) ? ring.submitAndWait(timeout_ms) : ring.submit();
+        if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            std::cerr << "[SocketServer] Reactor " << reactor.id << " io_uring_enter error: " << strerror(errno) << std::endl;
+            break;
+        }
+        
+        size_t count = ring.reap(completions, URING_BATCH);
+        for (size_t i = 0; i < count; ++i) {
+            const IoUring::Completion& completion = completions[i];
+            switch (uringOp(completion.user_data)) {
+                case URING_BUFFERS:
+                    if (completion.res < 0) {
+                        std::cerr << "[SocketServer] Reactor " << reactor.id << " buffer recycle error: "
+                                  << strerror(-completion.res) << std::endl;
+                    }
+                    break;
+                case URING_ACCEPT: onUringAccept(reactor, completion); break;
+                case URING_WAKEUP: onUringWakeup(reactor, completion); break;
+                case URING_RECV: onUringRecv(reactor, completion); break;
+                case URING_SEND: onUringSend(reactor, completion); break;
+            }
+        }
+        
+        uint64_t now_ticks = TscClock::now();
+        if (now_ticks >= reactor.next_tick_ticks) {
+            advanceTimers(reactor, now_ticks);
+        }
+        
+        size_t handed_over = drainOutbound(reactor);
+        size_t flushed = flushDirty(reactor);
+        
+        if (count == 0 && handed_over == 0 && flushed == 0) {
+            if (timeout_ms == 0) {
+                wait.idle();
+            }
+            continue;
+        }
+        wait.reset();
+    }
+}
+
+Connection* SocketServer::findUringConnection(Reactor& reactor, uint64_t user_data) {
+    uint64_t tag_id = user_data & URING_ID_MASK;
+    uint32_t index = static_cast<uint32_t>(tag_id);
+    if (index >= slot_capacity_) return nullptr;
+    
+    // Completions can outlive their connection; match the tagged id, not just the fd
+    auto it = reactor.connections.find(slots_[index].fd.load(std::memory_order_relaxed));
+    if (it == reactor.connections.end() || (it->second.id & URING_ID_MASK) != tag_id) return nullptr;
+    return &it->second;
+}
+
+void SocketServer::armUringConnection(Reactor& reactor, Connection& connection) {
+    clearNonBlocking(connection.fd);
+    if (!reactor.uring->prepRecv(connection.fd, connection.multishot_recv, uringTag(URING_RECV, connection.id))) {
+        std::cerr << "[SocketServer] Submission queue full, closing fd " << connection.fd << std::endl;
+        closeConnection(reactor, connection.fd);
+    }
+}
+
+void SocketServer::submitUringSend(Reactor& reactor, Connection& connection) {
+    // The completion resubmits whatever was appended meanwhile
+    if (connection.send_inflight) return;
+    
+    size_t iov_count = connection.tx.peek(connection.send_iov);
+    if (iov_count == 0) return;
+    
+    memset(&connection.send_msg, 0, sizeof(connection.send_msg));
+    connection.send_msg.msg_iov = connection.send_iov;
+    connection.send_msg.msg_iovlen = iov_count;
+    
+    if (!reactor.uring->prepSendmsg(connection.fd, &connection.send_msg, MSG_NOSIGNAL,
+                                   uringTag(URING_SEND, connection.id))) {
+        // Retried by the next flush of this connection
+        return;
+    }
+    connection.send_inflight = true;
+    send_calls_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SocketServer::onUringAccept(Reactor& reactor, const IoUring::Completion& completion) {
+    if (completion.res == -EINVAL && reactor.multishot_accept) {
+        // Kernel without multishot accept (before 5.19): re-arm one shot per completion
+        reactor.multishot_accept = false;
+    } else if (completion.res >= 0) {
+        handleConnection(completion.res, &reactor);
+    } else if (completion.res != -ECANCELED && completion.res != -EAGAIN) {
+        std::cerr << "[SocketServer] Reactor " << reactor.id << " accept error: " << strerror(-completion.res) << std::endl;
+        if (completion.res == -EINVAL) {
+            // One-shot accept rejected too: the listener is unusable, stop re-arming
+            return;
+        }
+    }
+    
+    if (!IoUring::hasMore(completion.flags) && running_.load()) {
+        reactor.uring->prepAccept(reactor.listen_fd, reactor.multishot_accept, uringTag(URING_ACCEPT, 0));
+    }
+}
+
+void SocketServer::onUringWakeup(Reactor& reactor, const IoUring::Completion& completion) {
+    (void)completion;
+    // Outbound handoffs are drained every cycle; only accepted fds need work here
+    registerPendingConnections(reactor);
+    reactor.uring->prepRead(reactor.wakeup_fd, &reactor.wakeup_value, sizeof(reactor.wakeup_value),
+                            uringTag(URING_WAKEUP, 0));
+}
+
+void SocketServer::onUringRecv(Reactor& reactor, const IoUring::Completion& completion) {
+    IoUring& ring = *reactor.uring;
+    Connection* connection = findUringConnection(reactor, completion.user_data);
+    
+    if (completion.res > 0 && IoUring::hasBuffer(completion.flags)) {
+        uint16_t buffer_id = IoUring::bufferId(completion.flags);
+        if (!connection) {
+            ring.recycleBuffer(buffer_id);
+            return;
+        }
+        connection->read_ticks = TscClock::now();
+        connection->session.last_rx_ms = reactor.timers.now();
+        
+        // Provided buffers are recycled right away, so bytes are copied into the
+        // connection's frame buffer; a frame may span several completions
+        const char* data = ring.buffer(buffer_id);
+        size_t remaining = static_cast<size_t>(completion.res);
+        int fd = connection->fd;
+        while (remaining > 0) {
+            FrameBuffer& rx = connection->rx;
+            size_t chunk = std::min(remaining, rx.writable());
+            if (chunk == 0) {
+                std::cerr << "[SocketServer] Frame larger than receive buffer on fd " << fd << ", closing" << std::endl;
+                ring.recycleBuffer(buffer_id);
+                closeConnection(reactor, fd);
+                return;
+            }
+            memcpy(rx.writePtr(), data, chunk);
+            rx.commit(chunk);
+            data += chunk;
+            remaining -= chunk;
+            
+            int frames = message_handler_->handleFrames(*connection);
+            if (frames < 0) {
+                std::cerr << "[SocketServer] Malformed frame on fd " << fd << ", closing" << std::endl;
+                ring.recycleBuffer(buffer_id);
+                closeConnection(reactor, fd);
+                return;
+            }
+            messages_processed_.fetch_add(frames, std::memory_order_relaxed);
+            reactor.frames_read.store(reactor.frames_read.load(std::memory_order_relaxed) + frames,
+                                      std::memory_order_relaxed);
+            if (connection->session.state == SessionState::CLOSING) {
+                ring.recycleBuffer(buffer_id);
+                closeSession(reactor, *connection);
+                return;
+            }
+        }
+        ring.recycleBuffer(buffer_id);
+        
+        if (!IoUring::hasMore(completion.flags)) {
+            armUringConnection(reactor, *connection);
+        }
+        return;
+    }
+    
+    if (IoUring::hasBuffer(completion.flags)) {
+        ring.recycleBuffer(IoUring::bufferId(completion.flags));
+    }
+    if (!connection) return;
+    
+    if (completion.res == -ENOBUFS || completion.res == -EINTR || completion.res == -EAGAIN) {
+        // Out of provided buffers: they come back as this cycle's completions are handled
+        if (!IoUring::hasMore(completion.flags)) {
+            armUringConnection(reactor, *connection);
+        }
+        return;
+    }
+    if (completion.res == -EINVAL && connection->multishot_recv) {
+        // Kernel without multishot recv: re-arm one shot per completion
+        connection->multishot_recv = false;
+        armUringConnection(reactor, *connection);
+        return;
+    }
+    if (completion.res < 0 && completion.res != -ECONNRESET && completion.res != -ECANCELED) {
+        std::cerr << "[SocketServer] Read error on fd " << connection->fd << ": " << strerror(-completion.res) << std::endl;
+    }
+    closeConnection(reactor, connection->fd);
+}
+
+void SocketServer::onUringSend(Reactor& reactor, const IoUring::Completion& completion) {
+    Connection* connection = findUringConnection(reactor, completion.user_data);
+    if (!connection) {
+        // Closed with this send in flight; its ring is no longer referenced
+        uint64_t tag_id = completion.user_data & URING_ID_MASK;
+        for (auto it = reactor.retired_tx.begin(); it != reactor.retired_tx.end(); ++it) {
+            if ((it->first & URING_ID_MASK) == tag_id) {
+                reactor.retired_tx.erase(it);
+                break;
+            }
+        }
+        return;
+    }
+    
+    connection->send_inflight = false;
+    if (completion.res < 0) {
+        if (completion.res != -EINTR && completion.res != -EAGAIN) {
+            if (completion.res != -EPIPE && completion.res != -ECONNRESET) {
+                std::cerr << "[SocketServer] Send error on fd " << connection->fd << ": "
+                          << strerror(-completion.res) << std::endl;
+            }
+            closeConnection(reactor, connection->fd);
+            return;
+        }
+    } else {
+        connection->tx.consume(static_cast<size_t>(completion.res));
+        slots_[static_cast<uint32_t>(connection->id)].queued_bytes.store(
+            static_cast<uint32_t>(connection->tx.queued()), std::memory_order_relaxed);
+    }
+    
+    // Short send, or frames appended while this one was in flight
+    if (!connection->tx.empty()) {
+        submitUringSend(reactor, *connection);
+    }
+}
+
+} // namespace hft
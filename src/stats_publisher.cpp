@@ -0,0 +1,175 @@
+#include "../include/stats_publisher.hpp"
+#include "../include/cpu_topology.hpp"
+#include "../include/tsc_clock.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace hft {
+
+namespace {
+
+void copyName(char (&out)[stats::NAME_LENGTH], const std::string& name) {
+    memset(out, 0, sizeof(out));
+    memcpy(out, name.data(), std::min(name.size(), sizeof(out) - 1));
+}
+
+} // namespace
+
+constexpr uint32_t StatsPublisher::DEFAULT_INTERVAL_MS;
+
+StatsPublisher::StatsPublisher() : staging_(new stats::Segment()) {
+    memset(staging_->counters, 0, sizeof(staging_->counters));
+    memset(staging_->histograms, 0, sizeof(staging_->histograms));
+}
+
+StatsPublisher::~StatsPublisher() {
+    stop();
+}
+
+bool StatsPublisher::addCounter(const std::string& name, CounterSource source) {
+    if (running_.load() || counters_.size() >= stats::MAX_COUNTERS) {
+        std::cerr << "[Stats] Cannot add counter " << name << std::endl;
+        return false;
+    }
+    copyName(staging_->counters[counters_.size()].name, name);
+    counters_.emplace_back(name, std::move(source));
+    return true;
+}
+
+bool StatsPublisher::addHistogram(const std::string& name, HistogramSource source) {
+    if (running_.load() || histograms_.size() >= stats::MAX_HISTOGRAMS) {
+        std::cerr << "[Stats] Cannot add histogram " << name << std::endl;
+        return false;
+    }
+    copyName(staging_->histograms[histograms_.size()].name, name);
+    histograms_.emplace_back(name, std::move(source));
+    return true;
+}
+
+bool StatsPublisher::start(const std::string& name, uint32_t interval_ms) {
+    if (running_.load()) return false;
+    
+    std::string shm_name = "/" + name;
+    int fd = shm_open(shm_name.c_str(), O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[Stats] Failed to create /dev/shm" << shm_name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, sizeof(stats::Segment)) != 0) {
+        std::cerr << "[Stats] Failed to size /dev/shm" << shm_name << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(shm_name.c_str());
+        return false;
+    }
+    void* base = mmap(nullptr, sizeof(stats::Segment), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "[Stats] Failed to map /dev/shm" << shm_name << ": " << strerror(errno) << std::endl;
+        shm_unlink(shm_name.c_str());
+        return false;
+    }
+    
+    // The fresh mapping is zeroed, which is also a valid even sequence
+    name_ = name;
+    interval_ms_ = interval_ms > 0 ? interval_ms : DEFAULT_INTERVAL_MS;
+    segment_ = static_cast<stats::Segment*>(base);
+    stats::SegmentHeader& header = segment_->header;
+    header.version = stats::VERSION;
+    header.header_size = sizeof(stats::SegmentHeader);
+    header.bucket_count = static_cast<uint32_t>(LatencyHistogram::BUCKET_COUNT);
+    header.pid = static_cast<uint32_t>(getpid());
+    header.interval_ms = interval_ms_;
+    
+    collect();
+    publish();
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header.magic, stats::MAGIC, sizeof(header.magic));
+    
+    running_ = true;
+    publisher_thread_ = std::thread(&StatsPublisher::publishLoop, this);
+    std::cout << "[Stats] Publishing " << counters_.size() << " counters and " << histograms_.size()
+              << " histograms to /dev/shm" << shm_name << " every " << interval_ms_ << " ms" << std::endl;
+    return true;
+}
+
+void StatsPublisher::stop() {
+    if (!segment_) return;
+    
+    running_ = false;
+    if (publisher_thread_.joinable()) {
+        publisher_thread_.join();
+    }
+    
+    // Readers that already mapped the segment keep the final snapshot
+    collect();
+    publish();
+    munmap(segment_, sizeof(stats::Segment));
+    segment_ = nullptr;
+    shm_unlink(("/" + name_).c_str());
+}
+
+void StatsPublisher::publishLoop() {
+    // Housekeeping, like the logger; keep it off the trading threads' CPUs
+    ThreadPlacement::getInstance().pinCurrentThread(ThreadRole::LOGGER);
+    pthread_setname_np(pthread_self(), "hft-stats");
+    
+    const auto interval = std::chrono::milliseconds(interval_ms_);
+    auto next = std::chrono::steady_clock::now() + interval;
+    while (running_.load()) {
+        // Short naps so stop() is not held up by a long interval
+        auto now = std::chrono::steady_clock::now();
+        if (now < next) {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(next - now, std::chrono::milliseconds(10)));
+            continue;
+        }
+        next += interval;
+        
+        collect();
+        publish();
+    }
+}
+
+void StatsPublisher::collect() {
+    // Sources may take their time; readers are only excluded during publish()
+    for (size_t i = 0; i < counters_.size(); ++i) {
+        staging_->counters[i].value = counters_[i].second();
+    }
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+        histograms_[i].second(scratch_);
+        stats::HistogramEntry& entry = staging_->histograms[i];
+        entry.count = scratch_.count();
+        entry.sum = scratch_.sum();
+        entry.max = scratch_.max();
+        for (size_t b = 0; b < LatencyHistogram::BUCKET_COUNT; ++b) {
+            entry.buckets[b] = scratch_.bucketCount(b);
+        }
+    }
+}
+
+void StatsPublisher::publish() {
+    stats::SegmentHeader& header = segment_->header;
+    uint64_t sequence = header.sequence.load(std::memory_order_relaxed);
+    
+    header.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    memcpy(segment_->counters, staging_->counters, counters_.size() * sizeof(stats::CounterEntry));
+    memcpy(segment_->histograms, staging_->histograms, histograms_.size() * sizeof(stats::HistogramEntry));
+    header.counter_count = static_cast<uint32_t>(counters_.size());
+    header.histogram_count = static_cast<uint32_t>(histograms_.size());
+    header.publish_ns = TscClock::wallNanos();
+    header.publish_count = publish_count_.load(std::memory_order_relaxed) + 1;
+    
+    header.sequence.store(sequence + 2, std::memory_order_release);
+    publish_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace hft
@@ -0,0 +1,118 @@
+#include "../include/symbol_registry.hpp"
+#include "../include/wire_format.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace hft {
+
+constexpr size_t SymbolRegistry::MAX_SYMBOLS;
+
+SymbolRegistry::SymbolRegistry()
+    : slots_(MAX_SYMBOLS * 2), names_(MAX_SYMBOLS + 1) {
+}
+
+bool SymbolRegistry::packKey(const char* symbol, size_t length, uint64_t& key) {
+    if (!symbol || length == 0 || length > wire::SYMBOL_LENGTH) return false;
+    
+    key = 0;
+    memcpy(&key, symbol, length);
+    return true;
+}
+
+size_t SymbolRegistry::slotFor(uint64_t key) const {
+    uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash ^ (hash >> 29)) & (slots_.size() - 1);
+}
+
+SymbolId SymbolRegistry::intern(const std::string& symbol) {
+    uint64_t key;
+    if (!packKey(symbol.data(), symbol.length(), key)) return INVALID_SYMBOL_ID;
+    
+    std::lock_guard<std::mutex> lock(intern_mutex_);
+    
+    size_t slot = slotFor(key);
+    while (true) {
+        uint64_t existing = slots_[slot].key.load(std::memory_order_relaxed);
+        if (existing == key) {
+            return slots_[slot].id.load(std::memory_order_relaxed);
+        }
+        if (existing == 0) break;
+        slot = (slot + 1) & (slots_.size() - 1);
+    }
+    
+    size_t count = count_.load(std::memory_order_relaxed);
+    if (count >= MAX_SYMBOLS) {
+        std::cerr << "[SymbolRegistry] Symbol table full, cannot intern " << symbol << std::endl;
+        return INVALID_SYMBOL_ID;
+    }
+    
+    // Ids start at 1; publish the name and id before the key makes the slot visible
+    SymbolId id = static_cast<SymbolId>(count + 1);
+    names_[id] = symbol;
+    slots_[slot].id.store(id, std::memory_order_relaxed);
+    slots_[slot].key.store(key, std::memory_order_release);
+    count_.store(count + 1, std::memory_order_release);
+    return id;
+}
+
+SymbolId SymbolRegistry::find(const char* symbol, size_t length) const {
+    uint64_t key;
+    if (!packKey(symbol, length, key)) return INVALID_SYMBOL_ID;
+    
+    size_t slot = slotFor(key);
+    while (true) {
+        uint64_t existing = slots_[slot].key.load(std::memory_order_acquire);
+        if (existing == key) {
+            return slots_[slot].id.load(std::memory_order_relaxed);
+        }
+        if (existing == 0) return INVALID_SYMBOL_ID;
+        slot = (slot + 1) & (slots_.size() - 1);
+    }
+}
+
+const std::string& SymbolRegistry::name(SymbolId id) const {
+    static const std::string empty;
+    if (id == INVALID_SYMBOL_ID || id > count_.load(std::memory_order_acquire)) return empty;
+    return names_[id];
+}
+
+SymbolId SymbolRegistry::verify(SymbolId id, const char* symbol, size_t length) const {
+    const std::string& known = name(id);
+    if (known.empty()) return INVALID_SYMBOL_ID;
+    if (length == 0) return id;
+    return (known.length() == length && memcmp(known.data(), symbol, length) == 0) ? id : INVALID_SYMBOL_ID;
+}
+
+size_t SymbolRegistry::loadFromFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "[SymbolRegistry] Failed to open reference data: " << path << std::endl;
+        return 0;
+    }
+    
+    std::vector<std::string> symbols;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t end = line.find_first_of(" \t\r#");
+        line = line.substr(0, end);
+        if (!line.empty()) {
+            symbols.push_back(line);
+        }
+    }
+    return load(symbols);
+}
+
+size_t SymbolRegistry::load(const std::vector<std::string>& symbols) {
+    size_t loaded = 0;
+    for (const auto& symbol : symbols) {
+        if (intern(symbol) != INVALID_SYMBOL_ID) {
+            ++loaded;
+        } else {
+            std::cerr << "[SymbolRegistry] Rejected symbol: " << symbol << std::endl;
+        }
+    }
+    return loaded;
+}
+
+} // namespace hft
@@ -1,4 +1,7 @@
 #include "../include/message.hpp"
+#include "../include/framing.hpp"
+#include "../include/latency_histogram.hpp"
+#include "../include/tsc_clock.hpp"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -13,6 +16,7 @@
 #include <algorithm>
 #include <signal.h>
 #include <atomic>
+#include <memory>
 
 namespace hft_test {
 
@@ -24,10 +28,45 @@ void signalHandler(int signal) {
     }
 }
 
+// Percentile summary, matching the server's latency report
+void printHistogram(const char* label, const hft::LatencyHistogram& histogram) {
+    std::cout << "  " << label << " (" << histogram.count() << " samples):" << std::endl;
+    if (histogram.count() == 0) return;
+    std::cout << "    avg " << histogram.mean() / 1000.0
+              << " p50 " << histogram.percentile(0.50) / 1000.0
+              << " p90 " << histogram.percentile(0.90) / 1000.0
+              << " p99 " << histogram.percentile(0.99) / 1000.0
+              << " p99.9 " << histogram.percentile(0.999) / 1000.0
+              << " p99.99 " << histogram.percentile(0.9999) / 1000.0
+              << " max " << histogram.max() / 1000.0 << " μs" << std::endl;
+}
+
+// Session traffic seen by a client that logged in
+struct SessionCounters {
+    size_t heartbeats_received{0};
+    size_t heartbeats_sent{0};
+    size_t market_data{0};
+    size_t logouts{0};
+    
+    void merge(const SessionCounters& other) {
+        heartbeats_received += other.heartbeats_received;
+        heartbeats_sent += other.heartbeats_sent;
+        market_data += other.market_data;
+        logouts += other.logouts;
+    }
+};
+
+void printSession(const std::string& label, const SessionCounters& counters) {
+    std::cout << "  " << label << ": " << counters.heartbeats_received << " heartbeats received, "
+              << counters.heartbeats_sent << " sent, " << counters.market_data << " market data, "
+              << counters.logouts << " LOGOUT(s) received" << std::endl;
+}
+
 class TestClient {
 public:
     TestClient(const std::string& server_ip, int port) 
-        : server_ip_(server_ip), port_(port), connected_(false), client_fd_(-1) {
+        : server_ip_(server_ip), port_(port), client_fd_(-1), connected_(false),
+          rx_(RECEIVE_BUFFER_SIZE) {
         // Setup signal handlers
         signal(SIGINT, signalHandler);
         signal(SIGTERM, signalHandler);
@@ -118,59 +157,185 @@ public:
     }
     
     bool sendMessage(const std::shared_ptr<hft::Message>& message) {
+        return sendMessage(*message);
+    }
+    
+    // Frames into a stack buffer; every message type is fixed layout
+    bool sendMessage(const hft::Message& message) {
         if (!connected_) {
             std::cerr << "[Client] Not connected to server" << std::endl;
             return false;
         }
         
-        auto data = message->serialize();
-        ssize_t sent = send(client_fd_, data.data(), data.size(), MSG_NOSIGNAL);
+        char frame[hft::FRAME_HEADER_SIZE + MAX_MESSAGE_SIZE];
+        size_t payload_length = message.serializedSize();
+        if (payload_length > MAX_MESSAGE_SIZE) {
+            std::cerr << "[Client] Message too large: " << payload_length << " bytes" << std::endl;
+            return false;
+        }
+        hft::encodeFrameHeader(static_cast<uint32_t>(payload_length), reinterpret_cast<uint8_t*>(frame));
+        message.serializeInto(frame + hft::FRAME_HEADER_SIZE);
+        size_t frame_length = hft::FRAME_HEADER_SIZE + payload_length;
+        
+        ssize_t sent = send(client_fd_, frame, frame_length, MSG_NOSIGNAL);
         
         if (sent < 0) {
             std::cerr << "[Client] Failed to send message: " << strerror(errno) << std::endl;
             return false;
         }
         
-        if (sent != static_cast<ssize_t>(data.size())) {
-            std::cerr << "[Client] Partial send: " << sent << "/" << data.size() << " bytes" << std::endl;
+        if (sent != static_cast<ssize_t>(frame_length)) {
+            std::cerr << "[Client] Partial send: " << sent << "/" << frame_length << " bytes" << std::endl;
+            return false;
+        }
+        
+        if (logged_in_) {
+            last_tx_ns_ = hft::TscClock::nowNanos();
+        }
+        return true;
+    }
+    
+    // Next sequence number for an outbound message, and the session's client
+    // id once logged in. Without a session the numbers just count up from 1.
+    uint64_t stamp(hft::Message& message) {
+        if (logged_in_) {
+            message.setClientId(client_id_);
+        }
+        uint64_t sequence = next_sequence_++;
+        message.setSequenceNumber(sequence);
+        return sequence;
+    }
+    
+    // Sends LOGIN and waits for the server's answer; false if it refused or
+    // never replied. heartbeat_ms 0 takes the server's default interval.
+    bool login(uint64_t client_id, uint32_t heartbeat_ms, bool market_data) {
+        hft::LoginMessage login(client_id, heartbeat_ms);
+        login.setSequenceNumber(0);     // The session's own numbering starts after the login
+        login.setFlags(market_data ? hft::wire::LOGIN_MARKET_DATA : 0);
+        if (!sendMessage(login)) {
             return false;
         }
         
+        size_t logouts = session_.logouts;
+        uint64_t deadline_ns = hft::TscClock::nowNanos() + ACK_TIMEOUT_NS;
+        auto ignore = [](const hft::OrderAckMessage&, uint64_t) {};
+        while (!logged_in_ && session_.logouts == logouts && g_running) {
+            if (!pollAcks(ignore) || hft::TscClock::nowNanos() > deadline_ns) break;
+        }
+        if (!logged_in_) {
+            std::cerr << "[Client] Login as client " << client_id << " was refused or timed out" << std::endl;
+            return false;
+        }
+        std::cout << "[Client] Logged in as client " << client_id_ << ", heartbeat " << heartbeat_ms_ << " ms"
+                  << (market_data ? ", market data on" : "") << std::endl;
         return true;
     }
     
+    // Sends LOGOUT and waits for the server's, reading whatever is still in flight
+    void logout() {
+        if (!logged_in_ || !connected_) return;
+        
+        hft::LogoutMessage logout(client_id_, hft::LogoutReason::NORMAL);
+        stamp(logout);
+        size_t logouts = session_.logouts;
+        if (!sendMessage(logout)) return;
+        
+        uint64_t deadline_ns = hft::TscClock::nowNanos() + ACK_TIMEOUT_NS;
+        auto ignore = [](const hft::OrderAckMessage&, uint64_t) {};
+        while (session_.logouts == logouts && g_running) {
+            if (!pollAcks(ignore) || hft::TscClock::nowNanos() > deadline_ns) break;
+        }
+        if (session_.logouts == logouts) {
+            std::cerr << "[Client] No LOGOUT from the server for client " << client_id_ << std::endl;
+        }
+    }
+    
+    // Reads whatever has arrived without blocking and hands each ORDER_ACK to
+    // on_ack. Session frames are handled here: the LOGIN reply opens the
+    // session, a HEARTBEAT is answered, a LOGOUT ends it, and MARKET_DATA is
+    // counted; fills are skipped. While logged in, a heartbeat also goes out
+    // whenever this side has been silent for an interval. False once the
+    // connection is closed or the stream is malformed.
+    template<typename OnAck>
+    bool pollAcks(OnAck on_ack) {
+        while (connected_) {
+            ssize_t n = recv(client_fd_, rx_.writePtr(), rx_.writable(), MSG_DONTWAIT);
+            if (n == 0) return false;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            rx_.commit(static_cast<size_t>(n));
+            uint64_t now_ns = hft::TscClock::nowNanos();
+            
+            while (rx_.readable() >= hft::FRAME_HEADER_SIZE) {
+                uint32_t payload_length = hft::decodeFrameHeader(reinterpret_cast<const uint8_t*>(rx_.readPtr()));
+                if (payload_length == 0 || payload_length > hft::MAX_FRAME_SIZE) {
+                    std::cerr << "[Client] Malformed frame from server" << std::endl;
+                    return false;
+                }
+                if (rx_.readable() < hft::FRAME_HEADER_SIZE + payload_length) break;
+                
+                const char* payload = rx_.readPtr() + hft::FRAME_HEADER_SIZE;
+                hft::MessageView view(payload, payload_length);
+                if (view.valid()) {
+                    onFrame(view, now_ns, on_ack);
+                }
+                rx_.consume(hft::FRAME_HEADER_SIZE + payload_length);
+            }
+            rx_.compact();
+            keepAlive(now_ns);
+        }
+        return false;
+    }
+    
+    // Closed loop: one order in flight, timed from send until its ack arrives
     void runLatencyTest(size_t message_count) {
         if (!connected_) {
             std::cerr << "[Client] Not connected to server" << std::endl;
             return;
         }
         
-        std::cout << "[Client] Running latency test with " << message_count << " messages..." << std::endl;
+        std::cout << "[Client] Running round-trip latency test with " << message_count << " orders..." << std::endl;
         
-        std::vector<double> latencies;
-        latencies.reserve(message_count);
+        hft::TscClock::calibrate();
+        hft::LatencyHistogram rtt;
+        size_t rejected = 0;
+        size_t timed_out = 0;
         
-        auto order_msg = std::make_shared<hft::OrderMessage>(12345, "AAPL", 150.50, 100, true);
+        hft::OrderMessage order(1, "AAPL", 150.50, 100, true);
         
         for (size_t i = 0; i < message_count && g_running; ++i) {
-            // Update message for each iteration
-            order_msg->setSequenceNumber(i + 1);
-            order_msg->setTimestamp(std::chrono::duration_cast<std::chrono::microseconds>(
-                std::chrono::high_resolution_clock::now().time_since_epoch()).count());
+            // Alternate sides at one price so the book stays flat
+            uint64_t sequence = stamp(order);
+            order.setOrderId(sequence);
+            order.setBuy(i % 2 == 0);
+            order.setTimestamp(hft::TscClock::wallNanos() / 1000);
             
-            auto start_time = std::chrono::high_resolution_clock::now();
-            
-            if (!sendMessage(order_msg)) {
+            uint64_t sent_ns = hft::TscClock::nowNanos();
+            if (!sendMessage(order)) {
                 std::cerr << "[Client] Failed to send message " << i << std::endl;
-                continue;
+                break;
             }
             
-            auto end_time = std::chrono::high_resolution_clock::now();
-            auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
-            latencies.push_back(latency / 1000.0); // Convert to microseconds
-            
-            // Small delay to avoid overwhelming the server
-            std::this_thread::sleep_for(std::chrono::microseconds(10));
+            bool acked = false;
+            uint64_t deadline_ns = sent_ns + ACK_TIMEOUT_NS;
+            while (!acked && g_running) {
+                bool open = pollAcks([&](const hft::OrderAckMessage& ack, uint64_t now_ns) {
+                    if (ack.getClientSequence() != sequence) return;
+                    rtt.record(now_ns - sent_ns);
+                    if (ack.getStatus() != hft::AckStatus::ACCEPTED) ++rejected;
+                    acked = true;
+                });
+                if (!open) {
+                    std::cerr << "[Client] Connection lost waiting for ack " << sequence << std::endl;
+                    return;
+                }
+                if (!acked && hft::TscClock::nowNanos() > deadline_ns) {
+                    ++timed_out;
+                    break;
+                }
+            }
             
             // Progress indicator
             if ((i + 1) % 1000 == 0) {
@@ -178,40 +343,21 @@ public:
             }
         }
         
-        if (latencies.empty()) {
-            std::cerr << "[Client] No messages were sent successfully" << std::endl;
-            return;
-        }
-        
-        // Calculate statistics
-        std::sort(latencies.begin(), latencies.end());
+        std::cout << "\n[Client] Latency Test Results:" << std::endl;
+        std::cout << "  Orders Acked: " << rtt.count() << " (" << rejected << " rejected, "
+                  << timed_out << " timed out)" << std::endl;
+        printHistogram("Round trip μs", rtt);
         
-        double sum = 0.0;
-        for (double latency : latencies) {
-            sum += latency;
+        if (rtt.count() == 0) {
+            std::cerr << "[Client] No acks were received" << std::endl;
+            return;
         }
         
-        double avg_latency = sum / latencies.size();
-        double p50_latency = latencies[latencies.size() * 0.5];
-        double p95_latency = latencies[latencies.size() * 0.95];
-        double p99_latency = latencies[latencies.size() * 0.99];
-        double min_latency = latencies.front();
-        double max_latency = latencies.back();
-        
-        std::cout << "\n[Client] Latency Test Results:" << std::endl;
-        std::cout << "  Messages Sent: " << latencies.size() << std::endl;
-        std::cout << "  Average Latency: " << avg_latency << " μs" << std::endl;
-        std::cout << "  P50 Latency: " << p50_latency << " μs" << std::endl;
-        std::cout << "  P95 Latency: " << p95_latency << " μs" << std::endl;
-        std::cout << "  P99 Latency: " << p99_latency << " μs" << std::endl;
-        std::cout << "  Min Latency: " << min_latency << " μs" << std::endl;
-        std::cout << "  Max Latency: " << max_latency << " μs" << std::endl;
-        
         // Check if we meet the 10 microsecond target
-        if (avg_latency < 10.0) {
-            std::cout << "  ✓ Target achieved: Average latency < 10 μs" << std::endl;
+        if (rtt.mean() < 10000.0) {
+            std::cout << "  ✓ Target achieved: Average round trip < 10 μs" << std::endl;
         } else {
-            std::cout << "  ✗ Target missed: Average latency >= 10 μs" << std::endl;
+            std::cout << "  ✗ Target missed: Average round trip >= 10 μs" << std::endl;
         }
     }
     
@@ -243,7 +389,7 @@ public:
             
             // Update message
             auto& msg = messages[msg_index % messages.size()];
-            msg->setSequenceNumber(messages_sent + 1);
+            stamp(*msg);
             msg->setTimestamp(std::chrono::duration_cast<std::chrono::microseconds>(
                 now.time_since_epoch()).count());
             
@@ -307,7 +453,7 @@ public:
             }
             
             // Update message
-            order_msg->setSequenceNumber(messages_sent + 1);
+            stamp(*order_msg);
             order_msg->setTimestamp(std::chrono::duration_cast<std::chrono::microseconds>(
                 now.time_since_epoch()).count());
             
@@ -342,6 +488,9 @@ public:
     }
     
     bool isConnected() const { return connected_; }
+    bool isLoggedIn() const { return logged_in_; }
+    uint64_t getClientId() const { return client_id_; }
+    const SessionCounters& getSessionCounters() const { return session_; }
     
     void waitForConnection(int max_retries = 10) {
         for (int i = 0; i < max_retries && !connected_; ++i) {
@@ -353,13 +502,282 @@ public:
         }
     }
 
+    static constexpr size_t MAX_MESSAGE_SIZE = 128;
+    static constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+    static constexpr uint64_t ACK_TIMEOUT_NS = 1000000000ull;
+
 private:
+    template<typename OnAck>
+    void onFrame(const hft::MessageView& view, uint64_t now_ns, OnAck& on_ack) {
+        switch (view.getType()) {
+            case hft::MessageType::ORDER_ACK: {
+                hft::OrderAckMessage ack;
+                if (ack.deserialize(view.data(), view.length())) {
+                    on_ack(ack, now_ns);
+                }
+                break;
+            }
+            case hft::MessageType::LOGIN: {
+                hft::LoginMessage reply;
+                if (reply.deserialize(view.data(), view.length())) {
+                    client_id_ = reply.getClientId();
+                    heartbeat_ms_ = reply.getHeartbeatIntervalMs();
+                    logged_in_ = true;
+                    last_tx_ns_ = now_ns;
+                }
+                break;
+            }
+            case hft::MessageType::HEARTBEAT:
+                ++session_.heartbeats_received;
+                sendHeartbeat();
+                break;
+            case hft::MessageType::LOGOUT: {
+                hft::LogoutMessage logout;
+                if (logout.deserialize(view.data(), view.length()) &&
+                    logout.getReason() != hft::LogoutReason::NORMAL) {
+                    std::cerr << "[Client] Server ended the session: reason "
+                              << static_cast<int>(logout.getReason()) << std::endl;
+                }
+                ++session_.logouts;
+                logged_in_ = false;
+                break;
+            }
+            case hft::MessageType::MARKET_DATA:
+                ++session_.market_data;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    // Our half of the heartbeat contract: never silent for a whole interval
+    void keepAlive(uint64_t now_ns) {
+        if (logged_in_ && now_ns - last_tx_ns_ >= heartbeat_ms_ * 1000000ull) {
+            sendHeartbeat();
+        }
+    }
+    
+    void sendHeartbeat() {
+        if (!logged_in_) return;
+        hft::HeartbeatMessage heartbeat(client_id_);
+        stamp(heartbeat);
+        if (sendMessage(heartbeat)) {
+            ++session_.heartbeats_sent;
+        }
+    }
+    
     std::string server_ip_;
     int port_;
     int client_fd_;
     bool connected_;
+    hft::FrameBuffer rx_;
+    
+    // Session state; frames are numbered from 1 whether or not one is open
+    uint64_t client_id_{0};
+    uint64_t next_sequence_{1};
+    uint32_t heartbeat_ms_{0};      // Granted by the server's LOGIN reply
+    bool logged_in_{false};
+    uint64_t last_tx_ns_{0};
+    SessionCounters session_;
+};
+
+constexpr size_t TestClient::MAX_MESSAGE_SIZE;
+constexpr size_t TestClient::RECEIVE_BUFFER_SIZE;
+constexpr uint64_t TestClient::ACK_TIMEOUT_NS;
+
+// Client id the main connection logs in with; open-loop sessions take the ones after it
+constexpr uint64_t MAIN_CLIENT_ID = 1;
+
+// Open-loop load: every thread sends orders on a fixed schedule over its
+// own connections whatever the acks are doing, so a server stall delays
+// the orders queued behind it instead of pausing the clock. Latency is
+// taken from each order's scheduled send time, which corrects for
+// coordinated omission, and also from the actual send for comparison.
+class LoadGenerator {
+public:
+    LoadGenerator(const std::string& server_ip, int port, double rate, size_t duration_seconds,
+                  size_t connection_count, size_t thread_count)
+        : server_ip_(server_ip), port_(port), rate_(rate), duration_seconds_(duration_seconds),
+          connection_count_(std::max<size_t>(connection_count, 1)),
+          thread_count_(std::max<size_t>(std::min(thread_count, connection_count_), 1)) {}
+    
+    // Log every connection in before the run and out after it
+    void setLogin(uint32_t heartbeat_ms, bool market_data) {
+        login_ = true;
+        heartbeat_ms_ = heartbeat_ms;
+        market_data_ = market_data;
+    }
+    
+    bool run() {
+        std::cout << "[Client] Running open-loop test: " << rate_ << " orders/s for " << duration_seconds_
+                  << "s over " << connection_count_ << " connection(s) on " << thread_count_ << " thread(s)..." << std::endl;
+        
+        hft::TscClock::calibrate();
+        std::vector<std::unique_ptr<Session>> sessions;
+        for (size_t i = 0; i < connection_count_; ++i) {
+            std::unique_ptr<Session> session(new Session(server_ip_, port_, MAIN_CLIENT_ID + 1 + i));
+            if (!session->client.connect()) {
+                std::cerr << "[Client] Failed to open connection " << (i + 1) << std::endl;
+                return false;
+            }
+            if (login_ && !session->client.login(session->order.getClientId(), heartbeat_ms_, market_data_)) {
+                return false;
+            }
+            sessions.push_back(std::move(session));
+        }
+        
+        // Connections are dealt out round robin; each thread paces its share of the rate
+        std::vector<std::unique_ptr<Result>> results;
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < thread_count_; ++t) {
+            std::vector<Session*> owned;
+            for (size_t i = t; i < sessions.size(); i += thread_count_) {
+                owned.push_back(sessions[i].get());
+            }
+            results.emplace_back(new Result());
+            threads.emplace_back(&LoadGenerator::runWorker, this, owned, rate_ / thread_count_, results.back().get());
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        
+        SessionCounters session_total;
+        for (const auto& session : sessions) {
+            session->client.logout();
+            session_total.merge(session->client.getSessionCounters());
+        }
+        
+        Result total;
+        for (const auto& result : results) {
+            total.corrected.merge(result->corrected);
+            total.uncorrected.merge(result->uncorrected);
+            total.scheduled += result->scheduled;
+            total.sent += result->sent;
+            total.rejected += result->rejected;
+            total.send_ns = std::max(total.send_ns, result->send_ns);
+        }
+        
+        double achieved_rate = total.send_ns > 0 ? total.sent * 1e9 / total.send_ns : 0.0;
+        std::cout << "\n[Client] Open-Loop Test Results:" << std::endl;
+        std::cout << "  Orders Scheduled: " << total.scheduled << std::endl;
+        std::cout << "  Orders Sent: " << total.sent << std::endl;
+        std::cout << "  Orders Acked: " << total.corrected.count() << " (" << total.rejected << " rejected, "
+                  << (total.sent - total.corrected.count()) << " unanswered)" << std::endl;
+        std::cout << "  Target Rate: " << rate_ << " orders/s" << std::endl;
+        std::cout << "  Actual Rate: " << achieved_rate << " orders/s" << std::endl;
+        printHistogram("Response time μs (from scheduled send)", total.corrected);
+        printHistogram("Service time μs (from actual send)", total.uncorrected);
+        if (login_) {
+            printSession("Sessions", session_total);
+        }
+        return true;
+    }
+
+private:
+    // Sent orders awaiting their ack, indexed by sequence number
+    struct Pending {
+        uint64_t sequence{0};
+        uint64_t intended_ns{0};
+        uint64_t sent_ns{0};
+    };
+    
+    struct Session {
+        Session(const std::string& server_ip, int port, uint64_t client_id)
+            : client(server_ip, port), pending(PENDING_WINDOW), order(1, "AAPL", 150.50, 100, true) {
+            order.setClientId(client_id);
+        }
+        
+        TestClient client;
+        std::vector<Pending> pending;
+        hft::OrderMessage order;
+        bool open{true};
+    };
+    
+    struct Result {
+        hft::LatencyHistogram corrected;
+        hft::LatencyHistogram uncorrected;
+        size_t scheduled{0};
+        size_t sent{0};
+        size_t rejected{0};
+        uint64_t send_ns{0};
+    };
+    
+    void runWorker(std::vector<Session*> sessions, double rate, Result* result) {
+        const double interval_ns = 1e9 / rate;
+        const uint64_t start_ns = hft::TscClock::nowNanos();
+        const uint64_t end_ns = start_ns + duration_seconds_ * 1000000000ull;
+        uint64_t next_ns = start_ns;
+        size_t outstanding = 0;
+        size_t turn = 0;
+        
+        while (g_running) {
+            uint64_t now_ns = hft::TscClock::nowNanos();
+            
+            // Catch up on every send that has come due; late sends keep their scheduled time
+            while (next_ns <= now_ns && next_ns < end_ns) {
+                Session& session = *sessions[turn++ % sessions.size()];
+                ++result->scheduled;
+                if (session.open && send(session, next_ns)) {
+                    ++result->sent;
+                    ++outstanding;
+                }
+                next_ns = start_ns + static_cast<uint64_t>(result->scheduled * interval_ns);
+            }
+            if (next_ns >= end_ns) {
+                if (result->send_ns == 0) result->send_ns = now_ns - start_ns;
+                if (outstanding == 0 || now_ns > end_ns + TestClient::ACK_TIMEOUT_NS) break;
+            }
+            
+            for (Session* session : sessions) {
+                if (!session->open) continue;
+                session->open = session->client.pollAcks([&](const hft::OrderAckMessage& ack, uint64_t ack_ns) {
+                    Pending& pending = session->pending[ack.getClientSequence() & (PENDING_WINDOW - 1)];
+                    if (pending.sequence != ack.getClientSequence()) return;
+                    result->corrected.record(ack_ns - pending.intended_ns);
+                    result->uncorrected.record(ack_ns - pending.sent_ns);
+                    if (ack.getStatus() != hft::AckStatus::ACCEPTED) ++result->rejected;
+                    pending.sequence = 0;
+                    --outstanding;
+                });
+            }
+        }
+    }
+    
+    bool send(Session& session, uint64_t intended_ns) {
+        hft::OrderMessage& order = session.order;
+        uint64_t sequence = session.client.stamp(order);
+        order.setOrderId((order.getClientId() << 40) | sequence);
+        order.setBuy(sequence % 2 == 0);
+        order.setTimestamp(hft::TscClock::wallNanos() / 1000);
+        
+        // An order still unanswered a whole window later is written off
+        Pending& pending = session.pending[sequence & (PENDING_WINDOW - 1)];
+        pending.sequence = sequence;
+        pending.intended_ns = intended_ns;
+        pending.sent_ns = hft::TscClock::nowNanos();
+        if (!session.client.sendMessage(order)) {
+            pending.sequence = 0;
+            session.open = false;
+            return false;
+        }
+        return true;
+    }
+    
+    static constexpr size_t PENDING_WINDOW = 65536;     // Power of two
+    
+    std::string server_ip_;
+    int port_;
+    double rate_;
+    size_t duration_seconds_;
+    size_t connection_count_;
+    size_t thread_count_;
+    bool login_{false};
+    uint32_t heartbeat_ms_{0};
+    bool market_data_{false};
 };
 
+constexpr size_t LoadGenerator::PENDING_WINDOW;
+
 void printUsage() {
     std::cout << "HFT Test Client - Enhanced Version" << std::endl;
     std::cout << "Usage: ./test_client <server_ip> <port> [options]" << std::endl;
@@ -367,6 +785,12 @@ void printUsage() {
     std::cout << "  -l <count>           Latency test with <count> messages" << std::endl;
     std::cout << "  -t <count> <seconds> Throughput test" << std::endl;
     std::cout << "  -s <count> <seconds> Stress test" << std::endl;
+    std::cout << "  -o <rate> <seconds>  Open-loop test: orders/s on a fixed schedule, acks timed" << std::endl;
+    std::cout << "  -c <connections>     Connections for the open-loop test (default: 1)" << std::endl;
+    std::cout << "  -n <threads>         Sending threads for the open-loop test (default: 1)" << std::endl;
+    std::cout << "  --login [hb_ms]      Log in (client " << MAIN_CLIENT_ID << ", open-loop connections after it), answer" << std::endl;
+    std::cout << "                       heartbeats and log out at the end; hb_ms 0 takes the server's interval" << std::endl;
+    std::cout << "  --market-data        With --login, ask the server to stream quotes to each session" << std::endl;
     std::cout << "  -w                   Wait for server to be ready" << std::endl;
     std::cout << "  -h                   Show this help" << std::endl;
     std::cout << std::endl;
@@ -374,7 +798,9 @@ void printUsage() {
     std::cout << "  ./test_client 127.0.0.1 8080 -l 10000" << std::endl;
     std::cout << "  ./test_client 127.0.0.1 8080 -t 100000 10" << std::endl;
     std::cout << "  ./test_client 127.0.0.1 8080 -s 50000 5" << std::endl;
+    std::cout << "  ./test_client 127.0.0.1 8080 -o 100000 10 -c 8 -n 2" << std::endl;
     std::cout << "  ./test_client 127.0.0.1 8080 -w -l 1000" << std::endl;
+    std::cout << "  ./test_client 127.0.0.1 8080 --login 200 -l 1000" << std::endl;
 }
 
 } // namespace hft_test
@@ -396,7 +822,14 @@ int main(int argc, char* argv[]) {
     size_t throughput_duration = 0;
     size_t stress_count = 0;
     size_t stress_duration = 0;
+    double open_loop_rate = 0.0;
+    size_t open_loop_duration = 0;
+    size_t connection_count = 1;
+    size_t sender_threads = 1;
     bool wait_for_server = false;
+    bool login = false;
+    uint32_t heartbeat_ms = 0;
+    bool market_data = false;
     
     for (int i = 3; i < argc; ++i) {
         std::string arg = argv[i];
@@ -411,8 +844,23 @@ int main(int argc, char* argv[]) {
         } else if (arg == "-s" && i + 2 < argc) {
             stress_count = std::stoul(argv[++i]);
             stress_duration = std::stoul(argv[++i]);
+        } else if (arg == "-o" && i + 2 < argc) {
+            open_loop_rate = std::stod(argv[++i]);
+            open_loop_duration = std::stoul(argv[++i]);
+        } else if (arg == "-c" && i + 1 < argc) {
+            connection_count = std::stoul(argv[++i]);
+        } else if (arg == "-n" && i + 1 < argc) {
+            sender_threads = std::stoul(argv[++i]);
         } else if (arg == "-w") {
             wait_for_server = true;
+        } else if (arg == "--login") {
+            login = true;
+            // The interval is optional
+            if (i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9') {
+                heartbeat_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+        } else if (arg == "--market-data") {
+            market_data = true;
         }
     }
     
@@ -421,7 +869,9 @@ int main(int argc, char* argv[]) {
     std::cout << "Latency Test: " << (latency_count > 0 ? std::to_string(latency_count) + " messages" : "disabled") << std::endl;
     std::cout << "Throughput Test: " << (throughput_count > 0 ? std::to_string(throughput_count) + " messages over " + std::to_string(throughput_duration) + "s" : "disabled") << std::endl;
     std::cout << "Stress Test: " << (stress_count > 0 ? std::to_string(stress_count) + " messages over " + std::to_string(stress_duration) + "s" : "disabled") << std::endl;
+    std::cout << "Open-Loop Test: " << (open_loop_rate > 0 ? std::to_string(static_cast<uint64_t>(open_loop_rate)) + " orders/s over " + std::to_string(open_loop_duration) + "s, " + std::to_string(connection_count) + " connection(s), " + std::to_string(sender_threads) + " thread(s)" : "disabled") << std::endl;
     std::cout << "Wait for Server: " << (wait_for_server ? "enabled" : "disabled") << std::endl;
+    std::cout << "Session: " << (login ? "login, heartbeat " + (heartbeat_ms > 0 ? std::to_string(heartbeat_ms) + " ms" : std::string("server default")) + (market_data ? ", market data" : "") : "none") << std::endl;
     std::cout << "======================" << std::endl;
     
     TestClient client(server_ip, port);
@@ -435,6 +885,10 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (login && !client.login(MAIN_CLIENT_ID, heartbeat_ms, market_data)) {
+        return 1;
+    }
+    
     try {
         // Run latency test
         if (latency_count > 0) {
@@ -451,8 +905,21 @@ int main(int argc, char* argv[]) {
             client.runStressTest(stress_count, stress_duration);
         }
         
+        // Open-loop test runs on its own connections; the main session ends
+        // first rather than sit silent through it
+        if (open_loop_rate > 0 && open_loop_duration > 0) {
+            client.logout();
+            LoadGenerator generator(server_ip, port, open_loop_rate, open_loop_duration, connection_count, sender_threads);
+            if (login) {
+                generator.setLogin(heartbeat_ms, market_data);
+            }
+            if (!generator.run()) {
+                return 1;
+            }
+        }
+        
         // If no tests specified, run a simple demo
-        if (latency_count == 0 && throughput_count == 0 && stress_count == 0) {
+        if (latency_count == 0 && throughput_count == 0 && stress_count == 0 && open_loop_rate <= 0) {
             std::cout << "\n[Main] Running demo mode..." << std::endl;
             
             // Send a few test messages
@@ -460,6 +927,8 @@ int main(int argc, char* argv[]) {
             auto md_msg = std::make_shared<hft::MarketDataMessage>("AAPL", 150.45, 150.55, 1000, 1000);
             
             std::cout << "[Main] Sending test messages..." << std::endl;
+            client.stamp(*order_msg);
+            client.stamp(*md_msg);
             
             if (client.sendMessage(order_msg)) {
                 std::cout << "[Main] Order message sent successfully" << std::endl;
@@ -469,8 +938,12 @@ int main(int argc, char* argv[]) {
                 std::cout << "[Main] Market data message sent successfully" << std::endl;
             }
             
-            // Wait a bit
-            std::this_thread::sleep_for(std::chrono::seconds(2));
+            // Wait a bit, still answering heartbeats if logged in
+            auto idle_until = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+            auto ignore = [](const hft::OrderAckMessage&, uint64_t) {};
+            while (std::chrono::steady_clock::now() < idle_until && g_running && client.pollAcks(ignore)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
         }
         
     } catch (const std::exception& e) {
@@ -478,6 +951,12 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (login) {
+        client.logout();
+        std::cout << "\n[Main] Session:" << std::endl;
+        printSession("Client " + std::to_string(MAIN_CLIENT_ID), client.getSessionCounters());
+    }
+    
     std::cout << "\n[Main] Test completed successfully" << std::endl;
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "../include/thread_slot.hpp"
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace hft {
+
+namespace {
+
+std::mutex& slotMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Released slots are reused before new ones are handed out
+std::vector<size_t>& freeSlots() {
+    static std::vector<size_t>* slots = new std::vector<size_t>();
+    return *slots;
+}
+
+size_t next_slot = 0;
+
+size_t acquireSlot() {
+    std::lock_guard<std::mutex> lock(slotMutex());
+    auto& free_slots = freeSlots();
+    if (!free_slots.empty()) {
+        size_t slot = free_slots.back();
+        free_slots.pop_back();
+        return slot;
+    }
+    
+    size_t slot = next_slot++;
+    if (slot >= MAX_THREAD_SLOTS) {
+        std::cerr << "[ThreadSlot] More than " << MAX_THREAD_SLOTS
+                  << " live threads; per-thread tables are now shared" << std::endl;
+    }
+    return slot % MAX_THREAD_SLOTS;
+}
+
+struct ThreadSlot {
+    size_t index;
+    ThreadSlot() : index(acquireSlot()) {}
+    ~ThreadSlot() {
+        std::lock_guard<std::mutex> lock(slotMutex());
+        freeSlots().push_back(index);
+    }
+};
+
+} // namespace
+
+size_t currentThreadSlot() {
+    static thread_local ThreadSlot slot;
+    return slot.index;
+}
+
+} // namespace hft
@@ -0,0 +1,93 @@
+#include "../include/timer_wheel.hpp"
+
+namespace hft {
+
+constexpr unsigned TimerWheel::LEVEL_BITS;
+constexpr size_t TimerWheel::SLOTS;
+constexpr unsigned TimerWheel::LEVELS;
+constexpr uint64_t TimerWheel::MAX_DELAY;
+
+TimerWheel::TimerWheel(uint64_t start_tick) : now_(start_tick) {
+    for (unsigned level = 0; level < LEVELS; ++level) {
+        for (size_t slot = 0; slot < SLOTS; ++slot) {
+            slots_[level][slot].next = &slots_[level][slot];
+            slots_[level][slot].prev = &slots_[level][slot];
+        }
+    }
+}
+
+void TimerWheel::schedule(Timer& timer, uint64_t delay) {
+    if (timer.armed()) {
+        unlink(timer);
+    } else {
+        ++count_;
+    }
+    timer.expiry = now_ + (delay > 0 ? delay : 1);
+    insert(timer);
+}
+
+void TimerWheel::cancel(Timer& timer) {
+    if (!timer.armed()) return;
+    unlink(timer);
+    --count_;
+}
+
+void TimerWheel::insert(Timer& timer) {
+    // Placed relative to the next tick to be processed, as advance() cascades
+    uint64_t base = now_ + 1;
+    uint64_t delta = timer.expiry - base;
+    if (delta > MAX_DELAY) {
+        timer.expiry = base + MAX_DELAY;
+        delta = MAX_DELAY;
+    }
+    
+    unsigned level = 0;
+    while (level + 1 < LEVELS && delta >= (1ull << (LEVEL_BITS * (level + 1)))) {
+        ++level;
+    }
+    
+    Timer& head = slots_[level][(timer.expiry >> (LEVEL_BITS * level)) & (SLOTS - 1)];
+    timer.next = &head;
+    timer.prev = head.prev;
+    head.prev->next = &timer;
+    head.prev = &timer;
+}
+
+void TimerWheel::cascade(uint64_t tick) {
+    // Level L wraps when the L lower levels all do; its due slot is
+    // redistributed below before level 0 fires this tick
+    for (unsigned level = 1; level < LEVELS; ++level) {
+        size_t index = (tick >> (LEVEL_BITS * level)) & (SLOTS - 1);
+        Timer pending;
+        takeSlot(slots_[level][index], pending);
+        while (pending.next != &pending) {
+            Timer& timer = *pending.next;
+            unlink(timer);
+            insert(timer);
+        }
+        if (index != 0) break;
+    }
+}
+
+void TimerWheel::unlink(Timer& timer) {
+    timer.prev->next = timer.next;
+    timer.next->prev = timer.prev;
+    timer.next = nullptr;
+    timer.prev = nullptr;
+}
+
+void TimerWheel::takeSlot(Timer& slot, Timer& out) {
+    if (slot.next == &slot) {
+        out.next = &out;
+        out.prev = &out;
+        return;
+    }
+    out.next = slot.next;
+    out.prev = slot.prev;
+    out.next->prev = &out;
+    out.prev->next = &out;
+    slot.next = &slot;
+    slot.prev = &slot;
+}
+
+} // namespace hft
@@ -0,0 +1,55 @@
+#include "../include/tsc_clock.hpp"
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace hft {
+
+bool TscClock::hasInvariantTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    // CPUID 0x80000007 EDX bit 8: the TSC ticks at a constant rate across
+    // P-, C- and T-states; without it tick deltas are not time
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+TscClock::Calibration TscClock::measure() {
+    Calibration cal;
+    cal.invariant_tsc = hasInvariantTsc();
+    cal.ticks_per_ns = 1.0;
+    cal.base_ns = fallbackNanos();
+    cal.base_ticks = cal.base_ns;
+    
+#if defined(__x86_64__) || defined(__i386__)
+    if (cal.invariant_tsc) {
+        // Bracket a short sleep with paired reads; 20ms keeps the error well
+        // under 0.1% without noticeably delaying startup. Raw reads: now()
+        // consults the calibration being built here.
+        unsigned int aux;
+        uint64_t start_ns = fallbackNanos();
+        uint64_t start_ticks = __rdtscp(&aux);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t end_ns = fallbackNanos();
+        uint64_t end_ticks = __rdtscp(&aux);
+        
+        double ticks_per_ns = static_cast<double>(end_ticks - start_ticks) /
+                              static_cast<double>(end_ns - start_ns);
+        cal.ticks_per_ns = ticks_per_ns > 0.0 ? ticks_per_ns : 1.0;
+        cal.base_ticks = end_ticks;
+        cal.base_ns = end_ns;
+    }
+#endif
+    
+    cal.ns_per_tick = 1.0 / cal.ticks_per_ns;
+    cal.base_wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    return cal;
+}
+
+} // namespace hft
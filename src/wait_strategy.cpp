@@ -0,0 +1,140 @@
+#include "../include/wait_strategy.hpp"
+#include <climits>
+#include <ctime>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace hft {
+
+constexpr uint32_t WaitStrategy::SPIN_LIMIT;
+constexpr uint32_t WaitStrategy::YIELD_LIMIT;
+constexpr uint32_t WaitStrategy::PARK_TIMEOUT_US;
+
+namespace {
+
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected, uint32_t timeout_us) {
+    struct timespec timeout;
+    timeout.tv_sec = timeout_us / 1000000;
+    timeout.tv_nsec = (timeout_us % 1000000) * 1000;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, expected, &timeout, nullptr, 0);
+}
+
+void futexWakeAll(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+} // namespace
+
+bool parseWaitStrategy(const std::string& name, WaitStrategyType& type) {
+    if (name == "spin") {
+        type = WaitStrategyType::BUSY_SPIN;
+    } else if (name == "yield") {
+        type = WaitStrategyType::SPIN_YIELD;
+    } else if (name == "park") {
+        type = WaitStrategyType::SPIN_PARK;
+    } else if (name == "busy-poll") {
+        type = WaitStrategyType::BUSY_POLL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* waitStrategyName(WaitStrategyType type) {
+    switch (type) {
+        case WaitStrategyType::BUSY_SPIN: return "spin";
+        case WaitStrategyType::SPIN_YIELD: return "yield";
+        case WaitStrategyType::SPIN_PARK: return "park";
+        case WaitStrategyType::BUSY_POLL: return "busy-poll";
+    }
+    return "unknown";
+}
+
+// WaitNotifier implementation
+void WaitNotifier::notify() {
+    // Pairs with the fence in prepareWait(): either this sees the waiter or
+    // the waiter's re-check sees what was published before the call
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0) return;
+    
+    epoch_.fetch_add(1, std::memory_order_release);
+    futexWakeAll(&epoch_);
+}
+
+uint32_t WaitNotifier::prepareWait() {
+    waiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_acquire);
+}
+
+void WaitNotifier::cancelWait() {
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void WaitNotifier::commitWait(uint32_t epoch, uint32_t timeout_us) {
+    futexWait(&epoch_, epoch, timeout_us);
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// WaitStrategy implementation
+WaitStrategy::WaitStrategy(WaitStrategyType type, WaitNotifier* notifier)
+    : type_(type), notifier_(notifier) {
+}
+
+WaitStrategy WaitStrategy::forEventLoop(WaitStrategyType type) {
+    WaitStrategy strategy(type);
+    strategy.event_loop_ = true;
+    return strategy;
+}
+
+void WaitStrategy::idle() {
+    if (idle_count_ < YIELD_LIMIT) {
+        ++idle_count_;
+    }
+    
+    switch (type_) {
+        case WaitStrategyType::BUSY_SPIN:
+        case WaitStrategyType::BUSY_POLL:
+            cpuRelax();
+            return;
+        
+        case WaitStrategyType::SPIN_YIELD:
+            if (idle_count_ < SPIN_LIMIT) {
+                cpuRelax();
+            } else {
+                sched_yield();
+            }
+            return;
+        
+        case WaitStrategyType::SPIN_PARK:
+            if (idle_count_ < SPIN_LIMIT) {
+                cpuRelax();
+            } else if (idle_count_ < YIELD_LIMIT) {
+                sched_yield();
+            } else if (event_loop_) {
+                // A futex here could not be woken by the loop's fds; the
+                // next poll blocks in the kernel instead
+                return;
+            } else if (notifier_) {
+                // No re-check to run: a notify racing the park is bounded by the timeout
+                notifier_->commitWait(notifier_->prepareWait(), PARK_TIMEOUT_US);
+            } else {
+                // Nobody will wake us: park on a private word until the timeout
+                std::atomic<uint32_t> word{0};
+                futexWait(&word, 0, PARK_TIMEOUT_US);
+            }
+            return;
+    }
+}
+
+int WaitStrategy::pollTimeoutMs() const {
+    // Only parking loops block; everything else polls with a zero timeout
+    if (type_ == WaitStrategyType::SPIN_PARK && idle_count_ >= YIELD_LIMIT) {
+        return static_cast<int>(PARK_TIMEOUT_US / 1000);
+    }
+    return 0;
+}
+
+} // namespace hft
@@ -0,0 +1,435 @@
+#include "../include/xdp_socket.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/if_xdp.h>) && __has_include(<linux/bpf.h>)
+#define HFT_HAVE_AF_XDP 1
+#endif
+#endif
+
+#ifdef HFT_HAVE_AF_XDP
+#include <linux/if_xdp.h>
+#include <linux/if_link.h>
+#include <linux/bpf.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+#endif
+
+namespace hft {
+
+constexpr uint32_t XdpSocket::FRAME_SIZE;
+constexpr uint32_t XdpSocket::FRAME_COUNT;
+constexpr uint32_t XdpSocket::RX_RING_SIZE;
+constexpr size_t XdpSocket::MAX_BATCH;
+
+#ifdef HFT_HAVE_AF_XDP
+
+namespace {
+
+// Ring indices are shared with the kernel, like io_uring's
+inline uint32_t loadAcquire(const uint32_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+inline void storeRelease(uint32_t* p, uint32_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+int sysBpf(int cmd, union bpf_attr* attr) {
+    return static_cast<int>(syscall(__NR_bpf, cmd, attr, sizeof(*attr)));
+}
+
+// Instruction builders for the redirect program
+bpf_insn insn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+    bpf_insn out;
+    out.code = code;
+    out.dst_reg = dst;
+    out.src_reg = src;
+    out.off = off;
+    out.imm = imm;
+    return out;
+}
+
+bpf_insn loadMem(uint8_t size, uint8_t dst, uint8_t src, int16_t off) {
+    return insn(BPF_LDX | BPF_MEM | size, dst, src, off, 0);
+}
+
+bpf_insn movReg(uint8_t dst, uint8_t src) { return insn(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0); }
+bpf_insn movImm(uint8_t dst, int32_t imm) { return insn(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm); }
+bpf_insn addImm(uint8_t dst, int32_t imm) { return insn(BPF_ALU64 | BPF_ADD | BPF_K, dst, 0, 0, imm); }
+bpf_insn jump(uint8_t op, uint8_t dst, int32_t imm) { return insn(BPF_JMP | op | BPF_K, dst, 0, 0, imm); }
+
+// Frame offsets the program checks: Ethernet, IPv4 without options, UDP
+constexpr int32_t ETH_TYPE_OFFSET = 12;
+constexpr int32_t IP_VERSION_OFFSET = 14;
+constexpr int32_t IP_PROTOCOL_OFFSET = 23;
+constexpr int32_t UDP_DEST_OFFSET = 36;
+constexpr int32_t HEADERS_SIZE = 42;
+
+inline uint16_t swap16(uint16_t value) { return static_cast<uint16_t>((value >> 8) | (value << 8)); }
+
+// XDP_PASS for anything that is not IPv4/UDP to one of the ports; matching
+// datagrams go to the XSKMAP entry of the receiving queue, or to the stack
+// when no socket is bound there. Packet loads are little-endian, so the
+// constants are compared byte-swapped.
+std::vector<bpf_insn> buildRedirectProgram(int map_fd, const std::vector<uint16_t>& ports) {
+    std::vector<bpf_insn> prog;
+    std::vector<size_t> to_pass;
+    std::vector<size_t> to_redirect;
+    
+    prog.push_back(movReg(BPF_REG_6, BPF_REG_1));
+    prog.push_back(loadMem(BPF_W, BPF_REG_2, BPF_REG_1, offsetof(xdp_md, data)));
+    prog.push_back(loadMem(BPF_W, BPF_REG_3, BPF_REG_1, offsetof(xdp_md, data_end)));
+    prog.push_back(movReg(BPF_REG_4, BPF_REG_2));
+    prog.push_back(addImm(BPF_REG_4, HEADERS_SIZE));
+    to_pass.push_back(prog.size());
+    prog.push_back(insn(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0, 0));
+    
+    prog.push_back(loadMem(BPF_H, BPF_REG_5, BPF_REG_2, ETH_TYPE_OFFSET));
+    to_pass.push_back(prog.size());
+    prog.push_back(jump(BPF_JNE, BPF_REG_5, swap16(0x0800)));
+    prog.push_back(loadMem(BPF_B, BPF_REG_5, BPF_REG_2, IP_VERSION_OFFSET));
+    to_pass.push_back(prog.size());
+    prog.push_back(jump(BPF_JNE, BPF_REG_5, 0x45));
+    prog.push_back(loadMem(BPF_B, BPF_REG_5, BPF_REG_2, IP_PROTOCOL_OFFSET));
+    to_pass.push_back(prog.size());
+    prog.push_back(jump(BPF_JNE, BPF_REG_5, IPPROTO_UDP));
+    
+    prog.push_back(loadMem(BPF_H, BPF_REG_5, BPF_REG_2, UDP_DEST_OFFSET));
+    for (uint16_t port : ports) {
+        to_redirect.push_back(prog.size());
+        prog.push_back(jump(BPF_JEQ, BPF_REG_5, swap16(port)));
+    }
+    to_pass.push_back(prog.size());
+    prog.push_back(insn(BPF_JMP | BPF_JA, 0, 0, 0, 0));
+    
+    // bpf_redirect_map(map, rx_queue_index, XDP_PASS)
+    size_t redirect = prog.size();
+    prog.push_back(loadMem(BPF_W, BPF_REG_2, BPF_REG_6, offsetof(xdp_md, rx_queue_index)));
+    prog.push_back(insn(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd));
+    prog.push_back(insn(0, 0, 0, 0, 0));
+    prog.push_back(movImm(BPF_REG_3, XDP_PASS));
+    prog.push_back(insn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map));
+    prog.push_back(insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+    
+    size_t pass = prog.size();
+    prog.push_back(movImm(BPF_REG_0, XDP_PASS));
+    prog.push_back(insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+    
+    // Jump offsets count from the instruction after the jump
+    for (size_t at : to_pass) {
+        prog[at].off = static_cast<int16_t>(pass - at - 1);
+    }
+    for (size_t at : to_redirect) {
+        prog[at].off = static_cast<int16_t>(redirect - at - 1);
+    }
+    return prog;
+}
+
+} // namespace
+
+XdpSocket::XdpSocket() {}
+
+XdpSocket::~XdpSocket() {
+    close();
+}
+
+bool XdpSocket::open(const std::string& interface, uint32_t queue, const std::vector<uint16_t>& ports) {
+    close();
+    
+    int ifindex = static_cast<int>(if_nametoindex(interface.c_str()));
+    if (ifindex == 0) {
+        std::cerr << "[XDP] Unknown interface " << interface << std::endl;
+        return false;
+    }
+    
+    fd_ = socket(AF_XDP, SOCK_RAW, 0);
+    if (fd_ < 0) {
+        std::cerr << "[XDP] AF_XDP socket failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (!setupUmem()) {
+        close();
+        return false;
+    }
+    
+    // Zero-copy needs the driver hook; the generic hook only copies
+    if (!attachProgram(ifindex, queue, ports) ||
+        !((driver_mode_ && bindSocket(ifindex, queue, true)) || bindSocket(ifindex, queue, false))) {
+        close();
+        return false;
+    }
+    
+    // The program may already be redirecting; insert last so it never
+    // sees a queue entry without a bound socket
+    uint32_t key = queue;
+    uint32_t value = static_cast<uint32_t>(fd_);
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = static_cast<uint32_t>(map_fd_);
+    attr.key = reinterpret_cast<uint64_t>(&key);
+    attr.value = reinterpret_cast<uint64_t>(&value);
+    if (sysBpf(BPF_MAP_UPDATE_ELEM, &attr) != 0) {
+        std::cerr << "[XDP] Failed to register socket for queue " << queue << ": " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    
+    std::cout << "[XDP] Bound to " << interface << " queue " << queue << " ("
+              << (driver_mode_ ? "driver" : "generic") << " hook, "
+              << (zero_copy_ ? "zero-copy" : "copy") << " mode)" << std::endl;
+    return true;
+}
+
+bool XdpSocket::setupUmem() {
+    umem_size_ = static_cast<size_t>(FRAME_SIZE) * FRAME_COUNT;
+    void* umem = mmap(nullptr, umem_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (umem == MAP_FAILED) {
+        std::cerr << "[XDP] Failed to map UMEM: " << strerror(errno) << std::endl;
+        umem_size_ = 0;
+        return false;
+    }
+    umem_ = static_cast<char*>(umem);
+    
+    xdp_umem_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.addr = reinterpret_cast<uint64_t>(umem_);
+    reg.len = umem_size_;
+    reg.chunk_size = FRAME_SIZE;
+    reg.headroom = 0;
+    if (setsockopt(fd_, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) != 0) {
+        std::cerr << "[XDP] UMEM registration failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    uint32_t fill_size = FRAME_COUNT;
+    uint32_t completion_size = 64;
+    uint32_t rx_size = RX_RING_SIZE;
+    if (setsockopt(fd_, SOL_XDP, XDP_UMEM_FILL_RING, &fill_size, sizeof(fill_size)) != 0 ||
+        setsockopt(fd_, SOL_XDP, XDP_UMEM_COMPLETION_RING, &completion_size, sizeof(completion_size)) != 0 ||
+        setsockopt(fd_, SOL_XDP, XDP_RX_RING, &rx_size, sizeof(rx_size)) != 0) {
+        std::cerr << "[XDP] Ring setup failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    xdp_mmap_offsets off;
+    socklen_t optlen = sizeof(off);
+    if (getsockopt(fd_, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) != 0) {
+        std::cerr << "[XDP] XDP_MMAP_OFFSETS failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (!mapRing(fill_, XDP_UMEM_PGOFF_FILL_RING, fill_size, sizeof(uint64_t),
+                 off.fr.producer, off.fr.consumer, off.fr.flags, off.fr.desc) ||
+        !mapRing(completion_, XDP_UMEM_PGOFF_COMPLETION_RING, completion_size, sizeof(uint64_t),
+                 off.cr.producer, off.cr.consumer, off.cr.flags, off.cr.desc) ||
+        !mapRing(rx_, XDP_PGOFF_RX_RING, rx_size, sizeof(xdp_desc),
+                 off.rx.producer, off.rx.consumer, off.rx.flags, off.rx.desc)) {
+        return false;
+    }
+    
+    // Every frame starts out owned by the kernel
+    uint64_t addrs[MAX_BATCH];
+    for (uint32_t frame = 0; frame < FRAME_COUNT; frame += MAX_BATCH) {
+        size_t count = 0;
+        for (; count < MAX_BATCH && frame + count < FRAME_COUNT; ++count) {
+            addrs[count] = static_cast<uint64_t>(frame + count) * FRAME_SIZE;
+        }
+        fillFrames(addrs, count);
+    }
+    return true;
+}
+
+bool XdpSocket::mapRing(Ring& ring, uint64_t page_offset, uint32_t size, size_t desc_size,
+                        uint64_t producer, uint64_t consumer, uint64_t flags, uint64_t descs) {
+    ring.map_size = descs + static_cast<size_t>(size) * desc_size;
+    void* map = mmap(nullptr, ring.map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd_, static_cast<off_t>(page_offset));
+    if (map == MAP_FAILED) {
+        std::cerr << "[XDP] Failed to map ring: " << strerror(errno) << std::endl;
+        ring.map_size = 0;
+        return false;
+    }
+    
+    char* base = static_cast<char*>(map);
+    ring.map = map;
+    ring.size = size;
+    ring.producer = reinterpret_cast<uint32_t*>(base + producer);
+    ring.consumer = reinterpret_cast<uint32_t*>(base + consumer);
+    ring.flags = reinterpret_cast<uint32_t*>(base + flags);
+    ring.descs = base + descs;
+    return true;
+}
+
+bool XdpSocket::bindSocket(int ifindex, uint32_t queue, bool zero_copy) {
+    sockaddr_xdp addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sxdp_family = AF_XDP;
+    addr.sxdp_ifindex = static_cast<uint32_t>(ifindex);
+    addr.sxdp_queue_id = queue;
+    addr.sxdp_flags = XDP_USE_NEED_WAKEUP | (zero_copy ? XDP_ZEROCOPY : XDP_COPY);
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if (!zero_copy) {
+            std::cerr << "[XDP] Bind to queue " << queue << " failed: " << strerror(errno) << std::endl;
+        }
+        return false;
+    }
+    zero_copy_ = zero_copy;
+    return true;
+}
+
+bool XdpSocket::attachProgram(int ifindex, uint32_t queue, const std::vector<uint16_t>& ports) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = queue + 1;
+    map_fd_ = sysBpf(BPF_MAP_CREATE, &attr);
+    if (map_fd_ < 0) {
+        std::cerr << "[XDP] XSKMAP creation failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    std::vector<bpf_insn> prog = buildRedirectProgram(map_fd_, ports);
+    static char verifier_log[4096];
+    static const char license[] = "Dual BSD/GPL";
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.expected_attach_type = BPF_XDP;
+    attr.insns = reinterpret_cast<uint64_t>(prog.data());
+    attr.insn_cnt = static_cast<uint32_t>(prog.size());
+    attr.license = reinterpret_cast<uint64_t>(license);
+    attr.log_buf = reinterpret_cast<uint64_t>(verifier_log);
+    attr.log_size = sizeof(verifier_log);
+    attr.log_level = 1;
+    prog_fd_ = sysBpf(BPF_PROG_LOAD, &attr);
+    if (prog_fd_ < 0) {
+        std::cerr << "[XDP] Program load failed: " << strerror(errno) << std::endl;
+        if (verifier_log[0] != '\0') {
+            std::cerr << verifier_log << std::endl;
+        }
+        return false;
+    }
+    
+    // A bpf link detaches itself when its fd closes, even if we crash
+    for (uint32_t mode : {static_cast<uint32_t>(XDP_FLAGS_DRV_MODE), static_cast<uint32_t>(XDP_FLAGS_SKB_MODE)}) {
+        memset(&attr, 0, sizeof(attr));
+        attr.link_create.prog_fd = static_cast<uint32_t>(prog_fd_);
+        attr.link_create.target_ifindex = static_cast<uint32_t>(ifindex);
+        attr.link_create.attach_type = BPF_XDP;
+        attr.link_create.flags = mode;
+        link_fd_ = sysBpf(BPF_LINK_CREATE, &attr);
+        if (link_fd_ >= 0) {
+            driver_mode_ = (mode == XDP_FLAGS_DRV_MODE);
+            return true;
+        }
+    }
+    std::cerr << "[XDP] Attaching the program failed: " << strerror(errno) << std::endl;
+    return false;
+}
+
+void XdpSocket::close() {
+    if (link_fd_ >= 0) {
+        ::close(link_fd_);
+        link_fd_ = -1;
+    }
+    if (prog_fd_ >= 0) {
+        ::close(prog_fd_);
+        prog_fd_ = -1;
+    }
+    if (map_fd_ >= 0) {
+        ::close(map_fd_);
+        map_fd_ = -1;
+    }
+    
+    for (Ring* ring : {&fill_, &completion_, &rx_}) {
+        if (ring->map) {
+            munmap(ring->map, ring->map_size);
+        }
+        *ring = Ring();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (umem_) {
+        munmap(umem_, umem_size_);
+        umem_ = nullptr;
+        umem_size_ = 0;
+    }
+    held_count_ = 0;
+    zero_copy_ = false;
+    driver_mode_ = false;
+}
+
+size_t XdpSocket::receive(Packet* out, size_t max) {
+    if (fd_ < 0) return 0;
+    release();
+    
+    uint32_t head = *rx_.consumer;
+    uint32_t available = loadAcquire(rx_.producer) - head;
+    size_t count = std::min<size_t>(std::min<size_t>(available, max), MAX_BATCH);
+    const xdp_desc* descs = static_cast<const xdp_desc*>(rx_.descs);
+    for (size_t i = 0; i < count; ++i) {
+        const xdp_desc& desc = descs[(head + i) & (rx_.size - 1)];
+        out[i].data = umem_ + desc.addr;
+        out[i].length = desc.len;
+        held_[i] = desc.addr;
+    }
+    held_count_ = count;
+    
+    // The kernel only writes frames it finds on the fill ring, so the
+    // descriptors can be retired now
+    if (count > 0) {
+        storeRelease(rx_.consumer, head + static_cast<uint32_t>(count));
+    }
+    return count;
+}
+
+void XdpSocket::release() {
+    if (held_count_ == 0) return;
+    fillFrames(held_, held_count_);
+    held_count_ = 0;
+}
+
+void XdpSocket::fillFrames(const uint64_t* addrs, size_t count) {
+    // There are only as many frames as fill slots, so this never overflows
+    uint32_t tail = *fill_.producer;
+    uint64_t* slots = static_cast<uint64_t*>(fill_.descs);
+    for (size_t i = 0; i < count; ++i) {
+        slots[(tail + i) & (fill_.size - 1)] = addrs[i];
+    }
+    storeRelease(fill_.producer, tail + static_cast<uint32_t>(count));
+    
+    // With need_wakeup the driver stops polling an empty fill ring until kicked
+    if (loadAcquire(fill_.flags) & XDP_RING_NEED_WAKEUP) {
+        recvfrom(fd_, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    }
+}
+
+#else // !HFT_HAVE_AF_XDP
+
+XdpSocket::XdpSocket() {}
+XdpSocket::~XdpSocket() {}
+
+bool XdpSocket::open(const std::string&, uint32_t, const std::vector<uint16_t>&) {
+    std::cerr << "[XDP] Built without AF_XDP headers" << std::endl;
+    return false;
+}
+
+void XdpSocket::close() {}
+size_t XdpSocket::receive(Packet*, size_t) { return 0; }
+void XdpSocket::release() {}
+
+#endif // HFT_HAVE_AF_XDP
+
+} // namespace hft
@@ -74,7 +74,7 @@ if ./test_client 127.0.0.1 8080 -l 100 > client_test2.log 2>&1; then
     
     # Show summary
     echo "Latency Test Summary:"
-    grep -E "(Messages Sent|Average Latency|Target achieved|Target missed)" client_test2.log
+    grep -E "(Orders Acked|Round trip|avg |Target achieved|Target missed)" client_test2.log
 else
     print_warning "Latency test failed"
     cat client_test2.log
@@ -114,6 +114,25 @@ fi
 
 echo ""
 
+# Test 5: Session test
+echo "=== Test 5: Session Test (login, heartbeats, logout) ==="
+print_status "Running latency and open-loop tests inside logged-in sessions..."
+if ./test_client 127.0.0.1 8080 --login 200 --market-data -l 100 -o 1000 2 -c 2 > client_test5.log 2>&1; then
+    print_success "Session test completed"
+    
+    # Every session should end with the server's LOGOUT
+    echo "Session Test Summary:"
+    grep -E "(Logged in|Orders Acked|LOGOUT)" client_test5.log
+    if grep -q "refused or timed out\|No LOGOUT\|Server ended the session" client_test5.log; then
+        print_warning "Session ended abnormally"
+    fi
+else
+    print_warning "Session test failed"
+    cat client_test5.log
+fi
+
+echo ""
+
 # Stop server
 print_status "Stopping server..."
 kill -TERM $SERVER_PID 2>/dev/null
@@ -150,6 +169,10 @@ if [ -f "client_test4.log" ] && grep -q "Failed\|ERROR" client_test4.log; then
     print_warning "Stress test issues detected"
 fi
 
+if [ -f "client_test5.log" ] && grep -q "Failed\|ERROR\|No LOGOUT" client_test5.log; then
+    print_warning "Session test issues detected"
+fi
+
 echo ""
 echo "=== Performance Results ==="
 echo "Check individual test logs for detailed results:"
@@ -157,6 +180,7 @@ echo "  - client_test1.log: Basic connectivity"
 echo "  - client_test2.log: Latency test"
 echo "  - client_test3.log: Throughput test"
 echo "  - client_test4.log: Stress test"
+echo "  - client_test5.log: Session test"
 echo "  - server.log: Server operation logs"
 echo ""
 echo "Target: < 10 microseconds average latency" 
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <iostream>
+
+// Minimal assertions for the unit tests. A failed check is reported and
+// counted rather than aborting, so one run lists every broken case; CTest
+// only looks at the exit status from finish().
+namespace hft_test {
+
+inline int& failureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+inline int finish(const char* suite) {
+    if (failureCount() == 0) {
+        std::cout << "[" << suite << "] All checks passed" << std::endl;
+        return 0;
+    }
+    std::cerr << "[" << suite << "] " << failureCount() << " check(s) failed" << std::endl;
+    return 1;
+}
+
+} // namespace hft_test
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition         \
+                      << ") failed" << std::endl;                                     \
+            ++hft_test::failureCount();                                               \
+        }                                                                             \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                    \
+    do {                                                                              \
+        if (!((actual) == (expected))) {                                              \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", "    \
+                      << #expected << ") failed: " << (actual) << " != "              \
+                      << (expected) << std::endl;                                     \
+            ++hft_test::failureCount();                                               \
+        }                                                                             \
+    } while (0)
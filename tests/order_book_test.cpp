@@ -0,0 +1,291 @@
+#include "../include/order_book.hpp"
+#include "check.hpp"
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+// Order book matching and the flat order index underneath it
+
+namespace hft_test {
+
+using hft::BookResult;
+using hft::Execution;
+using hft::FlatOrderIndex;
+using hft::OrderBook;
+using hft::RestingOrder;
+
+bool samePrice(double a, double b) {
+    return std::fabs(a - b) < 1e-9;
+}
+
+// Book around 100.00 in cent ticks that records every execution
+struct RecordingBook {
+    RecordingBook() : book(100.0, 0.01, 4096, 256) {
+        book.setExecutionCallback([this](const Execution& execution) { executions.push_back(execution); });
+    }
+    
+    OrderBook book;
+    std::vector<Execution> executions;
+};
+
+void testPriceTimePriority() {
+    RecordingBook fixture;
+    OrderBook& book = fixture.book;
+    
+    // Two asks at 100.00 in arrival order, a better one at 99.99 after them
+    CHECK(book.addOrder(1, 10, false, 100.00, 10) == BookResult::OK);
+    CHECK(book.addOrder(2, 20, false, 100.00, 10) == BookResult::OK);
+    CHECK(book.addOrder(3, 30, false, 99.99, 10) == BookResult::OK);
+    
+    // Best price first, then first come first served within the level
+    CHECK(book.addOrder(4, 40, true, 100.00, 25) == BookResult::OK);
+    CHECK_EQ(fixture.executions.size(), 3u);
+    if (fixture.executions.size() == 3) {
+        CHECK_EQ(fixture.executions[0].maker_order_id, 3u);
+        CHECK(samePrice(fixture.executions[0].price, 99.99));
+        CHECK_EQ(fixture.executions[1].maker_order_id, 1u);
+        CHECK(samePrice(fixture.executions[1].price, 100.00));
+        CHECK_EQ(fixture.executions[2].maker_order_id, 2u);
+        CHECK_EQ(fixture.executions[2].quantity, 5u);
+        CHECK_EQ(fixture.executions[2].taker_remaining, 0u);
+        CHECK_EQ(fixture.executions[2].taker_client_id, 40u);
+        CHECK_EQ(fixture.executions[2].maker_client_id, 20u);
+    }
+    
+    // A limit that does not cross rests instead of trading
+    fixture.executions.clear();
+    CHECK(book.addOrder(5, 50, true, 99.98, 10) == BookResult::OK);
+    CHECK(fixture.executions.empty());
+    CHECK(book.addOrder(5, 50, true, 99.98, 10) == BookResult::DUPLICATE_ORDER_ID);
+}
+
+void testPartialFills() {
+    RecordingBook fixture;
+    OrderBook& book = fixture.book;
+    
+    CHECK(book.addOrder(1, 10, false, 100.00, 30) == BookResult::OK);
+    
+    // Taker smaller than the maker: the maker keeps the rest and its place
+    CHECK(book.addOrder(2, 20, true, 100.00, 12) == BookResult::OK);
+    CHECK_EQ(fixture.executions.size(), 1u);
+    if (!fixture.executions.empty()) {
+        CHECK_EQ(fixture.executions[0].quantity, 12u);
+        CHECK_EQ(fixture.executions[0].maker_remaining, 18u);
+    }
+    RestingOrder resting;
+    CHECK(book.findOrder(1, resting));
+    CHECK_EQ(resting.quantity, 18u);
+    CHECK(!book.findOrder(2, resting));
+    
+    // Taker larger than the level: it sweeps the maker and rests the remainder
+    fixture.executions.clear();
+    CHECK(book.addOrder(3, 30, true, 100.00, 25) == BookResult::OK);
+    CHECK_EQ(fixture.executions.size(), 1u);
+    if (!fixture.executions.empty()) {
+        CHECK_EQ(fixture.executions[0].quantity, 18u);
+        CHECK_EQ(fixture.executions[0].maker_remaining, 0u);
+        CHECK_EQ(fixture.executions[0].taker_remaining, 7u);
+    }
+    CHECK(!book.findOrder(1, resting));
+    CHECK(book.findOrder(3, resting));
+    CHECK_EQ(resting.quantity, 7u);
+    CHECK(resting.is_buy);
+    
+    double price = 0.0;
+    uint64_t quantity = 0;
+    CHECK(!book.bestAsk(price, quantity));
+    CHECK(book.bestBid(price, quantity));
+    CHECK(samePrice(price, 100.00));
+    CHECK_EQ(quantity, 7u);
+    CHECK_EQ(book.orderCount(), 1u);
+}
+
+void testReplacePriority() {
+    RecordingBook fixture;
+    OrderBook& book = fixture.book;
+    
+    CHECK(book.addOrder(1, 10, true, 100.00, 10) == BookResult::OK);
+    CHECK(book.addOrder(2, 20, true, 100.00, 10) == BookResult::OK);
+    CHECK(book.addOrder(3, 30, true, 100.00, 10) == BookResult::OK);
+    
+    // Sizing down in place keeps the front of the queue
+    CHECK(book.replaceOrder(1, 100.00, 4) == BookResult::OK);
+    // Sizing up is a cancel/replace and goes to the back
+    CHECK(book.replaceOrder(2, 100.00, 15) == BookResult::OK);
+    
+    double price = 0.0;
+    uint64_t quantity = 0;
+    CHECK(book.bestBid(price, quantity));
+    CHECK_EQ(quantity, 29u);
+    
+    CHECK(book.addOrder(4, 40, false, 100.00, 29) == BookResult::OK);
+    CHECK_EQ(fixture.executions.size(), 3u);
+    if (fixture.executions.size() == 3) {
+        CHECK_EQ(fixture.executions[0].maker_order_id, 1u);
+        CHECK_EQ(fixture.executions[0].quantity, 4u);
+        CHECK_EQ(fixture.executions[1].maker_order_id, 3u);
+        CHECK_EQ(fixture.executions[2].maker_order_id, 2u);
+        CHECK_EQ(fixture.executions[2].quantity, 15u);
+    }
+    
+    // A replace to a crossing price trades like a new order
+    fixture.executions.clear();
+    CHECK(book.addOrder(5, 50, false, 100.05, 10) == BookResult::OK);
+    CHECK(book.addOrder(6, 60, true, 100.00, 10) == BookResult::OK);
+    CHECK(book.replaceOrder(6, 100.05, 6) == BookResult::OK);
+    CHECK_EQ(fixture.executions.size(), 1u);
+    if (!fixture.executions.empty()) {
+        CHECK_EQ(fixture.executions[0].maker_order_id, 5u);
+        CHECK_EQ(fixture.executions[0].taker_order_id, 6u);
+        CHECK_EQ(fixture.executions[0].quantity, 6u);
+    }
+    
+    CHECK(book.replaceOrder(99, 100.00, 1) == BookResult::UNKNOWN_ORDER_ID);
+    CHECK(book.replaceOrder(5, 100.05, 0) == BookResult::INVALID_QUANTITY);
+    CHECK(book.cancelOrder(6) == BookResult::UNKNOWN_ORDER_ID);
+}
+
+void testBestAfterRemoval() {
+    OrderBook book(100.0, 0.01, 4096, 256);
+    double price = 0.0;
+    uint64_t quantity = 0;
+    
+    // Bids with an empty level between them
+    CHECK(book.addOrder(1, 1, true, 100.00, 10) == BookResult::OK);
+    CHECK(book.addOrder(2, 1, true, 99.98, 20) == BookResult::OK);
+    CHECK(book.addOrder(3, 1, true, 99.95, 30) == BookResult::OK);
+    
+    // Emptying a level behind the best leaves the best alone
+    CHECK(book.cancelOrder(2) == BookResult::OK);
+    CHECK(book.bestBid(price, quantity));
+    CHECK(samePrice(price, 100.00));
+    
+    // Emptying the best walks down past the gaps to the next live level
+    CHECK(book.cancelOrder(1) == BookResult::OK);
+    CHECK(book.bestBid(price, quantity));
+    CHECK(samePrice(price, 99.95));
+    CHECK_EQ(quantity, 30u);
+    CHECK(book.cancelOrder(3) == BookResult::OK);
+    CHECK(!book.bestBid(price, quantity));
+    
+    // Asks walk up, and fills that empty levels move the best the same way
+    CHECK(book.addOrder(4, 1, false, 100.01, 5) == BookResult::OK);
+    CHECK(book.addOrder(5, 1, false, 100.04, 5) == BookResult::OK);
+    CHECK(book.addOrder(6, 2, true, 100.01, 5) == BookResult::OK);
+    CHECK(book.bestAsk(price, quantity));
+    CHECK(samePrice(price, 100.04));
+    CHECK(!book.bestBid(price, quantity));
+    CHECK(book.addOrder(7, 2, true, 100.10, 5) == BookResult::OK);
+    CHECK(!book.bestAsk(price, quantity));
+    CHECK(!book.bestBid(price, quantity));
+    CHECK_EQ(book.orderCount(), 0u);
+    
+    CHECK(book.addOrder(8, 1, true, 200.00, 5) == BookResult::PRICE_OUT_OF_RANGE);
+}
+
+// Same probe start as FlatOrderIndex::slotFor, so the test can build
+// collision runs on purpose
+size_t homeSlot(uint64_t order_id, size_t mask) {
+    uint64_t hash = order_id * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash ^ (hash >> 32)) & mask;
+}
+
+std::vector<uint64_t> idsWithHome(size_t home, size_t mask, size_t count, uint64_t first_id) {
+    std::vector<uint64_t> ids;
+    for (uint64_t id = first_id; ids.size() < count; ++id) {
+        if (homeSlot(id, mask) == home) ids.push_back(id);
+    }
+    return ids;
+}
+
+void testIndexCollisions() {
+    // Eight orders get 16 slots
+    FlatOrderIndex index(8);
+    const size_t mask = 15;
+    
+    // A run that starts in the last slot and wraps to the front, with
+    // entries homed at slot 0 interleaved behind it
+    std::vector<uint64_t> tail_ids = idsWithHome(mask, mask, 3, 1);
+    std::vector<uint64_t> front_ids = idsWithHome(0, mask, 2, 1);
+    std::vector<uint64_t> ids = {tail_ids[0], front_ids[0], tail_ids[1], tail_ids[2], front_ids[1]};
+    for (size_t i = 0; i < ids.size(); ++i) {
+        CHECK(index.insert(ids[i], static_cast<uint32_t>(i)));
+    }
+    CHECK(!index.insert(ids[0], 99));
+    
+    // Removing the head of the run must shift the survivors back so that
+    // every one of them is still reachable from its home slot
+    CHECK(index.erase(tail_ids[0]));
+    CHECK(!index.erase(tail_ids[0]));
+    uint32_t node = 0;
+    CHECK(!index.find(tail_ids[0], node));
+    for (size_t i = 1; i < ids.size(); ++i) {
+        CHECK(index.find(ids[i], node));
+        CHECK_EQ(node, i);
+    }
+    
+    // Then from the middle of the wrapped part
+    CHECK(index.erase(front_ids[0]));
+    CHECK(index.find(tail_ids[1], node) && node == 2);
+    CHECK(index.find(tail_ids[2], node) && node == 3);
+    CHECK(index.find(front_ids[1], node) && node == 4);
+    CHECK_EQ(index.size(), 3u);
+    
+    // Full at half load
+    for (uint64_t id = 1000; index.size() < 8; ++id) {
+        index.insert(id, 0);
+    }
+    CHECK(!index.insert(5000, 0));
+    CHECK(!index.insert(0, 0));
+}
+
+void testIndexChurn() {
+    // Random inserts and erases against a reference map
+    FlatOrderIndex index(64);
+    std::unordered_map<uint64_t, uint32_t> reference;
+    uint64_t state = 12345;
+    auto next = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    
+    for (uint32_t step = 0; step < 20000; ++step) {
+        // A small id range keeps probe runs long and erases frequent
+        uint64_t id = next() % 200 + 1;
+        if (reference.count(id)) {
+            CHECK(index.erase(id));
+            reference.erase(id);
+        } else if (reference.size() < 60) {
+            CHECK(index.insert(id, step));
+            reference[id] = step;
+        }
+    }
+    
+    CHECK_EQ(index.size(), reference.size());
+    for (uint64_t id = 1; id <= 200; ++id) {
+        uint32_t node = 0;
+        auto it = reference.find(id);
+        if (it != reference.end()) {
+            CHECK(index.find(id, node));
+            CHECK_EQ(node, it->second);
+        } else {
+            CHECK(!index.find(id, node));
+        }
+    }
+}
+
+} // namespace hft_test
+
+int main() {
+    using namespace hft_test;
+    
+    testPriceTimePriority();
+    testPartialFills();
+    testReplacePriority();
+    testBestAfterRemoval();
+    testIndexCollisions();
+    testIndexChurn();
+    return finish("OrderBookTest");
+}
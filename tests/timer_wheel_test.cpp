@@ -0,0 +1,143 @@
+#include "../include/timer_wheel.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <vector>
+
+// Timer wheel expiry: exact ticks and order across level boundaries
+
+namespace hft_test {
+
+using hft::TimerWheel;
+
+struct Fired {
+    uint64_t key;
+    uint64_t tick;
+};
+
+void testExpiryAcrossLevels() {
+    // Start off a slot boundary so the delays below straddle every cascade
+    const uint64_t start = 1000;
+    TimerWheel wheel(start);
+    
+    // Either side of each level's span, scheduled out of order
+    std::vector<uint64_t> delays = {4097, 1, 64, 262144, 63, 4095, 65, 2, 262143, 4096, 262145, 130, 17, 300000};
+    std::vector<TimerWheel::Timer> timers(delays.size());
+    for (size_t i = 0; i < delays.size(); ++i) {
+        timers[i].key = i;
+        wheel.schedule(timers[i], delays[i]);
+        CHECK(timers[i].armed());
+    }
+    CHECK_EQ(wheel.size(), delays.size());
+    
+    std::vector<Fired> fired;
+    size_t count = wheel.advance(start + 300000, [&](TimerWheel::Timer& timer) {
+        CHECK(!timer.armed());
+        Fired event = {timer.key, wheel.now()};
+        fired.push_back(event);
+    });
+    CHECK_EQ(count, delays.size());
+    CHECK_EQ(fired.size(), delays.size());
+    CHECK_EQ(wheel.size(), 0u);
+    
+    // Each fires on exactly its tick, and they come out in tick order
+    std::vector<uint64_t> sorted = delays;
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < fired.size() && i < sorted.size(); ++i) {
+        CHECK_EQ(fired[i].tick, start + delays[fired[i].key]);
+        CHECK_EQ(fired[i].tick, start + sorted[i]);
+    }
+}
+
+void testAdvanceInSteps() {
+    TimerWheel wheel(0);
+    TimerWheel::Timer early;
+    TimerWheel::Timer late;
+    early.key = 1;
+    late.key = 2;
+    wheel.schedule(early, 70);
+    wheel.schedule(late, 5000);
+    
+    std::vector<Fired> fired;
+    auto record = [&](TimerWheel::Timer& timer) {
+        Fired event = {timer.key, wheel.now()};
+        fired.push_back(event);
+    };
+    
+    // Nothing is due before its tick however time is chunked
+    CHECK_EQ(wheel.advance(69, record), 0u);
+    CHECK_EQ(wheel.advance(70, record), 1u);
+    for (uint64_t tick = 71; tick < 5000; tick += 333) {
+        CHECK_EQ(wheel.advance(tick, record), 0u);
+    }
+    CHECK_EQ(wheel.advance(5000, record), 1u);
+    CHECK_EQ(fired.size(), 2u);
+    if (fired.size() == 2) {
+        CHECK_EQ(fired[0].tick, 70u);
+        CHECK_EQ(fired[1].tick, 5000u);
+    }
+}
+
+void testRescheduleAndCancel() {
+    TimerWheel wheel(10);
+    TimerWheel::Timer first;
+    TimerWheel::Timer second;
+    TimerWheel::Timer cancelled;
+    first.key = 1;
+    second.key = 2;
+    cancelled.key = 3;
+    
+    wheel.schedule(first, 5);
+    wheel.schedule(second, 100);
+    wheel.schedule(cancelled, 50);
+    
+    // Rescheduling moves an armed timer rather than adding another
+    wheel.schedule(second, 8);
+    CHECK_EQ(wheel.size(), 3u);
+    wheel.cancel(cancelled);
+    wheel.cancel(cancelled);
+    CHECK(!cancelled.armed());
+    CHECK_EQ(wheel.size(), 2u);
+    
+    // A callback may re-arm its own timer; it fires again later, not this tick
+    std::vector<Fired> fired;
+    size_t rearms = 0;
+    wheel.advance(200, [&](TimerWheel::Timer& timer) {
+        Fired event = {timer.key, wheel.now()};
+        fired.push_back(event);
+        if (timer.key == 1 && rearms++ < 2) {
+            wheel.schedule(timer, 64);
+        }
+    });
+    
+    CHECK_EQ(fired.size(), 4u);
+    if (fired.size() == 4) {
+        CHECK(fired[0].key == 1 && fired[0].tick == 15);
+        CHECK(fired[1].key == 2 && fired[1].tick == 18);
+        CHECK(fired[2].key == 1 && fired[2].tick == 79);
+        CHECK(fired[3].key == 1 && fired[3].tick == 143);
+    }
+    CHECK_EQ(wheel.size(), 0u);
+    
+    // A zero delay still waits for the next tick
+    wheel.schedule(first, 0);
+    CHECK_EQ(first.expiry, 201u);
+}
+
+void testClampedDelay() {
+    TimerWheel wheel(0);
+    TimerWheel::Timer timer;
+    wheel.schedule(timer, TimerWheel::MAX_DELAY + 1000);
+    CHECK_EQ(timer.expiry, TimerWheel::MAX_DELAY + 1);
+}
+
+} // namespace hft_test
+
+int main() {
+    using namespace hft_test;
+    
+    testExpiryAcrossLevels();
+    testAdvanceInSteps();
+    testRescheduleAndCancel();
+    testClampedDelay();
+    return finish("TimerWheelTest");
+}